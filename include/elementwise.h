@@ -0,0 +1,110 @@
+/*
+ * elementwise.h
+ *
+ * Out-of-core elementwise expressions over co-tiled tensors, e.g.
+ *
+ *     T + R / D        2.0 * A - B        -(A * B) + 0.5
+ *
+ * Operands are upper-case letters: A is the first input tensor, B the
+ * second, and so on.  Real numeric literals, + - * /, unary minus and
+ * parentheses are supported.  All inputs must share rank, shape, chunk
+ * shape and dtype, so every expression evaluates tile-by-tile with no
+ * data movement between tiles.
+ *
+ * Block sparsity is preserved: a tile that is absent in an input is a
+ * structural zero, and output tiles that are structurally zero for the
+ * given expression are never read, computed or written.
+ */
+
+#ifndef ELEMENTWISE_H
+#define ELEMENTWISE_H
+
+#include <stddef.h>
+#include <complex.h>
+
+/* Maximum number of input tensors (operand letters A … H). */
+#define EW_MAX_INPUTS 8
+
+/* Maximum number of instructions in a compiled expression. */
+#define EW_MAX_PROG   64
+
+typedef enum {
+    EW_OP_LOAD,      /* push input tile `operand`                          */
+    EW_OP_CONST,     /* push scalar `value`                                */
+    EW_OP_ADD,
+    EW_OP_SUB,
+    EW_OP_MUL,
+    EW_OP_DIV,
+    EW_OP_NEG
+} ew_opcode_t;
+
+typedef struct {
+    ew_opcode_t op;
+    int         operand;    /* input index for EW_OP_LOAD                  */
+    double      value;      /* literal for EW_OP_CONST                     */
+} ew_instr_t;
+
+/*
+ * Compiled expression: postfix instruction stream.
+ *   n_inputs  — 1 + highest operand index referenced (0 for constants only)
+ *   max_depth — evaluation stack depth required by the program
+ */
+typedef struct {
+    int        n_instr;
+    ew_instr_t code[EW_MAX_PROG];
+    int        n_inputs;
+    int        max_depth;
+} ew_program_t;
+
+/*
+ * Parse an infix expression into a postfix program.  Constant
+ * sub-expressions are folded at compile time.
+ * Returns 0 on success, -1 on a syntax error.
+ */
+int ew_compile(const char *expr, ew_program_t *prog);
+
+/*
+ * Return 1 if the program's result is structurally zero for a tile in which
+ * present[k] == 0 marks input k as an absent (all-zero) tile, else 0.
+ *
+ * Rules: absent loads and 0.0 literals are zero; a+b and a-b are zero when
+ * both sides are; a*b when either side is; a/b when a is (0/D is treated
+ * as zero whatever D holds, matching the sparse convention that absent
+ * numerator tiles are never materialised).
+ */
+int ew_tile_is_zero(const ew_program_t *prog, const int *present);
+
+/*
+ * Evaluate the program over n elements.
+ *   in[k]  : pointer to input k's tile buffer, or NULL for an absent tile
+ *   out    : destination; may alias any in[k] (evaluation is elementwise)
+ */
+void ew_eval_fp64(const ew_program_t *prog, const double *const *in,
+                  double *out, size_t n);
+
+void ew_eval_c128(const ew_program_t *prog,
+                  const double _Complex *const *in,
+                  double _Complex *out, size_t n);
+
+/*
+ * Evaluate expr over n_in co-tiled HDF5 tensors and store the result in
+ * file_out / name_out.
+ *
+ * If (file_out, name_out) names one of the inputs the update is done in
+ * place (e.g. T = T + R/D with files {T, R, D} and file_out == T);
+ * otherwise file_out is created or overwritten.
+ *
+ * Pipeline: one reader thread stages tiles into BufferPool pages, a set of
+ * compute threads (TENSOR_NUM_THREADS, default: online CPUs) evaluates
+ * them, and one writer thread drains a WriteQueue to disk.  Pool size
+ * honours TENSOR_POOL_MB.
+ *
+ * Returns 0 on success, -1 on I/O error, -2 on incompatible shapes or
+ * dtypes, -3 on a malformed expression, -4 on allocation failure.
+ */
+int run_elementwise(const char *expr,
+                    const char *const *files_in,
+                    const char *const *names_in, int n_in,
+                    const char *file_out, const char *name_out);
+
+#endif /* ELEMENTWISE_H */
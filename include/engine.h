@@ -12,6 +12,15 @@
  */
 size_t query_physical_ram(void);
 
+/*
+ * Number of CPU worker threads to use for parallel stages.
+ *
+ * Honours the TENSOR_NUM_THREADS environment variable when it is set to a
+ * positive value; otherwise returns the number of online CPUs.  Always in
+ * [1, 64].
+ */
+int query_num_threads(void);
+
 /*
  * Contract A(i,k) * B(k,j) -> C(i,j) for rank-2 chunked HDF5 tensors.
  *
@@ -99,4 +108,36 @@ int run_contraction_einsum_acc(const char *expr,
                                const char *file_B, const char *name_B,
                                const char *file_C, const char *name_C);
 
+/*
+ * Executor state kept across einsum runs by a long-lived process: the
+ * work-stealing task pool, the I/O scheduler thread and the large
+ * macroblock buffers (A cache, B pre-cache, C accumulators, B slots).  A
+ * run reuses each buffer that is big enough and replaces the others, so
+ * a warm engine starts without spawning threads or faulting in fresh
+ * memory.  The pool is rebuilt when TENSOR_NUM_THREADS changes; the I/O
+ * depths and limits are read once, when the state is created.  One run at
+ * a time may use it.
+ */
+typedef struct EngineWarm EngineWarm;
+
+EngineWarm *engine_warm_create(void);
+void        engine_warm_destroy(EngineWarm *w);   /* NULL is a no-op */
+
+/* Per-run settings that would otherwise come from the environment. */
+typedef struct {
+    EngineWarm *warm;          /* kept executor state, or NULL            */
+    size_t      shm_cache_mb;  /* shared B tile cache; 0 → TENSOR_SHM_CACHE_MB */
+} engine_run_opts_t;
+
+/*
+ * run_contraction_einsum (accumulate = 0) or run_contraction_einsum_acc
+ * (accumulate = 1) with opts; opts may be NULL.
+ */
+int run_contraction_einsum_opts(const char *expr,
+                                const char *file_A, const char *name_A,
+                                const char *file_B, const char *name_B,
+                                const char *file_C, const char *name_C,
+                                int accumulate,
+                                const engine_run_opts_t *opts);
+
 #endif /* ENGINE_H */
@@ -0,0 +1,146 @@
+/*
+ * io_sched.h
+ *
+ * Prioritized I/O scheduler: one I/O thread serves tile reads and writes
+ * from several producers in class order instead of arrival order, so a
+ * burst of C writebacks cannot delay a B read that compute is blocked on.
+ *
+ * Classes, highest first:
+ *   IOS_DEMAND       a consumer is (or will immediately be) blocked on it
+ *   IOS_PREFETCH     the next slot of a double buffer
+ *   IOS_SPECULATIVE  read-ahead that may never be consumed
+ *   IOS_WRITEBACK    results leaving RAM
+ *
+ * Within a class requests run earliest-deadline-first (no deadline sorts
+ * last), ties in submission order.  Waiting on a request that is still
+ * queued promotes it to IOS_DEMAND, so low classes cannot starve a thread
+ * that needs them.  Each class has a depth limit on outstanding requests;
+ * ios_submit blocks while its class is full.
+ *
+ * Requests are caller-owned: fill fn/arg/cls/deadline_ns (and bytes/ops/
+ * write for throttling), submit, and keep the storage alive until ios_wait
+ * returns.  fn runs on the I/O thread and must do its own HDF5 locking
+ * (tensor_store_lock) like any other thread.
+ *
+ * QoS for co-located jobs: optional token buckets cap read bytes/s, write
+ * bytes/s and operations/s.  A request waits until its direction's bucket
+ * is out of debt, runs, and is then charged what it actually moved, so a
+ * fn may correct bytes/ops before returning.  Buckets hold IOS_BURST_S of
+ * credit.  Background mode lowers the I/O thread's own disk priority
+ * (ioprio_set on Linux, setiopolicy_np on macOS).
+ */
+
+#ifndef IO_SCHED_H
+#define IO_SCHED_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    IOS_DEMAND = 0,
+    IOS_PREFETCH,
+    IOS_SPECULATIVE,
+    IOS_WRITEBACK,
+    IOS_N_CLASSES
+} ios_class_t;
+
+typedef struct ios_req {
+    int           (*fn)(void *arg);  /* performs the I/O; 0 or negative   */
+    void           *arg;
+    ios_class_t     cls;
+    uint64_t        deadline_ns;     /* ios_now_ns() clock; 0 = none      */
+    size_t          bytes;           /* charged to the bandwidth bucket   */
+    size_t          ops;             /* charged to the IOPS bucket (0 → 1)*/
+    int             write;           /* 1 → write bucket                  */
+    /* Set by the scheduler. */
+    int             rc;              /* fn's return value                 */
+    int             state;           /* IOS_REQ_*                         */
+    int             promoted;        /* served as IOS_DEMAND after a wait */
+    uint64_t        t_submit, t_start, t_done;
+    struct ios_req *next;
+} ios_req_t;
+
+enum { IOS_REQ_IDLE = 0, IOS_REQ_QUEUED, IOS_REQ_RUNNING, IOS_REQ_DONE };
+
+/* Per-class counters, attributed to the class a request was submitted in. */
+typedef struct {
+    size_t n;               /* completed requests                          */
+    size_t n_promoted;      /* promoted to IOS_DEMAND by a waiter          */
+    size_t n_missed;        /* finished after their deadline               */
+    size_t n_blocked;       /* submits that waited for a depth slot        */
+    double wait_s;          /* summed submit → start                       */
+    double service_s;       /* summed start → done                         */
+    double throttle_s;      /* summed wait for bandwidth / IOPS tokens     */
+    size_t bytes;           /* charged bytes                               */
+    double max_latency_s;   /* worst submit → done                         */
+} ios_stats_t;
+
+#define IOS_BURST_S 0.1           /* bucket capacity, seconds of credit */
+
+enum { IOS_BG_NONE = 0, IOS_BG_LOW, IOS_BG_IDLE };
+
+typedef struct {
+    double read_bps;        /* bytes/s, 0 = unlimited                      */
+    double write_bps;
+    double iops;            /* operations/s, 0 = unlimited                 */
+    int    background;      /* IOS_BG_*                                    */
+} ios_limits_t;
+
+typedef struct {
+    pthread_t       thr;
+    pthread_mutex_t mu;
+    pthread_cond_t  cv_io;      /* I/O thread: work queued or shutdown      */
+    pthread_cond_t  cv_done;    /* waiters and depth-blocked submitters     */
+    ios_req_t      *head[IOS_N_CLASSES];
+    int             depth[IOS_N_CLASSES];        /* 0 = unbounded        */
+    int             outstanding[IOS_N_CLASSES];  /* queued + running     */
+    int             shutdown;
+    ios_stats_t     stats[IOS_N_CLASSES];
+    ios_limits_t    lim;
+    /* Token buckets, touched by the I/O thread only. */
+    double          tok_r, tok_w, tok_ops;
+    uint64_t        t_tok;
+} IOScheduler;
+
+/*
+ * Start the I/O thread.  depth[c] bounds the outstanding requests of class
+ * c (0 = unbounded); NULL takes TENSOR_IO_DEPTH ("d,p,s,w") or the defaults
+ * 0,2,4,0 — demand and writeback are already bounded by their callers'
+ * buffers.  lim NULL takes TENSOR_IO_READ_MBPS, TENSOR_IO_WRITE_MBPS,
+ * TENSOR_IO_IOPS and TENSOR_IO_BACKGROUND (1/low or idle), all unlimited
+ * or off when unset.  Returns NULL on failure.
+ */
+IOScheduler *ios_create(const int *depth, const ios_limits_t *lim);
+
+/* Finish every queued request, stop the I/O thread and free. */
+void         ios_destroy(IOScheduler *s);
+
+/* Wait until no request is queued or running; the thread keeps running. */
+void         ios_drain(IOScheduler *s);
+
+/* Zero the counters, so a reused scheduler reports one run at a time. */
+void         ios_reset_stats(IOScheduler *s);
+
+/* Queue r (blocks while r->cls is at its depth limit). */
+void         ios_submit(IOScheduler *s, ios_req_t *r);
+
+/* Wait for r, promoting it if still queued.  Returns r->rc. */
+int          ios_wait(IOScheduler *s, ios_req_t *r);
+
+/*
+ * Submit r and wait for it in its own class (no promotion): the caller is
+ * the producer doing the I/O on behalf of later consumers, not one of them.
+ */
+int          ios_run(IOScheduler *s, ios_req_t *r);
+
+/* Copy of the counters for class c. */
+ios_stats_t  ios_stats(IOScheduler *s, ios_class_t c);
+
+/* Monotonic clock used for deadlines. */
+uint64_t     ios_now_ns(void);
+
+/* "demand", "prefetch", "speculative", "writeback". */
+const char  *ios_class_name(ios_class_t c);
+
+#endif /* IO_SCHED_H */
@@ -0,0 +1,101 @@
+/*
+ * job_server.h
+ *
+ * Long-running contraction service.  One process owns an engine and serves
+ * jobs from any number of local clients over a Unix domain socket, so the
+ * per-invocation costs of engine_app-style runs — process start, HDF5 and
+ * BLAS initialisation, faulting in a fresh buffer pool, re-reading B
+ * tiles — are paid once.
+ *
+ * Scheduling: jobs from all connections go into one FIFO and a single
+ * worker runs them one at a time with the server's pool cap, so the
+ * resident footprint is bounded by one pool plus the shared B cache no
+ * matter how many clients submit.  Between jobs the worker keeps the
+ * contraction executor's task pool, I/O thread and A/B/C cache buffers
+ * (tensor_engine_config_t.keep_warm), the elementwise pool slab
+ * (pool_keep_warm) and the shared B tile caches of recent B files
+ * (shmc_keep) alive.
+ *
+ * Protocol (host byte order; the socket is node-local): a client sends one
+ * jsrv_hdr_t followed by hdr.len bytes holding hdr.n_args NUL-terminated
+ * strings, then reads one jsrv_reply_t.  One request per connection; the
+ * reply arrives when the job has finished.
+ *
+ *   JSRV_OP_CONTRACT     expr, A, B, C          tensor_engine_contract
+ *   JSRV_OP_ACCUMULATE   expr, A, B, C          tensor_engine_accumulate
+ *   JSRV_OP_ELEMENTWISE  expr, out, in0 … in7   tensor_engine_elementwise
+ *   JSRV_OP_VERIFY       expr, A, B, C          tensor_engine_verify
+ *   JSRV_OP_STATUS       —                      queue and counters only
+ *   JSRV_OP_SHUTDOWN     —                      finish queued jobs, exit
+ */
+
+#ifndef JOB_SERVER_H
+#define JOB_SERVER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define JSRV_MAGIC     0x314a434fu     /* "OCJ1" */
+#define JSRV_MAX_ARGS  10
+#define JSRV_MAX_LEN   8192            /* request payload bytes */
+
+enum {
+    JSRV_OP_CONTRACT = 1,
+    JSRV_OP_ACCUMULATE,
+    JSRV_OP_ELEMENTWISE,
+    JSRV_OP_VERIFY,
+    JSRV_OP_STATUS,
+    JSRV_OP_SHUTDOWN
+};
+
+/* jsrv_reply_t.status: whether the job ran; rc then holds its result. */
+enum {
+    JSRV_DONE = 0,
+    JSRV_BAD_REQUEST,        /* unknown op, wrong argument count          */
+    JSRV_BUSY,               /* queue full                                */
+    JSRV_CLOSING             /* shutdown requested, no new jobs           */
+};
+
+typedef struct {
+    uint32_t magic;
+    uint32_t op;             /* JSRV_OP_*                                  */
+    uint32_t n_args;
+    uint32_t len;            /* payload bytes after this header            */
+} jsrv_hdr_t;
+
+typedef struct {
+    uint32_t magic;
+    int32_t  status;         /* JSRV_DONE or a rejection                   */
+    int32_t  rc;             /* TENSOR_ENGINE_* of the job                 */
+    uint32_t queued;         /* jobs waiting when the reply was sent       */
+    uint64_t jobs_done;      /* jobs finished since the server started     */
+    double   queue_s;        /* time this job waited for the worker        */
+    double   run_s;          /* time this job ran                          */
+    double   max_rel_err;    /* JSRV_OP_VERIFY only                        */
+} jsrv_reply_t;
+
+typedef struct {
+    size_t pool_mb;          /* pool cap per job (0 → engine default)      */
+    size_t tile_bytes;       /* engine tile size (0 → default)             */
+    size_t cache_mb;         /* shared B tile cache per B file (0 → off)   */
+    int    keep_b;           /* B caches kept between jobs (0 → 4)         */
+    int    max_queue;        /* queued jobs before JSRV_BUSY (0 → 64)      */
+} jsrv_config_t;
+
+/*
+ * Serve on the socket at path (replacing a stale socket file) until a
+ * JSRV_OP_SHUTDOWN request has been answered and the queue has drained.
+ * cfg may be NULL for defaults.  Returns 0, or -1 if the socket cannot be
+ * set up.
+ */
+int jsrv_serve(const char *path, const jsrv_config_t *cfg);
+
+/*
+ * Client: send one request and wait for its reply.  Returns 0 when a
+ * reply was received (check rep->status and rep->rc), -1 on a connection
+ * or protocol failure.
+ */
+int jsrv_call(const char *path, int op, const char *const *args, int n_args,
+              jsrv_reply_t *rep);
+
+#endif /* JOB_SERVER_H */
@@ -39,4 +39,22 @@ void *pool_get_ptr(BufferPool *pool, size_t page_id);
 /* Number of currently free pages. */
 size_t pool_free_count(BufferPool *pool);
 
+/*
+ * Warm pools for long-running processes: with on = 1, pool_destroy keeps
+ * the (largest) page slab instead of freeing it and the next pool_create
+ * that fits reuses it, so already-faulted memory carries over between
+ * runs.  on = 0 frees the kept slab.
+ */
+void pool_keep_warm(int on);
+
+/*
+ * Per-thread scratch: a buffer of at least bytes bytes owned by the calling
+ * thread, grown on demand and freed when the thread exits.  Each slot is a
+ * separate buffer, so one caller's scratch survives another's use on the
+ * same thread.  Returns NULL if the allocation fails.
+ */
+enum { SCRATCH_ZPLANAR, SCRATCH_RETILE, SCRATCH_N_SLOTS };
+
+void *thread_scratch(int slot, size_t bytes);
+
 #endif /* MEMORY_H */
@@ -33,6 +33,8 @@ typedef struct {
     hsize_t    phys_offset[MAX_RANK];   /* Element offset into the HDF5 file  */
     TileStatus status;
     size_t     buffer_id;               /* Pool page ID; SIZE_MAX if not loaded */
+    haddr_t    file_addr;               /* Chunk byte address; HADDR_UNDEF if none */
+    hsize_t    file_bytes;              /* Stored chunk size in bytes           */
 } TileMetadata;
 
 typedef struct {
@@ -55,7 +57,9 @@ TensorRegistry *registry_create(int rank, const hsize_t *global_dims,
 
 /*
  * Create a registry by reading rank, global_dims, and chunk_dims directly from
- * an open HDF5 dataset.  This is the authoritative factory for existing files;
+ * an open HDF5 dataset.  Contiguous and compact datasets have no chunks; they
+ * get a virtual tiling from registry_virtual_chunk_dims and are read with
+ * hyperslabs like any chunked dataset.  This is the authoritative factory for existing files;
  * it eliminates any divergence between what was baked into the file and what
  * the registry believes the chunk boundaries to be.
  * The dataset must remain open for the lifetime of any subsequent
@@ -63,6 +67,23 @@ TensorRegistry *registry_create(int rank, const hsize_t *global_dims,
  */
 TensorRegistry *registry_create_from_dset(hid_t dset_id);
 
+/*
+ * Default virtual tile shape for a dataset without chunks: isotropic
+ * sides targeting TENSOR_VIRTUAL_TILE_BYTES (default
+ * REGISTRY_VIRTUAL_TILE_BYTES) per tile, clamped to global_dims.
+ */
+#define REGISTRY_VIRTUAL_TILE_BYTES (16UL << 20)
+void registry_virtual_chunk_dims(int rank, const hsize_t *global_dims,
+                                 tensor_dtype_t dtype, hsize_t *chunk_dims);
+
+/*
+ * Create a registry with explicit chunk dims and dtype, for storage
+ * backends that keep the tensor layout in their own header.
+ */
+TensorRegistry *registry_create_chunked(int rank, const hsize_t *global_dims,
+                                        const hsize_t *chunk_dims,
+                                        tensor_dtype_t dtype);
+
 void registry_destroy(TensorRegistry *reg);
 
 /*
@@ -74,7 +95,10 @@ TileMetadata *registry_get_tile(TensorRegistry *reg,
                                 const hsize_t *tile_coords);
 
 /*
- * Scan an open HDF5 dataset and mark all allocated chunks TILE_STATUS_ON_DISK.
+ * Scan an open HDF5 dataset and mark all allocated chunks TILE_STATUS_ON_DISK,
+ * recording each chunk's byte address and stored size in the file.  For a
+ * contiguous dataset every tile of reg's (virtual) tiling is ON_DISK once
+ * the dataset's storage is allocated.
  * Returns the number of active chunks found, or -1 on error.
  */
 long registry_scan_file(hid_t dset_id, TensorRegistry *reg);
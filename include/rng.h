@@ -0,0 +1,47 @@
+/*
+ * rng.h
+ *
+ * Small, stateless-friendly pseudo-random helpers used by the generators and
+ * verifiers.  Everything is a static inline over a single uint64_t state so
+ * that any tile (or vector element) can be regenerated independently from
+ * (seed, index) without replaying a global stream — the property that makes
+ * parallel generation reproducible regardless of thread count.
+ *
+ * splitmix64 (Steele, Lea & Flood 2014) passes BigCrush and is more than
+ * good enough for test data; it is not a cryptographic generator.
+ */
+
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+/* Advance *state and return the next 64-bit output. */
+static inline uint64_t rng_next(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/* Derive an independent stream seed for item `index` of stream `seed`. */
+static inline uint64_t rng_derive(uint64_t seed, uint64_t index)
+{
+    uint64_t s = seed ^ (index * 0xD1342543DE82EF95ULL);
+    return rng_next(&s);
+}
+
+/* Uniform double in [0, 1) with 53 random bits. */
+static inline double rng_uniform01(uint64_t *state)
+{
+    return (double)(rng_next(state) >> 11) * 0x1.0p-53;
+}
+
+/* Uniform double in [-1, 1). */
+static inline double rng_uniform(uint64_t *state)
+{
+    return 2.0 * rng_uniform01(state) - 1.0;
+}
+
+#endif /* RNG_H */
@@ -0,0 +1,95 @@
+/*
+ * shm_cache.h
+ *
+ * Node-local tile cache in POSIX shared memory, shared by cooperating
+ * engine processes that read the same input file: the first process to
+ * need a tile reads it from disk into the segment, the others copy it from
+ * there.
+ *
+ * One segment per (file identity, dataset, tiling): the name hashes the
+ * file's device, inode, size and mtime, so a rewritten file gets a fresh
+ * cache, and the dataset name, tile shape and tile count, so two datasets
+ * of one file, or one dataset read under two tilings, never share tiles.
+ * Layout: header, a lookup table of 2 × n_slots entries (open addressing
+ * on the tile index, lock-free: entries are claimed by compare-and-swap
+ * and never removed), then n_slots page-aligned tile slots.  Tiles are
+ * filled once and never evicted; when the slots run out, further tiles are
+ * simply not cached.
+ *
+ * Entry states: EMPTY → LOADING (owner pid set) → READY, or → UNCACHED if
+ * no slot was free or the owner's read failed.  A waiter that finds a
+ * LOADING entry whose owner has died takes the entry over and loads it
+ * itself, so a crashed process cannot wedge the others.
+ *
+ * Processes are reference-counted through a table of attached pids; the
+ * last live process to detach unlinks the segment, and dead pids are
+ * cleared on every attach and detach.  A long-running process may keep
+ * its reference across runs (shmc_keep) so the tiles outlive each job.
+ */
+
+#ifndef SHM_CACHE_H
+#define SHM_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#define SHMC_MAX_PROCS 64
+
+typedef struct ShmHeader ShmHeader;
+
+typedef struct {
+    ShmHeader     *hdr;
+    size_t         map_bytes;
+    char           name[32];
+    int            pid_slot;       /* index in the pid table, -1 if full    */
+    /* Process-local counters. */
+    atomic_size_t  n_hit;          /* served from the segment               */
+    atomic_size_t  n_fill;         /* read from disk into the segment       */
+    atomic_size_t  n_miss;         /* read privately (full or uncached)     */
+} ShmTileCache;
+
+/* shmc_lookup results. */
+enum { SHMC_MISS = 0, SHMC_HIT, SHMC_FILL };
+
+/*
+ * Attach to (or create) the cache for dataset dset (may be NULL) of the
+ * file at path, read as n_tiles tiles of chunk_dims[rank] elements and
+ * tile_bytes each.  cap_bytes bounds the tile slots of a new segment (an
+ * existing segment keeps its creator's size).  Returns NULL, with a
+ * message on stderr, if shared memory is unavailable.
+ */
+ShmTileCache *shmc_attach(const char *path, const char *dset, int rank,
+                          const size_t *chunk_dims, size_t tile_bytes,
+                          size_t n_tiles, size_t cap_bytes);
+
+/* Detach; unlinks the segment if no other live process is attached. */
+void          shmc_detach(ShmTileCache *c);
+
+/*
+ * Look up tile idx and set *data to its slot:
+ *   SHMC_HIT   the tile is ready; copy it out of *data.
+ *   SHMC_FILL  the caller now owns the slot: write the tile into *data and
+ *              call shmc_publish(c, idx, ok) exactly once.
+ *   SHMC_MISS  not cached (no room, load failed, or another process is
+ *              stuck); read privately.  *data is NULL.
+ * Blocks while another live process is loading the tile.
+ */
+int           shmc_lookup(ShmTileCache *c, uint64_t idx, void **data);
+
+/* Finish a SHMC_FILL: ok = 1 makes the tile visible, 0 marks it uncached. */
+void          shmc_publish(ShmTileCache *c, uint64_t idx, int ok);
+
+/*
+ * Keep caches warm in a long-running process: with n > 0, shmc_detach
+ * keeps up to n caches attached (oldest detached first) and shmc_attach of
+ * the same segment hands the kept mapping back with its counters reset.
+ * n = 0 detaches every kept cache.
+ */
+void          shmc_keep(int n);
+
+/* Tile slots of the segment and how many are in use. */
+size_t        shmc_slots(const ShmTileCache *c);
+size_t        shmc_slots_used(const ShmTileCache *c);
+
+#endif /* SHM_CACHE_H */
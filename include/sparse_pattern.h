@@ -0,0 +1,83 @@
+/*
+ * sparse_pattern.h
+ *
+ * Tile-level block-sparsity patterns for the sparse generator.  A pattern
+ * decides, per tile of a TensorRegistry, whether the tile is written
+ * (allocated on disk) or left as a structural zero.  All decisions are pure
+ * functions of (pattern, tile coordinates), so a pattern can be evaluated in
+ * any order from any thread and re-evaluated later for validation.
+ *
+ *   SP_DENSE       every tile
+ *   SP_RANDOM      each tile independently with probability `density`
+ *   SP_BANDED      tiles whose coordinates differ by at most `bandwidth`
+ *                  (max_d c_d - min_d c_d <= bandwidth) — the N-D analogue
+ *                  of a banded matrix
+ *   SP_BLOCK_DIAG  the tile grid is split into `n_blocks` equal slabs per
+ *                  dimension; a tile is kept when every coordinate falls in
+ *                  the same slab
+ *   SP_SYMMETRIC   SP_RANDOM decided on the sorted tile coordinates, so the
+ *                  pattern is invariant under any index permutation; the
+ *                  contents (sparse_pattern_fill_symmetric) are symmetric
+ *                  element-wise as well
+ */
+
+#ifndef SPARSE_PATTERN_H
+#define SPARSE_PATTERN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "registry.h"
+
+typedef enum {
+    SP_DENSE = 0,
+    SP_RANDOM,
+    SP_BANDED,
+    SP_BLOCK_DIAG,
+    SP_SYMMETRIC
+} sp_kind_t;
+
+typedef struct {
+    sp_kind_t kind;
+    double    density;     /* SP_RANDOM, SP_SYMMETRIC: fraction in [0, 1] */
+    int       bandwidth;   /* SP_BANDED: tiles off the diagonal (>= 0)    */
+    int       n_blocks;    /* SP_BLOCK_DIAG: diagonal blocks (>= 1)       */
+    uint64_t  seed;        /* selection and contents                      */
+} sparse_pattern_t;
+
+/*
+ * Parse a pattern name ("dense", "random", "banded", "blockdiag",
+ * "symmetric").  Returns 0 on success, -1 for an unknown name.
+ */
+int sparse_pattern_parse(const char *name, sp_kind_t *kind_out);
+
+/* Name of a pattern kind, for reports. */
+const char *sparse_pattern_name(sp_kind_t kind);
+
+/*
+ * Check that the pattern parameters are usable on reg.  SP_SYMMETRIC needs
+ * equal global and chunk extents in every dimension.  Prints the reason and
+ * returns -1 on failure.
+ */
+int sparse_pattern_validate(const sparse_pattern_t *pat,
+                            const TensorRegistry *reg);
+
+/*
+ * Selection callback (tw_select_fn signature): 1 if tile tile_index is part
+ * of the pattern pointed to by user (a const sparse_pattern_t *).
+ */
+int sparse_pattern_select(const TensorRegistry *reg, size_t tile_index,
+                          void *user);
+
+/* Number of tiles of reg selected by pat. */
+size_t sparse_pattern_count(const sparse_pattern_t *pat,
+                            const TensorRegistry *reg);
+
+/*
+ * Tile callback (tw_tile_fn signature) for SP_SYMMETRIC: element x gets a
+ * uniform [-1, 1) value derived from (seed, sorted(x)), so
+ * T[x] == T[perm(x)] for every permutation.  user is the pattern.
+ */
+int sparse_pattern_fill_symmetric(void *buf, const TensorRegistry *reg,
+                                  size_t tile_index, void *user);
+
+#endif /* SPARSE_PATTERN_H */
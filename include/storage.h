@@ -0,0 +1,218 @@
+/*
+ * storage.h
+ *
+ * Pluggable tile storage.  The einsum engine opens, scans, reads and
+ * writes tensors only through a StorageFile and its ops table, so the
+ * on-disk format is a backend choice:
+ *
+ *   hdf5  one dataset in an HDF5 file (tensor_store.c); every call takes
+ *         tensor_store_lock(), as all HDF5 access must.  A contiguous
+ *         dataset has no chunks and gets a virtual tiling (virtual_tiles),
+ *         which the caller may replace with stg_set_tiling before the
+ *         first scan.  Opened read-only with a native element type, its
+ *         tiles are gathered straight from the file without HDF5: from an
+ *         mmap of the data (TENSOR_MMAP=0 disables it) or by strided pread.
+ *   raw   the native tile-aligned format below; lock-free pread/pwrite.
+ *   stripe  a tensor striped over several drives: a small manifest naming
+ *         one native member file per directory, tile t in slot t / n of
+ *         member t mod n.  Each drive serves its own share of the tiles.
+ *   retile  a view of another StorageFile under a different tiling
+ *         (stg_retile).  Each tile is assembled from the inner tiles it
+ *         overlaps, so operands chunked differently along a contracted
+ *         index can be contracted without a rechunk pass.  With
+ *         stg_retile_stage the view is also writable: tiles are split or
+ *         gathered into the inner file's chunks, so C can be written in
+ *         any chunk shape.
+ *
+ * stg_open recognises a file by its magic, so any format can be passed
+ * wherever a tensor path is expected.  stg_create chooses the backend from
+ * the path: names ending in ".oct" get the native format, ".ocs" a striped
+ * tensor over the directories in TENSOR_STRIPE_DIRS (colon-separated),
+ * everything else HDF5.
+ *
+ * Native format (".oct", host byte order):
+ *
+ *   [0, 4096)            header (stg_raw_header_t)
+ *   [index_off, ...)     n_tiles × uint64: payload offset of each tile in
+ *                        row-major tile order, 0 = tile absent
+ *   [data_off, ...)      tile t at data_off + t × slot_bytes
+ *
+ * A payload is the full nominal tile, row-major with chunk_dims strides,
+ * boundary padding zeroed, so it is exactly what read_chunk_typed produces
+ * and can be pread, O_DIRECT-read or mmapped into a pool page as is.
+ * slot_bytes is the tile size rounded up to the payload alignment (16 KiB
+ * by default, 4 KiB minimum).  Absent tiles are never written and stay
+ * filesystem holes, so block-sparse tensors cost only their stored tiles.
+ *
+ * Stripe manifest (".ocs"): the line STG_STRIPE_MAGIC, a shape line
+ * "dtype rank global_dims… chunk_dims…", then one member path per line;
+ * relative paths are relative to the manifest.  Of T tiles, member k of n
+ * is a rank-1 native file of ceil((T - k) / n) whole tiles (at least one)
+ * whose local tile j is tile k + j·n.
+ */
+
+#ifndef STORAGE_H
+#define STORAGE_H
+
+#include "registry.h"   /* TensorRegistry, TileMetadata, MAX_RANK, hsize_t */
+#include <stddef.h>
+#include <stdint.h>
+
+#define STG_RAW_MAGIC       "OCTRAW01"
+#define STG_RAW_HEADER      4096
+#define STG_RAW_ALIGN       16384
+#define STG_RAW_ALIGN_MIN   4096
+#define STG_STRIPE_MAGIC    "OCTSTRP2"
+#define STG_STRIPE_MAX      16
+
+typedef struct {
+    char     magic[8];                 /* STG_RAW_MAGIC                     */
+    uint32_t version;                  /* 1                                 */
+    uint32_t dtype;                    /* tensor_dtype_t                    */
+    uint32_t rank;
+    uint32_t element_size;
+    uint64_t align;                    /* payload alignment                 */
+    uint64_t global_dims[MAX_RANK];
+    uint64_t chunk_dims[MAX_RANK];
+    uint64_t n_tiles;
+    uint64_t tile_bytes;               /* nominal tile payload              */
+    uint64_t slot_bytes;               /* tile_bytes rounded up to align    */
+    uint64_t index_off;
+    uint64_t data_off;
+} stg_raw_header_t;
+
+typedef struct StorageFile   StorageFile;
+typedef struct storage_ops   storage_ops_t;
+
+struct storage_ops {
+    const char *name;
+    /* Open an existing tensor (dset names the HDF5 dataset; ignored by raw). */
+    StorageFile    *(*open)(const char *path, const char *dset, int writable);
+    /* Create (or truncate) a tensor with no tiles and open it read-write. */
+    StorageFile    *(*create)(const char *path, const char *dset, int rank,
+                              const hsize_t *global_dims,
+                              const hsize_t *chunk_dims, tensor_dtype_t dtype);
+    /* Registry with every stored tile ON_DISK and its file_addr/file_bytes. */
+    TensorRegistry *(*scan)(StorageFile *f);
+    /* Tile at phys_offset into buf (a full nominal tile); 0 or -1. */
+    int             (*read_tile)(StorageFile *f, const hsize_t *phys_offset,
+                                 void *buf);
+    /* Store the nominal-strided tile buf at phys_offset; 0 or -1. */
+    int             (*write_tile)(StorageFile *f, const hsize_t *phys_offset,
+                                  const void *buf);
+    /* Store n tiles (offsets off[i], buffers buf[i]) in that order, as
+     * few writes as the format allows; 0 or -1. */
+    int             (*write_tiles)(StorageFile *f, size_t n,
+                                   const hsize_t *const *off,
+                                   const void *const *buf);
+    /* Page-cache hint for stored tile m (see file_advise); a no-op unless
+     * f->hints is set. */
+    void            (*advise)(StorageFile *f, const TileMetadata *m,
+                              int willneed);
+    void            (*close)(StorageFile *f);
+};
+
+/* Common header of every backend's handle. */
+struct StorageFile {
+    const storage_ops_t *ops;
+    int                  rank;
+    tensor_dtype_t       dtype;
+    size_t               element_size;
+    hsize_t              global_dims[MAX_RANK];
+    hsize_t              chunk_dims[MAX_RANK];
+    size_t               tile_bytes;   /* prod(chunk_dims) × element_size  */
+    int                  virtual_tiles;/* chunk_dims chosen, not stored    */
+    int                  hints;        /* advise reaches the page cache    */
+    int                  devices;      /* drives the tiles are spread over */
+};
+
+extern const storage_ops_t stg_hdf5_ops;
+extern const storage_ops_t stg_raw_ops;
+extern const storage_ops_t stg_stripe_ops;
+extern const storage_ops_t stg_retile_ops;
+
+/* Backend for an existing file (by magic), or NULL if unreadable. */
+const storage_ops_t *stg_probe(const char *path);
+
+/* Backend stg_create uses for path (by extension). */
+const storage_ops_t *stg_backend_for(const char *path);
+
+/* Open / create through the matching backend.  NULL on failure. */
+StorageFile *stg_open(const char *path, const char *dset, int writable);
+StorageFile *stg_create(const char *path, const char *dset, int rank,
+                        const hsize_t *global_dims, const hsize_t *chunk_dims,
+                        tensor_dtype_t dtype);
+
+/*
+ * Replace the virtual tiling of f (chunk_dims clamped to the global dims).
+ * Returns 0, or -1 if f's tiling is fixed by the file.
+ */
+int stg_set_tiling(StorageFile *f, const hsize_t *chunk_dims);
+
+/*
+ * View of inner with tiles of chunk_dims (clamped to the global dims; 0
+ * keeps inner's side), read-only until stg_retile_stage.  A tile is
+ * stored if any inner tile it overlaps is.  Takes ownership of inner,
+ * which is closed with the view — or at once if the view cannot be made
+ * (NULL).
+ */
+StorageFile *stg_retile(StorageFile *inner, const hsize_t *chunk_dims);
+
+/*
+ * Make a retile view writable (inner must be).  Inner tiles a write only
+ * partly covers are held until complete, in at most budget_bytes; past
+ * that the oldest are merged into the file (read, overlay, write).  Each
+ * view tile must be written at most once.  Returns 0 or -1.
+ */
+int stg_retile_stage(StorageFile *f, size_t budget_bytes);
+
+/* Merge every held tile into the file.  0 or -1; a no-op for other
+ * backends.  stg_close flushes too, but cannot report errors. */
+int stg_retile_flush(StorageFile *f);
+
+static inline TensorRegistry *stg_scan(StorageFile *f)
+{
+    return f->ops->scan(f);
+}
+static inline int stg_read_tile(StorageFile *f, const hsize_t *off, void *buf)
+{
+    return f->ops->read_tile(f, off, buf);
+}
+static inline int stg_write_tile(StorageFile *f, const hsize_t *off,
+                                 const void *buf)
+{
+    return f->ops->write_tile(f, off, buf);
+}
+static inline int stg_write_tiles(StorageFile *f, size_t n,
+                                  const hsize_t *const *off,
+                                  const void *const *buf)
+{
+    return f->ops->write_tiles(f, n, off, buf);
+}
+static inline void stg_advise(StorageFile *f, const TileMetadata *m,
+                              int willneed)
+{
+    f->ops->advise(f, m, willneed);
+}
+static inline void stg_close(StorageFile *f)
+{
+    if (f) f->ops->close(f);
+}
+
+/*
+ * Copy of the boundary tile buf with everything outside sf's extent
+ * zeroed, or NULL when the tile at off is interior (store buf as is).
+ * Sets *err on allocation failure.
+ */
+void *stg_pad_zero(const StorageFile *sf, const hsize_t *off,
+                   const void *buf, int *err);
+
+/*
+ * Copy every stored tile of src into a new tensor dst with the same shape,
+ * chunking and dtype; dst's format follows stg_backend_for(dst).  Absent
+ * tiles stay absent.  Returns the number of tiles copied, or -1.
+ */
+long stg_convert(const char *src, const char *src_dset,
+                 const char *dst, const char *dst_dset);
+
+#endif /* STORAGE_H */
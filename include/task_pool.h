@@ -0,0 +1,78 @@
+/*
+ * task_pool.h
+ *
+ * Portable work-stealing task runtime used by the einsum executor
+ * (exec_macroblock_gcd) on every platform.
+ *
+ * Each worker owns a Chase-Lev deque: it pushes and pops its own tasks at
+ * the bottom (LIFO, cache-warm), and idle workers steal from the top of a
+ * victim's deque (FIFO, oldest and usually largest work first).  Tasks
+ * submitted from outside the pool go to a shared inbox.  Uneven tasks —
+ * skipped sparse tiles next to full nominal GEMMs — therefore balance
+ * themselves without any static partitioning.
+ *
+ * Tasks may depend on other tasks: a task becomes runnable once it has
+ * been submitted and every predecessor has finished.  This is how the
+ * executor expresses "load B for step cf, then the GEMM rows of step cf,
+ * then reuse the B slot for step cf+2" without barriers.
+ *
+ * The pool is driven by one external thread at a time, which creates and
+ * submits tasks and then calls task_pool_wait(); that thread executes
+ * tasks too while it waits, so a pool with zero workers runs everything
+ * serially on the caller.
+ */
+
+#ifndef TASK_POOL_H
+#define TASK_POOL_H
+
+#include <stddef.h>
+
+typedef struct task_pool task_pool_t;
+typedef struct tp_task   tp_task_t;
+
+/* Task body: arg and idx are the values given to task_pool_task(). */
+typedef void (*tp_fn)(void *arg, size_t idx);
+
+/*
+ * Start a pool with n_workers background threads (< 0 → one fewer than
+ * query_num_threads(), since the waiting caller also runs tasks).
+ * Returns NULL on allocation or thread-creation failure.
+ */
+task_pool_t *task_pool_create(int n_workers);
+
+/* Stop the workers and free the pool.  No tasks may be outstanding. */
+void task_pool_destroy(task_pool_t *pool);
+
+/* Threads that execute tasks: the workers plus the waiting caller. */
+int task_pool_size(const task_pool_t *pool);
+
+/*
+ * Create a task running fn(arg, idx).  It does not run until submitted.
+ * Tasks are owned by the pool and freed by the next task_pool_wait().
+ * Returns NULL on allocation failure.
+ */
+tp_task_t *task_pool_task(task_pool_t *pool, tp_fn fn, void *arg, size_t idx);
+
+/*
+ * Make succ wait for pred (either may be NULL, which is a no-op).  Must be
+ * called before succ is submitted; pred may be running or finished.
+ * Returns 0, or -1 on allocation failure.
+ */
+int task_pool_depend(tp_task_t *succ, tp_task_t *pred);
+
+/* Submit a task; it runs once all its predecessors have finished. */
+void task_pool_submit(task_pool_t *pool, tp_task_t *task);
+
+/*
+ * Run submitted tasks on the calling thread until every submitted task
+ * has finished, then free them.
+ */
+void task_pool_wait(task_pool_t *pool);
+
+/*
+ * Run fn(arg, i) for i in [0, n) as independent tasks and wait.  An index
+ * whose task cannot be allocated runs inline on the caller.
+ */
+void task_pool_parallel_for(task_pool_t *pool, size_t n, tp_fn fn, void *arg);
+
+#endif /* TASK_POOL_H */
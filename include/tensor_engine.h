@@ -2,7 +2,7 @@
  * tensor_engine.h — Public C11 API for the Out-of-Core Tensor Contraction Engine
  *
  * This header is the sole interface a caller needs. All internal details
- * (BufferPool, HDF5 I/O, GCD dispatch, double-buffering) are hidden behind
+ * (BufferPool, HDF5 I/O, task scheduling, double-buffering) are hidden behind
  * the opaque tensor_engine_t pointer.
  *
  * Quick start:
@@ -30,6 +30,7 @@
 #define TENSOR_ENGINE_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -44,6 +45,21 @@ extern "C" {
 /** COMPLEX128: C99 double _Complex (16 bytes per element). */
 #define TENSOR_DTYPE_COMPLEX128  1
 
+/* -------------------------------------------------------------------------
+ * Block-sparsity patterns (tensor_engine_fill_sparse)
+ * -----------------------------------------------------------------------*/
+
+/** Every tile is written. */
+#define TENSOR_SPARSITY_DENSE       0
+/** Each tile independently with probability @c density. */
+#define TENSOR_SPARSITY_RANDOM      1
+/** Tiles whose grid coordinates differ by at most @c bandwidth. */
+#define TENSOR_SPARSITY_BANDED      2
+/** @c n_blocks diagonal blocks of tiles. */
+#define TENSOR_SPARSITY_BLOCK_DIAG  3
+/** Random pattern and contents invariant under any index permutation. */
+#define TENSOR_SPARSITY_SYMMETRIC   4
+
 /* -------------------------------------------------------------------------
  * Error codes
  * All functions that can fail return one of these values.
@@ -68,6 +84,9 @@ extern "C" {
 /** Unspecified internal error (I/O, HDF5, BLAS). */
 #define TENSOR_ENGINE_ERR        -5
 
+/** Verification failed: the result does not match its operands. */
+#define TENSOR_ENGINE_ERR_MISMATCH -6
+
 /* -------------------------------------------------------------------------
  * Configuration
  * -----------------------------------------------------------------------*/
@@ -98,6 +117,23 @@ typedef struct {
      *              granularity on Apple Silicon for optimal BLAS batching.
      */
     size_t tile_bytes;
+
+    /**
+     * Node-local shared B tile cache in MiB (see README, TENSOR_SHM_CACHE_MB).
+     *
+     * Default (0): the TENSOR_SHM_CACHE_MB environment variable, else off.
+     */
+    size_t shm_cache_mb;
+
+    /**
+     * Keep the contraction executor's task pool, I/O thread and cache
+     * buffers alive between calls instead of rebuilding them per call.
+     * Meant for long-lived callers such as the job server; the buffers
+     * stay resident until tensor_engine_free().
+     *
+     * Default (0): each contraction sets up and tears down its own.
+     */
+    int keep_warm;
 } tensor_engine_config_t;
 
 /* -------------------------------------------------------------------------
@@ -165,6 +201,28 @@ int tensor_engine_contract(tensor_engine_t *engine,
                            const char      *file_B,
                            const char      *file_C);
 
+/**
+ * tensor_engine_contract_chunked — contraction with a chosen output chunking.
+ *
+ * Same as tensor_engine_contract(), but @p file_C is chunked as
+ * @p c_chunk_dims (one side per output index, clamped to the output shape)
+ * instead of inheriting the operands' tiling — e.g. to match the access
+ * pattern of the next contraction that reads it.  The engine still
+ * accumulates in its natural tiles; writes are split or gathered into the
+ * requested chunks on the way out.
+ *
+ * @param c_chunk_dims  Chunk side per output index, or NULL for the
+ *                      natural chunking.
+ *
+ * @return  TENSOR_ENGINE_OK (0) on success, or a negative error code.
+ */
+int tensor_engine_contract_chunked(tensor_engine_t *engine,
+                                   const char      *einsum_expr,
+                                   const char      *file_A,
+                                   const char      *file_B,
+                                   const char      *file_C,
+                                   const size_t    *c_chunk_dims);
+
 /**
  * tensor_engine_accumulate — accumulating out-of-core N-D tensor contraction.
  *
@@ -194,6 +252,109 @@ int tensor_engine_accumulate(tensor_engine_t *engine,
                              const char      *file_B,
                              const char      *file_C);
 
+/* -------------------------------------------------------------------------
+ * Elementwise expressions
+ * -----------------------------------------------------------------------*/
+
+/**
+ * tensor_engine_elementwise — out-of-core elementwise expression.
+ *
+ * Evaluates @p expr over co-tiled tensors (same shape, chunk shape and
+ * dtype) and stores the result in @p file_out.  Operands are upper-case
+ * letters: @c A is @p files_in[0], @c B is @p files_in[1], and so on.
+ * Real literals, @c + @c - @c * @c /, unary minus and parentheses are
+ * supported, which covers axpy, scaling, Hadamard products and divides:
+ *
+ * @code
+ *   // Amplitude update T = T + R / D, in place.
+ *   const char *in[] = { "T.h5", "R.h5", "D.h5" };
+ *   tensor_engine_elementwise(eng, "A + B / C", in, 3, "T.h5");
+ *
+ *   // Y = 2 X + Y into a new file.
+ *   const char *xy[] = { "X.h5", "Y.h5" };
+ *   tensor_engine_elementwise(eng, "2 * A + B", xy, 2, "Z.h5");
+ * @endcode
+ *
+ * If @p file_out is one of the inputs it is updated in place; otherwise it
+ * is created (or overwritten) with the inputs' shape and chunking.
+ *
+ * Tiles flow through a reader → parallel compute → writer pipeline, so
+ * disk I/O overlaps the arithmetic.  Block sparsity is preserved: absent
+ * input tiles are zero, and output tiles that are structurally zero (e.g.
+ * both operands of a sum absent) are neither computed nor written.
+ *
+ * @param engine    Engine handle.
+ * @param expr      Expression over operands A … H.
+ * @param files_in  Array of @p n_in input paths (dataset "tensor").
+ * @param n_in      Number of inputs (1 ≤ n_in ≤ 8).
+ * @param file_out  Output path.
+ *
+ * @return TENSOR_ENGINE_OK on success, TENSOR_ENGINE_ERR_EXPR for a bad
+ *         expression, TENSOR_ENGINE_ERR_DIMS if inputs are not co-tiled,
+ *         or another negative error code.
+ */
+int tensor_engine_elementwise(tensor_engine_t    *engine,
+                              const char         *expr,
+                              const char *const  *files_in,
+                              int                 n_in,
+                              const char         *file_out);
+
+/* -------------------------------------------------------------------------
+ * Result verification
+ * -----------------------------------------------------------------------*/
+
+/**
+ * tensor_engine_verify_t — parameters and results of tensor_engine_verify().
+ *
+ * Zero-initialise, optionally set the inputs, and read the outputs after
+ * the call.
+ */
+typedef struct {
+    /* Inputs (0 → default) */
+    int      n_vectors;    /**< Random vectors per check (default 2).      */
+    uint64_t seed;         /**< Vector seed.                               */
+    double   rtol;         /**< Relative tolerance (default 1e-9).         */
+
+    /* Outputs */
+    double   max_abs_err;  /**< Largest |A·(B·x) − C·x| element.           */
+    double   max_rel_err;  /**< Same, relative to |A|·|B|·|x| + |C|·|x|.   */
+    size_t   n_checked;    /**< Elements compared.                         */
+    size_t   n_failed;     /**< Elements over tolerance.                   */
+    double   seconds;      /**< Wall time.                                 */
+} tensor_engine_verify_t;
+
+/**
+ * tensor_engine_verify — randomized check that C = einsum(expr, A, B).
+ *
+ * Freivalds' algorithm generalised to tensors: draws random vectors x over
+ * the free indices of B and compares C·x with A·(B·x).  Each of A, B and C
+ * is streamed once, tile by tile and in parallel, so verification costs
+ * about as much I/O as reading the three files — not a recomputation.
+ * Block-sparse tiles are skipped.
+ *
+ * An incorrect C passes only if every error happens to be orthogonal to all
+ * random vectors (probability 0 in exact arithmetic) or is smaller than
+ * @c rtol relative to the magnitudes summed into it.  RAM use is a few
+ * vectors over the free and contracted index spaces, e.g. 340² elements
+ * for "ijab,akbl->klji" with 340⁴ tensors.
+ *
+ * @param engine  Engine handle.
+ * @param expr    The einsum expression used to produce @p file_C.
+ * @param file_A  Operand A (dataset "tensor").
+ * @param file_B  Operand B (dataset "tensor").
+ * @param file_C  Result to check (dataset "tensor").
+ * @param v       Parameters in, statistics out; may be NULL for defaults.
+ *
+ * @return TENSOR_ENGINE_OK if C passes, TENSOR_ENGINE_ERR_MISMATCH if it
+ *         does not, or another negative error code.
+ */
+int tensor_engine_verify(tensor_engine_t        *engine,
+                         const char             *expr,
+                         const char             *file_A,
+                         const char             *file_B,
+                         const char             *file_C,
+                         tensor_engine_verify_t *v);
+
 /**
  * tensor_engine_strerror — human-readable description of an error code.
  *
@@ -240,6 +401,10 @@ int tensor_engine_create(tensor_engine_t *engine,
  * the given scalar.  After this call each element equals @p value and all
  * tiles are allocated on disk (the tensor is dense, not block-sparse).
  *
+ * Tiles are produced by TENSOR_NUM_THREADS threads (default: online CPUs)
+ * and streamed to disk by a single writer thread, using direct chunk
+ * writes when the dataset has no filters.
+ *
  * @param engine     Engine handle.
  * @param file_path  Path to an HDF5 file containing a "tensor" dataset.
  * @param value      Pointer to the fill scalar:
@@ -253,6 +418,62 @@ int tensor_engine_fill(tensor_engine_t *engine,
                        const char      *file_path,
                        const void      *value);
 
+/**
+ * tensor_engine_fill_random — fill every tile with seeded random values.
+ *
+ * Like tensor_engine_fill() but each element is uniform in [-1, 1).  For
+ * COMPLEX128 the real and imaginary parts are drawn independently.  Tile t
+ * (flat row-major index) is generated from its own stream derived from
+ * (@p seed, t), so the result is identical for any thread count and any
+ * tile can be regenerated independently for validation.
+ *
+ * @param engine     Engine handle.
+ * @param file_path  Path to an HDF5 file containing a "tensor" dataset.
+ * @param seed       Stream seed.
+ *
+ * @return TENSOR_ENGINE_OK on success, or a negative error code.
+ */
+int tensor_engine_fill_random(tensor_engine_t *engine,
+                              const char      *file_path,
+                              uint64_t         seed);
+
+/**
+ * tensor_engine_sparsity_t — tile selection for tensor_engine_fill_sparse().
+ */
+typedef struct {
+    int      pattern;    /**< One of the TENSOR_SPARSITY_* constants.      */
+    double   density;    /**< RANDOM / SYMMETRIC: tile fraction in [0, 1]. */
+    int      bandwidth;  /**< BANDED: max spread of tile coordinates.      */
+    int      n_blocks;   /**< BLOCK_DIAG: number of diagonal blocks.       */
+    uint64_t seed;       /**< Selection and contents seed.                 */
+} tensor_engine_sparsity_t;
+
+/**
+ * tensor_engine_fill_sparse — write a block-sparse random tensor.
+ *
+ * Writes only the tiles selected by @p sparsity; the remaining tiles stay
+ * unallocated and are treated as zero by every operation.  Selected tiles
+ * receive the same contents as tensor_engine_fill_random() with the same
+ * seed, except for TENSOR_SPARSITY_SYMMETRIC, whose elements satisfy
+ * T[x] == T[perm(x)] (all extents and tile sides must then be equal).
+ * Selection depends only on (pattern, seed, tile coordinates), so the
+ * result is reproducible for any thread count.
+ *
+ * The dataset should be freshly created: tiles already on disk that are
+ * not selected are left untouched.
+ *
+ * @param engine     Engine handle.
+ * @param file_path  Path to an HDF5 file containing a "tensor" dataset.
+ * @param sparsity   Pattern description.
+ *
+ * @return TENSOR_ENGINE_OK on success, TENSOR_ENGINE_ERR_DIMS if the
+ *         pattern parameters are invalid or do not fit the tensor, or
+ *         another negative error code.
+ */
+int tensor_engine_fill_sparse(tensor_engine_t                *engine,
+                              const char                     *file_path,
+                              const tensor_engine_sparsity_t *sparsity);
+
 #ifdef __cplusplus
 }
 #endif
@@ -57,7 +57,11 @@ herr_t write_chunk_fast(hid_t dset_id, const hsize_t *phys_offset,
  * Create a new HDF5 file containing one chunked, double-precision dataset.
  * Chunk size is derived from target_chunk_bytes.
  * Incremental allocation is used so unwritten chunks consume no disk space
- * (block-sparse layout).
+ * (block-sparse layout).  Chunks start on 16 KiB page boundaries (4 KiB for
+ * smaller chunks); TENSOR_H5_ALIGN, TENSOR_H5_PAGED, TENSOR_H5_META_BLOCK
+ * and TENSOR_H5_PREALLOC tune the layout (see create_tensor_file and
+ * set_chunk_alloc in tensor_store.c).  The default paged layout needs
+ * HDF5 1.10 or newer to read.
  *
  * Returns 0 on success, -1 on failure.
  */
@@ -87,6 +91,22 @@ herr_t create_chunked_dataset_explicit(const char *filename,
  */
 hid_t dset_open_no_cache(hid_t file_id, const char *dset_name);
 
+/* ----------------------------------------------------------------------- */
+/* Thread safety                                                            */
+/* ----------------------------------------------------------------------- */
+
+/*
+ * Process-wide HDF5 lock.
+ *
+ * Most HDF5 builds (including the Homebrew bottle) are compiled without
+ * --enable-threadsafe, so concurrent H5D* calls from different threads
+ * corrupt library state.  Any code that issues HDF5 calls from more than
+ * one thread must bracket each call sequence with tensor_store_lock() /
+ * tensor_store_unlock().  The lock is not recursive.
+ */
+void tensor_store_lock(void);
+void tensor_store_unlock(void);
+
 /* ----------------------------------------------------------------------- */
 /* Complex type support                                                     */
 /* ----------------------------------------------------------------------- */
@@ -128,6 +148,49 @@ herr_t write_chunk_typed(hid_t dset_id, const hsize_t *phys_offset,
                          int rank, const hsize_t *chunk_dims,
                          hid_t mem_type);
 
+/* ----------------------------------------------------------------------- */
+/* Direct chunk I/O                                                         */
+/* ----------------------------------------------------------------------- */
+
+/*
+ * Return 1 if whole chunks of dset can be transferred as raw bytes from a
+ * buffer laid out as mem_type: the dataset is chunked, has no filters, and
+ * its file type is identical to mem_type (no conversion needed).
+ * Returns 0 otherwise (including on error).
+ */
+int dset_supports_direct_io(hid_t dset_id, hid_t mem_type);
+
+/*
+ * Write one full nominal chunk of nbytes raw bytes with H5Dwrite_chunk,
+ * bypassing hyperslab selection and type conversion.  Valid only when
+ * dset_supports_direct_io() returned 1.  Boundary chunks are stored at
+ * full nominal size; the caller should zero the padding region so later
+ * direct reads see clean data.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+herr_t write_chunk_direct(hid_t dset_id, const hsize_t *phys_offset,
+                          const void *data_ptr, size_t nbytes);
+
+/* ----------------------------------------------------------------------- */
+/* Page-cache hints                                                         */
+/* ----------------------------------------------------------------------- */
+
+/*
+ * POSIX file descriptor behind an open dataset's file when it uses the
+ * default sec2 driver, or -1 (other drivers, or on error).  The descriptor
+ * belongs to HDF5: do not close it.
+ */
+int dset_posix_fd(hid_t dset_id);
+
+/*
+ * Advise the kernel about bytes [addr, addr + len) of fd: willneed = 1
+ * starts asynchronous readahead, 0 lets the page cache drop them.  A
+ * no-op for fd < 0, an undefined address, or where the platform has no
+ * such hint.
+ */
+void file_advise(int fd, haddr_t addr, hsize_t len, int willneed);
+
 /* ----------------------------------------------------------------------- */
 /* Typed dataset creation (for einsum engine)                              */
 /* ----------------------------------------------------------------------- */
@@ -0,0 +1,113 @@
+/*
+ * tile_kernels.h
+ *
+ * Tile-level compute kernels shared by the contraction engine and the
+ * validators, so a reference recomputation runs exactly the arithmetic the
+ * engine runs.
+ *
+ * tile_gemm dispatches to the compiled-in BLAS (Accelerate, MKL, OpenBLAS);
+ * without BLAS it falls back to portable scalar loops.
+ *
+ * Packed A operands: an A tile that is multiplied against many B tiles can
+ * be packed once into the GEMM's internal panel format and reused, so the
+ * per-call repacking disappears from the hot loop.  MKL provides this via
+ * cblas_dgemm_pack / cblas_dgemm_compute (FP64 only); the scalar fallback
+ * packs A into MR-row panels consumed by a register-blocked micro-kernel.
+ * Other backends (OpenBLAS, Accelerate) expose no pack API, so
+ * tile_gemm_pack_size() reports 0 and callers keep the plain path.
+ *
+ * Planar complex operands: a COMPLEX128 tile may instead be held as two
+ * real planes (all real parts, then all imaginary parts).  A planar
+ * product runs the 3M scheme — three real GEMMs on the planes instead of
+ * one complex GEMM, i.e. 3 real multiplies per complex multiply-add
+ * instead of 4 — so it goes through the backend's (usually faster) real
+ * GEMM and the surrounding element loops stay stride-1 on doubles.
+ */
+
+#ifndef TILE_KERNELS_H
+#define TILE_KERNELS_H
+
+#include "registry.h"   /* tensor_dtype_t */
+#include <stddef.h>
+
+/*
+ * Row-major C[0:M, 0:N] (+)= A[0:M, 0:K] × B[0:K, 0:N] for FP64 or
+ * COMPLEX128 buffers with leading dimensions lda / ldb / ldc (elements).
+ *
+ *   accumulate = 0 : C  = A·B   (C need not be initialised)
+ *   accumulate = 1 : C += A·B
+ */
+void tile_gemm(tensor_dtype_t dtype, int M, int N, int K,
+               const void *A, int lda,
+               const void *B, int ldb,
+               void *C, int ldc, int accumulate);
+
+/*
+ * Bytes needed for a packed M×K A operand used with N-column B operands,
+ * or 0 if this backend cannot pack dtype.
+ */
+size_t tile_gemm_pack_size(tensor_dtype_t dtype, int M, int N, int K);
+
+/* Short backend name for the packed path ("MKL packed GEMM", ...). */
+const char *tile_gemm_pack_name(void);
+
+/*
+ * Pack row-major A[0:M, 0:K] (leading dimension lda) into Ap, which must
+ * hold tile_gemm_pack_size(dtype, M, N, K) bytes.
+ */
+void tile_gemm_pack_a(tensor_dtype_t dtype, int M, int N, int K,
+                      const void *A, int lda, void *Ap);
+
+/*
+ * tile_gemm with A given as a packed operand from tile_gemm_pack_a, for
+ * the M, N and K it was packed with; see tile_gemm_packed_any_n.
+ */
+void tile_gemm_packed(tensor_dtype_t dtype, int M, int N, int K,
+                      const void *Ap,
+                      const void *B, int ldb,
+                      void *C, int ldc, int accumulate);
+
+/*
+ * 1 if this backend's packed A may also be applied to B operands wider
+ * than the N it was packed with (the engine micro-kernel), 0 if not
+ * (MKL: cblas_dgemm_compute must see the packing m, n, k).
+ */
+int tile_gemm_packed_any_n(void);
+
+/*
+ * Bytes of a planar A operand for an M×K complex tile: the real plane,
+ * the imaginary plane and their sum, each M×K doubles with leading
+ * dimension K.
+ */
+size_t tile_zplanar_a_size(int M, int K);
+
+/*
+ * Build the planar A operand Ap (tile_zplanar_a_size(M, K) bytes) from an
+ * interleaved complex row-major A[0:M, 0:K] with leading dimension lda.
+ */
+void tile_zplanar_pack_a(int M, int K, const void *A, int lda, double *Ap);
+
+/*
+ * Split an interleaved complex rows×cols block (leading dimension lds,
+ * complex elements) into real and imaginary planes with leading
+ * dimension ldp (doubles).
+ */
+void tile_zplanar_split(int rows, int cols, const void *src, int lds,
+                        double *re, double *im, int ldp);
+
+/*
+ * Planar C = A·B (beta = 0) by the 3M scheme:
+ *
+ *   Cr = Ar·Br − Ai·Bi
+ *   Ci = (Ar+Ai)·(Br+Bi) − Ar·Br − Ai·Bi
+ *
+ * Ap comes from tile_zplanar_pack_a (leading dimension K); B and C are
+ * given as separate planes with leading dimensions ldb / ldc.  The
+ * Br+Bi sum lives in a per-thread scratch that grows on demand and is
+ * freed when the thread exits.
+ */
+void tile_gemm_zplanar(int M, int N, int K, const double *Ap,
+                       const double *Br, const double *Bi, int ldb,
+                       double *Cr, double *Ci, int ldc);
+
+#endif /* TILE_KERNELS_H */
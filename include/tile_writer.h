@@ -0,0 +1,95 @@
+/*
+ * tile_writer.h
+ *
+ * Parallel tile writer shared by tensor_engine_fill() and the generator
+ * tools.  N producer threads generate tile contents into BufferPool pages;
+ * a single writer thread (wq_writer_main) drains them to HDF5 through a
+ * WriteQueue, so generation overlaps I/O and HDF5 is only ever entered from
+ * one thread.
+ *
+ * Contents are one of:
+ *   TW_FILL_CONST    — one scalar broadcast to every element
+ *   TW_FILL_RANDOM   — uniform [-1, 1) values from a per-tile seed,
+ *                      rng_derive(seed, tile_index); identical for any
+ *                      number of producer threads
+ *   TW_FILL_CALLBACK — a user function fills each tile
+ *
+ * An optional selection callback restricts which tiles are written; the
+ * rest stay unallocated (block-sparse).
+ */
+
+#ifndef TILE_WRITER_H
+#define TILE_WRITER_H
+
+#include <hdf5.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "registry.h"
+
+typedef enum {
+    TW_FILL_CONST = 0,
+    TW_FILL_RANDOM,
+    TW_FILL_CALLBACK
+} tw_fill_t;
+
+/*
+ * Fill buf (a nominal chunk_dims-strided tile of reg->dtype) with the
+ * contents of tile tile_index (flat row-major index into reg->tiles).
+ * Called concurrently from several producer threads.  Return 0 on success.
+ */
+typedef int (*tw_tile_fn)(void *buf, const TensorRegistry *reg,
+                          size_t tile_index, void *user);
+
+/* Return 1 to write tile tile_index, 0 to leave it unallocated. */
+typedef int (*tw_select_fn)(const TensorRegistry *reg, size_t tile_index,
+                            void *user);
+
+typedef struct {
+    tw_fill_t     fill;
+    const void   *value;        /* TW_FILL_CONST: one element of reg->dtype */
+    uint64_t      seed;         /* TW_FILL_RANDOM                          */
+    tw_tile_fn    tile_fn;      /* TW_FILL_CALLBACK                        */
+    void         *tile_user;
+    tw_select_fn  select;       /* NULL → every tile                       */
+    void         *select_user;
+    int           n_producers;  /* 0 → query_num_threads()                 */
+    int           direct;       /* 1 → H5Dwrite_chunk when the dataset
+                                   allows it (no filters, same type)        */
+    int           progress;     /* 1 → progress line on stdout             */
+} tile_writer_opts_t;
+
+typedef struct {
+    size_t tiles;               /* tiles written                           */
+    size_t bytes;               /* nominal tile bytes written              */
+    double seconds;             /* wall time                               */
+    int    direct;              /* 1 if direct chunk writes were used      */
+} tile_writer_stats_t;
+
+/*
+ * Write tiles of dset (described by reg, which may be freshly created and
+ * unscanned) according to opts.  mem_type is the HDF5 memory type for
+ * reg->dtype.  stats may be NULL.
+ *
+ * Returns 0 on success, -1 on I/O or callback failure, -4 on allocation
+ * failure.
+ */
+int tile_writer_run(hid_t dset, const TensorRegistry *reg, hid_t mem_type,
+                    const tile_writer_opts_t *opts,
+                    tile_writer_stats_t *stats);
+
+/*
+ * Generate the TW_FILL_RANDOM contents of tile tile_index into buf.
+ * Exposed so validators can regenerate any tile without reading it.
+ * Padding beyond the tensor extent is zeroed.
+ */
+void tile_fill_random(void *buf, const TensorRegistry *reg,
+                      size_t tile_index, uint64_t seed);
+
+/*
+ * Zero the region of a nominal tile buffer that lies outside the tensor
+ * extent (no-op for interior tiles).
+ */
+void tile_zero_padding(void *buf, const TensorRegistry *reg,
+                       size_t tile_index);
+
+#endif /* TILE_WRITER_H */
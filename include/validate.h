@@ -0,0 +1,63 @@
+/*
+ * validate.h
+ *
+ * Sampled-tile ground-truth check of C = einsum(expr, A, B), the native
+ * counterpart of tools/validate_contraction.py.
+ *
+ * Each selected C tile is recomputed from hyperslabs of A and B: the
+ * contracted indices are walked block by block (A's chunk size along each
+ * index), every block is permuted into [free_A | contracted] and
+ * [contracted | free_B] and multiplied with the engine's tile_gemm, and
+ * the stored tile is compared against the product.  Tiles are checked by
+ * TENSOR_NUM_THREADS workers.
+ *
+ * Tile selection follows the Python tool: the corner tile, the last tile,
+ * the centre tile, then seeded random tiles up to the requested count.
+ *
+ * Error metric (per tile):
+ *   max_abs = max |C - ref|
+ *   max_rel = max_abs / max |ref|      (normwise; max_abs when ref == 0)
+ * A tile fails when max_rel > rtol.
+ */
+
+#ifndef VALIDATE_H
+#define VALIDATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    long        n_tiles;   /* tiles to check: 0 → 5, < 0 → all          */
+    double      rtol;      /* tolerance on max_rel (0 → 1e-9)           */
+    uint64_t    seed;      /* random tile selection (0 → 42)            */
+    int         verbose;   /* 0: summary, 1: one line per tile,         */
+                           /* 2: also the worst element of failed tiles  */
+    const char *dset_A;    /* dataset names (NULL → "tensor")           */
+    const char *dset_B;
+    const char *dset_C;
+} validate_opts_t;
+
+typedef struct {
+    size_t n_checked;      /* tiles compared                            */
+    size_t n_failed;       /* tiles over tolerance                      */
+    double max_abs_err;    /* worst over all checked tiles              */
+    double max_rel_err;
+    double seconds;        /* wall time                                 */
+} validate_report_t;
+
+/*
+ * Check sampled (or all) C tiles against a recomputation from A and B.
+ * opts may be NULL (defaults); report may be NULL.  Per-tile lines are
+ * printed to stdout when opts->verbose > 0.
+ *
+ * Returns 0 if every checked tile passes, 1 on mismatch, -1 on I/O error,
+ * -2 on incompatible shapes or dtypes, -3 on a malformed expression,
+ * -4 on allocation failure.
+ */
+int validate_contraction(const char *expr,
+                         const char *file_A, const char *file_B,
+                         const char *file_C,
+                         const validate_opts_t *opts,
+                         validate_report_t *report);
+
+#endif /* VALIDATE_H */
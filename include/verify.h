@@ -0,0 +1,68 @@
+/*
+ * verify.h
+ *
+ * Freivalds-style randomized check of an out-of-core contraction result.
+ *
+ * For C = einsum(expr, A, B) with index classes
+ *   free_A (in A and C), free_B (in B and C), contracted (in A and B),
+ * draw k random vectors x over free_B and compare
+ *
+ *   w = C·x          (sum over free_B)           — one pass over C
+ *   z = A·(B·x)      (y = B·x over contracted,   — one pass over B,
+ *                     z = A·y over free_A)          one pass over A
+ *
+ * Each tensor is streamed once, tile by tile, so the cost is O(|A|+|B|+|C|)
+ * I/O and flops instead of recomputing the contraction.  Unallocated
+ * (block-sparse) tiles are skipped.  Vectors are held in RAM: x, y, z and w
+ * together take 2·k·(|free_B| + |contracted| + 2·|free_A|) doubles per
+ * worker thread (complex and absolute-value accumulators).
+ *
+ * With exact arithmetic a wrong C survives a random real x with
+ * probability 0; in floating point an error is reported when
+ * |z - w| > rtol · (|A|·|B|·|x| + |C|·|x|) for any element, the bound a
+ * correct result satisfies up to rounding of the sums.
+ */
+
+#ifndef VERIFY_H
+#define VERIFY_H
+
+#include <hdf5.h>     /* hsize_t */
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    int      n_vectors;   /* independent random vectors k (0 → 2)         */
+    uint64_t seed;        /* vector seed                                  */
+    double   rtol;        /* relative tolerance (0 → 1e-9)                */
+} verify_opts_t;
+
+typedef struct {
+    double max_abs_err;   /* max |z - w| over all elements and vectors    */
+    double max_rel_err;   /* max |z - w| / (|A||B||x| + |C||x|)           */
+    size_t n_checked;     /* elements of z compared (|free_A| · k)        */
+    size_t n_failed;      /* elements over tolerance                      */
+    double seconds;       /* wall time                                    */
+} verify_report_t;
+
+/*
+ * Check that the "tensor" dataset in file_C equals einsum(expr, A, B).
+ * opts may be NULL (defaults); report may be NULL.
+ *
+ * Returns 0 if the check passes, 1 if C does not match, -1 on I/O error,
+ * -2 on incompatible shapes, -3 on a malformed expression, -4 on
+ * allocation failure.
+ */
+int verify_contraction(const char *expr,
+                       const char *file_A, const char *file_B,
+                       const char *file_C,
+                       const verify_opts_t *opts,
+                       verify_report_t *report);
+
+/*
+ * Record extent e for index letter c in ext_of (indexed c - 'a', 0 =
+ * unset).  Returns -2, reported on stderr under caller's name, if c
+ * already has a different extent.  Shared with validate_contraction.
+ */
+int verify_set_extent(hsize_t *ext_of, char c, hsize_t e, const char *caller);
+
+#endif /* VERIFY_H */
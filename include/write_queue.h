@@ -63,4 +63,35 @@ write_task_t wq_pop(WriteQueue *wq);
  */
 void         wq_push_sentinel(WriteQueue *wq);
 
+/* ----------------------------------------------------------------------- */
+/* Writer thread                                                            */
+/* ----------------------------------------------------------------------- */
+
+/*
+ * Context for wq_writer_main.  Filled by the caller before pthread_create
+ * and owned by the caller; the writer only updates n_written.
+ *
+ * Each popped task is written with write_chunk_typed(dset, phys_off, ...)
+ * — or write_chunk_direct() when direct is set — under tensor_store_lock(),
+ * then its page is returned to owning_pool (skipped when owning_pool is
+ * NULL).  On any write failure wq->err is set and the writer keeps draining
+ * so producers never block on a full ring.
+ */
+typedef struct {
+    WriteQueue *wq;
+    hid_t       dset;
+    int         rank;
+    hsize_t     chunk_dims[MAX_RANK];
+    size_t      element_size;
+    hid_t       mem_type;
+    int         direct;         /* 1 → H5Dwrite_chunk of the nominal tile  */
+    /* Optional progress hook, called after every successful write. */
+    void      (*on_write)(void *user, size_t n_written);
+    void       *on_write_user;
+    size_t      n_written;      /* tiles successfully written (output)     */
+} wq_writer_t;
+
+/* pthread entry point; arg is a wq_writer_t*.  Returns at the sentinel. */
+void        *wq_writer_main(void *arg);
+
 #endif /* WRITE_QUEUE_H */
@@ -0,0 +1,767 @@
+/*
+ * elementwise.c — out-of-core elementwise expression engine.
+ *
+ * Three stages connected by bounded queues:
+ *
+ *   reader thread   registry order → pool pages ← read_chunk_typed
+ *        ↓ ew_job_t ring (EW_QUEUE_DEPTH)
+ *   compute threads ew_eval_fp64 / ew_eval_c128, in place on a pool page
+ *        ↓ WriteQueue
+ *   writer thread   wq_writer_main → write_chunk_typed → pool_release
+ *
+ * HDF5 calls from the reader and writer are serialised by
+ * tensor_store_lock().  The pool itself is not thread-safe, so every
+ * acquire/release happens under pool_mu.
+ */
+
+#include "elementwise.h"
+#include "engine.h"
+#include "memory.h"
+#include "registry.h"
+#include "tensor_store.h"
+#include "write_queue.h"
+
+#include <hdf5.h>
+#include <ctype.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/* NVMe page alignment for pool pages — matches engine.c. */
+#define EW_PAGE_ALIGN     16384UL
+
+/* Elements per evaluation block: small enough that the whole operand stack
+ * stays in L1/L2, large enough to amortise the interpreter dispatch. */
+#define EW_BLOCK          512
+
+/* Maximum evaluation stack depth (bounded by EW_MAX_PROG anyway). */
+#define EW_MAX_STACK      16
+
+/* Reader → compute ring capacity and writer ring capacity (tiles). */
+#define EW_QUEUE_DEPTH    8
+#define EW_WQ_CAP         4
+
+/* ----------------------------------------------------------------------- */
+/* Expression compiler (recursive descent → postfix)                        */
+/* ----------------------------------------------------------------------- */
+
+typedef struct {
+    const char   *p;
+    ew_program_t *prog;
+    int           err;
+} ew_parser_t;
+
+static void ew_skip_ws(ew_parser_t *ps)
+{
+    while (*ps->p && isspace((unsigned char)*ps->p)) ps->p++;
+}
+
+static void ew_emit(ew_parser_t *ps, ew_opcode_t op, int operand, double v)
+{
+    ew_program_t *pr = ps->prog;
+
+    /* Constant folding on the tail of the instruction stream. */
+    if (op == EW_OP_NEG && pr->n_instr >= 1 &&
+        pr->code[pr->n_instr - 1].op == EW_OP_CONST) {
+        pr->code[pr->n_instr - 1].value = -pr->code[pr->n_instr - 1].value;
+        return;
+    }
+    if (op >= EW_OP_ADD && op <= EW_OP_DIV && pr->n_instr >= 2 &&
+        pr->code[pr->n_instr - 1].op == EW_OP_CONST &&
+        pr->code[pr->n_instr - 2].op == EW_OP_CONST) {
+        double a = pr->code[pr->n_instr - 2].value;
+        double b = pr->code[pr->n_instr - 1].value;
+        double r = (op == EW_OP_ADD) ? a + b :
+                   (op == EW_OP_SUB) ? a - b :
+                   (op == EW_OP_MUL) ? a * b : a / b;
+        pr->n_instr--;
+        pr->code[pr->n_instr - 1].value = r;
+        return;
+    }
+
+    if (pr->n_instr >= EW_MAX_PROG) { ps->err = 1; return; }
+    ew_instr_t *in = &pr->code[pr->n_instr++];
+    in->op      = op;
+    in->operand = operand;
+    in->value   = v;
+}
+
+static void ew_parse_expr(ew_parser_t *ps);
+
+static void ew_parse_primary(ew_parser_t *ps)
+{
+    ew_skip_ws(ps);
+    char c = *ps->p;
+
+    if (c == '(') {
+        ps->p++;
+        ew_parse_expr(ps);
+        ew_skip_ws(ps);
+        if (*ps->p != ')') { ps->err = 1; return; }
+        ps->p++;
+    } else if (c >= 'A' && c < 'A' + EW_MAX_INPUTS) {
+        int k = c - 'A';
+        ps->p++;
+        if (isalnum((unsigned char)*ps->p)) { ps->err = 1; return; }
+        ew_emit(ps, EW_OP_LOAD, k, 0.0);
+        if (k + 1 > ps->prog->n_inputs) ps->prog->n_inputs = k + 1;
+    } else if (isdigit((unsigned char)c) || c == '.') {
+        char  *end;
+        double v = strtod(ps->p, &end);
+        if (end == ps->p) { ps->err = 1; return; }
+        ps->p = end;
+        ew_emit(ps, EW_OP_CONST, 0, v);
+    } else {
+        ps->err = 1;
+    }
+}
+
+static void ew_parse_unary(ew_parser_t *ps)
+{
+    ew_skip_ws(ps);
+    if (*ps->p == '-') {
+        ps->p++;
+        ew_parse_unary(ps);
+        ew_emit(ps, EW_OP_NEG, 0, 0.0);
+    } else if (*ps->p == '+') {
+        ps->p++;
+        ew_parse_unary(ps);
+    } else {
+        ew_parse_primary(ps);
+    }
+}
+
+static void ew_parse_term(ew_parser_t *ps)
+{
+    ew_parse_unary(ps);
+    for (;;) {
+        if (ps->err) return;
+        ew_skip_ws(ps);
+        char c = *ps->p;
+        if (c != '*' && c != '/') return;
+        ps->p++;
+        ew_parse_unary(ps);
+        ew_emit(ps, c == '*' ? EW_OP_MUL : EW_OP_DIV, 0, 0.0);
+    }
+}
+
+static void ew_parse_expr(ew_parser_t *ps)
+{
+    ew_parse_term(ps);
+    for (;;) {
+        if (ps->err) return;
+        ew_skip_ws(ps);
+        char c = *ps->p;
+        if (c != '+' && c != '-') return;
+        ps->p++;
+        ew_parse_term(ps);
+        ew_emit(ps, c == '+' ? EW_OP_ADD : EW_OP_SUB, 0, 0.0);
+    }
+}
+
+int ew_compile(const char *expr, ew_program_t *prog)
+{
+    if (!expr || !prog) return -1;
+    memset(prog, 0, sizeof(*prog));
+
+    ew_parser_t ps = { expr, prog, 0 };
+    ew_parse_expr(&ps);
+    ew_skip_ws(&ps);
+    if (ps.err || *ps.p != '\0' || prog->n_instr == 0) return -1;
+
+    /* Stack depth check. */
+    int depth = 0;
+    for (int i = 0; i < prog->n_instr; i++) {
+        switch (prog->code[i].op) {
+        case EW_OP_LOAD:
+        case EW_OP_CONST: depth++; break;
+        case EW_OP_NEG:   break;
+        default:          depth--; break;
+        }
+        if (depth > prog->max_depth) prog->max_depth = depth;
+    }
+    if (depth != 1 || prog->max_depth > EW_MAX_STACK) return -1;
+    return 0;
+}
+
+/* ----------------------------------------------------------------------- */
+/* Structural-zero analysis                                                 */
+/* ----------------------------------------------------------------------- */
+
+int ew_tile_is_zero(const ew_program_t *prog, const int *present)
+{
+    int z[EW_MAX_STACK];
+    int sp = 0;
+
+    for (int i = 0; i < prog->n_instr; i++) {
+        const ew_instr_t *in = &prog->code[i];
+        switch (in->op) {
+        case EW_OP_LOAD:  z[sp++] = !present[in->operand]; break;
+        case EW_OP_CONST: z[sp++] = (in->value == 0.0);    break;
+        case EW_OP_NEG:   break;
+        case EW_OP_ADD:
+        case EW_OP_SUB:   sp--; z[sp - 1] = z[sp - 1] && z[sp]; break;
+        case EW_OP_MUL:   sp--; z[sp - 1] = z[sp - 1] || z[sp]; break;
+        case EW_OP_DIV:   sp--; break;
+        }
+    }
+    return z[0];
+}
+
+/* ----------------------------------------------------------------------- */
+/* Blocked stack evaluator                                                  */
+/*                                                                           */
+/* Each stack entry is either a vector (pointer into an input tile or a     */
+/* scratch block) or a scalar, so literals and absent tiles never get       */
+/* broadcast into memory.  Binary ops write into the scratch block of the   */
+/* left operand's stack slot — or straight into `out` for the final         */
+/* instruction.  Writes are index-for-index, so dst may alias either        */
+/* source; the loops are plain enough for the compiler to vectorise.        */
+/* ----------------------------------------------------------------------- */
+
+#define EW_DEFINE_EVAL(NAME, T)                                               \
+typedef struct { const T *v; T s; } NAME##_slot_t;                          \
+                                                                              \
+static void NAME##_binop(ew_opcode_t op, T *dst,                             \
+                         const NAME##_slot_t *a, const NAME##_slot_t *b,     \
+                         size_t n)                                            \
+{                                                                             \
+    const T *x = a->v, *y = b->v;                                             \
+    const T  s = a->s, t = b->s;                                              \
+    if (x && y) {                                                             \
+        switch (op) {                                                         \
+        case EW_OP_ADD: for (size_t i = 0; i < n; i++) dst[i] = x[i] + y[i]; break; \
+        case EW_OP_SUB: for (size_t i = 0; i < n; i++) dst[i] = x[i] - y[i]; break; \
+        case EW_OP_MUL: for (size_t i = 0; i < n; i++) dst[i] = x[i] * y[i]; break; \
+        default:        for (size_t i = 0; i < n; i++) dst[i] = x[i] / y[i]; break; \
+        }                                                                     \
+    } else if (x) {                                                           \
+        switch (op) {                                                         \
+        case EW_OP_ADD: for (size_t i = 0; i < n; i++) dst[i] = x[i] + t; break; \
+        case EW_OP_SUB: for (size_t i = 0; i < n; i++) dst[i] = x[i] - t; break; \
+        case EW_OP_MUL: for (size_t i = 0; i < n; i++) dst[i] = x[i] * t; break; \
+        default:        for (size_t i = 0; i < n; i++) dst[i] = x[i] / t; break; \
+        }                                                                     \
+    } else {                                                                  \
+        switch (op) {                                                         \
+        case EW_OP_ADD: for (size_t i = 0; i < n; i++) dst[i] = s + y[i]; break; \
+        case EW_OP_SUB: for (size_t i = 0; i < n; i++) dst[i] = s - y[i]; break; \
+        case EW_OP_MUL: for (size_t i = 0; i < n; i++) dst[i] = s * y[i]; break; \
+        default:        for (size_t i = 0; i < n; i++) dst[i] = s / y[i]; break; \
+        }                                                                     \
+    }                                                                         \
+}                                                                             \
+                                                                              \
+void NAME(const ew_program_t *prog, const T *const *in, T *out, size_t n)    \
+{                                                                             \
+    T scratch[EW_MAX_STACK][EW_BLOCK];                                        \
+    NAME##_slot_t st[EW_MAX_STACK];                                           \
+    const int last = prog->n_instr - 1;                                       \
+                                                                              \
+    for (size_t off = 0; off < n; off += EW_BLOCK) {                          \
+        size_t nb = (n - off < EW_BLOCK) ? n - off : EW_BLOCK;                \
+        int    sp = 0;                                                        \
+        for (int i = 0; i <= last; i++) {                                     \
+            const ew_instr_t *ins = &prog->code[i];                           \
+            T *dst = (i == last) ? out + off : scratch[sp > 0 ? sp - 1 : 0];  \
+            switch (ins->op) {                                                \
+            case EW_OP_LOAD:                                                  \
+                st[sp].v = in[ins->operand] ? in[ins->operand] + off : NULL;  \
+                st[sp].s = 0;                                                 \
+                sp++;                                                         \
+                break;                                                        \
+            case EW_OP_CONST:                                                 \
+                st[sp].v = NULL;                                              \
+                st[sp].s = (T)ins->value;                                     \
+                sp++;                                                         \
+                break;                                                        \
+            case EW_OP_NEG:                                                   \
+                if (st[sp - 1].v) {                                           \
+                    const T *x = st[sp - 1].v;                                \
+                    for (size_t k = 0; k < nb; k++) dst[k] = -x[k];           \
+                    st[sp - 1].v = dst;                                       \
+                } else {                                                      \
+                    st[sp - 1].s = -st[sp - 1].s;                             \
+                }                                                             \
+                break;                                                        \
+            default:                                                          \
+                sp--;                                                         \
+                if (!st[sp - 1].v && !st[sp].v) {                             \
+                    T s = st[sp - 1].s, t = st[sp].s;                         \
+                    st[sp - 1].s = (ins->op == EW_OP_ADD) ? s + t :           \
+                                   (ins->op == EW_OP_SUB) ? s - t :           \
+                                   (ins->op == EW_OP_MUL) ? s * t : s / t;    \
+                } else {                                                      \
+                    if (i != last) dst = scratch[sp - 1];                     \
+                    NAME##_binop(ins->op, dst, &st[sp - 1], &st[sp], nb);     \
+                    st[sp - 1].v = dst;                                       \
+                }                                                             \
+                break;                                                        \
+            }                                                                 \
+        }                                                                     \
+        /* Materialise the result if the last step left it elsewhere. */      \
+        T *o = out + off;                                                     \
+        if (!st[0].v) {                                                       \
+            for (size_t k = 0; k < nb; k++) o[k] = st[0].s;                   \
+        } else if (st[0].v != o) {                                            \
+            memmove(o, st[0].v, nb * sizeof(T));                              \
+        }                                                                     \
+    }                                                                         \
+}
+
+EW_DEFINE_EVAL(ew_eval_fp64, double)
+EW_DEFINE_EVAL(ew_eval_c128, double _Complex)
+
+#undef EW_DEFINE_EVAL
+
+/* ----------------------------------------------------------------------- */
+/* Pipeline state                                                           */
+/* ----------------------------------------------------------------------- */
+
+typedef struct {
+    size_t  tile;                        /* flat tile index; SIZE_MAX → exit */
+    hsize_t phys_off[MAX_RANK];
+    int     zero_only;                   /* write zeros, no evaluation       */
+    size_t  ids[EW_MAX_INPUTS];          /* page per input; SIZE_MAX=absent */
+    size_t  out_id;                      /* page receiving the result        */
+} ew_job_t;
+
+typedef struct {
+    /* Static configuration */
+    const ew_program_t *prog;
+    int                 n_in;
+    int                 rank;
+    hsize_t             chunk_dims[MAX_RANK];
+    size_t              tile_elems;
+    size_t              element_size;
+    tensor_dtype_t      dtype;
+    hid_t               mem_type;
+    hid_t               dset_in[EW_MAX_INPUTS];
+    TensorRegistry     *reg_in[EW_MAX_INPUTS];
+    const TensorRegistry *reg_out;       /* tiles already in output, or NULL */
+
+    /* Pool (not thread-safe; guarded by pool_mu) */
+    BufferPool         *pool;
+    pthread_mutex_t     pool_mu;
+    pthread_cond_t      pool_cond;
+
+    /* Reader → compute ring */
+    ew_job_t            ring[EW_QUEUE_DEPTH];
+    int                 head, tail, count;
+    pthread_mutex_t     ring_mu;
+    pthread_cond_t      ring_cond;
+
+    WriteQueue         *wq;
+    volatile int        err;
+
+    /* Statistics (written by the reader only) */
+    size_t              n_computed;
+    size_t              n_zeroed;
+    size_t              n_skipped;
+} ew_shared_t;
+
+static void ew_ring_push(ew_shared_t *sh, const ew_job_t *job)
+{
+    pthread_mutex_lock(&sh->ring_mu);
+    while (sh->count == EW_QUEUE_DEPTH)
+        pthread_cond_wait(&sh->ring_cond, &sh->ring_mu);
+    sh->ring[sh->head % EW_QUEUE_DEPTH] = *job;
+    sh->head++;
+    sh->count++;
+    pthread_cond_broadcast(&sh->ring_cond);
+    pthread_mutex_unlock(&sh->ring_mu);
+}
+
+static ew_job_t ew_ring_pop(ew_shared_t *sh)
+{
+    pthread_mutex_lock(&sh->ring_mu);
+    while (sh->count == 0)
+        pthread_cond_wait(&sh->ring_cond, &sh->ring_mu);
+    ew_job_t job = sh->ring[sh->tail % EW_QUEUE_DEPTH];
+    /* The exit sentinel stays in the ring so every worker sees it. */
+    if (job.tile != SIZE_MAX) {
+        sh->tail++;
+        sh->count--;
+        pthread_cond_broadcast(&sh->ring_cond);
+    }
+    pthread_mutex_unlock(&sh->ring_mu);
+    return job;
+}
+
+/* Acquire n pages atomically (all or wait), so partially staged jobs can
+ * never starve each other of the last free pages. */
+static void ew_acquire_pages(ew_shared_t *sh, int n, size_t *ids)
+{
+    pthread_mutex_lock(&sh->pool_mu);
+    while (pool_free_count(sh->pool) < (size_t)n)
+        pthread_cond_wait(&sh->pool_cond, &sh->pool_mu);
+    for (int i = 0; i < n; i++)
+        pool_acquire(sh->pool, &ids[i]);
+    pthread_mutex_unlock(&sh->pool_mu);
+}
+
+static void ew_release_page(ew_shared_t *sh, size_t id)
+{
+    pthread_mutex_lock(&sh->pool_mu);
+    pool_release(sh->pool, id);
+    pthread_cond_broadcast(&sh->pool_cond);
+    pthread_mutex_unlock(&sh->pool_mu);
+}
+
+/* ----------------------------------------------------------------------- */
+/* Reader thread                                                            */
+/* ----------------------------------------------------------------------- */
+
+static void *ew_reader_main(void *arg)
+{
+    ew_shared_t *sh = (ew_shared_t *)arg;
+    size_t total = sh->reg_in[0]->total_tiles;
+
+    for (size_t t = 0; t < total && !sh->err && !sh->wq->err; t++) {
+        int present[EW_MAX_INPUTS];
+        int n_present = 0;
+        for (int k = 0; k < sh->n_in; k++) {
+            present[k] = (sh->reg_in[k]->tiles[t].status != TILE_STATUS_NULL);
+            n_present += present[k];
+        }
+
+        ew_job_t job;
+        memset(&job, 0, sizeof(job));
+        job.tile = t;
+        memcpy(job.phys_off, sh->reg_in[0]->tiles[t].phys_offset,
+               sizeof(job.phys_off));
+        for (int k = 0; k < EW_MAX_INPUTS; k++) job.ids[k] = SIZE_MAX;
+
+        if (ew_tile_is_zero(sh->prog, present)) {
+            /* Structural zero: only materialise it if the output already
+             * holds data for this tile (in-place update). */
+            if (!sh->reg_out ||
+                sh->reg_out->tiles[t].status == TILE_STATUS_NULL) {
+                sh->n_skipped++;
+                continue;
+            }
+            ew_acquire_pages(sh, 1, &job.out_id);
+            job.zero_only = 1;
+            sh->n_zeroed++;
+            ew_ring_push(sh, &job);
+            continue;
+        }
+
+        /* One page per present input; the result is computed in place in
+         * the first of them.  Constant-only tiles still need one page. */
+        size_t ids[EW_MAX_INPUTS];
+        int    n_pages = (n_present > 0) ? n_present : 1;
+        ew_acquire_pages(sh, n_pages, ids);
+
+        int j = 0;
+        for (int k = 0; k < sh->n_in && !sh->err; k++) {
+            if (!present[k]) continue;
+            job.ids[k] = ids[j++];
+            /* Loading the same dataset twice (e.g. "A * A" with one file
+             * passed twice) still reads it twice; inputs are few. */
+            void *dst = pool_get_ptr(sh->pool, job.ids[k]);
+            tensor_store_lock();
+            herr_t st = read_chunk_typed(sh->dset_in[k], job.phys_off, dst,
+                                         sh->element_size, sh->rank,
+                                         sh->chunk_dims, sh->mem_type);
+            tensor_store_unlock();
+            if (st < 0) {
+                fprintf(stderr, "run_elementwise: read failed (input %c, "
+                        "tile %zu)\n", 'A' + k, t);
+                sh->err = 1;
+            }
+        }
+        job.out_id = ids[0];
+
+        if (sh->err) {
+            for (int i = 0; i < n_pages; i++) ew_release_page(sh, ids[i]);
+            break;
+        }
+        sh->n_computed++;
+        ew_ring_push(sh, &job);
+    }
+
+    /* Sentinel: stays at the ring head; each worker observes it and exits. */
+    ew_job_t stop;
+    memset(&stop, 0, sizeof(stop));
+    stop.tile = SIZE_MAX;
+    ew_ring_push(sh, &stop);
+    return NULL;
+}
+
+/* ----------------------------------------------------------------------- */
+/* Compute threads                                                          */
+/* ----------------------------------------------------------------------- */
+
+static void *ew_worker_main(void *arg)
+{
+    ew_shared_t *sh = (ew_shared_t *)arg;
+
+    for (;;) {
+        ew_job_t job = ew_ring_pop(sh);
+        if (job.tile == SIZE_MAX) break;
+
+        void *out = pool_get_ptr(sh->pool, job.out_id);
+
+        if (job.zero_only) {
+            memset(out, 0, sh->tile_elems * sh->element_size);
+        } else if (sh->dtype == DTYPE_FP64) {
+            const double *in[EW_MAX_INPUTS];
+            for (int k = 0; k < sh->n_in; k++)
+                in[k] = (job.ids[k] == SIZE_MAX) ? NULL
+                        : (const double *)pool_get_ptr(sh->pool, job.ids[k]);
+            ew_eval_fp64(sh->prog, in, (double *)out, sh->tile_elems);
+        } else {
+            const double _Complex *in[EW_MAX_INPUTS];
+            for (int k = 0; k < sh->n_in; k++)
+                in[k] = (job.ids[k] == SIZE_MAX) ? NULL
+                        : (const double _Complex *)
+                          pool_get_ptr(sh->pool, job.ids[k]);
+            ew_eval_c128(sh->prog, in, (double _Complex *)out,
+                         sh->tile_elems);
+        }
+
+        for (int k = 0; k < sh->n_in; k++)
+            if (job.ids[k] != SIZE_MAX && job.ids[k] != job.out_id)
+                ew_release_page(sh, job.ids[k]);
+
+        write_task_t wt;
+        memset(&wt, 0, sizeof(wt));
+        wt.buf_C       = out;
+        wt.id_C        = job.out_id;
+        memcpy(wt.phys_off, job.phys_off, sizeof(wt.phys_off));
+        wt.owning_pool = sh->pool;
+        wt.pool_mu     = &sh->pool_mu;
+        wt.pool_cond   = &sh->pool_cond;
+        wq_push(sh->wq, &wt);
+    }
+    return NULL;
+}
+
+/* ----------------------------------------------------------------------- */
+/* run_elementwise                                                          */
+/* ----------------------------------------------------------------------- */
+
+/* 1 if both paths name the same existing file. */
+static int ew_same_file(const char *a, const char *b)
+{
+    struct stat sa, sb;
+    if (stat(a, &sa) != 0 || stat(b, &sb) != 0) return 0;
+    return sa.st_dev == sb.st_dev && sa.st_ino == sb.st_ino;
+}
+
+int run_elementwise(const char *expr,
+                    const char *const *files_in,
+                    const char *const *names_in, int n_in,
+                    const char *file_out, const char *name_out)
+{
+    if (!expr || !files_in || !names_in || !file_out || !name_out ||
+        n_in < 1 || n_in > EW_MAX_INPUTS)
+        return -1;
+
+    ew_program_t prog;
+    if (ew_compile(expr, &prog) < 0 || prog.n_inputs > n_in) {
+        fprintf(stderr, "run_elementwise: cannot compile '%s' for %d "
+                "input(s)\n", expr, n_in);
+        return -3;
+    }
+
+    /* In-place if the output names one of the inputs.  Any input may be
+     * the aliased one, so look for the exact (file, dataset) pair before
+     * rejecting an output that would truncate an input's file. */
+    int inplace = -1, same_file = 0;
+    for (int k = 0; k < n_in; k++) {
+        if (!ew_same_file(files_in[k], file_out)) continue;
+        same_file = 1;
+        if (strcmp(names_in[k], name_out) == 0) {
+            inplace = k;
+            break;
+        }
+    }
+    if (same_file && inplace < 0) {
+        fprintf(stderr, "run_elementwise: output dataset '%s' would "
+                "truncate input file '%s'\n", name_out, file_out);
+        return -1;
+    }
+
+    int            rc = 0;
+    hid_t          fid[EW_MAX_INPUTS];
+    ew_shared_t   *sh = (ew_shared_t *)calloc(1, sizeof(*sh));
+    hid_t          fid_out = -1, dset_out = -1;
+    if (!sh) return -4;
+    for (int k = 0; k < EW_MAX_INPUTS; k++) {
+        fid[k] = -1;
+        sh->dset_in[k] = -1;
+    }
+    sh->mem_type = H5T_NATIVE_DOUBLE;
+
+    /* ------------------------------------------------------------------ */
+    /* Open inputs and check they are co-tiled.                           */
+    /* ------------------------------------------------------------------ */
+    for (int k = 0; k < n_in; k++) {
+        unsigned flags = (inplace >= 0 &&
+                          ew_same_file(files_in[k], file_out))
+                         ? H5F_ACC_RDWR : H5F_ACC_RDONLY;
+        fid[k] = H5Fopen(files_in[k], flags, H5P_DEFAULT);
+        if (fid[k] < 0) {
+            fprintf(stderr, "run_elementwise: cannot open '%s'\n",
+                    files_in[k]);
+            rc = -1; goto cleanup;
+        }
+        sh->dset_in[k] = dset_open_no_cache(fid[k], names_in[k]);
+        if (sh->dset_in[k] < 0) {
+            fprintf(stderr, "run_elementwise: no dataset '%s' in '%s'\n",
+                    names_in[k], files_in[k]);
+            rc = -1; goto cleanup;
+        }
+        sh->reg_in[k] = registry_create_from_dset(sh->dset_in[k]);
+        if (!sh->reg_in[k]) { rc = -4; goto cleanup; }
+        if (registry_scan_file(sh->dset_in[k], sh->reg_in[k]) < 0) {
+            rc = -1; goto cleanup;
+        }
+
+        const TensorRegistry *r0 = sh->reg_in[0], *rk = sh->reg_in[k];
+        int ok = (rk->rank == r0->rank && rk->dtype == r0->dtype);
+        for (int d = 0; ok && d < r0->rank; d++)
+            ok = (rk->global_dims[d] == r0->global_dims[d] &&
+                  rk->chunk_dims[d]  == r0->chunk_dims[d]);
+        if (!ok) {
+            fprintf(stderr, "run_elementwise: '%s' is not co-tiled with "
+                    "'%s'\n", files_in[k], files_in[0]);
+            rc = -2; goto cleanup;
+        }
+    }
+
+    const TensorRegistry *r0 = sh->reg_in[0];
+    sh->prog         = &prog;
+    sh->n_in         = n_in;
+    sh->rank         = r0->rank;
+    sh->dtype        = r0->dtype;
+    sh->element_size = (r0->dtype == DTYPE_COMPLEX128)
+                       ? sizeof(double _Complex) : sizeof(double);
+    sh->tile_elems   = 1;
+    for (int d = 0; d < r0->rank; d++) {
+        sh->chunk_dims[d] = r0->chunk_dims[d];
+        sh->tile_elems   *= (size_t)r0->chunk_dims[d];
+    }
+    if (sh->dtype == DTYPE_COMPLEX128) {
+        sh->mem_type = create_h5_complex_type();
+        if (sh->mem_type < 0) { rc = -1; goto cleanup; }
+    }
+
+    /* ------------------------------------------------------------------ */
+    /* Open or create the output.                                         */
+    /* ------------------------------------------------------------------ */
+    if (inplace >= 0) {
+        fid_out  = H5Fopen(file_out, H5F_ACC_RDWR, H5P_DEFAULT);
+        dset_out = (fid_out >= 0) ? dset_open_no_cache(fid_out, name_out)
+                                  : -1;
+        sh->reg_out = sh->reg_in[inplace];
+    } else {
+        if (create_chunked_dataset_einsum(file_out, name_out, r0->rank,
+                                          r0->global_dims, r0->chunk_dims,
+                                          r0->dtype) < 0) {
+            rc = -1; goto cleanup;
+        }
+        fid_out  = H5Fopen(file_out, H5F_ACC_RDWR, H5P_DEFAULT);
+        dset_out = (fid_out >= 0) ? dset_open_no_cache(fid_out, name_out)
+                                  : -1;
+    }
+    if (dset_out < 0) {
+        fprintf(stderr, "run_elementwise: cannot open output '%s'\n",
+                file_out);
+        rc = -1; goto cleanup;
+    }
+
+    /* ------------------------------------------------------------------ */
+    /* Pool: enough pages for every stage to hold a full tile set.        */
+    /* ------------------------------------------------------------------ */
+    int    n_workers = query_num_threads();
+    size_t bpp = (sh->tile_elems * sh->element_size + EW_PAGE_ALIGN - 1)
+                 & ~(EW_PAGE_ALIGN - 1);
+    size_t per_job   = (size_t)n_in;
+    size_t num_pages = ((size_t)n_workers + EW_QUEUE_DEPTH + EW_WQ_CAP + 1)
+                       * per_job;
+    size_t budget    = (size_t)((double)query_physical_ram() * 0.8);
+    const char *env_mb = getenv("TENSOR_POOL_MB");
+    if (env_mb) {
+        size_t cap = (size_t)strtoul(env_mb, NULL, 10) * 1024UL * 1024UL;
+        if (cap > 0 && cap < budget) budget = cap;
+    }
+    if (num_pages * bpp > budget) num_pages = budget / bpp;
+    if (num_pages < per_job) {
+        fprintf(stderr, "run_elementwise: pool budget too small for %zu "
+                "pages of %zu bytes\n", per_job, bpp);
+        rc = -4; goto cleanup;
+    }
+
+    sh->pool = pool_create(num_pages, bpp);
+    sh->wq   = wq_create(EW_WQ_CAP);
+    if (!sh->pool || !sh->wq) { rc = -4; goto cleanup; }
+    pthread_mutex_init(&sh->pool_mu, NULL);
+    pthread_cond_init(&sh->pool_cond, NULL);
+    pthread_mutex_init(&sh->ring_mu, NULL);
+    pthread_cond_init(&sh->ring_cond, NULL);
+
+    printf("Elementwise: %s  (%d input%s, %zu tiles, %d workers, "
+           "%zu pages)\n", expr, n_in, n_in == 1 ? "" : "s",
+           r0->total_tiles, n_workers, num_pages);
+
+    /* ------------------------------------------------------------------ */
+    /* Run the pipeline.                                                  */
+    /* ------------------------------------------------------------------ */
+    wq_writer_t writer;
+    memset(&writer, 0, sizeof(writer));
+    writer.wq           = sh->wq;
+    writer.dset         = dset_out;
+    writer.rank         = sh->rank;
+    writer.element_size = sh->element_size;
+    writer.mem_type     = sh->mem_type;
+    memcpy(writer.chunk_dims, sh->chunk_dims, sizeof(writer.chunk_dims));
+
+    pthread_t  th_reader, th_writer;
+    pthread_t *th_workers = (pthread_t *)calloc((size_t)n_workers,
+                                                sizeof(pthread_t));
+    if (!th_workers) { rc = -4; goto cleanup_sync; }
+
+    pthread_create(&th_writer, NULL, wq_writer_main, &writer);
+    for (int w = 0; w < n_workers; w++)
+        pthread_create(&th_workers[w], NULL, ew_worker_main, sh);
+    pthread_create(&th_reader, NULL, ew_reader_main, sh);
+
+    pthread_join(th_reader, NULL);
+    for (int w = 0; w < n_workers; w++)
+        pthread_join(th_workers[w], NULL);
+    wq_push_sentinel(sh->wq);
+    pthread_join(th_writer, NULL);
+    free(th_workers);
+
+    if (sh->err || sh->wq->err) rc = -1;
+    printf("Elementwise: %zu computed, %zu zeroed, %zu skipped (sparse), "
+           "%zu written\n", sh->n_computed, sh->n_zeroed, sh->n_skipped,
+           writer.n_written);
+
+cleanup_sync:
+    pthread_cond_destroy(&sh->ring_cond);
+    pthread_mutex_destroy(&sh->ring_mu);
+    pthread_cond_destroy(&sh->pool_cond);
+    pthread_mutex_destroy(&sh->pool_mu);
+cleanup:
+    if (sh->wq)   wq_destroy(sh->wq);
+    if (sh->pool) pool_destroy(sh->pool);
+    if (dset_out >= 0) H5Dclose(dset_out);
+    if (fid_out  >= 0) H5Fclose(fid_out);
+    for (int k = 0; k < n_in; k++) {
+        if (sh->reg_in[k])      registry_destroy(sh->reg_in[k]);
+        if (sh->dset_in[k] >= 0) H5Dclose(sh->dset_in[k]);
+        if (fid[k] >= 0)        H5Fclose(fid[k]);
+    }
+    if (sh->dtype == DTYPE_COMPLEX128 && sh->mem_type >= 0 &&
+        sh->mem_type != H5T_NATIVE_DOUBLE)
+        H5Tclose(sh->mem_type);
+    free(sh);
+    return rc;
+}
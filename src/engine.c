@@ -12,8 +12,6 @@
 
 #ifdef __APPLE__
 #include <sys/sysctl.h>
-#include <dispatch/dispatch.h>
-#define HAS_GCD 1
 #endif
 
 #ifdef USE_ACCELERATE
@@ -24,24 +22,17 @@
 #  include <cblas.h>
 #endif
 
-/* Generic BLAS dispatch macros.
- * TENSOR_DGEMM / TENSOR_ZGEMM expand to the correct function regardless of
- * which backend (Accelerate, OpenBLAS, future MKL) was compiled in.
- * When no BLAS is present they are left undefined and the fallback scalar
- * kernels in the #ifndef HAVE_CBLAS blocks are used instead.
- */
-#if defined(USE_ACCELERATE) || defined(HAVE_CBLAS)
-#  define TENSOR_DGEMM(order,ta,tb,m,n,k,alpha,A,lda,B,ldb,beta,C,ldc) \
-          cblas_dgemm(order,ta,tb,m,n,k,alpha,A,lda,B,ldb,beta,C,ldc)
-#  define TENSOR_ZGEMM(order,ta,tb,m,n,k,alpha,A,lda,B,ldb,beta,C,ldc) \
-          cblas_zgemm(order,ta,tb,m,n,k,alpha,A,lda,B,ldb,beta,C,ldc)
-#endif
-
 #include "einsum.h"
+#include "tile_kernels.h"
+#include "task_pool.h"
+#include "io_sched.h"
+#include "shm_cache.h"
+#include "storage.h"
 #include "odometer.h"
 #include "write_queue.h"
 #include "metal_backend.h"
 #include <complex.h>
+#include <stdatomic.h>
 
 /* ----------------------------------------------------------------------- */
 /* Feature A — Dynamic RAM query                                            */
@@ -74,72 +65,27 @@ size_t query_physical_ram(void)
     return 512UL * 1024UL * 1024UL;
 }
 
+int query_num_threads(void)
+{
+    const char *env = getenv("TENSOR_NUM_THREADS");
+    long n = env ? strtol(env, NULL, 10) : 0;
+    if (n <= 0) n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n <= 0) n = 1;
+    if (n > 64) n = 64;
+    return (int)n;
+}
+
 /* NVMe hardware page size on Apple Silicon (16 KB).
  * Pool pages aligned to this boundary avoid read-amplification. */
 #define NVME_PAGE_BYTES 16384UL
 
-/* HDF5 raw-data chunk cache per file handle.
- * 1 GB keeps the HDF5 B-tree metadata and hot chunks resident in RAM
- * when the pool has space to spare. */
-#define HDF5_CHUNK_CACHE_BYTES (1UL << 30)
-
-/* ----------------------------------------------------------------------- */
-/* engine_fopen_cached — open an HDF5 file with a large chunk cache        */
-/* ----------------------------------------------------------------------- */
-static hid_t engine_fopen_cached(const char *path, unsigned flags,
-                                  size_t rdcc_nbytes)
-{
-    hid_t fapl = H5Pcreate(H5P_FILE_ACCESS);
-    if (fapl < 0) return H5Fopen(path, flags, H5P_DEFAULT);
-
-    /* Large prime slot count: keeps the hash table collision rate low.
-     * rdcc_w0 = 0.75 — prefer evicting chunks that are not repeated. */
-    H5Pset_cache(fapl, 0, 100003, rdcc_nbytes, 0.75);
-
-    hid_t fid = H5Fopen(path, flags, fapl);
-    H5Pclose(fapl);
-    return fid;
-}
-
 /* ----------------------------------------------------------------------- */
-/* Feature B — Tile multiply kernel (fallback when BLAS is absent)         */
+/* Feature B — Tile multiply kernel                                         */
 /*                                                                           */
-/* Computes C[0:M, 0:N] += A[0:M, 0:K] × B[0:K, 0:N].                    */
-/* Buffers are row-major with nominal strides lda / ldb / ldc.             */
-/* Passing the actual (clamped) dims avoids iterating over zero padding,   */
-/* which is especially important for boundary tiles.                        */
+/* tile_gemm() (tile_kernels.c) dispatches to the compiled-in BLAS or the   */
+/* scalar fallback.  Callers pass the actual (clamped) dims with nominal    */
+/* leading dimensions, which avoids iterating over boundary-tile padding.   */
 /* ----------------------------------------------------------------------- */
-#ifndef HAVE_CBLAS
-static void compute_tile(const double * restrict A, int lda,
-                         const double * restrict B, int ldb,
-                         double       * restrict C, int ldc,
-                         int M, int N, int K)
-{
-    for (int m = 0; m < M; m++) {
-        for (int k = 0; k < K; k++) {
-            double a_val = A[m * lda + k];
-            if (a_val == 0.0) continue;          /* skip sparse columns    */
-            for (int n = 0; n < N; n++)
-                C[m * ldc + n] += a_val * B[k * ldb + n];
-        }
-    }
-}
-#endif /* !HAVE_CBLAS */
-
-#ifndef HAVE_CBLAS
-static void compute_tile_z(const double _Complex * restrict A, int lda,
-                            const double _Complex * restrict B, int ldb,
-                            double _Complex       * restrict C, int ldc,
-                            int M, int N, int K)
-{
-    for (int m = 0; m < M; m++)
-        for (int k = 0; k < K; k++) {
-            double _Complex a = A[m * lda + k];
-            for (int n = 0; n < N; n++)
-                C[m * ldc + n] += a * B[k * ldb + n];
-        }
-}
-#endif /* !HAVE_CBLAS */
 
 /* ----------------------------------------------------------------------- */
 /* Feature C — Async I/O double-buffer                                      */
@@ -152,7 +98,7 @@ static void compute_tile_z(const double _Complex * restrict A, int lda,
 /*   • All pool_acquire / pool_release calls are made under IOShared.mu     */
 /*     so pool_acquire/pool_release do not need their own lock.             */
 /*   • The compute thread reads slot fields under the lock and only calls   */
-/*     cblas_dgemm / compute_tile after releasing it, using locally copied  */
+/*     tile_gemm after releasing it, using locally copied                  */
 /*     pointers that remain valid until pool_release (also under the lock). */
 /* ----------------------------------------------------------------------- */
 
@@ -597,21 +543,10 @@ int run_contraction(const char *file_A, const char *name_A,
                  * chunk_dims, which are the in-memory row strides laid
                  * down by read_chunk_fast.
                  */
-#ifdef HAVE_CBLAS
-                cblas_dgemm(CblasRowMajor,
-                            CblasNoTrans, CblasNoTrans,
-                            aM, aN, aK,
-                            1.0,
-                            bA, (int)reg_A->chunk_dims[1],
-                            bB, (int)reg_B->chunk_dims[1],
-                            1.0,
-                            buf_C, (int)reg_C->chunk_dims[1]);
-#else
-                compute_tile(bA, (int)reg_A->chunk_dims[1],
-                             bB, (int)reg_B->chunk_dims[1],
-                             buf_C, (int)reg_C->chunk_dims[1],
-                             aM, aN, aK);
-#endif
+                tile_gemm(DTYPE_FP64, aM, aN, aK,
+                          bA, (int)reg_A->chunk_dims[1],
+                          bB, (int)reg_B->chunk_dims[1],
+                          buf_C, (int)reg_C->chunk_dims[1], 1);
 
                 /* Return A/B pages under mutex (pool is not thread-safe). */
                 pthread_mutex_lock(&s.mu);
@@ -1164,23 +1099,10 @@ int run_contraction_4d(const char *file_A, const char *name_A,
                  *
                  * beta = 0.0: C_blas is fully overwritten each call.
                  */
-#ifdef HAVE_CBLAS
-                cblas_dgemm(CblasRowMajor,
-                            CblasNoTrans, CblasNoTrans,
-                            M_blas, N_blas, K_blas,
-                            1.0,
-                            bA,        K_blas,
-                            buf_B_perm, N_blas,
-                            0.0,
-                            buf_C_blas, N_blas);
-#else
-                memset(buf_C_blas, 0,
-                       (size_t)M_blas * (size_t)N_blas * sizeof(double));
-                compute_tile(bA,        K_blas,
-                             buf_B_perm, N_blas,
-                             buf_C_blas, N_blas,
-                             M_blas, N_blas, K_blas);
-#endif
+                tile_gemm(DTYPE_FP64, M_blas, N_blas, K_blas,
+                          bA,         K_blas,
+                          buf_B_perm, N_blas,
+                          buf_C_blas, N_blas, 0);
 
                 /* (c) Scatter-accumulate: C_blas(i*j, k*l) → buf_C(k,l,j,i).
                  *
@@ -1283,13 +1205,11 @@ static int perm_is_identity(const int *perm, int rank)
 typedef struct {
     const char               *file_A, *name_A;
     const char               *file_B, *name_B;
-    hid_t                     dset_C;
     TensorRegistry           *reg_A, *reg_B, *reg_C;
     contraction_plan_t        plan;
     int                       rank_A, rank_B, rank_C;
     tensor_dtype_t            dtype;
     size_t                    element_size;
-    hid_t                     h5type_mem;
     size_t                    c_grid_sz[MAX_RANK];
     hsize_t                   contracted_grid[MAX_RANK];
     size_t                    bytes_per_page;
@@ -1303,6 +1223,13 @@ typedef struct {
     size_t                    pool_capacity_bytes;
     size_t                    pool_num_pages;
     int                       accumulate;   /* 1 = C += A*B; 0 = C = A*B */
+    size_t                    a_pack_bytes; /* >0: A-cache holds packed A  */
+    int                       a_pack_any_n; /* packed A fits wide B runs   */
+    int                       planar;       /* 1: caches hold complex planes */
+    ShmTileCache             *shm_B;        /* node-local B cache, or NULL */
+    int                       symmetric;    /* 1: B is A, C = C^T (see below)*/
+    int                       c_mirror[MAX_RANK]; /* C dim d <-> c_mirror[d] */
+    EngineWarm               *warm;         /* kept executor state, or NULL */
 } ContractionShared;
 
 /* Per-GCD-task metadata for exec_macroblock_gcd. */
@@ -1312,14 +1239,754 @@ typedef struct {
     size_t blas_phys[MAX_RANK];  /* actual [free_A dims | free_B dims] sizes */
 } MBTask;
 
+/*
+ * Bytes per column of the wide B / C matrices.  In planar mode they are
+ * a real plane followed by an imaginary plane, so a column is one double.
+ */
+static size_t mb_col_bytes(const ContractionShared *sh)
+{
+    return sh->planar ? sizeof(double) : sh->element_size;
+}
+
+/*
+ * Store one B tile into its column block of a wide K_nom × (n·N_nom)
+ * row-major matrix (leading dimension ldw elements), so a whole B group
+ * can be multiplied against one A tile in a single GEMM.  raw is the tile
+ * as read; tmp is a one-page scratch for the permutation.  In planar mode
+ * the wide matrix is two K_nom × ldw planes: wide points into the real
+ * plane and the imaginary plane follows it.
+ */
+static void mb_store_b(const ContractionShared *sh, const char *raw,
+                       const size_t *phys_B, char *tmp,
+                       char *wide, size_t ldw)
+{
+    const size_t esz = sh->element_size;
+    const size_t row = (size_t)sh->N_nom * esz;
+    const char  *src = raw;
+    if (!perm_is_identity(sh->plan.perm_B, sh->rank_B)) {
+        memset(tmp, 0, sh->bytes_per_page);
+        tensor_permute(raw, tmp, (size_t)sh->rank_B, phys_B,
+                       sh->chunk_dims_B_sz, sh->plan.perm_B, esz);
+        src = tmp;
+    }
+    if (sh->planar) {
+        double *re = (double *)wide;
+        tile_zplanar_split(sh->K_nom, sh->N_nom, src, sh->N_nom, re,
+                           re + (size_t)sh->K_nom * ldw, (int)ldw);
+        return;
+    }
+    for (int k = 0; k < sh->K_nom; k++)
+        memcpy(wide + (size_t)k * ldw * esz, src + (size_t)k * row, row);
+}
+
+/*
+ * One A tile against a B group: Cw = A · Bw with beta = 0, then every
+ * present B tile's N_nom-column block of Cw is scatter-accumulated into
+ * its own C accumulator (Ca + fbi_l * bpp).
+ *
+ * Bw is a wide K_nom × (n·N_nom) matrix with leading dimension ldb; Cw is
+ * M_nom × (n·N_nom) with leading dimension n·N_nom.  Each maximal run of
+ * present B tiles is one GEMM — a single wide call when the group is
+ * dense — so missing tiles cost no flops.  An MKL-packed A only fits its
+ * packing width, so there each B tile is its own call.  bA is an A-cache
+ * entry: a packed operand when sh->a_pack_bytes > 0, a planar operand
+ * when sh->planar (Bw and Cw then hold real and imaginary planes),
+ * otherwise a permuted M_nom × K_nom tile.  pa holds A's physical tile
+ * dims (boundary check).
+ */
+static void mb_gemm_row(const ContractionShared *sh, const void *bA,
+                        const size_t *pa, const char *Bw, size_t ldb,
+                        const MBTask *bt, size_t n, char *Cw, char *Ca)
+{
+    const size_t esz = mb_col_bytes(sh);
+    const size_t N   = (size_t)sh->N_nom;
+    const size_t ldc = n * N;
+    const int    rC  = sh->rank_C;
+    const int    nfA = sh->plan.n_free_A;
+    const int    cx  = (sh->dtype != DTYPE_FP64);
+    /* Planar: imaginary planes follow the real ones. */
+    const size_t bim = (size_t)sh->K_nom * ldb;
+    const size_t cim = (size_t)sh->M_nom * ldc;
+
+    for (size_t j = 0; j < n; ) {
+        if (!bt[j].fb_exists) { j++; continue; }
+        size_t j1 = j + 1;
+        while (j1 < n && bt[j1].fb_exists) j1++;
+        int Nw = (int)((j1 - j) * N);
+        if (sh->planar) {
+            const double *br = (const double *)Bw + j * N;
+            double       *cr = (double *)Cw + j * N;
+            tile_gemm_zplanar(sh->M_nom, Nw, sh->K_nom, (const double *)bA,
+                              br, br + bim, (int)ldb, cr, cr + cim, (int)ldc);
+        } else if (sh->a_pack_bytes && !sh->a_pack_any_n) {
+            /* Packed for N_nom columns: one call per B tile. */
+            for (size_t t = j; t < j1; t++)
+                tile_gemm_packed(sh->dtype, sh->M_nom, (int)N, sh->K_nom, bA,
+                                 Bw + t * N * esz, (int)ldb,
+                                 Cw + t * N * esz, (int)ldc, 0);
+        } else if (sh->a_pack_bytes)
+            tile_gemm_packed(sh->dtype, sh->M_nom, Nw, sh->K_nom, bA,
+                             Bw + j * N * esz, (int)ldb,
+                             Cw + j * N * esz, (int)ldc, 0);
+        else
+            tile_gemm(sh->dtype, sh->M_nom, Nw, sh->K_nom, bA, sh->K_nom,
+                      Bw + j * N * esz, (int)ldb,
+                      Cw + j * N * esz, (int)ldc, 0);
+        j = j1;
+    }
+
+    for (size_t fbi_l = 0; fbi_l < n; fbi_l++) {
+        if (!bt[fbi_l].fb_exists) continue;
+        const char *bCb = Cw + fbi_l * N * esz;
+        char       *bCa = Ca + fbi_l * sh->bytes_per_page;
+        /* Combined blas_phys: free-A from A's dims, free-B from the task. */
+        size_t bphys[MAX_RANK];
+        for (int d = 0; d < rC; d++)
+            bphys[(size_t)d] = (d < nfA)
+                ? pa[(size_t)sh->plan.perm_A[d]]
+                : bt[fbi_l].blas_phys[(size_t)d];
+        int is_bnd = 0;
+        for (int d = 0; d < rC; d++)
+            if (bphys[(size_t)d] < sh->blas_dims[(size_t)d]) { is_bnd = 1; break; }
+        if (!is_bnd) {
+            /* blas flat index f = m·N_nom + c; source row stride is ldc. */
+            const size_t *sidx = sh->scatter_idx;
+            for (size_t m = 0, f = 0; m < (size_t)sh->M_nom; m++) {
+                if (sh->planar) {
+                    const double *sr = (const double *)bCb + m * ldc;
+                    const double *si = sr + cim;
+                    double       *dst = (double *)bCa;
+                    for (size_t c = 0; c < N; c++, f++) {
+                        dst[2 * sidx[f]]     += sr[c];
+                        dst[2 * sidx[f] + 1] += si[c];
+                    }
+                } else if (!cx) {
+                    const double *src = (const double *)bCb + m * ldc;
+                    double       *dst = (double *)bCa;
+                    for (size_t c = 0; c < N; c++, f++) dst[sidx[f]] += src[c];
+                } else {
+                    const double _Complex *src =
+                        (const double _Complex *)bCb + m * ldc;
+                    double _Complex *dst = (double _Complex *)bCa;
+                    for (size_t c = 0; c < N; c++, f++) dst[sidx[f]] += src[c];
+                }
+            }
+        } else {
+            size_t bc[MAX_RANK];
+            memset(bc, 0, (size_t)rC * sizeof(size_t));
+            do {
+                size_t bf = compute_flat_index((size_t)rC, bc, sh->blas_strides);
+                size_t sf = (bf / N) * ldc + bf % N;
+                if (sh->planar) {
+                    double *dst = (double *)bCa + 2 * sh->scatter_idx[bf];
+                    dst[0] += ((const double *)bCb)[sf];
+                    dst[1] += ((const double *)bCb)[sf + cim];
+                } else if (!cx)
+                    ((double *)bCa)[sh->scatter_idx[bf]] +=
+                        ((const double *)bCb)[sf];
+                else
+                    ((double _Complex *)bCa)[sh->scatter_idx[bf]] +=
+                        ((const double _Complex *)bCb)[sf];
+            } while (odometer_step((size_t)rC, bc, bphys));
+        }
+    }
+}
+
+/*
+ * Read B tile mB into raw (one page, pre-zeroed by the caller) through the
+ * node-local shared tile cache when one is attached: the first process to
+ * need a tile reads it into the segment, the others copy it from there.
+ * Returns 1 if the tile came from disk, 0 if from the shared cache, -1 on
+ * a read error.
+ */
+static int mb_read_b_tile(const ContractionShared *sh, StorageFile *st_B,
+                          const TileMetadata *mB, char *raw)
+{
+    const TensorRegistry *rB  = sh->reg_B;
+    const uint64_t        idx = (uint64_t)(mB - rB->tiles);
+    void *slot = NULL;
+    int   hit  = sh->shm_B ? shmc_lookup(sh->shm_B, idx, &slot) : SHMC_MISS;
+    if (hit == SHMC_HIT) {
+        memcpy(raw, slot, sh->bytes_per_page);
+        return 0;
+    }
+    int rc = stg_read_tile(st_B, mB->phys_offset, raw);
+    if (hit == SHMC_FILL) {
+        if (rc >= 0) memcpy(slot, raw, sh->bytes_per_page);
+        shmc_publish(sh->shm_B, idx, rc >= 0);
+    }
+    return (rc < 0) ? -1 : 1;
+}
+
+/*
+ * Read B tiles fb_lo .. fb_lo+n-1 of contracted step con_row and store
+ * them as the column blocks of the wide matrix Bw (leading dimension
+ * n·N_nom), filling bt[] with presence and free-B physical dims.  raw and
+ * tmp are one-page scratch buffers.  The bytes read from disk (not the
+ * shared cache) are added to *bytes.  Returns 0, or -1 on a read error.
+ */
+static int mb_load_b_group(const ContractionShared *sh, StorageFile *st_B,
+                           const hsize_t *con_row, const hsize_t *fb_all,
+                           size_t fb_lo, size_t n, char *raw, char *tmp,
+                           char *Bw, MBTask *bt, size_t *bytes)
+{
+    const contraction_plan_t *plan = &sh->plan;
+    const TensorRegistry     *rB   = sh->reg_B;
+    const int n_con = plan->n_contracted;
+    const int n_fA  = plan->n_free_A;
+    const int n_fB  = plan->n_free_B;
+    const size_t bpp = sh->bytes_per_page;
+
+    for (size_t fbi_l = 0; fbi_l < n; fbi_l++) {
+        const hsize_t *fb_row = fb_all + (fb_lo + fbi_l) * MAX_RANK;
+        hsize_t b_tile[MAX_RANK];
+        memset(b_tile, 0, sizeof(b_tile));
+        for (int d = 0; d < n_con; d++)
+            b_tile[(size_t)plan->perm_B[d]] = con_row[(size_t)d];
+        for (int q = 0; q < n_fB; q++)
+            b_tile[(size_t)plan->perm_B[n_con + q]] = fb_row[(size_t)q];
+
+        TileMetadata *mB = registry_get_tile(sh->reg_B, b_tile);
+        bt[fbi_l].fb_exists = (mB && mB->status == TILE_STATUS_ON_DISK) ? 1 : 0;
+        if (!bt[fbi_l].fb_exists) continue;
+
+        memset(raw, 0, bpp);
+        int rc = mb_read_b_tile(sh, st_B, mB, raw);
+        if (rc < 0) {
+            bt[fbi_l].fb_exists = 0;
+            return -1;
+        }
+        if (rc > 0) *bytes += bpp;
+
+        size_t phys_B[MAX_RANK];
+        for (int d = 0; d < sh->rank_B; d++) {
+            hsize_t end = mB->phys_offset[(size_t)d] + rB->chunk_dims[(size_t)d];
+            phys_B[(size_t)d] = (size_t)(
+                (end > rB->global_dims[(size_t)d])
+                ? rB->global_dims[(size_t)d] - mB->phys_offset[(size_t)d]
+                : rB->chunk_dims[(size_t)d]);
+        }
+        mb_store_b(sh, raw, phys_B, tmp,
+                   Bw + fbi_l * (size_t)sh->N_nom * mb_col_bytes(sh),
+                   n * (size_t)sh->N_nom);
+        /* Store free-B phys dims at blas_phys[n_fA+q]. */
+        for (int q = 0; q < n_fB; q++)
+            bt[fbi_l].blas_phys[(size_t)(n_fA + q)] =
+                phys_B[(size_t)plan->perm_B[n_con + q]];
+    }
+    return 0;
+}
+
+/*
+ * Kernel readahead hints.  The macroblock schedule is static, so tiles can
+ * be announced to the page cache a distance before they are read (WILLNEED)
+ * and released once read for the last time (DONTNEED), using the chunk
+ * byte ranges from the registry scan.  Hints are plain syscalls: no HDF5
+ * lock, and harmless when the file is not on a page-cached filesystem.
+ */
+static TileMetadata *mb_a_tile(const ContractionShared *sh,
+                               const hsize_t *fa_row, const hsize_t *con_row)
+{
+    const contraction_plan_t *plan = &sh->plan;
+    hsize_t a_tile[MAX_RANK];
+    memset(a_tile, 0, sizeof(a_tile));
+    for (int p = 0; p < plan->n_free_A; p++)
+        a_tile[(size_t)plan->perm_A[p]] = fa_row[(size_t)p];
+    for (int d = 0; d < plan->n_contracted; d++)
+        a_tile[(size_t)plan->perm_A[plan->n_free_A + d]] = con_row[(size_t)d];
+    return registry_get_tile(sh->reg_A, a_tile);
+}
+
+static TileMetadata *mb_b_tile(const ContractionShared *sh,
+                               const hsize_t *con_row, const hsize_t *fb_row)
+{
+    const contraction_plan_t *plan = &sh->plan;
+    hsize_t b_tile[MAX_RANK];
+    memset(b_tile, 0, sizeof(b_tile));
+    for (int d = 0; d < plan->n_contracted; d++)
+        b_tile[(size_t)plan->perm_B[d]] = con_row[(size_t)d];
+    for (int q = 0; q < plan->n_free_B; q++)
+        b_tile[(size_t)plan->perm_B[plan->n_contracted + q]] = fb_row[(size_t)q];
+    return registry_get_tile(sh->reg_B, b_tile);
+}
+
+static void mb_advise_tile(StorageFile *st, const TileMetadata *m,
+                           int willneed)
+{
+    if (st && m && m->status == TILE_STATUS_ON_DISK)
+        stg_advise(st, m, willneed);
+}
+
+/* Hint B tiles fb_lo .. fb_lo+n-1 of contracted step con_row. */
+static void mb_advise_b_group(const ContractionShared *sh, StorageFile *st,
+                              const hsize_t *con_row, const hsize_t *fb_all,
+                              size_t fb_lo, size_t n, int willneed)
+{
+    if (!st) return;
+    for (size_t fbi_l = 0; fbi_l < n; fbi_l++)
+        mb_advise_tile(st, mb_b_tile(sh, con_row,
+                                     fb_all + (fb_lo + fbi_l) * MAX_RANK),
+                       willneed);
+}
+
+/*
+ * One A/C tile read or C tile write as an I/O-scheduler request; fn runs
+ * on the I/O thread.
+ */
+typedef struct {
+    ios_req_t                req;
+    const ContractionShared *sh;
+    StorageFile             *st;
+    const hsize_t           *off;
+    char                    *buf;
+    int                      write;
+    const TileMetadata      *b_tile;   /* B read via mb_read_b_tile        */
+    int                      from_disk;
+    /* C write batch (offs non-NULL): n_tiles tiles in one stg_write_tiles. */
+    size_t                   n_tiles;
+    const hsize_t *const    *offs;
+    const void *const       *bufs;
+} MBTileIO;
+
+/* One C tile of a finished pair, keyed by its row-major index in C. */
+typedef struct {
+    size_t         idx;
+    const hsize_t *off;
+    const void    *buf;
+} MBCWrite;
+
+static int mb_cwrite_cmp(const void *a, const void *b)
+{
+    size_t x = ((const MBCWrite *)a)->idx, y = ((const MBCWrite *)b)->idx;
+    return (x > y) - (x < y);
+}
+
+/* C write batches stop here, so a demand read never queues behind more. */
+#define MB_WRITE_BATCH_BYTES (64UL << 20)
+
+static int mb_io_tile(void *arg)
+{
+    MBTileIO *t = (MBTileIO *)arg;
+    const ContractionShared *sh = t->sh;
+    if (t->b_tile) {
+        int rc = mb_read_b_tile(sh, t->st, t->b_tile, t->buf);
+        t->from_disk = (rc > 0);
+        t->req.bytes = t->from_disk ? sh->bytes_per_page : 0;
+        return (rc < 0) ? -1 : 0;
+    }
+    if (t->offs)
+        return stg_write_tiles(t->st, t->n_tiles, t->offs, t->bufs);
+    return t->write ? stg_write_tile(t->st, t->off, t->buf)
+                    : stg_read_tile(t->st, t->off, t->buf);
+}
+
+static void mb_tile_io_init(MBTileIO *t, const ContractionShared *sh,
+                            StorageFile *st, const hsize_t *off, char *buf,
+                            int write, ios_class_t cls, uint64_t deadline_ns)
+{
+    memset(t, 0, sizeof(*t));
+    t->sh              = sh;
+    t->st              = st;
+    t->off             = off;
+    t->buf             = buf;
+    t->write           = write;
+    t->req.fn          = mb_io_tile;
+    t->req.arg         = t;
+    t->req.cls         = cls;
+    t->req.deadline_ns = deadline_ns;
+    t->req.bytes       = sh->bytes_per_page;
+    t->req.ops         = 1;
+    t->req.write       = write;
+}
+
+/* Wait for n queued tile requests; -1 if any of them failed. */
+static int mb_tile_io_wait(IOScheduler *ios, MBTileIO *t, size_t n)
+{
+    int rc = 0;
+    for (size_t i = 0; i < n; i++)
+        if (ios_wait(ios, &t[i].req) < 0) rc = -1;
+    return rc;
+}
+
+/* ----------------------------------------------------------------------- */
+/* Step 3 executors — task-pool work items for one (gA, gB) pair           */
+/*                                                                           */
+/* MBWork is one executor's view of the pair: the shared A cache, a B      */
+/* source (the pre-cache, or a ring of streaming slots), and the C_blas/  */
+/* C_accum rows it writes.  Row r of C_blas/C_accum belongs to A tile      */
+/* fai_l = r, so tasks on different rows never share memory.               */
+/*                                                                           */
+/* Prefetch ring: streaming B goes through `ring` slots (2..MB_RING_MAX).  */
+/* Between pairs the ring is resized from the measured B-load latency and  */
+/* compute time per step (mb_ring_size), within the memory budget, so      */
+/* jittery storage gets deeper read-ahead and steady storage stays at two. */
+/*                                                                           */
+/* Split-K: when total_fA × total_fB is below the thread count the per-row */
+/* tasks cannot occupy every core.  Executor s then owns the contracted    */
+/* steps [s·total_con/S, (s+1)·total_con/S) of each pair with private C    */
+/* accumulators (executor 0 uses C_accum itself); a fixed pairwise tree    */
+/* sums the partials.  Slice bounds and tree shape depend only on S, so    */
+/* results are reproducible for a given split.                              */
+/* ----------------------------------------------------------------------- */
+#define MB_SPLIT_K_MAX 64
+#define MB_RING_MAX    16
+
+/*
+ * Streaming state shared by the load and row tasks of one executor: the
+ * step schedule of the current pair, the compute frontier, and load /
+ * compute measurements that drive the ring size (cumulative over pairs).
+ */
+typedef struct {
+    size_t        n_steps;
+    size_t       *step_cf;      /* [total_con] contracted index of step j  */
+    atomic_int   *rows_left;    /* [total_con] unfinished rows of step j   */
+    atomic_size_t front;        /* lowest step that may have rows left     */
+    atomic_uint_fast64_t row_ns;/* summed row-task time                    */
+    /* Written by load tasks only, which the graph serialises. */
+    size_t        n_loads;
+    size_t        n_starved;    /* loads compute was already waiting for   */
+    size_t        n_ahead;      /* loads issued > 1 step ahead             */
+    double        load_s, load_s2;  /* summed latency and its square       */
+} MBStream;
+
+typedef struct {
+    const ContractionShared *sh;
+    StorageFile    *st_B;
+    const hsize_t  *con_all, *fb_all;
+    const char     *A_cache;       /* index = (fai_l·total_con + cf)·a_stride */
+    size_t          a_stride;
+    const int      *A_exist;
+    const size_t   *A_phys;
+    size_t          total_con, total_fB;
+    const char     *B_full_cache;  /* NULL: stream B from st_B             */
+    const MBTask   *tasks_full;
+    size_t          cf_lo, cf_hi;  /* contracted steps of this executor    */
+    /* Current (gA, gB) pair. */
+    size_t          fb_lo, n_fA_cur, n_fB_cur;
+    /* Buffers (split-K executors s ≥ 1 own theirs). */
+    char           *B_raw, *B_tmp;
+    char           *B_slot[MB_RING_MAX];   /* wide K_nom × (n_fB_cur·N_nom) */
+    MBTask         *bt_slot[MB_RING_MAX];
+    size_t          ring;          /* streaming slots in use (≥ 2)         */
+    MBStream       *st;
+    char           *C_blas, *C_accum;
+    char           *mem;           /* owned allocation, split-K s ≥ 1      */
+    IOScheduler    *ios;
+    uint64_t        step_ns;       /* last pair's compute time per step    */
+    /* Page-cache hints (hint_B NULL: off). */
+    StorageFile    *hint_B;
+    size_t          ra_steps;      /* WILLNEED this many steps past reads  */
+    int             drop_B;        /* DONTNEED each B group once read      */
+    size_t          bytes_read_B;
+    int             err;
+} MBWork;
+
+/* One B group load as an I/O-scheduler request (runs on the I/O thread). */
+typedef struct {
+    ios_req_t      req;
+    MBWork        *w;
+    size_t         cf;
+    int            slot;
+} MBLoad;
+
+static int mb_io_load_b(void *arg)
+{
+    MBLoad *l = (MBLoad *)arg;
+    MBWork *w = l->w;
+    size_t  before = w->bytes_read_B;
+    int     rc = mb_load_b_group(w->sh, w->st_B,
+                                 w->con_all + l->cf * MAX_RANK,
+                                 w->fb_all, w->fb_lo, w->n_fB_cur, w->B_raw,
+                                 w->B_tmp, w->B_slot[l->slot],
+                                 w->bt_slot[l->slot], &w->bytes_read_B);
+    if (w->drop_B)
+        mb_advise_b_group(w->sh, w->hint_B, w->con_all + l->cf * MAX_RANK,
+                          w->fb_all, w->fb_lo, w->n_fB_cur, 0);
+    /* Charge only the tiles that exist on disk (empty ones are skipped). */
+    l->req.bytes = w->bytes_read_B - before;
+    l->req.ops   = l->req.bytes / w->sh->bytes_per_page;
+    return rc;
+}
+
+/* Load step cf into slot through the scheduler and wait for it. */
+static int mb_sched_load_b(MBWork *w, size_t cf, int slot, ios_class_t cls,
+                           uint64_t deadline_ns)
+{
+    MBLoad l;
+    memset(&l, 0, sizeof(l));
+    l.w               = w;
+    l.cf              = cf;
+    l.slot            = slot;
+    l.req.fn          = mb_io_load_b;
+    l.req.arg         = &l;
+    l.req.cls         = cls;
+    l.req.deadline_ns = deadline_ns;
+    return ios_run(w->ios, &l.req);
+}
+
+/* WILLNEED for the B group of contracted index cf in the current pair. */
+static void mb_advise_b_step(const MBWork *w, size_t cf)
+{
+    mb_advise_b_group(w->sh, w->hint_B, w->con_all + cf * MAX_RANK, w->fb_all,
+                      w->fb_lo, w->n_fB_cur, 1);
+}
+
+/* Row fai_l against the B pre-cache for every contracted step. */
+static void mb_task_row_cached(void *arg, size_t fai_l)
+{
+    MBWork *w = (MBWork *)arg;
+    const ContractionShared *sh = w->sh;
+    const size_t N   = (size_t)sh->N_nom;
+    const size_t bpp = sh->bytes_per_page;
+
+    for (size_t cf = w->cf_lo; cf < w->cf_hi; cf++) {
+        size_t ai = fai_l * w->total_con + cf;
+        if (!w->A_exist[ai]) continue;
+        mb_gemm_row(sh, w->A_cache + ai * w->a_stride,
+                    w->A_phys + ai * MAX_RANK,
+                    w->B_full_cache + cf * w->total_fB * bpp
+                    + w->fb_lo * N * mb_col_bytes(sh),
+                    w->total_fB * N,
+                    w->tasks_full + cf * w->total_fB + w->fb_lo, w->n_fB_cur,
+                    w->C_blas  + fai_l * w->n_fB_cur * bpp,
+                    w->C_accum + fai_l * w->n_fB_cur * bpp);
+    }
+}
+
+/*
+ * Streaming: load step j into slot j % ring.  Its class follows from how
+ * far ahead of the compute frontier it is: compute already waiting →
+ * demand (a starvation unless j = 0), next step → prefetch, further →
+ * speculative.  Deadlines are that many steps of compute from now.
+ */
+static void mb_task_load_b(void *arg, size_t j)
+{
+    MBWork   *w  = (MBWork *)arg;
+    MBStream *st = w->st;
+    if (w->err) return;
+
+    size_t f = atomic_load(&st->front);
+    while (f < j && atomic_load(&st->rows_left[f]) == 0) f++;
+    atomic_store(&st->front, f);
+    size_t      ahead = j - f;
+    ios_class_t cls   = (ahead == 0) ? IOS_DEMAND
+                      : (ahead == 1) ? IOS_PREFETCH : IOS_SPECULATIVE;
+    if (ahead == 0 && j > 0) st->n_starved++;
+    if (ahead > 1)           st->n_ahead++;
+
+    /* The ring reaches j + ring - 1; the page cache runs ra_steps further. */
+    if (w->hint_B && w->ra_steps) {
+        size_t far = j + w->ring - 1 + w->ra_steps;
+        for (size_t t = (j == 0) ? w->ring : far; t <= far && t < st->n_steps; t++)
+            mb_advise_b_step(w, st->step_cf[t]);
+    }
+
+    uint64_t t0 = ios_now_ns();
+    if (mb_sched_load_b(w, st->step_cf[j], (int)(j % w->ring), cls,
+                        (ahead && w->step_ns) ? t0 + ahead * w->step_ns
+                                              : 0) < 0)
+        w->err = 1;
+    double t = (double)(ios_now_ns() - t0) * 1e-9;
+    st->n_loads++;
+    st->load_s  += t;
+    st->load_s2 += t * t;
+}
+
+/* Streaming: idx = j·n_fA_cur + fai_l. */
+static void mb_task_row_stream(void *arg, size_t idx)
+{
+    MBWork   *w    = (MBWork *)arg;
+    MBStream *st   = w->st;
+    size_t    j    = idx / w->n_fA_cur;
+    size_t    fai  = idx % w->n_fA_cur;
+    size_t    slot = j % w->ring;
+    size_t    ai   = fai * w->total_con + st->step_cf[j];
+    const size_t bpp = w->sh->bytes_per_page;
+    if (!w->err) {
+        uint64_t t0 = ios_now_ns();
+        mb_gemm_row(w->sh, w->A_cache + ai * w->a_stride,
+                    w->A_phys + ai * MAX_RANK, w->B_slot[slot],
+                    w->n_fB_cur * (size_t)w->sh->N_nom, w->bt_slot[slot],
+                    w->n_fB_cur,
+                    w->C_blas  + fai * w->n_fB_cur * bpp,
+                    w->C_accum + fai * w->n_fB_cur * bpp);
+        atomic_fetch_add(&st->row_ns, ios_now_ns() - t0);
+    }
+    atomic_fetch_sub(&st->rows_left[j], 1);
+}
+
+/*
+ * Streaming Step 3 of one pair as a task graph over R = w->ring slots:
+ *   L(j)       load B of the j-th contracted step that has any A tile into
+ *              slot j % R — after L(j-1) (one reader, shared scratch) and
+ *              after every row of step j-R (slot reuse)
+ *   R(j, fai)  GEMM + scatter of A row fai against slot j % R — after L(j)
+ *              and after the row's previous step (same C rows)
+ * Loads run up to R-1 steps ahead of the slowest row, and a row may run
+ * ahead of slower rows until it needs a slot that is still in use.  Every
+ * created task is submitted even after an error, so the wait cannot hang.
+ * Returns 0, -1 on a B read error, -4 on allocation failure.
+ */
+static int mb_run_stream(task_pool_t *pool, MBWork *w)
+{
+    const size_t n  = w->n_fA_cur;
+    const size_t R  = w->ring;
+    MBStream    *st = w->st;
+    tp_task_t **last = (tp_task_t **)calloc(n, sizeof(tp_task_t *));
+    tp_task_t **hist = (tp_task_t **)calloc(R * n, sizeof(tp_task_t *));
+    tp_task_t  *prevL = NULL;
+    int rc = (last && hist) ? 0 : -4;
+
+    /* Step schedule: contracted steps with at least one A tile. */
+    st->n_steps = 0;
+    for (size_t cf = w->cf_lo; cf < w->cf_hi; cf++) {
+        int rows = 0;
+        for (size_t fai = 0; fai < n; fai++)
+            rows += w->A_exist[fai * w->total_con + cf] ? 1 : 0;
+        if (!rows) continue;
+        st->step_cf[st->n_steps] = cf;
+        atomic_store(&st->rows_left[st->n_steps], rows);
+        st->n_steps++;
+    }
+    atomic_store(&st->front, 0);
+
+    for (size_t j = 0; j < st->n_steps && rc == 0; j++) {
+        size_t     cf  = st->step_cf[j];
+        tp_task_t **hj = hist + (j % R) * n;   /* rows of step j - R */
+        tp_task_t *L   = task_pool_task(pool, mb_task_load_b, w, j);
+        if (!L) { rc = -4; break; }
+        if (task_pool_depend(L, prevL) < 0) rc = -4;
+        for (size_t fai = 0; fai < n; fai++)
+            if (task_pool_depend(L, hj[fai]) < 0) rc = -4;
+        task_pool_submit(pool, L);
+
+        for (size_t fai = 0; fai < n; fai++) {
+            hj[fai] = NULL;
+            if (!w->A_exist[fai * w->total_con + cf]) continue;
+            tp_task_t *T = (rc == 0)
+                ? task_pool_task(pool, mb_task_row_stream, w, j * n + fai)
+                : NULL;
+            if (!T) {
+                /* Keep the frontier moving for loads already queued. */
+                atomic_fetch_sub(&st->rows_left[j], 1);
+                rc = -4;
+                continue;
+            }
+            if (task_pool_depend(T, L) < 0 ||
+                task_pool_depend(T, last[fai]) < 0)
+                rc = -4;
+            task_pool_submit(pool, T);
+            last[fai] = hj[fai] = T;
+        }
+        prevL = L;
+    }
+    task_pool_wait(pool);
+
+    free(last);
+    free(hist);
+    if (rc != 0) return rc;
+    return w->err ? -1 : 0;
+}
+
+/*
+ * Ring slots for the next pair: one computing plus enough loads in flight
+ * to cover a slow read (mean + 2σ of the measured latency) at the measured
+ * compute time per step — or per load, when reads are the bottleneck and
+ * deeper read-ahead only absorbs their variance.  n_thr converts summed
+ * row time into wall time.  Clamped to [2, ring_max].
+ */
+static size_t mb_ring_size(const MBStream *st, int n_thr, size_t ring_max)
+{
+    size_t r = 2;
+    if (st->n_loads >= 2) {
+        double nl   = (double)st->n_loads;
+        double mean = st->load_s / nl;
+        double var  = st->load_s2 / nl - mean * mean;
+        double slow = mean + 2.0 * sqrt(var > 0.0 ? var : 0.0);
+        double step = (double)atomic_load(&st->row_ns) * 1e-9
+                    / (double)(n_thr > 0 ? n_thr : 1) / nl;
+        double per  = (step > mean) ? step : mean;
+        if (per > 0.0) r = 1 + (size_t)ceil(slow / per);
+    }
+    if (r < 2)        r = 2;
+    if (r > ring_max) r = ring_max;
+    return r;
+}
+
+/* Split-K executor s: its contracted slice, serially, row after row. */
+static void mb_task_split(void *arg, size_t s)
+{
+    MBWork *w = (MBWork *)arg + s;
+    const ContractionShared *sh = w->sh;
+    const size_t bpp = sh->bytes_per_page;
+
+    if (w->B_full_cache) {
+        for (size_t fai = 0; fai < w->n_fA_cur; fai++)
+            mb_task_row_cached(w, fai);
+        return;
+    }
+    for (size_t cf = w->cf_lo; cf < w->cf_hi; cf++) {
+        int any_a = 0;
+        for (size_t fai = 0; fai < w->n_fA_cur; fai++)
+            if (w->A_exist[fai * w->total_con + cf]) { any_a = 1; break; }
+        if (!any_a) continue;
+        if (w->hint_B && w->ra_steps) {
+            size_t far = cf + w->ra_steps;
+            for (size_t t = (cf == w->cf_lo) ? cf + 1 : far;
+                 t <= far && t < w->cf_hi; t++)
+                mb_advise_b_step(w, t);
+        }
+        if (mb_sched_load_b(w, cf, 0, IOS_DEMAND, 0) < 0) {
+            w->err = 1;
+            return;
+        }
+        for (size_t fai = 0; fai < w->n_fA_cur; fai++) {
+            size_t ai = fai * w->total_con + cf;
+            if (!w->A_exist[ai]) continue;
+            mb_gemm_row(sh, w->A_cache + ai * w->a_stride,
+                        w->A_phys + ai * MAX_RANK, w->B_slot[0],
+                        w->n_fB_cur * (size_t)sh->N_nom, w->bt_slot[0],
+                        w->n_fB_cur,
+                        w->C_blas  + fai * w->n_fB_cur * bpp,
+                        w->C_accum + fai * w->n_fB_cur * bpp);
+        }
+    }
+}
+
+/*
+ * Run one pair across S split-K executors on pool and reduce into
+ * w[0].C_accum.  acc_bytes is the live accumulator size.
+ * Returns 0, or -1 if any executor hit a B read error.
+ */
+static int mb_split_k_run(task_pool_t *pool, MBWork *w, size_t S,
+                          size_t acc_bytes)
+{
+    for (size_t s = 1; s < S; s++)
+        memset(w[s].C_accum, 0, acc_bytes);
+    task_pool_parallel_for(pool, S, mb_task_split, w);
+    for (size_t s = 0; s < S; s++)
+        if (w[s].err) return -1;
+
+    /* Pairwise tree: 0+=1, 2+=3, ... then 0+=2, 4+=6, ... (complex parts
+     * are independent doubles, so one real loop covers both dtypes). */
+    const size_t n = acc_bytes / sizeof(double);
+    for (size_t step = 1; step < S; step *= 2)
+        for (size_t s = 0; s + step < S; s += 2 * step) {
+            double       *dst = (double *)w[s].C_accum;
+            const double *src = (const double *)w[s + step].C_accum;
+            for (size_t i = 0; i < n; i++) dst[i] += src[i];
+        }
+    return 0;
+}
+
 /* ----------------------------------------------------------------------- */
 /* IOProfiler — deterministic I/O accounting for exec_macroblock_gcd       */
 /*                                                                           */
 /* All counters are plain size_t — no atomics needed because:               */
 /*   • A reads happen only on the main thread (Step 1 or A pre-cache).      */
-/*   • B reads happen only on the serial b_io_q (load_b block or pre-cache).*/
-/*   • C writes happen only on the main thread (Step 4).                    */
-/*   • Main thread reads the struct only after dispatch_sync drains b_io_q. */
+/*   • B reads in Step 3 are tallied per executor (MBWork.bytes_read_B)    */
+/*     and merged on the main thread after task_pool_wait().                */
+/*   • C writes are queued by the main thread (Step 4), counted at submit. */
 /* ----------------------------------------------------------------------- */
 typedef struct {
     /* --- Actual I/O (bytes via read_chunk_typed / write_chunk_typed) --- */
@@ -1355,7 +2022,67 @@ typedef struct {
 /* exec_macroblock_gcd — forward declaration (defined below)               */
 /* ----------------------------------------------------------------------- */
 static int exec_macroblock_gcd(const ContractionShared *sh,
-                                hid_t dset_A, hid_t dset_B, hid_t dset_C);
+                                StorageFile *st_A, StorageFile *st_B,
+                                StorageFile *st_C);
+
+/* ----------------------------------------------------------------------- */
+/* EngineWarm — executor state kept across runs (see engine.h)              */
+/* ----------------------------------------------------------------------- */
+enum {
+    MBK_A_CACHE, MBK_B_CACHE, MBK_B_SLOT0, MBK_B_SLOT1,
+    MBK_C_BLAS, MBK_C_ACCUM, MBK_C_WB, MBK_C_MIR, MBK_N
+};
+
+struct EngineWarm {
+    task_pool_t *pool;
+    IOScheduler *ios;
+    char        *buf[MBK_N];
+    size_t       cap[MBK_N];
+};
+
+EngineWarm *engine_warm_create(void)
+{
+    EngineWarm *w = (EngineWarm *)calloc(1, sizeof(EngineWarm));
+    if (w && !(w->ios = ios_create(NULL, NULL))) {
+        free(w);
+        w = NULL;
+    }
+    return w;
+}
+
+void engine_warm_destroy(EngineWarm *w)
+{
+    if (!w) return;
+    task_pool_destroy(w->pool);
+    ios_destroy(w->ios);
+    for (int k = 0; k < MBK_N; k++) free(w->buf[k]);
+    free(w);
+}
+
+/* 16 KB-aligned buffer of bytes for kept slot k: w's own when big enough,
+ * else a fresh one that w keeps in its place.  Without w, plain
+ * posix_memalign; release with mb_buf_free either way. */
+static char *mb_buf(EngineWarm *w, int k, size_t bytes)
+{
+    char *p = NULL;
+    if (w && w->cap[k] >= bytes) return w->buf[k];
+    if (w) {
+        free(w->buf[k]);
+        w->buf[k] = NULL;
+        w->cap[k] = 0;
+    }
+    if (posix_memalign((void **)&p, 16384, bytes) != 0) return NULL;
+    if (w) {
+        w->buf[k] = p;
+        w->cap[k] = bytes;
+    }
+    return p;
+}
+
+static void mb_buf_free(EngineWarm *w, char *p)
+{
+    if (!w) free(p);
+}
 
 
 
@@ -1363,7 +2090,8 @@ static int exec_macroblock_gcd(const ContractionShared *sh,
 /* ----------------------------------------------------------------------- */
 /* exec_macroblock_gcd                                                       */
 /*                                                                           */
-/* Out-of-core block-caching contraction with GCD parallel BLAS.            */
+/* Out-of-core block-caching contraction with task-parallel BLAS.         */
+/* (The name predates the portable task pool; GCD is no longer used.)      */
 /*                                                                           */
 /* Loop structure (A-pinning macro-block strategy):                          */
 /*                                                                           */
@@ -1373,35 +2101,49 @@ static int exec_macroblock_gcd(const ContractionShared *sh,
 /*                                                                           */
 /*     for each contracted pair (a,b):                                       */
 /*       permute A_cache[a,b] → A_perm  (once per pair, not per C tile)     */
-/*       for each free_B tile (k,l) [SERIAL I/O]:                           */
-/*         read B[a,k,b,l] → permute → B_perm[k,l]                          */
-/*       dispatch_apply(total_free_B) [GCD PARALLEL]:                        */
-/*         cblas_zgemm(A_perm, B_perm[k,l]) → C_blas[k,l]  (beta=0)        */
-/*         scatter-accumulate C_blas[k,l] → C_accum[k,l]                    */
+/*       load task [one B reader at a time]:                                */
+/*         read B[a,k,b,l] → permute → column block (k,l) of B_wide         */
+/*       row task per free_A tile [WORK-STEALING POOL]:                      */
+/*         one wide GEMM  A_perm · B_wide → C_wide  (beta=0)                */
+/*         scatter-accumulate each column block (k,l) → C_accum[k,l]       */
 /*                                                                           */
-/*     for each free_B tile (k,l) [SERIAL]:                                 */
-/*       write_chunk_typed(C_accum[k,l])                                     */
+/*     for each free_B tile (k,l) [WRITE-BEHIND]:                           */
+/*       queue writeback of C_accum[k,l]; swap C_accum with C_wb            */
 /*                                                                           */
 /* I/O reduction:                                                            */
 /*   A reads  OLD: N_C_tiles × N_contracted = N^4 × N^2 = N^6               */
 /*   A reads  NEW: N_free_A  × N_contracted = N^2 × N^2 = N^4  (N^2 fewer) */
 /*   B reads unchanged (always O(N^6) unique element accesses).              */
 /*                                                                           */
-/* GCD parallelism: the free_B BLAS loop is embarrassingly parallel —       */
-/* each (k,l) task writes to a unique C_accum[k,l] buffer, requiring        */
-/* zero mutexes in the hot math path.                                        */
+/* GEMM aggregation: a B group is stored as one K_nom × (n_fB·N_nom)      */
+/* matrix, so each (A tile, contracted pair) is a single wide GEMM rather   */
+/* than n_fB narrow ones; BLAS blocks and threads it far better when the    */
+/* chunk side is small.  Missing B tiles split the call into runs.         */
+/*                                                                           */
+/* Task parallelism (task_pool.c): each row task writes to its own C_wide */
+/* and C_accum buffers, requiring zero mutexes in the hot math path.  Rows */
+/* depend on their B load and on their own previous step only, so sparse   */
+/* or boundary rows finish early and idle workers steal the heavy ones.    */
 /*                                                                           */
 /* Memory layout (all posix_memalign'd, 16 KB NVMe-aligned):                */
 /*   A_cache     total_contracted × bytes_per_page   (pinned across pairs)  */
 /*   A_perm      1 × bytes_per_page                  (permuted A, per pair) */
 /*   B_raw       1 × bytes_per_page                  (read scratch)         */
-/*   B_perm_base total_free_B × bytes_per_page       (permuted B, per pair) */
-/*   C_blas_base total_free_B × bytes_per_page       (BLAS scratch/task)   */
+/*   B_perm_base total_free_B × bytes_per_page       (B_wide, per pair)     */
+/*   C_blas_base total_free_B × bytes_per_page       (C_wide per A tile)    */
 /*   C_accum_base total_free_B × bytes_per_page      (running accumulators) */
+/*   C_wb_base    total_free_B × bytes_per_page      (previous pair, writing) */
+/*                                                                           */
+/* I/O scheduling (io_sched.c): every HDF5 access inside the loop goes      */
+/* through one I/O thread in priority order — A and C-init reads and the   */
+/* first B load of a pair are demand reads, later B loads prefetches, and  */
+/* C tiles writebacks that drain behind the next pair's compute.  A burst  */
+/* of writes therefore never delays a read that compute is waiting on.     */
 /* ----------------------------------------------------------------------- */
 
 static int exec_macroblock_gcd(const ContractionShared *sh,
-                                hid_t dset_A, hid_t dset_B, hid_t dset_C)
+                                StorageFile *st_A, StorageFile *st_B,
+                                StorageFile *st_C)
 {
     const contraction_plan_t *plan = &sh->plan;
     const int rank_A  = sh->rank_A;
@@ -1410,9 +2152,15 @@ static int exec_macroblock_gcd(const ContractionShared *sh,
     const int n_fA    = plan->n_free_A;
     const int n_fB    = plan->n_free_B;
     const int n_con   = plan->n_contracted;
-    const int is_cplx = (sh->dtype != DTYPE_FP64);
     const size_t bpp  = sh->bytes_per_page;
     const size_t esz  = sh->element_size;
+    /* A-cache entry stride: one page, or the packed (or planar) operand
+     * rounded up to the NVMe page so every entry stays 16 KB-aligned. */
+    const size_t a_op = sh->planar
+        ? tile_zplanar_a_size(sh->M_nom, sh->K_nom) : sh->a_pack_bytes;
+    const size_t a_stride = a_op
+        ? (a_op + NVME_PAGE_BYTES - 1) & ~(size_t)(NVME_PAGE_BYTES - 1)
+        : bpp;
 
     /* ------------------------------------------------------------------ */
     /* Grid sizes along each axis                                          */
@@ -1446,23 +2194,46 @@ static int exec_macroblock_gcd(const ContractionShared *sh,
     size_t block_fB = (size_t)ceil(sqrt((double)total_fB));
     if (block_fB < 1) block_fB = 1;
     if (block_fB > total_fB) block_fB = total_fB;
+    /* The A cache pins block_fA × total_con entries of a_stride bytes
+     * (over a page when packed or planar); keep it within a quarter of
+     * RAM.  A symmetric product needs square blocks, so B follows. */
+    const size_t fA_want = block_fA;
+    {
+        size_t fA_fit = query_physical_ram() / 4 / (total_con * a_stride);
+        if (fA_fit < 1) fA_fit = 1;
+        if (block_fA > fA_fit) {
+            block_fA = fA_fit;
+            if (sh->symmetric) block_fB = block_fA;
+        }
+    }
     size_t P_A = (total_fA + block_fA - 1) / block_fA;  /* A-group count  */
     size_t P_B = (total_fB + block_fB - 1) / block_fB;  /* B-group count  */
+    /* Symmetric product: the fA and fB grids coincide, so pair (gA,gB)
+     * is the transpose of (gB,gA) and only gB >= gA is computed. */
+    const int    sym     = sh->symmetric;
+    const size_t n_pairs = sym ? P_A * (P_A + 1) / 2 : P_A * P_B;
 
-    printf("Macroblock-GCD 2D-SUMMA execution:\n");
+    printf("Macroblock 2D-SUMMA execution:\n");
     printf("  free_A : %zu tiles  ->  %zu groups of <=%zu  (P_A=%zu)\n",
            total_fA, P_A, block_fA, P_A);
     printf("  contr. : %zu tiles\n", total_con);
     printf("  free_B : %zu tiles  ->  %zu groups of <=%zu  (P_B=%zu)\n",
            total_fB, P_B, block_fB, P_B);
-    printf("  A-cache/gA    : %.3f GiB  (%zu x %zu tiles, loaded once per gA)\n",
-           (double)(block_fA * total_con * bpp) / (1024.0*1024*1024),
-           block_fA, total_con);
-    printf("  B-buf (2 slots): %.3f GiB  (%zu tiles x 2)\n",
-           (double)(2 * block_fB * bpp) / (1024.0*1024*1024), block_fB);
-    printf("  C-accum/pair  : %.3f GiB  (%zu x %zu tiles)\n",
+    printf("  A-cache/gA    : %.3f GiB  (%zu x %zu tiles, loaded once per gA%s)\n",
+           (double)(block_fA * total_con * a_stride) / (1024.0*1024*1024),
+           block_fA, total_con, sh->planar ? ", planar"
+                                : sh->a_pack_bytes ? ", packed" : "");
+    if (block_fA < fA_want)
+        printf("  A-cache cap   : %zu free_A tiles per group fit in RAM/4, "
+               "not %zu\n", block_fA, fA_want);
+    printf("  B-buf/slot    : %.3f GiB  (%zu tiles; 2+ slots when streaming)\n",
+           (double)(block_fB * bpp) / (1024.0*1024*1024), block_fB);
+    printf("  C-accum/pair  : %.3f GiB  (%zu x %zu tiles, x2 for write-behind)\n",
            (double)(block_fA * block_fB * bpp) / (1024.0*1024*1024),
            block_fA, block_fB);
+    if (sym)
+        printf("  symmetric     : %zu of %zu pairs, off-diagonal C mirrored "
+               "on write\n", n_pairs, P_A * P_B);
 
     /* Initialise profiler (theoretical minimums set after cache decisions). */
     IOProfiler prof;
@@ -1470,7 +2241,7 @@ static int exec_macroblock_gcd(const ContractionShared *sh,
     prof.bytes_per_page      = bpp;
     prof.pool_capacity_bytes = sh->pool_capacity_bytes;
     prof.pool_num_pages      = sh->pool_num_pages;
-    prof.n_macroblocks       = P_A * P_B;
+    prof.n_macroblocks       = n_pairs;
 
     /* ------------------------------------------------------------------ */
     /* Allocate buffers (16 KB NVMe-aligned, not from pool)               */
@@ -1482,16 +2253,56 @@ static int exec_macroblock_gcd(const ContractionShared *sh,
             goto mb_cleanup; \
         } \
     } while (0)
+    /* Same for the buffers a warm engine keeps (slot k, see EngineWarm). */
+#define MB_KEEP(ptr, k, n_pages) \
+    do { \
+        if (!((ptr) = mb_buf(warm, (k), (n_pages) * bpp))) { \
+            fprintf(stderr, "exec_macroblock_gcd: alloc failed (%s)\n", #ptr); \
+            goto mb_cleanup; \
+        } \
+    } while (0)
 
+    EngineWarm *warm = sh->warm;
     int ret = 0;
 
     char   *A_cache_base  = NULL;
     char   *A_perm_buf    = NULL;
+    char   *A_pack_tmp    = NULL;          /* permuted A awaiting packing   */
     char   *B_raw_buf     = NULL;
-    char   *B_perm_buf[2] = {NULL, NULL};  /* ping-pong double buffers */
+    char   *B_tile_tmp    = NULL;          /* permuted B awaiting mb_store_b */
+    char   *B_perm_buf[MB_RING_MAX] = {NULL};  /* streaming prefetch ring */
     char   *C_blas_base   = NULL;
     char   *C_accum_base  = NULL;
-    MBTask *tasks_buf[2]  = {NULL, NULL};
+    char   *C_wb_base     = NULL;          /* previous pair, being written  */
+    char   *C_mir_base    = NULL;          /* ... its transpose (symmetric) */
+    size_t  c_slots       = (sym ? 2 : 1) * block_fA * block_fB;
+    size_t  c_chunk[MAX_RANK];             /* C tile dims, for mirroring    */
+    MBTileIO *c_wr        = NULL;          /* its writeback requests        */
+    size_t  n_wr          = 0;
+    MBCWrite *c_ord       = NULL;          /* its tiles in C's tile order   */
+    const hsize_t **c_offs = NULL;         /* ... as stg_write_tiles args   */
+    const void    **c_bufs = NULL;
+    IOScheduler *ios      = NULL;
+
+    /* Page-cache hints: TENSOR_READAHEAD tiles ahead of each read.         */
+    StorageFile *hint_A   = NULL, *hint_B = NULL;
+    int     ra_devices    = 1;
+    size_t  ra_tiles      = 0;
+    size_t  ra_steps      = 0;             /* ... in B groups when streaming */
+    int     drop_B        = 0;
+
+    /* Streaming prefetch ring (slots 0, 1 above; up to MB_RING_MAX).       */
+    MBStream stream;
+    size_t  ring          = 2;             /* slots for the next pair       */
+    size_t  ring_alloc    = 2;             /* slots allocated               */
+    size_t  ring_max      = 2;             /* memory-budget bound           */
+    size_t  ring_peak     = 2;
+    size_t  ring_budget   = 0;             /* bytes left beside the B cache */
+    int     ring_fixed    = 0;             /* TENSOR_PREFETCH_SLOTS         */
+    memset(&stream, 0, sizeof(stream));
+    uint64_t pair_ns      = 0;             /* last pair's wall time         */
+    uint64_t step_ns      = 0;             /* ... per contracted step       */
+    MBTask *tasks_buf[MB_RING_MAX] = {NULL};
     int    *A_exist       = NULL;
     hsize_t *con_all      = NULL;          /* contracted-pair coord array */
 
@@ -1505,22 +2316,33 @@ static int exec_macroblock_gcd(const ContractionShared *sh,
     hsize_t *fb_all       = NULL;   /* [total_fB × MAX_RANK]                 */
     size_t  *A_phys_cache = NULL;   /* [block_fA × total_con × MAX_RANK]     */
 
-    /* GCD objects — declared here (before any goto) and initialised below. */
-#ifdef HAS_GCD
-    dispatch_queue_t     b_io_q   = NULL;
-    dispatch_semaphore_t b_sem0   = NULL;
-    dispatch_semaphore_t b_sem1   = NULL;
-    int                 *b_io_err = NULL;  /* heap[2]: [0]=slot0, [1]=slot1 */
-#endif
+    /* Step 3 executors: work-stealing pool, pair template, split-K slices. */
+    task_pool_t *pool     = NULL;
+    MBWork       mbw;
+    MBWork      *sk       = NULL;
+    size_t       split_k  = 1;
+    memset(&mbw, 0, sizeof(mbw));
 
     /* A_cache holds block_fA × total_con permuted tiles; reused for all gB. */
-    MB_ALLOC(A_cache_base,  block_fA * total_con);
+    A_cache_base = mb_buf(warm, MBK_A_CACHE, block_fA * total_con * a_stride);
+    if (!A_cache_base) {
+        fprintf(stderr, "exec_macroblock_gcd: alloc failed (A_cache_base)\n");
+        goto mb_cleanup;
+    }
     MB_ALLOC(A_perm_buf,    1);           /* scratch for A load+permute step */
+    if (a_op)
+        MB_ALLOC(A_pack_tmp, 1);
     MB_ALLOC(B_raw_buf,     1);
-    MB_ALLOC(B_perm_buf[0], block_fB);   /* double-buffer: slot 0           */
-    MB_ALLOC(B_perm_buf[1], block_fB);   /* double-buffer: slot 1           */
-    MB_ALLOC(C_blas_base,   block_fA * block_fB);
-    MB_ALLOC(C_accum_base,  block_fA * block_fB);
+    MB_ALLOC(B_tile_tmp,    1);
+    MB_KEEP(B_perm_buf[0], MBK_B_SLOT0, block_fB);  /* ring slot 0 (more on demand) */
+    MB_KEEP(B_perm_buf[1], MBK_B_SLOT1, block_fB);  /* ring slot 1            */
+    MB_KEEP(C_blas_base,   MBK_C_BLAS,  block_fA * block_fB);
+    MB_KEEP(C_accum_base,  MBK_C_ACCUM, block_fA * block_fB);
+    MB_KEEP(C_wb_base,     MBK_C_WB,    block_fA * block_fB);
+    if (sym)
+        MB_KEEP(C_mir_base, MBK_C_MIR, block_fA * block_fB);
+    for (int d = 0; d < rank_C; d++)
+        c_chunk[(size_t)d] = (size_t)sh->reg_C->chunk_dims[(size_t)d];
 
     tasks_buf[0]  = (MBTask  *)malloc(block_fB * sizeof(MBTask));
     tasks_buf[1]  = (MBTask  *)malloc(block_fB * sizeof(MBTask));
@@ -1530,8 +2352,16 @@ static int exec_macroblock_gcd(const ContractionShared *sh,
     fb_all        = (hsize_t *)malloc(total_fB  * MAX_RANK * sizeof(hsize_t));
     A_phys_cache  = (size_t  *)malloc(
                         block_fA * total_con * MAX_RANK * sizeof(size_t));
+    c_wr          = (MBTileIO *)calloc(c_slots, sizeof(MBTileIO));
+    c_ord         = (MBCWrite *)malloc(c_slots * sizeof(MBCWrite));
+    c_offs        = (const hsize_t **)malloc(c_slots * sizeof(*c_offs));
+    c_bufs        = (const void **)malloc(c_slots * sizeof(*c_bufs));
+    stream.step_cf   = (size_t *)malloc(total_con * sizeof(size_t));
+    stream.rows_left = (atomic_int *)malloc(total_con * sizeof(atomic_int));
     if (!tasks_buf[0] || !tasks_buf[1] || !A_exist || !con_all ||
-        !fa_all || !fb_all || !A_phys_cache) {
+        !fa_all || !fb_all || !A_phys_cache || !c_wr || !c_ord ||
+        !c_offs || !c_bufs ||
+        !stream.step_cf || !stream.rows_left) {
         fprintf(stderr, "exec_macroblock_gcd: malloc failed (bufs/coords)\n");
         goto mb_cleanup;
     }
@@ -1565,19 +2395,85 @@ static int exec_macroblock_gcd(const ContractionShared *sh,
         } while (odometer_step((size_t)n_fB, fb, fb_grid));
     }
 
-#ifdef HAS_GCD
-    b_io_q  = dispatch_queue_create("mb.b_io", DISPATCH_QUEUE_SERIAL);
-    b_sem0  = dispatch_semaphore_create(0);
-    b_sem1  = dispatch_semaphore_create(0);
-    b_io_err = (int *)calloc(2, sizeof(int));
-    if (!b_io_q || !b_sem0 || !b_sem1 || !b_io_err) {
-        fprintf(stderr, "exec_macroblock_gcd: GCD init failed\n");
+    /* A warm engine keeps its pool while the thread count stands. */
+    if (warm && warm->pool &&
+        task_pool_size(warm->pool) != query_num_threads()) {
+        task_pool_destroy(warm->pool);
+        warm->pool = NULL;
+    }
+    pool = (warm && warm->pool) ? warm->pool : task_pool_create(-1);
+    if (warm) warm->pool = pool;
+    if (!pool) {
+        fprintf(stderr, "exec_macroblock_gcd: task pool init failed\n");
+        ret = -1;
         goto mb_cleanup;
     }
-#endif
+    printf("  task pool     : %d threads (work-stealing)\n",
+           task_pool_size(pool));
+    ios = warm ? warm->ios : ios_create(NULL, NULL);
+    if (!ios) {
+        fprintf(stderr, "exec_macroblock_gcd: I/O scheduler init failed\n");
+        ret = -1;
+        goto mb_cleanup;
+    }
+    if (warm) ios_reset_stats(ios);
+    printf("  I/O scheduler : depth demand/prefetch/spec/writeback = "
+           "%d/%d/%d/%d  (0 = unbounded)\n",
+           ios->depth[IOS_DEMAND], ios->depth[IOS_PREFETCH],
+           ios->depth[IOS_SPECULATIVE], ios->depth[IOS_WRITEBACK]);
+    if (ios->lim.read_bps > 0.0 || ios->lim.write_bps > 0.0 ||
+        ios->lim.iops > 0.0 || ios->lim.background != IOS_BG_NONE) {
+        printf("  I/O limits    : read ");
+        if (ios->lim.read_bps > 0.0)
+            printf("%.0f MiB/s", ios->lim.read_bps / 1048576.0);
+        else
+            printf("-");
+        printf(", write ");
+        if (ios->lim.write_bps > 0.0)
+            printf("%.0f MiB/s", ios->lim.write_bps / 1048576.0);
+        else
+            printf("-");
+        printf(", IOPS ");
+        if (ios->lim.iops > 0.0) printf("%.0f", ios->lim.iops);
+        else                     printf("-");
+        printf("%s\n", ios->lim.background == IOS_BG_IDLE ? ", background idle"
+                      : ios->lim.background == IOS_BG_LOW  ? ", background low"
+                      : "");
+    }
 
 #undef MB_ALLOC
 
+    /* ------------------------------------------------------------------ */
+    /* Kernel readahead hints (backends with a POSIX fd).               */
+    /* TENSOR_READAHEAD=N tiles, default 16, 0 = off.  Every A tile and */
+    /* every pre-cached B tile is read once, so it is dropped from the  */
+    /* page cache after the read; streamed B only when it is too big to */
+    /* stay cached across gA.  A tensor striped over n drives hints n×  */
+    /* as far ahead, so every drive has a full window in flight.        */
+    /* ------------------------------------------------------------------ */
+    {
+        const char *env_ra = getenv("TENSOR_READAHEAD");
+        long v = (env_ra && *env_ra) ? strtol(env_ra, NULL, 10) : 16;
+        if (v > 0) {
+            hint_A     = st_A->hints ? st_A : NULL;
+            hint_B     = st_B->hints ? st_B : NULL;
+            ra_devices = (hint_A && st_A->devices > ra_devices)
+                         ? st_A->devices : ra_devices;
+            ra_devices = (hint_B && st_B->devices > ra_devices)
+                         ? st_B->devices : ra_devices;
+            ra_tiles   = (size_t)v * (size_t)ra_devices;
+            ra_steps   = (ra_tiles + block_fB - 1) / block_fB;
+            drop_B     = total_con * total_fB * bpp > query_physical_ram() / 2;
+        }
+        if (hint_A || hint_B)
+            printf("  readahead     : %zu tiles ahead, %d drive%s%s\n",
+                   ra_tiles, ra_devices, ra_devices > 1 ? "s" : "",
+                   drop_B ? ", streamed B dropped after use" : "");
+        else
+            printf("  readahead     : off%s\n",
+                   ra_tiles ? "  (backend takes no hints)" : "");
+    }
+
     /* ------------------------------------------------------------------ */
     /* B tile pre-cache (optional): if total_con × total_fB tiles fit in  */
     /* RAM, read every permuted B tile once and skip HDF5 in the loop.    */
@@ -1590,17 +2486,19 @@ static int exec_macroblock_gcd(const ContractionShared *sh,
         size_t b_cache_bytes = total_con * total_fB * bpp;
 
         if (b_cache_bytes <= ram_limit &&
-            posix_memalign((void **)&B_full_cache, 16384,
-                           b_cache_bytes) == 0) {
+            (B_full_cache = mb_buf(warm, MBK_B_CACHE, b_cache_bytes))) {
             tasks_full = (MBTask *)calloc(total_con * total_fB, sizeof(MBTask));
             if (tasks_full)
                 use_b_cache = 1;
             else {
-                free(B_full_cache);
+                mb_buf_free(warm, B_full_cache);
                 B_full_cache = NULL;
             }
         }
 
+        /* What the cache leaves for split-K workers or the prefetch ring. */
+        ring_budget = use_b_cache ? ram_limit - b_cache_bytes : ram_limit;
+
         printf("  B pre-cache : ");
         if (use_b_cache)
             printf("%.3f GiB  (loading all B tiles once)\n",
@@ -1619,6 +2517,18 @@ static int exec_macroblock_gcd(const ContractionShared *sh,
             memset(fb, 0, sizeof(fb));
             size_t ff = 0;
             do {
+                /* Linear pre-cache order is cf·total_fB + ff. */
+                if (hint_B) {
+                    size_t i   = cf * total_fB + ff;
+                    size_t end = total_con * total_fB;
+                    for (size_t t = (i == 0) ? 0 : i + ra_tiles;
+                         t <= i + ra_tiles && t < end; t++)
+                        mb_advise_tile(hint_B,
+                                       mb_b_tile(sh, con_all + (t / total_fB)
+                                                         * MAX_RANK,
+                                                 fb_all + (t % total_fB)
+                                                         * MAX_RANK), 1);
+                }
                 hsize_t b_tile[MAX_RANK];
                 memset(b_tile, 0, sizeof(b_tile));
                 for (int d = 0; d < n_con; d++)
@@ -1633,17 +2543,22 @@ static int exec_macroblock_gcd(const ContractionShared *sh,
                     (mB && mB->status == TILE_STATUS_ON_DISK) ? 1 : 0;
 
                 if (t->fb_exists) {
+                    MBTileIO io;
                     memset(B_raw_buf, 0, bpp);
-                    if (read_chunk_typed(dset_B, mB->phys_offset, B_raw_buf,
-                                         esz, rank_B, sh->reg_B->chunk_dims,
-                                         sh->h5type_mem) < 0) {
+                    mb_tile_io_init(&io, sh, st_B, mB->phys_offset,
+                                    B_raw_buf, 0, IOS_DEMAND, 0);
+                    io.b_tile = mB;
+                    if (ios_run(ios, &io.req) < 0) {
                         fprintf(stderr,
                                 "exec_macroblock_gcd: B pre-cache read error\n");
                         ret = -1;
                         goto mb_cleanup;
                     }
-                    prof.bytes_read_B += bpp;
-                    prof.tiles_read_B++;
+                    mb_advise_tile(hint_B, mB, 0);
+                    if (io.from_disk) {
+                        prof.bytes_read_B += bpp;
+                        prof.tiles_read_B++;
+                    }
                     size_t phys_B[MAX_RANK];
                     for (int d = 0; d < rank_B; d++) {
                         hsize_t end = mB->phys_offset[(size_t)d]
@@ -1654,14 +2569,12 @@ static int exec_macroblock_gcd(const ContractionShared *sh,
                               - mB->phys_offset[(size_t)d]
                             : sh->reg_B->chunk_dims[(size_t)d]);
                     }
-                    char *dst = B_full_cache + (cf * total_fB + ff) * bpp;
-                    if (perm_is_identity(plan->perm_B, rank_B)) {
-                        memcpy(dst, B_raw_buf, bpp);
-                    } else {
-                        memset(dst, 0, bpp);
-                        tensor_permute(B_raw_buf, dst, (size_t)rank_B, phys_B,
-                                       sh->chunk_dims_B_sz, plan->perm_B, esz);
-                    }
+                    /* Row cf of the pre-cache is one wide K_nom ×
+                     * (total_fB·N_nom) matrix; tile ff is column block ff. */
+                    mb_store_b(sh, B_raw_buf, phys_B, B_tile_tmp,
+                               B_full_cache + cf * total_fB * bpp
+                               + ff * (size_t)sh->N_nom * mb_col_bytes(sh),
+                               total_fB * (size_t)sh->N_nom);
                     for (int q = 0; q < n_fB; q++)
                         t->blas_phys[(size_t)(n_fA + q)] =
                             phys_B[(size_t)plan->perm_B[n_con + q]];
@@ -1672,6 +2585,136 @@ static int exec_macroblock_gcd(const ContractionShared *sh,
         }
     }
 
+    /* ------------------------------------------------------------------ */
+    /* Split-K plan: fewer output tiles than threads but several          */
+    /* contracted tiles → partition the contracted range across workers. */
+    /* TENSOR_SPLIT_K=0 disables it; TENSOR_SPLIT_K=N forces N slices.    */
+    /* Each slice past the first owns w_pages of buffers, so the slice    */
+    /* count is bounded by what the B pre-cache leaves (ring_budget).     */
+    /* ------------------------------------------------------------------ */
+    {
+        int         n_thr   = query_num_threads();
+        const char *env_sk  = getenv("TENSOR_SPLIT_K");
+        size_t      c_pages = block_fA * block_fB;
+        size_t      w_pages = 2 * c_pages + (use_b_cache ? 0 : block_fB + 2);
+        size_t      sk_fit  = 1 + ring_budget / (w_pages * bpp);
+        if (env_sk && *env_sk) {
+            long v  = strtol(env_sk, NULL, 10);
+            split_k = (v > 1) ? (size_t)v : 1;
+        } else if (total_fA * total_fB < (size_t)n_thr) {
+            split_k = (size_t)n_thr;
+        }
+        if (split_k > total_con)      split_k = total_con;
+        if (split_k > MB_SPLIT_K_MAX) split_k = MB_SPLIT_K_MAX;
+        if (split_k > sk_fit)         split_k = sk_fit;
+
+        /* Template for this gA/gB loop; per-pair fields are set in Step 3. */
+        mbw.sh           = sh;
+        mbw.st_B         = st_B;
+        mbw.con_all      = con_all;
+        mbw.fb_all       = fb_all;
+        mbw.A_cache      = A_cache_base;
+        mbw.a_stride     = a_stride;
+        mbw.A_exist      = A_exist;
+        mbw.A_phys       = A_phys_cache;
+        mbw.total_con    = total_con;
+        mbw.total_fB     = total_fB;
+        mbw.B_full_cache = use_b_cache ? B_full_cache : NULL;
+        mbw.tasks_full   = tasks_full;
+        mbw.cf_lo        = 0;
+        mbw.cf_hi        = total_con;
+        mbw.B_raw        = B_raw_buf;
+        mbw.B_tmp        = B_tile_tmp;
+        mbw.B_slot[0]    = B_perm_buf[0];
+        mbw.B_slot[1]    = B_perm_buf[1];
+        mbw.bt_slot[0]   = tasks_buf[0];
+        mbw.bt_slot[1]   = tasks_buf[1];
+        mbw.ring         = 2;
+        mbw.st           = &stream;
+        mbw.C_blas       = C_blas_base;
+        mbw.C_accum      = C_accum_base;
+        mbw.ios          = ios;
+        mbw.hint_B       = hint_B;
+        mbw.ra_steps     = ra_steps;
+        mbw.drop_B       = drop_B;
+
+        if (split_k > 1) {
+            int ok = 1;
+            sk = (MBWork *)calloc(split_k, sizeof(MBWork));
+            if (!sk) ok = 0;
+            for (size_t s = 0; ok && s < split_k; s++) {
+                MBWork *w = &sk[s];
+                *w = mbw;
+                w->cf_lo = s * total_con / split_k;
+                w->cf_hi = (s + 1) * total_con / split_k;
+                if (s == 0) continue;       /* executor 0: engine buffers */
+                if (posix_memalign((void **)&w->mem, 16384,
+                                   w_pages * bpp) != 0) {
+                    w->mem = NULL;
+                    ok = 0;
+                    break;
+                }
+                w->C_blas  = w->mem;
+                w->C_accum = w->mem + c_pages * bpp;
+                memset(w->B_slot, 0, sizeof(w->B_slot));
+                memset(w->bt_slot, 0, sizeof(w->bt_slot));
+                if (!use_b_cache) {
+                    w->B_raw     = w->C_accum + c_pages * bpp;
+                    w->B_tmp     = w->B_raw + bpp;
+                    w->B_slot[0] = w->B_tmp + bpp;
+                    w->bt_slot[0] = (MBTask *)malloc(block_fB * sizeof(MBTask));
+                    if (!w->bt_slot[0]) ok = 0;
+                }
+            }
+            if (!ok) {
+                fprintf(stderr, "exec_macroblock_gcd: split-K alloc failed, "
+                                "using output parallelism\n");
+                for (size_t s = 1; sk && s < split_k; s++) {
+                    free(sk[s].mem);
+                    free(sk[s].bt_slot[0]);
+                }
+                free(sk);
+                sk      = NULL;
+                split_k = 1;
+            }
+        }
+
+        if (split_k > 1 && env_sk && *env_sk)
+            printf("  split-K     : %zu slices of ~%zu contracted tiles  "
+                   "(TENSOR_SPLIT_K)\n", split_k, total_con / split_k);
+        else if (split_k > 1)
+            printf("  split-K     : %zu slices of ~%zu contracted tiles  "
+                   "(%zu output tiles < %d threads)\n",
+                   split_k, total_con / split_k, total_fA * total_fB, n_thr);
+        if (split_k > 1)
+            printf("  split-K mem : %.1f MiB  (%zu worker buffers of "
+                   "%zu tiles)\n",
+                   (double)((split_k - 1) * w_pages * bpp) / 1048576.0,
+                   split_k - 1, w_pages);
+        else
+            printf("  split-K     : off\n");
+    }
+
+    /* ------------------------------------------------------------------ */
+    /* Prefetch ring for streaming B: TENSOR_PREFETCH_SLOTS=N fixes N     */
+    /* slots; otherwise start at 2 and resize between pairs from measured */
+    /* load latency and compute time.  Bounded by the B pre-cache budget. */
+    /* ------------------------------------------------------------------ */
+    if (!use_b_cache && split_k == 1) {
+        const char *env_r = getenv("TENSOR_PREFETCH_SLOTS");
+        ring_max = ring_budget / (block_fB * bpp);
+        if (ring_max > MB_RING_MAX) ring_max = MB_RING_MAX;
+        if (ring_max < 2)           ring_max = 2;
+        if (env_r && *env_r && strtol(env_r, NULL, 10) > 0) {
+            long v = strtol(env_r, NULL, 10);
+            ring       = (v < 2) ? 2 : ((size_t)v > ring_max ? ring_max : (size_t)v);
+            ring_fixed = 1;
+            printf("  prefetch ring : %zu slots  (TENSOR_PREFETCH_SLOTS)\n", ring);
+        } else {
+            printf("  prefetch ring : adaptive, 2..%zu slots\n", ring_max);
+        }
+    }
+
     /* ------------------------------------------------------------------ */
     /* Theoretical minimum I/O for 2D SUMMA.                             */
     /*                                                                    */
@@ -1698,7 +2741,7 @@ static int exec_macroblock_gcd(const ContractionShared *sh,
     /*                                                                    */
     /* Outer gA: load block_fA × total_con A tiles (once per gA).        */
     /* Inner gB: zero C, stream B (block_fB tiles/contracted pair,       */
-    /*           double-buffered), dispatch_apply BLAS, write C.         */
+    /*           double-buffered) and GEMM rows on the pool, write C.    */
     /* ------------------------------------------------------------------ */
     size_t pair_done = 0;
 
@@ -1718,6 +2761,18 @@ static int exec_macroblock_gcd(const ContractionShared *sh,
             const hsize_t *fa_row = fa_all + fai * MAX_RANK;
 
             for (size_t cf = 0; cf < total_con; cf++) {
+                /* A is read once, in order fai·total_con + cf. */
+                if (hint_A) {
+                    size_t i   = fai * total_con + cf;
+                    size_t end = total_fA * total_con;
+                    for (size_t t = (i == 0) ? 0 : i + ra_tiles;
+                         t <= i + ra_tiles && t < end; t++)
+                        mb_advise_tile(hint_A,
+                                       mb_a_tile(sh, fa_all + (t / total_con)
+                                                         * MAX_RANK,
+                                                 con_all + (t % total_con)
+                                                         * MAX_RANK), 1);
+                }
                 hsize_t a_tile[MAX_RANK];
                 memset(a_tile, 0, sizeof(a_tile));
                 for (int p = 0; p < n_fA; p++)
@@ -1726,19 +2781,21 @@ static int exec_macroblock_gcd(const ContractionShared *sh,
                 for (int d = 0; d < n_con; d++)
                     a_tile[(size_t)plan->perm_A[n_fA + d]] = con_row[(size_t)d];
 
-                char *dst_A = A_cache_base + (fai_local * total_con + cf) * bpp;
+                char *dst_A = A_cache_base + (fai_local * total_con + cf) * a_stride;
                 size_t *pa  = A_phys_cache +
                               (fai_local * total_con + cf) * MAX_RANK;
 
                 TileMetadata *mA = registry_get_tile(sh->reg_A, a_tile);
                 if (mA && mA->status == TILE_STATUS_ON_DISK) {
+                    MBTileIO io;
                     memset(A_perm_buf, 0, bpp);
-                    if (read_chunk_typed(dset_A, mA->phys_offset, A_perm_buf,
-                                         esz, rank_A, sh->reg_A->chunk_dims,
-                                         sh->h5type_mem) < 0) {
+                    mb_tile_io_init(&io, sh, st_A, mA->phys_offset,
+                                    A_perm_buf, 0, IOS_DEMAND, 0);
+                    if (ios_run(ios, &io.req) < 0) {
                         fprintf(stderr, "exec_macroblock_gcd: A read error\n");
                         ret = -1; break;
                     }
+                    mb_advise_tile(hint_A, mA, 0);
                     prof.bytes_read_A += bpp;
                     prof.tiles_read_A++;
                     /* Compute physical dims (for boundary detection). */
@@ -1751,17 +2808,28 @@ static int exec_macroblock_gcd(const ContractionShared *sh,
                               - mA->phys_offset[(size_t)d]
                             : sh->reg_A->chunk_dims[(size_t)d]);
                     }
-                    /* Permute into A_cache_base. */
+                    /* Permute into A_cache_base — or, when packing or
+                     * splitting planes, into A_pack_tmp and convert once
+                     * from there for all gB. */
+                    char *perm_dst = a_op ? A_pack_tmp : dst_A;
+                    const char *perm_src = perm_dst;
                     if (perm_is_identity(plan->perm_A, rank_A)) {
-                        memcpy(dst_A, A_perm_buf, bpp);
+                        perm_src = A_perm_buf;
+                        if (!a_op) memcpy(dst_A, A_perm_buf, bpp);
                     } else {
-                        memset(dst_A, 0, bpp);
-                        tensor_permute(A_perm_buf, dst_A, (size_t)rank_A, pa,
+                        memset(perm_dst, 0, bpp);
+                        tensor_permute(A_perm_buf, perm_dst, (size_t)rank_A, pa,
                                        sh->chunk_dims_A_sz, plan->perm_A, esz);
                     }
+                    if (sh->planar)
+                        tile_zplanar_pack_a(sh->M_nom, sh->K_nom, perm_src,
+                                            sh->K_nom, (double *)dst_A);
+                    else if (sh->a_pack_bytes)
+                        tile_gemm_pack_a(sh->dtype, sh->M_nom, sh->N_nom,
+                                         sh->K_nom, perm_src, sh->K_nom, dst_A);
                     A_exist[fai_local * total_con + cf] = 1;
                 } else {
-                    memset(dst_A, 0, bpp);
+                    memset(dst_A, 0, a_stride);
                     memset(pa, 0, MAX_RANK * sizeof(size_t));
                     A_exist[fai_local * total_con + cf] = 0;
                 }
@@ -1772,11 +2840,12 @@ static int exec_macroblock_gcd(const ContractionShared *sh,
         /* ---------------------------------------------------------------- */
         /* Inner gB loop                                                    */
         /* ---------------------------------------------------------------- */
-        for (size_t gB = 0; gB < P_B && ret == 0; gB++) {
+        for (size_t gB = sym ? gA : 0; gB < P_B && ret == 0; gB++) {
             size_t fb_lo    = gB * block_fB;
             size_t fb_hi    = fb_lo + block_fB;
             if (fb_hi > total_fB) fb_hi = total_fB;
             size_t n_fB_cur = fb_hi - fb_lo;
+            uint64_t t_pair = ios_now_ns();
 
             /* Step 2: Initialise C accumulators for this (gA, gB) pair.
              *
@@ -1808,10 +2877,10 @@ static int exec_macroblock_gcd(const ContractionShared *sh,
                         memset(C_data, 0, bpp);
                         TileMetadata *mC = registry_get_tile(sh->reg_C, c_tile);
                         if (mC && mC->status == TILE_STATUS_ON_DISK) {
-                            if (read_chunk_typed(dset_C, mC->phys_offset,
-                                                 C_data, esz, rank_C,
-                                                 sh->reg_C->chunk_dims,
-                                                 sh->h5type_mem) < 0) {
+                            MBTileIO io;
+                            mb_tile_io_init(&io, sh, st_C, mC->phys_offset,
+                                            C_data, 0, IOS_DEMAND, 0);
+                            if (ios_run(ios, &io.req) < 0) {
                                 fprintf(stderr,
                                         "exec_macroblock_gcd: C read error "
                                         "(accumulate mode)\n");
@@ -1826,521 +2895,69 @@ static int exec_macroblock_gcd(const ContractionShared *sh,
             }
             prof.b_bytes_cur_mb = 0;
 
-            /* Step 3: Contracted loop. */
-            if (use_b_cache) {
-                /* B globally pre-cached: iterate pairs, BLAS only. */
-                for (size_t cf = 0; cf < total_con && ret == 0; cf++) {
-                    /* Check any A exists for this cf across fA group. */
-                    int any_a = 0;
-                    for (size_t fai_l = 0; fai_l < n_fA_cur; fai_l++)
-                        if (A_exist[fai_l * total_con + cf]) { any_a = 1; break; }
-                    if (!any_a) continue;
-
-                    /* Pointers captured by the block. */
-                    const char   *cap_Ap     = A_cache_base;  /* base; index = (fai*tcon+cf)*bpp */
-                    /* B slice for this gB group within the pre-cache. */
-                    const char   *cap_Bp     = B_full_cache
-                                               + cf * total_fB * bpp
-                                               + fb_lo * bpp;
-                    char         *cap_Cb     = C_blas_base;
-                    char         *cap_Ca     = C_accum_base;
-                    const MBTask *cap_Brow   = tasks_full + cf * total_fB
-                                               + fb_lo;
-                    const size_t *cap_sidx   = sh->scatter_idx;
-                    const size_t *cap_bstr   = sh->blas_strides;
-                    size_t cap_tblas         = sh->total_blas;
-                    int cap_Mn = sh->M_nom, cap_Kn = sh->K_nom,
-                        cap_Nn = sh->N_nom;
-                    int    cap_rC    = rank_C;
-                    int    cap_cx    = is_cplx;
-                    size_t cap_bpp   = bpp;
-                    size_t cap_nfAc  = n_fA_cur;
-                    size_t cap_nfBc  = n_fB_cur;
-                    size_t cap_tcon  = total_con;
-                    int   *cap_Aexist = A_exist;
-                    const size_t *cap_Aphys = A_phys_cache;  /* base; index = (fai*tcon+cf)*MAX_RANK */
-                    const size_t *cap_bd    = sh->blas_dims;
-                    int cap_nfA_bc = n_fA;
-
-#ifdef HAS_GCD
-                    dispatch_apply(cap_nfAc * cap_nfBc,
-                                   DISPATCH_APPLY_AUTO,
-                                   ^(size_t task_idx) {
-                        size_t fai_l = task_idx / cap_nfBc;
-                        size_t fbi_l = task_idx % cap_nfBc;
-                        if (!cap_Aexist[fai_l * cap_tcon + cf]) return;
-                        if (!cap_Brow[fbi_l].fb_exists) return;
-                        const void *bA  = cap_Ap + (fai_l * cap_tcon + cf) * cap_bpp;
-                        const void *bB  = cap_Bp + fbi_l * cap_bpp;
-                        void       *bCb = cap_Cb + task_idx * cap_bpp;
-                        void       *bCa = cap_Ca + task_idx * cap_bpp;
-#ifdef TENSOR_ZGEMM
-                        if (!cap_cx) {
-                            double alpha = 1.0, beta = 0.0;
-                            TENSOR_DGEMM(CblasRowMajor,CblasNoTrans,CblasNoTrans,
-                                cap_Mn,cap_Nn,cap_Kn, alpha,
-                                (const double *)bA, cap_Kn,
-                                (const double *)bB, cap_Nn,
-                                beta, (double *)bCb, cap_Nn);
-                        } else {
-                            double _Complex alpha=CMPLX(1.0,0.0),beta=CMPLX(0.0,0.0);
-                            TENSOR_ZGEMM(CblasRowMajor,CblasNoTrans,CblasNoTrans,
-                                cap_Mn,cap_Nn,cap_Kn, &alpha,
-                                (const double _Complex *)bA, cap_Kn,
-                                (const double _Complex *)bB, cap_Nn,
-                                &beta,(double _Complex *)bCb, cap_Nn);
-                        }
-#else
-                        memset(bCb, 0, cap_bpp);
-#endif
-                        /* Combined blas_phys: free-A from A_phys, free-B from task. */
-                        size_t bphys[MAX_RANK];
-                        const size_t *pa2 = cap_Aphys +
-                            (fai_l * cap_tcon + cf) * MAX_RANK;
-                        for (int d=0; d<cap_rC; d++) bphys[(size_t)d] =
-                            (d < cap_nfA_bc)
-                                ? pa2[(size_t)plan->perm_A[d]]
-                                : cap_Brow[fbi_l].blas_phys[(size_t)d];
-                        int is_bnd = 0;
-                        for (int d=0; d<cap_rC; d++)
-                            if (bphys[(size_t)d] < cap_bd[(size_t)d]) { is_bnd=1; break; }
-                        if (!is_bnd) {
-                            if (!cap_cx) {
-                                const double *src=(const double *)bCb;
-                                double *dst=(double *)bCa;
-                                for (size_t f=0;f<cap_tblas;f++) dst[cap_sidx[f]]+=src[f];
-                            } else {
-                                const double _Complex *src=(const double _Complex *)bCb;
-                                double _Complex *dst=(double _Complex *)bCa;
-                                for (size_t f=0;f<cap_tblas;f++) dst[cap_sidx[f]]+=src[f];
-                            }
-                        } else {
-                            size_t bc[MAX_RANK];
-                            memset(bc,0,(size_t)cap_rC*sizeof(size_t));
-                            do {
-                                size_t bf=compute_flat_index((size_t)cap_rC,bc,cap_bstr);
-                                if (!cap_cx)
-                                    ((double*)bCa)[cap_sidx[bf]]+=((const double*)bCb)[bf];
-                                else
-                                    ((double _Complex*)bCa)[cap_sidx[bf]]+=
-                                        ((const double _Complex*)bCb)[bf];
-                            } while (odometer_step((size_t)cap_rC, bc, bphys));
-                        }
-                    });
-#else
-                    for (size_t task_idx = 0; task_idx < cap_nfAc * cap_nfBc; task_idx++) {
-                        size_t fai_l = task_idx / cap_nfBc;
-                        size_t fbi_l = task_idx % cap_nfBc;
-                        if (!cap_Aexist[fai_l * cap_tcon + cf]) continue;
-                        if (!cap_Brow[fbi_l].fb_exists) continue;
-                        const void *bA  = cap_Ap + (fai_l * cap_tcon + cf) * cap_bpp;
-                        const void *bB  = cap_Bp + fbi_l * cap_bpp;
-                        void       *bCb = cap_Cb + task_idx * cap_bpp;
-                        void       *bCa = cap_Ca + task_idx * cap_bpp;
-#ifdef TENSOR_ZGEMM
-                        if (!cap_cx) {
-                            double alpha=1.0,beta=0.0;
-                            TENSOR_DGEMM(CblasRowMajor,CblasNoTrans,CblasNoTrans,
-                                cap_Mn,cap_Nn,cap_Kn, alpha,
-                                (const double *)bA,cap_Kn,
-                                (const double *)bB,cap_Nn,
-                                beta,(double *)bCb,cap_Nn);
-                        } else {
-                            double _Complex alpha=CMPLX(1.0,0.0),beta=CMPLX(0.0,0.0);
-                            TENSOR_ZGEMM(CblasRowMajor,CblasNoTrans,CblasNoTrans,
-                                cap_Mn,cap_Nn,cap_Kn, &alpha,
-                                (const double _Complex *)bA,cap_Kn,
-                                (const double _Complex *)bB,cap_Nn,
-                                &beta,(double _Complex *)bCb,cap_Nn);
-                        }
-#endif
-                        size_t bphys[MAX_RANK];
-                        {
-                            const size_t *pa2s = cap_Aphys +
-                                (fai_l * cap_tcon + cf) * MAX_RANK;
-                            for (int d=0;d<cap_rC;d++) bphys[(size_t)d] =
-                                (d < cap_nfA_bc)
-                                    ? pa2s[(size_t)plan->perm_A[d]]
-                                    : cap_Brow[fbi_l].blas_phys[(size_t)d];
-                        }
-                        int is_bnd=0;
-                        for (int d=0;d<cap_rC;d++)
-                            if (bphys[(size_t)d]<cap_bd[(size_t)d]){is_bnd=1;break;}
-                        if (!is_bnd) {
-                            if (!cap_cx){
-                                const double *src=(const double *)bCb;
-                                double *dst=(double *)bCa;
-                                for(size_t f=0;f<cap_tblas;f++) dst[cap_sidx[f]]+=src[f];
-                            } else {
-                                const double _Complex *src=(const double _Complex*)bCb;
-                                double _Complex *dst=(double _Complex*)bCa;
-                                for(size_t f=0;f<cap_tblas;f++) dst[cap_sidx[f]]+=src[f];
-                            }
-                        } else {
-                            size_t bc[MAX_RANK];
-                            memset(bc,0,(size_t)cap_rC*sizeof(size_t));
-                            do {
-                                size_t bf=compute_flat_index((size_t)cap_rC,bc,cap_bstr);
-                                if(!cap_cx)
-                                    ((double*)bCa)[cap_sidx[bf]]+=((const double*)bCb)[bf];
-                                else
-                                    ((double _Complex*)bCa)[cap_sidx[bf]]+=
-                                        ((const double _Complex*)bCb)[bf];
-                            } while(odometer_step((size_t)cap_rC,bc,bphys));
-                        }
-                    }
-#endif /* HAS_GCD */
-                } /* for cf (B-cached) */
-
-            } else {
-                /* -------------------------------------------------------- */
-                /* Double-buffered B I/O + GCD BLAS.                       */
-                /* load_b fills block_fB B tiles for (cf_idx, gB) into     */
-                /* slot bslot; main thread runs BLAS on the ready slot.    */
-                /* -------------------------------------------------------- */
-#ifdef HAS_GCD
-                b_io_err[0] = 0;
-                b_io_err[1] = 0;
-
-                char   *b_pb0 = B_perm_buf[0];
-                char   *b_pb1 = B_perm_buf[1];
-                MBTask *tb0   = tasks_buf[0];
-                MBTask *tb1   = tasks_buf[1];
-
-                IOProfiler *prof_ptr    = &prof;
-                size_t      fb_lo_cap   = fb_lo;
-                size_t      n_fB_cur_cap = n_fB_cur;
-
-                void (^load_b)(size_t, int) = ^(size_t cf_idx, int bslot) {
-                    const hsize_t *con_row = con_all + cf_idx * MAX_RANK;
-                    char   *Bpb   = (bslot == 0) ? b_pb0 : b_pb1;
-                    MBTask *btask = (bslot == 0) ? tb0   : tb1;
-                    int    err    = 0;
-
-                    for (size_t fbi_l = 0; fbi_l < n_fB_cur_cap; fbi_l++) {
-                        size_t fbi = fb_lo_cap + fbi_l;
-                        const hsize_t *fb_row = fb_all + fbi * MAX_RANK;
-
-                        hsize_t b_tile[MAX_RANK];
-                        memset(b_tile, 0, sizeof(b_tile));
-                        for (int d = 0; d < n_con; d++)
-                            b_tile[(size_t)plan->perm_B[d]] = con_row[(size_t)d];
-                        for (int q = 0; q < n_fB; q++)
-                            b_tile[(size_t)plan->perm_B[n_con + q]] =
-                                fb_row[(size_t)q];
-
-                        TileMetadata *mB = registry_get_tile(sh->reg_B, b_tile);
-                        btask[fbi_l].fb_exists =
-                            (mB && mB->status == TILE_STATUS_ON_DISK) ? 1 : 0;
-
-                        if (btask[fbi_l].fb_exists) {
-                            memset(B_raw_buf, 0, bpp);
-                            if (read_chunk_typed(dset_B, mB->phys_offset,
-                                                 B_raw_buf, esz, rank_B,
-                                                 sh->reg_B->chunk_dims,
-                                                 sh->h5type_mem) < 0) {
-                                err = 1;
-                                btask[fbi_l].fb_exists = 0;
-                            } else {
-                                prof_ptr->bytes_read_B   += bpp;
-                                prof_ptr->tiles_read_B++;
-                                prof_ptr->b_bytes_cur_mb += bpp;
-                                size_t phys_B[MAX_RANK];
-                                for (int d = 0; d < rank_B; d++) {
-                                    hsize_t end = mB->phys_offset[(size_t)d]
-                                                + sh->reg_B->chunk_dims[(size_t)d];
-                                    phys_B[(size_t)d] = (size_t)(
-                                        (end > sh->reg_B->global_dims[(size_t)d])
-                                        ? sh->reg_B->global_dims[(size_t)d]
-                                          - mB->phys_offset[(size_t)d]
-                                        : sh->reg_B->chunk_dims[(size_t)d]);
-                                }
-                                char *bperm = Bpb + fbi_l * bpp;
-                                if (perm_is_identity(plan->perm_B, rank_B)) {
-                                    memcpy(bperm, B_raw_buf, bpp);
-                                } else {
-                                    memset(bperm, 0, bpp);
-                                    tensor_permute(B_raw_buf, bperm,
-                                                   (size_t)rank_B, phys_B,
-                                                   sh->chunk_dims_B_sz,
-                                                   plan->perm_B, esz);
-                                }
-                                /* Store free-B phys dims at blas_phys[n_fA+q]. */
-                                for (int q = 0; q < n_fB; q++)
-                                    btask[fbi_l].blas_phys[(size_t)(n_fA + q)] =
-                                        phys_B[(size_t)plan->perm_B[n_con + q]];
-                            }
+            /* Step 3: Contracted loop on the task pool.
+             *
+             * Split-K:   executors own contracted slices, then reduce.
+             * B-cached:  one task per A row over every contracted step.
+             * Streaming: B loads and GEMM rows as a dependency graph
+             *            (mb_run_stream), so I/O overlaps compute. */
+            {
+                size_t nw = (split_k > 1) ? split_k : 1;
+                MBWork *ws = (split_k > 1) ? sk : &mbw;
+                int     rc;
+                uint64_t t3 = ios_now_ns();
+                ws[0].C_accum = C_accum_base;   /* swapped by Step 4 */
+                for (size_t s = 0; s < nw; s++) {
+                    ws[s].step_ns      = step_ns;
+                    ws[s].fb_lo        = fb_lo;
+                    ws[s].n_fA_cur     = n_fA_cur;
+                    ws[s].n_fB_cur     = n_fB_cur;
+                    ws[s].bytes_read_B = 0;
+                    ws[s].err          = 0;
+                }
+                if (split_k > 1) {
+                    rc = mb_split_k_run(pool, sk, split_k,
+                                        n_fA_cur * n_fB_cur * bpp);
+                } else if (use_b_cache) {
+                    task_pool_parallel_for(pool, n_fA_cur,
+                                           mb_task_row_cached, &mbw);
+                    rc = 0;
+                } else {
+                    /* Grow the ring to this pair's size (slots are kept). */
+                    while (ring_alloc < ring) {
+                        size_t r = ring_alloc;
+                        if (posix_memalign((void **)&B_perm_buf[r], 16384,
+                                           block_fB * bpp) != 0) {
+                            B_perm_buf[r] = NULL;
+                            break;
                         }
+                        tasks_buf[r] = (MBTask *)malloc(block_fB * sizeof(MBTask));
+                        if (!tasks_buf[r]) break;
+                        mbw.B_slot[r]  = B_perm_buf[r];
+                        mbw.bt_slot[r] = tasks_buf[r];
+                        ring_alloc++;
                     }
-                    b_io_err[bslot] = err;
-                    dispatch_semaphore_signal(bslot == 0 ? b_sem0 : b_sem1);
-                };
-
-                /* Kick pipeline: cf=0→slot0, cf=1→slot1. */
-                dispatch_async(b_io_q, ^{ load_b(0, 0); });
-                if (total_con > 1)
-                    dispatch_async(b_io_q, ^{ load_b(1, 1); });
-
-                size_t cf = 0;
-                while (cf < total_con && ret == 0) {
-                    int bslot = (int)(cf % 2);
-                    dispatch_semaphore_wait(bslot == 0 ? b_sem0 : b_sem1,
-                                           DISPATCH_TIME_FOREVER);
-                    if (b_io_err[bslot]) {
-                        fprintf(stderr,
-                                "exec_macroblock_gcd: async B read error\n");
-                        ret = -1; break;
-                    }
-
-                    /* Check if any A tile exists for this cf in the group. */
-                    int any_a = 0;
-                    for (size_t fai_l = 0; fai_l < n_fA_cur; fai_l++)
-                        if (A_exist[fai_l * total_con + cf]) { any_a = 1; break; }
-
-                    if (any_a) {
-                        MBTask *btask_cur = (bslot == 0) ? tb0 : tb1;
-                        const char   *cap_Ap     = A_cache_base;
-                        const char   *cap_Bp     = (bslot==0) ? b_pb0 : b_pb1;
-                        char         *cap_Cb     = C_blas_base;
-                        char         *cap_Ca     = C_accum_base;
-                        const MBTask *cap_tasks  = btask_cur;
-                        const size_t *cap_sidx   = sh->scatter_idx;
-                        const size_t *cap_bstr   = sh->blas_strides;
-                        size_t cap_tblas         = sh->total_blas;
-                        int cap_Mn = sh->M_nom, cap_Kn = sh->K_nom,
-                            cap_Nn = sh->N_nom;
-                        int    cap_rC    = rank_C;
-                        int    cap_cx    = is_cplx;
-                        size_t cap_bpp   = bpp;
-                        size_t cap_nfAc  = n_fA_cur;
-                        size_t cap_nfBc  = n_fB_cur;
-                        size_t cap_tcon  = total_con;
-                        size_t cap_cf    = cf;
-                        int   *cap_Aexist = A_exist;
-                        const size_t *cap_Aphys = A_phys_cache;
-                        const size_t *cap_bd    = sh->blas_dims;
-                        int cap_nfA = n_fA;
-
-                        dispatch_apply(cap_nfAc * cap_nfBc,
-                                       DISPATCH_APPLY_AUTO,
-                                       ^(size_t task_idx) {
-                            size_t fai_l = task_idx / cap_nfBc;
-                            size_t fbi_l = task_idx % cap_nfBc;
-                            if (!cap_Aexist[fai_l * cap_tcon + cap_cf]) return;
-                            if (!cap_tasks[fbi_l].fb_exists) return;
-                            const void *bA  = cap_Ap +
-                                (fai_l * cap_tcon + cap_cf) * cap_bpp;
-                            const void *bB  = cap_Bp + fbi_l * cap_bpp;
-                            void       *bCb = cap_Cb + task_idx * cap_bpp;
-                            void       *bCa = cap_Ca + task_idx * cap_bpp;
-#ifdef TENSOR_ZGEMM
-                            if (!cap_cx) {
-                                double alpha=1.0,beta=0.0;
-                                TENSOR_DGEMM(CblasRowMajor,CblasNoTrans,
-                                    CblasNoTrans, cap_Mn,cap_Nn,cap_Kn, alpha,
-                                    (const double *)bA,cap_Kn,
-                                    (const double *)bB,cap_Nn,
-                                    beta,(double *)bCb,cap_Nn);
-                            } else {
-                                double _Complex alpha=CMPLX(1.0,0.0),
-                                               beta=CMPLX(0.0,0.0);
-                                TENSOR_ZGEMM(CblasRowMajor,CblasNoTrans,
-                                    CblasNoTrans, cap_Mn,cap_Nn,cap_Kn,
-                                    &alpha,(const double _Complex *)bA,cap_Kn,
-                                    (const double _Complex *)bB,cap_Nn,
-                                    &beta,(double _Complex *)bCb,cap_Nn);
-                            }
-#else
-                            memset(bCb, 0, cap_bpp);
-#endif
-                            /* Combine A and B physical dims for boundary check. */
-                            size_t bphys[MAX_RANK];
-                            const size_t *pa3 = cap_Aphys +
-                                (fai_l * cap_tcon + cap_cf) * MAX_RANK;
-                            for (int d=0; d<cap_rC; d++)
-                                bphys[(size_t)d] = (d < cap_nfA)
-                                    ? pa3[(size_t)plan->perm_A[d]]
-                                    : cap_tasks[fbi_l].blas_phys[(size_t)d];
-                            int is_bnd=0;
-                            for (int d=0;d<cap_rC;d++)
-                                if (bphys[(size_t)d]<cap_bd[(size_t)d]){is_bnd=1;break;}
-                            if (!is_bnd) {
-                                if (!cap_cx) {
-                                    const double *src=(const double *)bCb;
-                                    double *dst=(double *)bCa;
-                                    for (size_t f=0;f<cap_tblas;f++)
-                                        dst[cap_sidx[f]]+=src[f];
-                                } else {
-                                    const double _Complex *src=
-                                        (const double _Complex *)bCb;
-                                    double _Complex *dst=(double _Complex *)bCa;
-                                    for (size_t f=0;f<cap_tblas;f++)
-                                        dst[cap_sidx[f]]+=src[f];
-                                }
-                            } else {
-                                size_t bc[MAX_RANK];
-                                memset(bc,0,(size_t)cap_rC*sizeof(size_t));
-                                do {
-                                    size_t bf=compute_flat_index(
-                                        (size_t)cap_rC,bc,cap_bstr);
-                                    if (!cap_cx)
-                                        ((double*)bCa)[cap_sidx[bf]]+=
-                                            ((const double*)bCb)[bf];
-                                    else
-                                        ((double _Complex*)bCa)[cap_sidx[bf]]+=
-                                            ((const double _Complex*)bCb)[bf];
-                                } while (odometer_step((size_t)cap_rC,bc,bphys));
-                            }
-                        }); /* dispatch_apply */
-                    } /* if any_a */
-
-                    /* Recycle slot for cf+2. */
-                    if (cf + 2 < total_con)
-                        dispatch_async(b_io_q, ^{ load_b(cf + 2, bslot); });
-                    cf++;
-                } /* while contracted loop (GCD) */
-
-                /* Drain before leaving the gB block. */
-                dispatch_sync(b_io_q, ^{});
-
-#else /* !HAS_GCD — serial path */
-                {
-                    for (size_t cf = 0; cf < total_con && ret == 0; cf++) {
-                        int any_a = 0;
-                        for (size_t fai_l = 0; fai_l < n_fA_cur; fai_l++)
-                            if (A_exist[fai_l * total_con + cf]) { any_a=1; break; }
-                        if (!any_a) continue;
-
-                        /* Serial B load for this cf and gB slice. */
-                        MBTask *btask = tasks_buf[0];
-                        const hsize_t *con_row = con_all + cf * MAX_RANK;
-                        for (size_t fbi_l = 0; fbi_l < n_fB_cur; fbi_l++) {
-                            size_t fbi = fb_lo + fbi_l;
-                            const hsize_t *fb_row = fb_all + fbi * MAX_RANK;
-                            hsize_t b_tile[MAX_RANK];
-                            memset(b_tile, 0, sizeof(b_tile));
-                            for (int d = 0; d < n_con; d++)
-                                b_tile[(size_t)plan->perm_B[d]] = con_row[(size_t)d];
-                            for (int q = 0; q < n_fB; q++)
-                                b_tile[(size_t)plan->perm_B[n_con + q]] =
-                                    fb_row[(size_t)q];
-                            TileMetadata *mB = registry_get_tile(sh->reg_B, b_tile);
-                            btask[fbi_l].fb_exists =
-                                (mB && mB->status == TILE_STATUS_ON_DISK) ? 1 : 0;
-                            if (btask[fbi_l].fb_exists) {
-                                memset(B_raw_buf, 0, bpp);
-                                if (read_chunk_typed(dset_B, mB->phys_offset,
-                                    B_raw_buf, esz, rank_B,
-                                    sh->reg_B->chunk_dims, sh->h5type_mem) < 0) {
-                                    fprintf(stderr,
-                                        "exec_macroblock_gcd: B read error\n");
-                                    ret = -1; break;
-                                }
-                                prof.bytes_read_B   += bpp;
-                                prof.tiles_read_B++;
-                                prof.b_bytes_cur_mb += bpp;
-                                size_t phys_B[MAX_RANK];
-                                for (int d = 0; d < rank_B; d++) {
-                                    hsize_t end = mB->phys_offset[(size_t)d]
-                                                + sh->reg_B->chunk_dims[(size_t)d];
-                                    phys_B[(size_t)d] = (size_t)(
-                                        (end > sh->reg_B->global_dims[(size_t)d])
-                                        ? sh->reg_B->global_dims[(size_t)d]
-                                          - mB->phys_offset[(size_t)d]
-                                        : sh->reg_B->chunk_dims[(size_t)d]);
-                                }
-                                char *bperm = B_perm_buf[0] + fbi_l * bpp;
-                                if (perm_is_identity(plan->perm_B, rank_B)) {
-                                    memcpy(bperm, B_raw_buf, bpp);
-                                } else {
-                                    memset(bperm, 0, bpp);
-                                    tensor_permute(B_raw_buf, bperm,
-                                        (size_t)rank_B, phys_B,
-                                        sh->chunk_dims_B_sz, plan->perm_B, esz);
-                                }
-                                for (int q = 0; q < n_fB; q++)
-                                    btask[fbi_l].blas_phys[(size_t)(n_fA + q)] =
-                                        phys_B[(size_t)plan->perm_B[n_con + q]];
-                            }
-                        }
-                        if (ret != 0) break;
-
-                        /* Serial BLAS over (fai_l, fbi_l). */
-                        for (size_t fai_l = 0; fai_l < n_fA_cur; fai_l++) {
-                            if (!A_exist[fai_l * total_con + cf]) continue;
-                            const size_t *pa3 = A_phys_cache +
-                                (fai_l * total_con + cf) * MAX_RANK;
-                            const void *bA = A_cache_base +
-                                (fai_l * total_con + cf) * bpp;
-                            for (size_t fbi_l = 0; fbi_l < n_fB_cur; fbi_l++) {
-                                if (!btask[fbi_l].fb_exists) continue;
-                                size_t task_idx = fai_l * n_fB_cur + fbi_l;
-                                const void *bB  = B_perm_buf[0] + fbi_l * bpp;
-                                void       *bCb = C_blas_base   + task_idx * bpp;
-                                void       *bCa = C_accum_base  + task_idx * bpp;
-#ifdef TENSOR_ZGEMM
-                                if (!is_cplx) {
-                                    double alpha=1.0,beta=0.0;
-                                    TENSOR_DGEMM(CblasRowMajor,CblasNoTrans,
-                                        CblasNoTrans, sh->M_nom,sh->N_nom,
-                                        sh->K_nom, alpha,(const double *)bA,
-                                        sh->K_nom,(const double *)bB,sh->N_nom,
-                                        beta,(double *)bCb,sh->N_nom);
-                                } else {
-                                    double _Complex alpha=CMPLX(1.0,0.0),
-                                                   beta=CMPLX(0.0,0.0);
-                                    TENSOR_ZGEMM(CblasRowMajor,CblasNoTrans,
-                                        CblasNoTrans, sh->M_nom,sh->N_nom,
-                                        sh->K_nom, &alpha,
-                                        (const double _Complex *)bA,sh->K_nom,
-                                        (const double _Complex *)bB,sh->N_nom,
-                                        &beta,(double _Complex *)bCb,sh->N_nom);
-                                }
-#endif
-                                size_t bphys[MAX_RANK];
-                                for (int d=0;d<rank_C;d++)
-                                    bphys[(size_t)d] = (d < n_fA)
-                                        ? pa3[(size_t)plan->perm_A[d]]
-                                        : btask[fbi_l].blas_phys[(size_t)d];
-                                int is_bnd=0;
-                                for (int d=0;d<rank_C;d++)
-                                    if (bphys[(size_t)d]<sh->blas_dims[(size_t)d])
-                                        { is_bnd=1; break; }
-                                if (!is_bnd) {
-                                    if (!is_cplx) {
-                                        const double *src=(const double *)bCb;
-                                        double *dst=(double *)bCa;
-                                        for(size_t f=0;f<sh->total_blas;f++)
-                                            dst[sh->scatter_idx[f]]+=src[f];
-                                    } else {
-                                        const double _Complex *src=
-                                            (const double _Complex *)bCb;
-                                        double _Complex *dst=(double _Complex *)bCa;
-                                        for(size_t f=0;f<sh->total_blas;f++)
-                                            dst[sh->scatter_idx[f]]+=src[f];
-                                    }
-                                } else {
-                                    size_t bc[MAX_RANK];
-                                    memset(bc,0,(size_t)rank_C*sizeof(size_t));
-                                    do {
-                                        size_t bf=compute_flat_index(
-                                            (size_t)rank_C,bc,sh->blas_strides);
-                                        if (!is_cplx)
-                                            ((double*)bCa)[sh->scatter_idx[bf]]+=
-                                                ((const double*)bCb)[bf];
-                                        else
-                                            ((double _Complex*)bCa)
-                                                [sh->scatter_idx[bf]]+=
-                                                ((const double _Complex*)bCb)[bf];
-                                    } while(odometer_step((size_t)rank_C,bc,bphys));
-                                }
-                            }
-                        }
-                    } /* for cf serial */
+                    if (ring > ring_alloc) ring = ring_max = ring_alloc;
+                    if (ring > ring_peak)  ring_peak = ring;
+                    mbw.ring = ring;
+                    rc = mb_run_stream(pool, &mbw);
+                    if (rc == 0 && !ring_fixed)
+                        ring = mb_ring_size(&stream, task_pool_size(pool),
+                                            ring_max);
                 }
-#endif /* HAS_GCD */
-
-            } /* !use_b_cache contracted loop */
+                step_ns = (ios_now_ns() - t3) / total_con;
+                for (size_t s = 0; s < nw; s++) {
+                    prof.bytes_read_B   += ws[s].bytes_read_B;
+                    prof.tiles_read_B   += ws[s].bytes_read_B / bpp;
+                    prof.b_bytes_cur_mb += ws[s].bytes_read_B;
+                }
+                if (rc != 0) {
+                    fprintf(stderr, "exec_macroblock_gcd: %s\n",
+                            rc == -4 ? "task allocation failed"
+                                     : "B read error");
+                    ret = -1;
+                }
+            }
 
             /* ------------------------------------------------------------ */
             /* Redundancy assertion: B reads this (gA,gB) pair must not     */
@@ -2360,8 +2977,29 @@ static int exec_macroblock_gcd(const ContractionShared *sh,
             }
 
             /* ------------------------------------------------------------ */
-            /* Step 4: Write completed C tiles for this (gA, gB) pair.     */
+            /* Step 4: Queue this pair's C tiles as writebacks.            */
+            /*                                                              */
+            /* The previous pair's writes had all of this pair's compute   */
+            /* to drain; once they have, its buffer becomes the next       */
+            /* pair's accumulator and this one is written behind it.  The  */
+            /* deadline is when that buffer is needed again.  Tiles go out */
+            /* in C's row-major tile order, each run of consecutive tiles  */
+            /* as one request, so a new file allocates them back to back  */
+            /* and the native format writes each run with one pwritev.    */
             /* ------------------------------------------------------------ */
+            if (ret == 0 && mb_tile_io_wait(ios, c_wr, n_wr) < 0) {
+                fprintf(stderr, "exec_macroblock_gcd: write_chunk_typed "
+                                "failed before pair (%zu,%zu)\n", gA, gB);
+                ret = -1;
+            }
+            n_wr = 0;
+            {
+                char *t      = C_wb_base;
+                C_wb_base    = C_accum_base;
+                C_accum_base = t;
+            }
+            pair_ns = ios_now_ns() - t_pair;
+            size_t n_c = 0;
             for (size_t fai_l = 0; fai_l < n_fA_cur && ret == 0; fai_l++) {
                 size_t fai = fa_lo + fai_l;
                 const hsize_t *fa_row = fa_all + fai * MAX_RANK;
@@ -2380,42 +3018,81 @@ static int exec_macroblock_gcd(const ContractionShared *sh,
 
                     TileMetadata *mC = registry_get_tile(sh->reg_C, c_tile);
                     if (mC) {
-                        char *C_data = C_accum_base +
-                            (fai_l * n_fB_cur + fbi_l) * bpp;
-                        if (write_chunk_typed(dset_C, mC->phys_offset,
-                                              C_data, esz, rank_C,
-                                              sh->reg_C->chunk_dims,
-                                              sh->h5type_mem) < 0) {
-                            fprintf(stderr,
-                                    "exec_macroblock_gcd: write_chunk_typed "
-                                    "failed at pair (%zu,%zu)\n", gA, gB);
-                            ret = -1; break;
-                        }
-                        prof.bytes_written_C += bpp;
-                        prof.tiles_written_C++;
+                        c_ord[n_c].idx = (size_t)(mC - sh->reg_C->tiles);
+                        c_ord[n_c].off = mC->phys_offset;
+                        c_ord[n_c].buf = C_wb_base
+                                         + (fai_l * n_fB_cur + fbi_l) * bpp;
+                        n_c++;
                     }
+                    if (!sym || gB == gA) continue;
+
+                    /* Its mirror: tile (fb,fa), the transpose of this one.
+                     * Mirrored dims have equal chunk sides, so the padded
+                     * tile permutes as a whole. */
+                    hsize_t m_tile[MAX_RANK];
+                    memset(m_tile, 0, sizeof(m_tile));
+                    for (int d = 0; d < rank_C; d++)
+                        m_tile[(size_t)sh->c_mirror[d]] = c_tile[(size_t)d];
+                    TileMetadata *mM = registry_get_tile(sh->reg_C, m_tile);
+                    if (!mM) continue;
+                    char *mir = C_mir_base + (fai_l * n_fB_cur + fbi_l) * bpp;
+                    tensor_permute(C_wb_base + (fai_l * n_fB_cur + fbi_l) * bpp,
+                                   mir, (size_t)rank_C, c_chunk, c_chunk,
+                                   sh->c_mirror, esz);
+                    c_ord[n_c].idx = (size_t)(mM - sh->reg_C->tiles);
+                    c_ord[n_c].off = mM->phys_offset;
+                    c_ord[n_c].buf = mir;
+                    n_c++;
+                }
+            }
+            qsort(c_ord, n_c, sizeof(MBCWrite), mb_cwrite_cmp);
+            {
+                size_t   run_max  = MB_WRITE_BATCH_BYTES / bpp;
+                uint64_t deadline = ios_now_ns() + pair_ns;
+                if (run_max < 1) run_max = 1;
+                for (size_t i = 0; i < n_c && ret == 0; ) {
+                    size_t len = 1;
+                    while (i + len < n_c && len < run_max &&
+                           c_ord[i + len].idx == c_ord[i].idx + len)
+                        len++;
+                    for (size_t k = i; k < i + len; k++) {
+                        c_offs[k] = c_ord[k].off;
+                        c_bufs[k] = c_ord[k].buf;
+                    }
+                    MBTileIO *io = &c_wr[n_wr++];
+                    mb_tile_io_init(io, sh, st_C, NULL, NULL, 1,
+                                    IOS_WRITEBACK, deadline);
+                    io->n_tiles   = len;
+                    io->offs      = c_offs + i;
+                    io->bufs      = c_bufs + i;
+                    io->req.bytes = len * bpp;
+                    ios_submit(ios, &io->req);
+                    prof.bytes_written_C += len * bpp;
+                    prof.tiles_written_C += len;
+                    i += len;
                 }
             }
 
             pair_done++;
             printf("\r  Block-pair %zu / %zu  (%.1f%%)",
-                   pair_done, P_A * P_B,
-                   100.0 * (double)pair_done / (double)(P_A * P_B));
+                   pair_done, n_pairs,
+                   100.0 * (double)pair_done / (double)n_pairs);
             fflush(stdout);
 
         } /* for gB */
     } /* for gA */
 
+    /* Drain the last pair's writebacks. */
+    if (mb_tile_io_wait(ios, c_wr, n_wr) < 0) {
+        fprintf(stderr, "exec_macroblock_gcd: write_chunk_typed failed "
+                        "(last pair)\n");
+        ret = -1;
+    }
+    n_wr = 0;
+
     printf("\n");
 
 mb_cleanup:
-#ifdef HAS_GCD
-    /* Drain any in-flight B-load before reading profiler (memory barrier). */
-    if (b_io_q) {
-        dispatch_sync(b_io_q, ^{});  /* ensures all prof_ptr writes are visible */
-    }
-#endif
-
     /* ------------------------------------------------------------------ */
     /* I/O Profiling Report                                                */
     /* ------------------------------------------------------------------ */
@@ -2445,6 +3122,13 @@ mb_cleanup:
                prof.n_macroblocks, P_A, P_B);
         printf("  block_fA / block_fB   : %zu / %zu tiles\n", block_fA, block_fB);
         printf("  B pre-cache active    : %s\n", use_b_cache ? "YES" : "NO");
+        if (sh->shm_B)
+            printf("  Shared B tile cache   : %zu hits, %zu read for all, "
+                   "%zu private  (%zu / %zu slots used)\n",
+                   atomic_load(&sh->shm_B->n_hit),
+                   atomic_load(&sh->shm_B->n_fill),
+                   atomic_load(&sh->shm_B->n_miss),
+                   shmc_slots_used(sh->shm_B), shmc_slots(sh->shm_B));
         printf("\n");
 
         /* Table header */
@@ -2497,6 +3181,36 @@ mb_cleanup:
         } else if (prof.bytes_read_C == 0) {
             printf("  C accumulators stayed in RAM — zero disk reads of C.\n");
         }
+
+        if (stream.n_loads > 0) {
+            double nl   = (double)stream.n_loads;
+            double mean = stream.load_s / nl;
+            double var  = stream.load_s2 / nl - mean * mean;
+            printf("  Prefetch ring: %zu slots at end, %zu peak; %zu loads, "
+                   "%zu starved, %zu > 1 step ahead\n",
+                   ring, ring_peak, stream.n_loads, stream.n_starved,
+                   stream.n_ahead);
+            printf("  B load %.3f ± %.3f ms, compute %.3f ms per step\n",
+                   1e3 * mean, 1e3 * sqrt(var > 0.0 ? var : 0.0),
+                   1e3 * (double)atomic_load(&stream.row_ns) * 1e-9
+                       / (double)(pool ? task_pool_size(pool) : 1) / nl);
+        }
+
+        if (ios) {
+            printf("\n  %-12s  %8s  %8s  %8s  %10s  %10s  %10s  %9s\n",
+                   "I/O class", "Requests", "Promoted", "Missed",
+                   "Mean wait", "Mean serv.", "Max lat.", "Throttle");
+            for (int c = 0; c < IOS_N_CLASSES; c++) {
+                ios_stats_t st = ios_stats(ios, (ios_class_t)c);
+                double n = st.n ? (double)st.n : 1.0;
+                printf("  %-12s  %8zu  %8zu  %8zu  %7.3f ms  %7.3f ms  "
+                       "%7.3f ms  %7.3f s\n",
+                       ios_class_name((ios_class_t)c), st.n, st.n_promoted,
+                       st.n_missed, 1e3 * st.wait_s / n,
+                       1e3 * st.service_s / n, 1e3 * st.max_latency_s,
+                       st.throttle_s);
+            }
+        }
         printf("=================================================================\n");
 
         /* ---------------------------------------------------------------- */
@@ -2513,8 +3227,8 @@ mb_cleanup:
             size_t base_rd_A   = size_A;
             size_t base_rd_B   = total_fA * size_B;
             /* 2D SUMMA actuals (from profiler). */
-            size_t summa_A_ram = block_fA * total_con * bpp;
-            size_t summa_B_ram = 2 * block_fB * bpp;
+            size_t summa_A_ram = block_fA * total_con * a_stride;
+            size_t summa_B_ram = ring_peak * block_fB * bpp;
             size_t summa_C_ram = block_fA * block_fB * bpp;
             double total_base  = (double)(base_rd_A + base_rd_B);
             double total_summa = (double)(prof.bytes_read_A + prof.bytes_read_B);
@@ -2532,7 +3246,7 @@ mb_cleanup:
                    "A-cache RAM",
                    (double)base_A_ram  / GiB, (double)summa_A_ram / GiB);
             printf("  %-28s  %8.3f GiB  %8.3f GiB\n",
-                   "B-buffer RAM (2 slots)",
+                   "B-buffer RAM (ring slots)",
                    (double)base_B_ram  / GiB, (double)summa_B_ram / GiB);
             printf("  %-28s  %8.3f GiB  %8.3f GiB\n",
                    "C-accum RAM",
@@ -2567,31 +3281,44 @@ mb_cleanup:
         }
     }
 
-#ifdef HAS_GCD
-    /* Release GCD objects (already drained by dispatch_sync above). */
-    if (b_io_q) {
-        dispatch_release(b_io_q);
-    }
-    if (b_sem0) dispatch_release(b_sem0);
-    if (b_sem1) dispatch_release(b_sem1);
-    free(b_io_err);
-#endif
     free(A_phys_cache);
     free(fb_all);
     free(fa_all);
+    for (size_t s = 1; sk && s < split_k; s++) {
+        free(sk[s].mem);
+        free(sk[s].bt_slot[0]);
+    }
+    free(sk);
+    if (warm) {
+        ios_drain(ios);             /* kept: only wait out writebacks   */
+    } else {
+        task_pool_destroy(pool);
+        ios_destroy(ios);           /* finishes queued writebacks first */
+    }
+    free(c_wr);
+    free(c_ord);
+    free(c_offs);
+    free(c_bufs);
+    mb_buf_free(warm, C_wb_base);
+    mb_buf_free(warm, C_mir_base);
     free(tasks_full);
-    free(B_full_cache);
+    mb_buf_free(warm, B_full_cache);
     free(con_all);
     free(A_exist);
-    free(tasks_buf[1]);
-    free(tasks_buf[0]);
-    free(C_accum_base);
-    free(C_blas_base);
-    free(B_perm_buf[1]);
-    free(B_perm_buf[0]);
+    free(stream.rows_left);
+    free(stream.step_cf);
+    for (size_t r = 0; r < MB_RING_MAX; r++) {
+        free(tasks_buf[r]);
+        if (r < 2) mb_buf_free(warm, B_perm_buf[r]);
+        else       free(B_perm_buf[r]);
+    }
+    mb_buf_free(warm, C_accum_base);
+    mb_buf_free(warm, C_blas_base);
+    free(B_tile_tmp);
     free(B_raw_buf);
     free(A_perm_buf);
-    free(A_cache_base);
+    mb_buf_free(warm, A_cache_base);
+    free(A_pack_tmp);
     return ret;
 }
 
@@ -2599,11 +3326,218 @@ mb_cleanup:
 /* run_contraction_einsum                                                    */
 /* ----------------------------------------------------------------------- */
 
+/* Cleanup helper for the einsum path, whose tensors are StorageFiles. */
+static void einsum_cleanup(BufferPool *pool, TensorRegistry *reg_A,
+                           TensorRegistry *reg_B, TensorRegistry *reg_C,
+                           StorageFile *st_A, StorageFile *st_B,
+                           StorageFile *st_C)
+{
+    if (pool)  pool_destroy(pool);
+    if (reg_A) registry_destroy(reg_A);
+    if (reg_B) registry_destroy(reg_B);
+    if (reg_C) registry_destroy(reg_C);
+    stg_close(st_A);
+    stg_close(st_B);
+    stg_close(st_C);
+}
+
+/*
+ * Virtual tiling for contiguous operands (storage.h).  The contracted dims
+ * of A and B must be tiled alike: a contiguous B takes A's tile sides on
+ * them (a contiguous A, B's when B is chunked); free dims keep the default
+ * virtual sides.
+ */
+static void einsum_plan_virtual_tiles(const contraction_plan_t *plan,
+                                      StorageFile *st_A, StorageFile *st_B)
+{
+    if (!st_A->virtual_tiles && !st_B->virtual_tiles) return;
+    StorageFile       *v   = st_B->virtual_tiles ? st_B : st_A;
+    const StorageFile *ref = (v == st_B) ? st_A : st_B;
+    hsize_t chunk[MAX_RANK];
+    memcpy(chunk, v->chunk_dims, sizeof(chunk));
+    for (int d = 0; d < plan->n_contracted; d++) {
+        int a_dim = plan->perm_A[plan->n_free_A + d];
+        int b_dim = plan->perm_B[d];
+        if (v == st_B) chunk[b_dim] = ref->chunk_dims[a_dim];
+        else           chunk[a_dim] = ref->chunk_dims[b_dim];
+    }
+    stg_set_tiling(v, chunk);
+
+    for (int k = 0; k < 2; k++) {
+        const StorageFile *f = k ? st_B : st_A;
+        if (!f->virtual_tiles) continue;
+        printf("Virtual tiling %c: ", k ? 'B' : 'A');
+        for (int d = 0; d < f->rank; d++)
+            printf("%s%llu", d ? "\xc3\x97" : "",
+                   (unsigned long long)f->chunk_dims[d]);
+        printf("\n");
+    }
+}
+
+static void einsum_print_shape(int rank, const hsize_t *dims, const char *end)
+{
+    for (int d = 0; d < rank; d++)
+        printf("%s%llu", d ? "\xc3\x97" : "", (unsigned long long)dims[d]);
+    printf("%s", end);
+}
+
+/*
+ * Output chunk shape requested through TENSOR_C_CHUNK_DIMS ("64,64,32" or
+ * "64x64x32"), clamped to global_C.  Returns 1 and fills chunk, 0 if unset,
+ * or -1 if malformed.
+ */
+static int einsum_c_chunk_request(int rank_C, const hsize_t *global_C,
+                                  hsize_t *chunk)
+{
+    const char *env = getenv("TENSOR_C_CHUNK_DIMS");
+    if (!env || !*env) return 0;
+    const char *p = env;
+    int         n = 0;
+    while (*p && n < MAX_RANK) {
+        char *end;
+        unsigned long long v = strtoull(p, &end, 10);
+        if (end == p || v == 0) break;
+        chunk[n] = (v < global_C[n]) ? (hsize_t)v : global_C[n];
+        n++;
+        p = end;
+        if (*p == ',' || *p == 'x') p++;
+        else break;
+    }
+    if (*p || n != rank_C) {
+        fprintf(stderr, "run_contraction_einsum: TENSOR_C_CHUNK_DIMS='%s' "
+                        "must list %d positive sides\n", env, rank_C);
+        return -1;
+    }
+    return 1;
+}
+
+/*
+ * Give C the engine's natural tiling when its file is chunked otherwise:
+ * wrap it in a retile view (storage.h) and rescan.  The view is made
+ * writable once the pool is sized.  Returns 0, or -1 (C already closed).
+ */
+static int einsum_retile_c(StorageFile **st_C, TensorRegistry **reg_C,
+                           const hsize_t *chunk_dims_C)
+{
+    int rank = (*st_C)->rank;
+    if (memcmp((*st_C)->chunk_dims, chunk_dims_C, (size_t)rank * sizeof(hsize_t)) == 0)
+        return 0;
+    printf("Output retiling: tiles ");
+    einsum_print_shape(rank, chunk_dims_C, " -> chunks ");
+    einsum_print_shape(rank, (*st_C)->chunk_dims, "\n");
+    registry_destroy(*reg_C);
+    *reg_C = NULL;
+    *st_C  = stg_retile(*st_C, chunk_dims_C);
+    if (!*st_C) return -1;
+    *reg_C = stg_scan(*st_C);
+    if (!*reg_C) {
+        stg_close(*st_C);           /* closes the wrapped C too */
+        *st_C = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Same-operand symmetric product, C[x,y] = sum_k A[x,k] A[y,k]
+ * (e.g. "ikab,jkab->ij" with A and B the same dataset): free index q of A
+ * and free index q of B sit on the same operand dim, and so does each
+ * contracted index.  Then C tile (x,y) is the transpose of tile (y,x) and
+ * mirror[d] names the C dim that dim d swaps with.  Returns 1 if so.
+ */
+static int einsum_plan_symmetric(const contraction_plan_t *plan,
+                                 const TensorRegistry *reg_A,
+                                 const TensorRegistry *reg_B, int *mirror)
+{
+    int n_fA = plan->n_free_A, n_con = plan->n_contracted;
+    if (plan->rank_A != plan->rank_B || n_fA != plan->n_free_B || n_fA == 0 ||
+        memcmp(reg_A->chunk_dims, reg_B->chunk_dims,
+               (size_t)plan->rank_A * sizeof(hsize_t)) != 0)
+        return 0;
+    for (int q = 0; q < n_fA; q++)
+        if (plan->perm_A[q] != plan->perm_B[n_con + q]) return 0;
+    for (int d = 0; d < n_con; d++)
+        if (plan->perm_A[n_fA + d] != plan->perm_B[d]) return 0;
+    for (int d = 0; d < plan->rank_C; d++) {
+        int blas = plan->perm_C[d];
+        int swap = (blas < n_fA) ? blas + n_fA : blas - n_fA;
+        for (int e = 0; e < plan->rank_C; e++)
+            if (plan->perm_C[e] == swap) mirror[d] = e;
+    }
+    return 1;
+}
+
+/* A common side may grow a tile side at most this much over the larger of
+ * the two sides it replaces; beyond that the larger side is used. */
+#define EINSUM_RETILE_MAX_GROWTH 4
+
+static hsize_t einsum_gcd(hsize_t a, hsize_t b)
+{
+    while (b) { hsize_t t = a % b; a = b; b = t; }
+    return a;
+}
+
+/*
+ * Common tiling for chunked operands (storage.h, retile).  When A and B
+ * were chunked differently along a contracted index, both are read under
+ * a shared side: the LCM of the two, so every virtual tile is a whole
+ * number of physical chunks of each, unless that grows the tile more than
+ * EINSUM_RETILE_MAX_GROWTH× — then the larger side, and the finer operand
+ * assembles tiles from partially overlapping chunks.  Free dims keep their
+ * chunking.  Returns 0, or -1 if a view cannot be made.
+ */
+static int einsum_plan_common_tiles(const contraction_plan_t *plan,
+                                    StorageFile **st_A, StorageFile **st_B)
+{
+    hsize_t ca[MAX_RANK], cb[MAX_RANK];
+    int     re_A = 0, re_B = 0;
+    memcpy(ca, (*st_A)->chunk_dims, sizeof(ca));
+    memcpy(cb, (*st_B)->chunk_dims, sizeof(cb));
+    for (int d = 0; d < plan->n_contracted; d++) {
+        int     a_dim = plan->perm_A[plan->n_free_A + d];
+        int     b_dim = plan->perm_B[d];
+        hsize_t a = ca[a_dim], b = cb[b_dim];
+        if (a == b) continue;
+        hsize_t ext  = (*st_A)->global_dims[a_dim];
+        hsize_t big  = (a > b) ? a : b;
+        hsize_t side = a / einsum_gcd(a, b) * b;
+        if (side > big * EINSUM_RETILE_MAX_GROWTH) side = big;
+        if (side > ext) side = ext;
+        re_A |= (side != a);
+        re_B |= (side != b);
+        ca[a_dim] = cb[b_dim] = side;
+    }
+
+    for (int k = 0; k < 2; k++) {
+        StorageFile  **st = k ? st_B : st_A;
+        const hsize_t *c  = k ? cb : ca;
+        if (!(k ? re_B : re_A)) continue;
+        printf("Retiling %c: ", k ? 'B' : 'A');
+        einsum_print_shape((*st)->rank, (*st)->chunk_dims, " -> ");
+        einsum_print_shape((*st)->rank, c, "\n");
+        if ((*st)->virtual_tiles) {
+            stg_set_tiling(*st, c);
+        } else {
+            *st = stg_retile(*st, c);
+            if (!*st) return -1;
+        }
+    }
+    return 0;
+}
+
+static long einsum_stored_tiles(const TensorRegistry *reg)
+{
+    long n = 0;
+    for (size_t t = 0; t < reg->total_tiles; t++)
+        n += reg->tiles[t].status == TILE_STATUS_ON_DISK;
+    return n;
+}
+
 static int run_einsum_impl(const char *expr,
                             const char *file_A, const char *name_A,
                             const char *file_B, const char *name_B,
                             const char *file_C, const char *name_C,
-                            int accumulate)
+                            int accumulate, const engine_run_opts_t *opts)
 {
     printf("\n=== N-D Einsum Contraction Engine%s ===\n",
            accumulate ? " (accumulate)" : "");
@@ -2623,72 +3557,52 @@ static int run_einsum_impl(const char *expr,
         printf("%s\n", einsum_sprint_plan(&plan, buf, sizeof(buf)));
     }
 
+    /* 2. Open A and B through their storage backends.                   */
     /* ------------------------------------------------------------------ */
-    /* 2. Open A and B.                                                    */
-    /* ------------------------------------------------------------------ */
-    hid_t fa = engine_fopen_cached(file_A, H5F_ACC_RDONLY, HDF5_CHUNK_CACHE_BYTES);
-    hid_t fb = engine_fopen_cached(file_B, H5F_ACC_RDONLY, HDF5_CHUNK_CACHE_BYTES);
-    if (fa < 0 || fb < 0) {
+    StorageFile *st_A = stg_open(file_A, name_A, 0);
+    StorageFile *st_B = stg_open(file_B, name_B, 0);
+    if (!st_A || !st_B) {
         fprintf(stderr,
                 "run_contraction_einsum: cannot open '%s' or '%s'\n",
                 file_A, file_B);
-        if (fa >= 0) H5Fclose(fa);
-        if (fb >= 0) H5Fclose(fb);
-        return -1;
-    }
-
-    hid_t dset_A = dset_open_no_cache(fa, name_A);
-    hid_t dset_B = dset_open_no_cache(fb, name_B);
-    if (dset_A < 0 || dset_B < 0) {
-        fprintf(stderr,
-                "run_contraction_einsum: cannot open dataset '%s' or '%s'\n",
-                name_A, name_B);
-        engine_cleanup(NULL, NULL, NULL, NULL,
-                       dset_A, dset_B, -1, fa, fb, -1);
+        einsum_cleanup(NULL, NULL, NULL, NULL, st_A, st_B, NULL);
         return -1;
     }
 
     /* ------------------------------------------------------------------ */
     /* 3. Read rank and global dims; verify they match the parse result.  */
     /* ------------------------------------------------------------------ */
-    hid_t fsp_A = H5Dget_space(dset_A);
-    hid_t fsp_B = H5Dget_space(dset_B);
-    if (fsp_A < 0 || fsp_B < 0) {
-        if (fsp_A >= 0) H5Sclose(fsp_A);
-        if (fsp_B >= 0) H5Sclose(fsp_B);
-        engine_cleanup(NULL, NULL, NULL, NULL,
-                       dset_A, dset_B, -1, fa, fb, -1);
-        return -1;
-    }
-
-    int rank_A = H5Sget_simple_extent_ndims(fsp_A);
-    int rank_B = H5Sget_simple_extent_ndims(fsp_B);
-    hsize_t global_A[MAX_RANK], global_B[MAX_RANK];
-    H5Sget_simple_extent_dims(fsp_A, global_A, NULL);
-    H5Sget_simple_extent_dims(fsp_B, global_B, NULL);
-    H5Sclose(fsp_A);
-    H5Sclose(fsp_B);
+    int            rank_A   = st_A->rank;
+    int            rank_B   = st_B->rank;
+    const hsize_t *global_A = st_A->global_dims;
+    const hsize_t *global_B = st_B->global_dims;
 
     if (rank_A != plan.rank_A || rank_B != plan.rank_B) {
         fprintf(stderr,
                 "run_contraction_einsum: rank mismatch — "
                 "A has rank %d (plan %d), B has rank %d (plan %d)\n",
                 rank_A, plan.rank_A, rank_B, plan.rank_B);
-        engine_cleanup(NULL, NULL, NULL, NULL,
-                       dset_A, dset_B, -1, fa, fb, -1);
+        einsum_cleanup(NULL, NULL, NULL, NULL, st_A, st_B, NULL);
         return -1;
     }
 
     /* ------------------------------------------------------------------ */
     /* 4. Build registries and scan tiles.                                 */
     /* ------------------------------------------------------------------ */
-    TensorRegistry *reg_A = registry_create_from_dset(dset_A);
-    TensorRegistry *reg_B = registry_create_from_dset(dset_B);
+    einsum_plan_virtual_tiles(&plan, st_A, st_B);
+    if (einsum_plan_common_tiles(&plan, &st_A, &st_B) != 0) {
+        fprintf(stderr, "run_contraction_einsum: cannot retile A or B\n");
+        einsum_cleanup(NULL, NULL, NULL, NULL, st_A, st_B, NULL);
+        return -1;
+    }
+    global_A = st_A->global_dims;
+    global_B = st_B->global_dims;
+    printf("Scanning input tiles...\n");
+    TensorRegistry *reg_A = stg_scan(st_A);
+    TensorRegistry *reg_B = stg_scan(st_B);
     if (!reg_A || !reg_B) {
-        fprintf(stderr,
-                "run_contraction_einsum: registry_create_from_dset failed\n");
-        engine_cleanup(NULL, reg_A, reg_B, NULL,
-                       dset_A, dset_B, -1, fa, fb, -1);
+        fprintf(stderr, "run_contraction_einsum: tile scan failed\n");
+        einsum_cleanup(NULL, reg_A, reg_B, NULL, st_A, st_B, NULL);
         return -1;
     }
 
@@ -2699,8 +3613,7 @@ static int run_einsum_impl(const char *expr,
                 "A is %s, B is %s; mixed-type contraction not supported\n",
                 (reg_A->dtype == DTYPE_FP64) ? "FP64" : "COMPLEX128",
                 (reg_B->dtype == DTYPE_FP64) ? "FP64" : "COMPLEX128");
-        engine_cleanup(NULL, reg_A, reg_B, NULL,
-                       dset_A, dset_B, -1, fa, fb, -1);
+        einsum_cleanup(NULL, reg_A, reg_B, NULL, st_A, st_B, NULL);
         return -1;
     }
 
@@ -2709,9 +3622,8 @@ static int run_einsum_impl(const char *expr,
                                   ? sizeof(double)
                                   : sizeof(double _Complex);
 
-    printf("Scanning input tiles...\n");
-    long tiles_A = registry_scan_file(dset_A, reg_A);
-    long tiles_B = registry_scan_file(dset_B, reg_B);
+    long tiles_A = einsum_stored_tiles(reg_A);
+    long tiles_B = einsum_stored_tiles(reg_B);
     printf("  A: %ld tiles   B: %ld tiles\n", tiles_A, tiles_B);
 
     /* ------------------------------------------------------------------ */
@@ -2726,8 +3638,7 @@ static int run_einsum_impl(const char *expr,
                     "A dim %d = %llu, B dim %d = %llu\n",
                     a_dim, (unsigned long long)global_A[(size_t)a_dim],
                     b_dim, (unsigned long long)global_B[(size_t)b_dim]);
-            engine_cleanup(NULL, reg_A, reg_B, NULL,
-                           dset_A, dset_B, -1, fa, fb, -1);
+            einsum_cleanup(NULL, reg_A, reg_B, NULL, st_A, st_B, NULL);
             return -1;
         }
     }
@@ -2755,60 +3666,50 @@ static int run_einsum_impl(const char *expr,
     }
 
     /* ------------------------------------------------------------------ */
-    /* 7. Open or create output dataset C.                                 */
+    /* 7. Open or create output tensor C.                                  */
     /* ------------------------------------------------------------------ */
-    hid_t fc = -1, dset_C = -1;
+    StorageFile    *st_C  = NULL;
     TensorRegistry *reg_C = NULL;
 
     if (!accumulate) {
-        /* Normal mode: create a fresh C file. */
-        if (create_chunked_dataset_einsum(file_C, name_C, rank_C,
-                                          global_C, chunk_dims_C, dtype) < 0) {
-            fprintf(stderr,
-                    "run_contraction_einsum: create_chunked_dataset_einsum "
-                    "failed for '%s'\n", file_C);
-            engine_cleanup(NULL, reg_A, reg_B, NULL,
-                           dset_A, dset_B, -1, fa, fb, -1);
+        /* Normal mode: create a fresh C file; its format follows the name
+         * and its chunking follows the request, if any. */
+        hsize_t file_chunk_C[MAX_RANK];
+        int     req = einsum_c_chunk_request(rank_C, global_C, file_chunk_C);
+        if (req < 0) {
+            einsum_cleanup(NULL, reg_A, reg_B, NULL, st_A, st_B, NULL);
             return -1;
         }
-        fc     = engine_fopen_cached(file_C, H5F_ACC_RDWR, HDF5_CHUNK_CACHE_BYTES);
-        dset_C = (fc >= 0) ? dset_open_no_cache(fc, name_C) : -1;
-        if (fc < 0 || dset_C < 0) {
-            fprintf(stderr,
-                    "run_contraction_einsum: cannot open output '%s'\n", file_C);
-            engine_cleanup(NULL, reg_A, reg_B, NULL,
-                           dset_A, dset_B, dset_C, fa, fb, fc);
-            return -1;
-        }
-        reg_C = registry_create_from_dset(dset_C);
+        st_C  = stg_create(file_C, name_C, rank_C, global_C,
+                           req ? file_chunk_C : chunk_dims_C, dtype);
+        reg_C = st_C ? stg_scan(st_C) : NULL;
+        if (reg_C && einsum_retile_c(&st_C, &reg_C, chunk_dims_C) != 0)
+            st_C = NULL;
         if (!reg_C) {
             fprintf(stderr,
-                    "run_contraction_einsum: registry_create_from_dset(C) "
-                    "failed\n");
-            engine_cleanup(NULL, reg_A, reg_B, NULL,
-                           dset_A, dset_B, dset_C, fa, fb, fc);
+                    "run_contraction_einsum: cannot create output '%s'\n",
+                    file_C);
+            einsum_cleanup(NULL, reg_A, reg_B, NULL, st_A, st_B, st_C);
             return -1;
         }
     } else {
         /* Accumulate mode: open an existing C file and validate it. */
-        fc     = engine_fopen_cached(file_C, H5F_ACC_RDWR, HDF5_CHUNK_CACHE_BYTES);
-        dset_C = (fc >= 0) ? dset_open_no_cache(fc, name_C) : -1;
-        if (fc < 0 || dset_C < 0) {
+        st_C = stg_open(file_C, name_C, 1);
+        if (!st_C) {
             fprintf(stderr,
                     "run_contraction_einsum_acc: cannot open existing C '%s'.\n"
                     "  C must exist before calling run_contraction_einsum_acc.\n",
                     file_C);
-            engine_cleanup(NULL, reg_A, reg_B, NULL,
-                           dset_A, dset_B, dset_C, fa, fb, fc);
+            einsum_cleanup(NULL, reg_A, reg_B, NULL, st_A, st_B, NULL);
             return -1;
         }
-        reg_C = registry_create_from_dset(dset_C);
+        /* Scan existing tiles so exec_macroblock_gcd knows which are on disk.
+         * A contiguous C is tiled like the result. */
+        if (st_C->virtual_tiles) stg_set_tiling(st_C, chunk_dims_C);
+        reg_C = stg_scan(st_C);
         if (!reg_C) {
-            fprintf(stderr,
-                    "run_contraction_einsum_acc: registry_create_from_dset(C) "
-                    "failed\n");
-            engine_cleanup(NULL, reg_A, reg_B, NULL,
-                           dset_A, dset_B, dset_C, fa, fb, fc);
+            fprintf(stderr, "run_contraction_einsum_acc: C tile scan failed\n");
+            einsum_cleanup(NULL, reg_A, reg_B, NULL, st_A, st_B, st_C);
             return -1;
         }
         /* Validate shape compatibility. */
@@ -2817,8 +3718,7 @@ static int run_einsum_impl(const char *expr,
                     "run_contraction_einsum_acc: C rank mismatch — "
                     "file has rank %d, contraction expects %d\n",
                     reg_C->rank, rank_C);
-            engine_cleanup(NULL, reg_A, reg_B, reg_C,
-                           dset_A, dset_B, dset_C, fa, fb, fc);
+            einsum_cleanup(NULL, reg_A, reg_B, reg_C, st_A, st_B, st_C);
             return -1;
         }
         for (int d = 0; d < rank_C; d++) {
@@ -2829,8 +3729,7 @@ static int run_einsum_impl(const char *expr,
                         d,
                         (unsigned long long)reg_C->global_dims[(size_t)d],
                         (unsigned long long)global_C[(size_t)d]);
-                engine_cleanup(NULL, reg_A, reg_B, reg_C,
-                               dset_A, dset_B, dset_C, fa, fb, fc);
+                einsum_cleanup(NULL, reg_A, reg_B, reg_C, st_A, st_B, st_C);
                 return -1;
             }
         }
@@ -2840,32 +3739,24 @@ static int run_einsum_impl(const char *expr,
                     "file=%s, contraction expects %s\n",
                     (reg_C->dtype == DTYPE_FP64) ? "FP64" : "COMPLEX128",
                     (dtype          == DTYPE_FP64) ? "FP64" : "COMPLEX128");
-            engine_cleanup(NULL, reg_A, reg_B, reg_C,
-                           dset_A, dset_B, dset_C, fa, fb, fc);
+            einsum_cleanup(NULL, reg_A, reg_B, reg_C, st_A, st_B, st_C);
+            return -1;
+        }
+        if (!st_C->virtual_tiles &&
+            einsum_retile_c(&st_C, &reg_C, chunk_dims_C) != 0) {
+            fprintf(stderr, "run_contraction_einsum_acc: cannot retile C\n");
+            einsum_cleanup(NULL, reg_A, reg_B, reg_C, st_A, st_B, NULL);
             return -1;
         }
-        /* Scan existing tiles so exec_macroblock_gcd knows which are on disk. */
-        long tiles_C = registry_scan_file(dset_C, reg_C);
-        printf("  C: %ld existing tiles (accumulate mode)\n", tiles_C);
+        printf("  C: %ld existing tiles (accumulate mode)\n",
+               einsum_stored_tiles(reg_C));
     }
 
     /* ------------------------------------------------------------------ */
-    /* 8. HDF5 memory type for typed I/O.                                 */
+    /* 8. Report the storage backends.                                     */
     /* ------------------------------------------------------------------ */
-    hid_t h5type_mem;
-    if (dtype == DTYPE_FP64) {
-        h5type_mem = H5T_NATIVE_DOUBLE;
-    } else {
-        h5type_mem = create_h5_complex_type();
-        if (h5type_mem < 0) {
-            fprintf(stderr,
-                    "run_contraction_einsum: create_h5_complex_type "
-                    "failed\n");
-            engine_cleanup(NULL, reg_A, reg_B, reg_C,
-                           dset_A, dset_B, dset_C, fa, fb, fc);
-            return -1;
-        }
-    }
+    printf("Storage: A %s  B %s  C %s\n", st_A->ops->name, st_B->ops->name,
+           st_C->ops->name);
 
     /* ------------------------------------------------------------------ */
     /* 9. Initialise memory pool (80% RAM, min 8 pages).                  */
@@ -2944,18 +3835,14 @@ static int run_einsum_impl(const char *expr,
                 "run_contraction_einsum: RAM too small for %d pages "
                 "(need %zu bytes)\n", 3 + 1 + WQ_CAP + 4,
                 (size_t)(3 + 1 + WQ_CAP + 4) * bytes_per_page);
-        if (dtype != DTYPE_FP64) H5Tclose(h5type_mem);
-        engine_cleanup(NULL, reg_A, reg_B, reg_C,
-                       dset_A, dset_B, dset_C, fa, fb, fc);
+        einsum_cleanup(NULL, reg_A, reg_B, reg_C, st_A, st_B, st_C);
         return -1;
     }
 
     BufferPool *pool = pool_create(num_pages, bytes_per_page);
     if (!pool) {
         fprintf(stderr, "run_contraction_einsum: pool_create failed\n");
-        if (dtype != DTYPE_FP64) H5Tclose(h5type_mem);
-        engine_cleanup(NULL, reg_A, reg_B, reg_C,
-                       dset_A, dset_B, dset_C, fa, fb, fc);
+        einsum_cleanup(NULL, reg_A, reg_B, reg_C, st_A, st_B, st_C);
         return -1;
     }
 
@@ -2967,6 +3854,16 @@ static int run_einsum_impl(const char *expr,
            num_pages, elems_per_page,
            (double)(num_pages * bytes_per_page) / (1024.0 * 1024.0 * 1024.0));
 
+    /* A retiled C holds partially written chunks until they fill; bound
+     * them by TENSOR_C_STAGE_MB, by default an eighth of the pool. */
+    if (st_C->ops == &stg_retile_ops) {
+        const char *env    = getenv("TENSOR_C_STAGE_MB");
+        size_t      budget = (env && *env)
+                           ? (size_t)strtoull(env, NULL, 10) << 20
+                           : num_pages * bytes_per_page / 8;
+        stg_retile_stage(st_C, budget);
+    }
+
     /* ------------------------------------------------------------------ */
     /* 10. Precompute nominal BLAS dimensions.                             */
     /* ------------------------------------------------------------------ */
@@ -3036,9 +3933,7 @@ static int run_einsum_impl(const char *expr,
     size_t *scatter_idx = (size_t *)malloc(total_blas * sizeof(size_t));
     if (!scatter_idx) {
         fprintf(stderr, "run_contraction_einsum: scatter_idx malloc failed\n");
-        if (dtype != DTYPE_FP64) H5Tclose(h5type_mem);
-        engine_cleanup(pool, reg_A, reg_B, reg_C,
-                       dset_A, dset_B, dset_C, fa, fb, fc);
+        einsum_cleanup(pool, reg_A, reg_B, reg_C, st_A, st_B, st_C);
         return -1;
     }
     {
@@ -3069,13 +3964,11 @@ static int run_einsum_impl(const char *expr,
     memset(&sh, 0, sizeof(sh));
     sh.file_A = file_A; sh.name_A = name_A;
     sh.file_B = file_B; sh.name_B = name_B;
-    sh.dset_C = dset_C;
     sh.reg_A  = reg_A;  sh.reg_B  = reg_B;  sh.reg_C  = reg_C;
     sh.plan   = plan;
     sh.rank_A = rank_A; sh.rank_B = rank_B; sh.rank_C = rank_C;
     sh.dtype  = dtype;
     sh.element_size = element_size;
-    sh.h5type_mem   = h5type_mem;
     sh.bytes_per_page = bytes_per_page;
     sh.M_nom = M_nom; sh.N_nom = N_nom; sh.K_nom = K_nom;
     sh.total_blas = total_blas;
@@ -3090,19 +3983,85 @@ static int run_einsum_impl(const char *expr,
     sh.pool_num_pages      = num_pages;
     sh.accumulate          = accumulate;
 
+    /* Pre-packed A-cache: pack each A tile once per gA instead of inside
+     * every GEMM.  Automatic when the backend can pack this dtype;
+     * TENSOR_PACK_A=0 disables it. */
+    {
+        const char *env_pack = getenv("TENSOR_PACK_A");
+        int         want     = !(env_pack && strcmp(env_pack, "0") == 0);
+        size_t      pk       = tile_gemm_pack_size(dtype, M_nom, N_nom, K_nom);
+        sh.a_pack_bytes = want ? pk : 0;
+        sh.a_pack_any_n = tile_gemm_packed_any_n();
+
+        /* TENSOR_COMPLEX_PLANAR=1: hold complex tiles as real/imaginary
+         * planes in the A and B caches and multiply them with 3M real
+         * GEMMs.  Tiles are split once as they enter the caches; files
+         * stay interleaved. */
+        const char *env_pl = getenv("TENSOR_COMPLEX_PLANAR");
+        sh.planar = dtype == DTYPE_COMPLEX128 && env_pl &&
+                    strcmp(env_pl, "1") == 0;
+        if (sh.planar) sh.a_pack_bytes = 0;
+        printf("A-cache packing: %s\n",
+               sh.planar ? "planar complex (3M real GEMMs)"
+               : sh.a_pack_bytes ? tile_gemm_pack_name()
+                                 : (pk ? "off (TENSOR_PACK_A=0)"
+                                       : "unavailable for this backend/dtype"));
+    }
+
+    /* Node-local shared B tile cache: TENSOR_SHM_CACHE_MB=N (or the
+     * caller's shm_cache_mb) lets jobs on one node that read the same B
+     * dataset under the same tiling share tiles through /dev/shm.  A
+     * retiled or virtually tiled B (whose tiles are not the file's chunks)
+     * stays out of it. */
+    {
+        const char *env_shm = getenv("TENSOR_SHM_CACHE_MB");
+        long mb = (env_shm && *env_shm) ? strtol(env_shm, NULL, 10) : 0;
+        if (opts && opts->shm_cache_mb) mb = (long)opts->shm_cache_mb;
+        if (mb > 0 && st_B->ops == &stg_retile_ops)
+            printf("Shared B tile cache: off (B is retiled)\n");
+        else if (mb > 0 && st_B->virtual_tiles)
+            printf("Shared B tile cache: off (B is contiguous)\n");
+        else if (mb > 0)
+            sh.shm_B = shmc_attach(file_B, name_B, rank_B,
+                                   sh.chunk_dims_B_sz, bytes_per_page,
+                                   reg_B->total_tiles, (size_t)mb << 20);
+        if (sh.shm_B)
+            printf("Shared B tile cache: %s  (%zu slots, %zu filled)\n",
+                   sh.shm_B->name, shmc_slots(sh.shm_B),
+                   shmc_slots_used(sh.shm_B));
+    }
+
+    /* Symmetric product: with B the same dataset as A and the indices
+     * paired up, only block pairs on and above the diagonal are computed
+     * and each off-diagonal one is also written transposed.  Accumulate
+     * mode keeps the full loop, since the old C need not be symmetric.
+     * TENSOR_SYMMETRIC=0 disables it. */
+    {
+        const char *env_sy = getenv("TENSOR_SYMMETRIC");
+        sh.symmetric = !accumulate &&
+                       !(env_sy && strcmp(env_sy, "0") == 0) &&
+                       strcmp(file_A, file_B) == 0 &&
+                       strcmp(name_A, name_B) == 0 &&
+                       einsum_plan_symmetric(&plan, reg_A, reg_B, sh.c_mirror);
+        if (sh.symmetric)
+            printf("Symmetric product: B is A, computing the upper block "
+                   "triangle of C\n");
+    }
+
     /* ------------------------------------------------------------------ */
-    /* 12-13. Execute: A-pinning macro-block loop + GCD parallel BLAS.   */
+    /* 12-13. Execute: A-pinning macro-block loop + task-parallel BLAS.  */
     /* ------------------------------------------------------------------ */
-    int ret = exec_macroblock_gcd(&sh, dset_A, dset_B, dset_C);
+    sh.warm = opts ? opts->warm : NULL;
+    int ret = exec_macroblock_gcd(&sh, st_A, st_B, st_C);
+    if (stg_retile_flush(st_C) != 0) ret = -1;
     printf("\nN-D contraction complete.\n");
+    shmc_detach(sh.shm_B);
 
     pool_destroy(pool);
 
     free(scatter_idx);
-    if (dtype != DTYPE_FP64) H5Tclose(h5type_mem);
     /* Pass NULL for pool since we destroyed it above. */
-    engine_cleanup(NULL, reg_A, reg_B, reg_C,
-                   dset_A, dset_B, dset_C, fa, fb, fc);
+    einsum_cleanup(NULL, reg_A, reg_B, reg_C, st_A, st_B, st_C);
     return ret;
 }
 
@@ -3116,7 +4075,7 @@ int run_contraction_einsum(const char *expr,
                             const char *file_C, const char *name_C)
 {
     return run_einsum_impl(expr, file_A, name_A, file_B, name_B,
-                           file_C, name_C, /*accumulate=*/0);
+                           file_C, name_C, /*accumulate=*/0, NULL);
 }
 
 int run_contraction_einsum_acc(const char *expr,
@@ -3125,5 +4084,15 @@ int run_contraction_einsum_acc(const char *expr,
                                const char *file_C, const char *name_C)
 {
     return run_einsum_impl(expr, file_A, name_A, file_B, name_B,
-                           file_C, name_C, /*accumulate=*/1);
+                           file_C, name_C, /*accumulate=*/1, NULL);
+}
+
+int run_contraction_einsum_opts(const char *expr,
+                                const char *file_A, const char *name_A,
+                                const char *file_B, const char *name_B,
+                                const char *file_C, const char *name_C,
+                                int accumulate, const engine_run_opts_t *opts)
+{
+    return run_einsum_impl(expr, file_A, name_A, file_B, name_B,
+                           file_C, name_C, accumulate, opts);
 }
@@ -0,0 +1,327 @@
+/*
+ * io_sched.c — Prioritized I/O scheduler implementation (see io_sched.h).
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#  define _GNU_SOURCE           /* syscall(SYS_ioprio_set) */
+#endif
+
+#include "io_sched.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#  include <sys/syscall.h>
+/* <linux/ioprio.h> is not shipped everywhere; the ABI values are stable. */
+#  define IOS_IOPRIO_WHO_PROCESS 1
+#  define IOS_IOPRIO_CLASS_SHIFT 13
+#  define IOS_IOPRIO_CLASS_BE    2
+#  define IOS_IOPRIO_CLASS_IDLE  3
+#elif defined(__APPLE__)
+#  include <sys/resource.h>
+#endif
+
+static const int ios_default_depth[IOS_N_CLASSES] = {0, 2, 4, 0};
+
+uint64_t ios_now_ns(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000ull + (uint64_t)t.tv_nsec;
+}
+
+const char *ios_class_name(ios_class_t c)
+{
+    static const char *names[IOS_N_CLASSES] = {
+        "demand", "prefetch", "speculative", "writeback"
+    };
+    return ((int)c >= 0 && c < IOS_N_CLASSES) ? names[c] : "?";
+}
+
+/* Lower the calling thread's disk priority (background mode). */
+static void ios_apply_background(int mode)
+{
+    if (mode == IOS_BG_NONE) return;
+#if defined(__linux__) && defined(SYS_ioprio_set)
+    int prio = (mode == IOS_BG_IDLE)
+        ? IOS_IOPRIO_CLASS_IDLE << IOS_IOPRIO_CLASS_SHIFT
+        : (IOS_IOPRIO_CLASS_BE << IOS_IOPRIO_CLASS_SHIFT) | 7;  /* lowest BE */
+    if (syscall(SYS_ioprio_set, IOS_IOPRIO_WHO_PROCESS, 0, prio) != 0)
+        fprintf(stderr, "ios: ioprio_set failed (%s)\n", strerror(errno));
+#elif defined(__APPLE__)
+    if (setiopolicy_np(IOPOL_TYPE_DISK, IOPOL_SCOPE_THREAD,
+                       mode == IOS_BG_IDLE ? IOPOL_THROTTLE
+                                           : IOPOL_UTILITY) != 0)
+        fprintf(stderr, "ios: setiopolicy_np failed (%s)\n", strerror(errno));
+#else
+    fprintf(stderr, "ios: background I/O priority not supported here\n");
+#endif
+}
+
+/* Refill one bucket for dt seconds, capped at IOS_BURST_S of credit. */
+static void ios_refill(double *tok, double rate, double dt)
+{
+    if (rate <= 0.0) return;
+    *tok += rate * dt;
+    if (*tok > rate * IOS_BURST_S) *tok = rate * IOS_BURST_S;
+}
+
+static void ios_tokens_update(IOScheduler *s)
+{
+    uint64_t now = ios_now_ns();
+    double   dt  = (double)(now - s->t_tok) * 1e-9;
+    s->t_tok = now;
+    ios_refill(&s->tok_r,   s->lim.read_bps,  dt);
+    ios_refill(&s->tok_w,   s->lim.write_bps, dt);
+    ios_refill(&s->tok_ops, s->lim.iops,      dt);
+}
+
+/*
+ * Sleep until the buckets r draws from are out of debt; returns the
+ * seconds slept.  Called on the I/O thread without the lock.
+ */
+static double ios_throttle(IOScheduler *s, const ios_req_t *r)
+{
+    double slept = 0.0;
+    for (;;) {
+        ios_tokens_update(s);
+        double rate = r->write ? s->lim.write_bps : s->lim.read_bps;
+        double tok  = r->write ? s->tok_w : s->tok_r;
+        double wait = 0.0;
+        if (rate > 0.0 && tok < 0.0)
+            wait = -tok / rate;
+        if (s->lim.iops > 0.0 && s->tok_ops < 0.0 &&
+            -s->tok_ops / s->lim.iops > wait)
+            wait = -s->tok_ops / s->lim.iops;
+        if (wait <= 0.0) return slept;
+        struct timespec ts;
+        ts.tv_sec  = (time_t)wait;
+        ts.tv_nsec = (long)((wait - (double)ts.tv_sec) * 1e9);
+        nanosleep(&ts, NULL);
+        slept += wait;
+    }
+}
+
+/* Charge what r moved (pay-after: the next request waits off the debt). */
+static void ios_charge(IOScheduler *s, const ios_req_t *r)
+{
+    if (r->write) { if (s->lim.write_bps > 0.0) s->tok_w -= (double)r->bytes; }
+    else          { if (s->lim.read_bps  > 0.0) s->tok_r -= (double)r->bytes; }
+    if (s->lim.iops > 0.0) s->tok_ops -= (double)(r->ops ? r->ops : 1);
+}
+
+/* Insert r into list *head by deadline (0 = last), after equal keys. */
+static void ios_insert(ios_req_t **head, ios_req_t *r)
+{
+    uint64_t key = r->deadline_ns ? r->deadline_ns : UINT64_MAX;
+    while (*head) {
+        uint64_t k = (*head)->deadline_ns ? (*head)->deadline_ns : UINT64_MAX;
+        if (k > key) break;
+        head = &(*head)->next;
+    }
+    r->next = *head;
+    *head   = r;
+}
+
+static void ios_unlink(ios_req_t **head, ios_req_t *r)
+{
+    while (*head && *head != r) head = &(*head)->next;
+    if (*head) *head = r->next;
+    r->next = NULL;
+}
+
+static void *ios_thread_main(void *arg)
+{
+    IOScheduler *s = (IOScheduler *)arg;
+
+    ios_apply_background(s->lim.background);
+    s->t_tok = ios_now_ns();
+
+    pthread_mutex_lock(&s->mu);
+    for (;;) {
+        ios_req_t *r = NULL;
+        for (int c = 0; c < IOS_N_CLASSES && !r; c++)
+            if (s->head[c]) {
+                r = s->head[c];
+                s->head[c] = r->next;
+                r->next    = NULL;
+            }
+        if (!r) {
+            if (s->shutdown) break;
+            pthread_cond_wait(&s->cv_io, &s->mu);
+            continue;
+        }
+        r->state   = IOS_REQ_RUNNING;
+        pthread_mutex_unlock(&s->mu);
+
+        double throttled = ios_throttle(s, r);
+        r->t_start = ios_now_ns();
+        int rc = r->fn(r->arg);
+        ios_charge(s, r);
+
+        pthread_mutex_lock(&s->mu);
+        r->rc     = rc;
+        r->t_done = ios_now_ns();
+        r->state  = IOS_REQ_DONE;
+
+        ios_stats_t *st = &s->stats[r->cls];
+        double lat = (double)(r->t_done - r->t_submit) * 1e-9;
+        st->n++;
+        st->wait_s    += (double)(r->t_start - r->t_submit) * 1e-9;
+        st->service_s += (double)(r->t_done - r->t_start) * 1e-9;
+        st->throttle_s += throttled;
+        st->bytes      += r->bytes;
+        if (lat > st->max_latency_s) st->max_latency_s = lat;
+        if (r->deadline_ns && r->t_done > r->deadline_ns) st->n_missed++;
+        if (r->promoted) st->n_promoted++;
+        s->outstanding[r->cls]--;
+        pthread_cond_broadcast(&s->cv_done);
+    }
+    pthread_mutex_unlock(&s->mu);
+    return NULL;
+}
+
+/* Non-negative double from an environment variable (0 when unset). */
+static double ios_env_double(const char *name)
+{
+    const char *v = getenv(name);
+    double      d = (v && *v) ? strtod(v, NULL) : 0.0;
+    return (d > 0.0) ? d : 0.0;
+}
+
+IOScheduler *ios_create(const int *depth, const ios_limits_t *lim)
+{
+    IOScheduler *s = (IOScheduler *)calloc(1, sizeof(IOScheduler));
+    if (!s) return NULL;
+
+    memcpy(s->depth, ios_default_depth, sizeof(s->depth));
+    if (depth) {
+        memcpy(s->depth, depth, sizeof(s->depth));
+    } else {
+        const char *env = getenv("TENSOR_IO_DEPTH");
+        for (int c = 0; env && *env && c < IOS_N_CLASSES; c++) {
+            char *end;
+            long  v = strtol(env, &end, 10);
+            if (end == env) break;
+            s->depth[c] = (v > 0) ? (int)v : 0;
+            env = (*end == ',') ? end + 1 : end;
+        }
+    }
+
+    if (lim) {
+        s->lim = *lim;
+    } else {
+        const char *bg = getenv("TENSOR_IO_BACKGROUND");
+        s->lim.read_bps  = ios_env_double("TENSOR_IO_READ_MBPS")  * 1048576.0;
+        s->lim.write_bps = ios_env_double("TENSOR_IO_WRITE_MBPS") * 1048576.0;
+        s->lim.iops      = ios_env_double("TENSOR_IO_IOPS");
+        if (bg && strcmp(bg, "idle") == 0)
+            s->lim.background = IOS_BG_IDLE;
+        else if (bg && (strcmp(bg, "1") == 0 || strcmp(bg, "low") == 0))
+            s->lim.background = IOS_BG_LOW;
+    }
+    s->tok_r   = s->lim.read_bps  * IOS_BURST_S;
+    s->tok_w   = s->lim.write_bps * IOS_BURST_S;
+    s->tok_ops = s->lim.iops      * IOS_BURST_S;
+
+    pthread_mutex_init(&s->mu, NULL);
+    pthread_cond_init(&s->cv_io, NULL);
+    pthread_cond_init(&s->cv_done, NULL);
+    if (pthread_create(&s->thr, NULL, ios_thread_main, s) != 0) {
+        fprintf(stderr, "ios_create: pthread_create failed\n");
+        pthread_cond_destroy(&s->cv_done);
+        pthread_cond_destroy(&s->cv_io);
+        pthread_mutex_destroy(&s->mu);
+        free(s);
+        return NULL;
+    }
+    return s;
+}
+
+void ios_destroy(IOScheduler *s)
+{
+    if (!s) return;
+    pthread_mutex_lock(&s->mu);
+    s->shutdown = 1;
+    pthread_cond_signal(&s->cv_io);
+    pthread_mutex_unlock(&s->mu);
+    pthread_join(s->thr, NULL);
+    pthread_cond_destroy(&s->cv_done);
+    pthread_cond_destroy(&s->cv_io);
+    pthread_mutex_destroy(&s->mu);
+    free(s);
+}
+
+void ios_drain(IOScheduler *s)
+{
+    pthread_mutex_lock(&s->mu);
+    for (int c = 0; c < IOS_N_CLASSES; c++)
+        while (s->outstanding[c] > 0)
+            pthread_cond_wait(&s->cv_done, &s->mu);
+    pthread_mutex_unlock(&s->mu);
+}
+
+void ios_reset_stats(IOScheduler *s)
+{
+    pthread_mutex_lock(&s->mu);
+    memset(s->stats, 0, sizeof(s->stats));
+    pthread_mutex_unlock(&s->mu);
+}
+
+void ios_submit(IOScheduler *s, ios_req_t *r)
+{
+    pthread_mutex_lock(&s->mu);
+    if (s->depth[r->cls] > 0 && s->outstanding[r->cls] >= s->depth[r->cls]) {
+        s->stats[r->cls].n_blocked++;
+        while (s->outstanding[r->cls] >= s->depth[r->cls])
+            pthread_cond_wait(&s->cv_done, &s->mu);
+    }
+    s->outstanding[r->cls]++;
+    r->rc       = 0;
+    r->promoted = 0;
+    r->state    = IOS_REQ_QUEUED;
+    r->t_submit = ios_now_ns();
+    r->t_start  = r->t_done = 0;
+    ios_insert(&s->head[r->cls], r);
+    pthread_cond_signal(&s->cv_io);
+    pthread_mutex_unlock(&s->mu);
+}
+
+static int ios_wait_impl(IOScheduler *s, ios_req_t *r, int promote)
+{
+    pthread_mutex_lock(&s->mu);
+    if (promote && r->state == IOS_REQ_QUEUED && r->cls != IOS_DEMAND &&
+        !r->promoted) {
+        ios_unlink(&s->head[r->cls], r);
+        r->promoted = 1;
+        ios_insert(&s->head[IOS_DEMAND], r);
+    }
+    while (r->state != IOS_REQ_DONE && r->state != IOS_REQ_IDLE)
+        pthread_cond_wait(&s->cv_done, &s->mu);
+    int rc = r->rc;
+    pthread_mutex_unlock(&s->mu);
+    return rc;
+}
+
+int ios_wait(IOScheduler *s, ios_req_t *r)
+{
+    return ios_wait_impl(s, r, 1);
+}
+
+int ios_run(IOScheduler *s, ios_req_t *r)
+{
+    ios_submit(s, r);
+    return ios_wait_impl(s, r, 0);
+}
+
+ios_stats_t ios_stats(IOScheduler *s, ios_class_t c)
+{
+    pthread_mutex_lock(&s->mu);
+    ios_stats_t st = s->stats[c];
+    pthread_mutex_unlock(&s->mu);
+    return st;
+}
@@ -0,0 +1,498 @@
+/*
+ * job_server.c — Long-running contraction service (see job_server.h).
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#  define _GNU_SOURCE           /* struct ucred (SO_PEERCRED) */
+#endif
+
+#include "job_server.h"
+#include "memory.h"
+#include "shm_cache.h"
+#include "tensor_engine.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef MSG_NOSIGNAL
+#  define JSRV_SEND_FLAGS MSG_NOSIGNAL
+#else
+#  define JSRV_SEND_FLAGS 0            /* SO_NOSIGPIPE is set per socket */
+#endif
+
+#define JSRV_POLL_MS     200           /* accept loop: shutdown check     */
+#define JSRV_RECV_S      10            /* a client must send its request  */
+
+typedef struct jsrv_job {
+    int              op;
+    int              n_args;
+    const char      *args[JSRV_MAX_ARGS];
+    char             payload[JSRV_MAX_LEN + 1];
+    uint64_t         t_submit;
+    int              done;
+    jsrv_reply_t     rep;
+    struct jsrv_job *next;
+} jsrv_job_t;
+
+typedef struct {
+    pthread_mutex_t  mu;
+    pthread_cond_t   cv_work;     /* worker: job queued or closing          */
+    pthread_cond_t   cv_done;     /* connections: a job finished            */
+    jsrv_job_t      *head, *tail;
+    int              queued;
+    int              max_queue;
+    int              closing;
+    int              n_conn;      /* connection threads still running       */
+    uint64_t         jobs_done;
+    tensor_engine_t *eng;
+} JobServer;
+
+typedef struct {
+    JobServer *srv;
+    int        fd;
+} jsrv_conn_t;
+
+static uint64_t jsrv_now_ns(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000ull + (uint64_t)t.tv_nsec;
+}
+
+static const char *jsrv_op_name(int op)
+{
+    static const char *names[] = {
+        "?", "contract", "accumulate", "elementwise", "verify", "status",
+        "shutdown"
+    };
+    return (op > 0 && op <= JSRV_OP_SHUTDOWN) ? names[op] : names[0];
+}
+
+/* ----------------------------------------------------------------------- */
+/* Socket helpers                                                           */
+/* ----------------------------------------------------------------------- */
+
+static int jsrv_recv_all(int fd, void *buf, size_t n)
+{
+    char *p = (char *)buf;
+    while (n > 0) {
+        ssize_t r = recv(fd, p, n, 0);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return -1;
+        p += r;
+        n -= (size_t)r;
+    }
+    return 0;
+}
+
+static int jsrv_send_all(int fd, const void *buf, size_t n)
+{
+    const char *p = (const char *)buf;
+    while (n > 0) {
+        ssize_t r = send(fd, p, n, JSRV_SEND_FLAGS);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return -1;
+        p += r;
+        n -= (size_t)r;
+    }
+    return 0;
+}
+
+static void jsrv_no_sigpipe(int fd)
+{
+#ifdef SO_NOSIGPIPE
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#else
+    (void)fd;
+#endif
+}
+
+/* 1 if the peer on fd runs as this process's user.  Where the platform
+ * cannot tell, the socket file's 0600 mode is the only guard. */
+static int jsrv_peer_ok(int fd)
+{
+#if defined(SO_PEERCRED)
+    struct ucred cr;
+    socklen_t    len = sizeof(cr);
+    return getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cr, &len) == 0 &&
+           cr.uid == getuid();
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) || \
+      defined(__NetBSD__)
+    uid_t uid;
+    gid_t gid;
+    return getpeereid(fd, &uid, &gid) == 0 && uid == getuid();
+#else
+    (void)fd;
+    return 1;
+#endif
+}
+
+/* Fill addr for path; -1 if the path does not fit sun_path. */
+static int jsrv_addr(const char *path, struct sockaddr_un *addr)
+{
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr->sun_path)) {
+        fprintf(stderr, "jsrv: socket path too long: %s\n", path);
+        return -1;
+    }
+    strcpy(addr->sun_path, path);
+    return 0;
+}
+
+/* ----------------------------------------------------------------------- */
+/* Worker                                                                   */
+/* ----------------------------------------------------------------------- */
+
+/* Whether n arguments fit op. */
+static int jsrv_args_ok(int op, int n)
+{
+    switch (op) {
+    case JSRV_OP_CONTRACT:
+    case JSRV_OP_ACCUMULATE:
+    case JSRV_OP_VERIFY:      return n == 4;
+    case JSRV_OP_ELEMENTWISE: return n >= 3 && n <= JSRV_MAX_ARGS;
+    case JSRV_OP_STATUS:
+    case JSRV_OP_SHUTDOWN:    return n == 0;
+    default:                  return 0;
+    }
+}
+
+static void jsrv_run_job(JobServer *s, jsrv_job_t *j)
+{
+    const char *const *a = j->args;
+    switch (j->op) {
+    case JSRV_OP_CONTRACT:
+        j->rep.rc = tensor_engine_contract(s->eng, a[0], a[1], a[2], a[3]);
+        break;
+    case JSRV_OP_ACCUMULATE:
+        j->rep.rc = tensor_engine_accumulate(s->eng, a[0], a[1], a[2], a[3]);
+        break;
+    case JSRV_OP_ELEMENTWISE:
+        j->rep.rc = tensor_engine_elementwise(s->eng, a[0], a + 2,
+                                              j->n_args - 2, a[1]);
+        break;
+    case JSRV_OP_VERIFY: {
+        tensor_engine_verify_t v;
+        memset(&v, 0, sizeof(v));
+        j->rep.rc = tensor_engine_verify(s->eng, a[0], a[1], a[2], a[3], &v);
+        j->rep.max_rel_err = v.max_rel_err;
+        break;
+    }
+    }
+}
+
+static void *jsrv_worker_main(void *arg)
+{
+    JobServer *s = (JobServer *)arg;
+    pthread_mutex_lock(&s->mu);
+    for (;;) {
+        jsrv_job_t *j = s->head;
+        if (!j) {
+            if (s->closing) break;
+            pthread_cond_wait(&s->cv_work, &s->mu);
+            continue;
+        }
+        s->head = j->next;
+        if (!s->head) s->tail = NULL;
+        s->queued--;
+        pthread_mutex_unlock(&s->mu);
+
+        uint64_t t0 = jsrv_now_ns();
+        j->rep.queue_s = (double)(t0 - j->t_submit) * 1e-9;
+        jsrv_run_job(s, j);
+        j->rep.run_s   = (double)(jsrv_now_ns() - t0) * 1e-9;
+        printf("jsrv: %s %s: %s  (queued %.2f s, ran %.2f s)\n",
+               jsrv_op_name(j->op), j->args[0],
+               tensor_engine_strerror(j->rep.rc), j->rep.queue_s,
+               j->rep.run_s);
+        fflush(stdout);
+
+        pthread_mutex_lock(&s->mu);
+        s->jobs_done++;
+        j->done = 1;
+        pthread_cond_broadcast(&s->cv_done);
+    }
+    pthread_mutex_unlock(&s->mu);
+    return NULL;
+}
+
+/* ----------------------------------------------------------------------- */
+/* Connections                                                              */
+/* ----------------------------------------------------------------------- */
+
+/* Read and parse one request into j; returns 0, or -1 to drop the client. */
+static int jsrv_read_request(int fd, jsrv_job_t *j, int *bad)
+{
+    jsrv_hdr_t h;
+    *bad = 0;
+    if (jsrv_recv_all(fd, &h, sizeof(h)) != 0 || h.magic != JSRV_MAGIC ||
+        h.len > JSRV_MAX_LEN || h.n_args > JSRV_MAX_ARGS)
+        return -1;
+    if (h.len > 0 && jsrv_recv_all(fd, j->payload, h.len) != 0)
+        return -1;
+    j->payload[h.len] = '\0';
+    j->op     = (int)h.op;
+    j->n_args = (int)h.n_args;
+
+    size_t off = 0;
+    for (int i = 0; i < j->n_args; i++) {
+        if (off >= h.len) { *bad = 1; return 0; }
+        j->args[i] = j->payload + off;
+        off += strlen(j->args[i]) + 1;
+    }
+    if (!jsrv_args_ok(j->op, j->n_args)) *bad = 1;
+    if (j->n_args == 0) j->args[0] = "";
+    return 0;
+}
+
+static void *jsrv_conn_main(void *arg)
+{
+    jsrv_conn_t *cn = (jsrv_conn_t *)arg;
+    JobServer   *s  = cn->srv;
+    int          fd = cn->fd;
+    free(cn);
+
+    jsrv_job_t *j = (jsrv_job_t *)calloc(1, sizeof(jsrv_job_t));
+    int         bad = 0;
+    if (j && jsrv_read_request(fd, j, &bad) == 0) {
+        j->rep.magic = JSRV_MAGIC;
+        pthread_mutex_lock(&s->mu);
+        if (bad) {
+            j->rep.status = JSRV_BAD_REQUEST;
+        } else if (j->op == JSRV_OP_SHUTDOWN) {
+            s->closing = 1;
+            pthread_cond_signal(&s->cv_work);
+        } else if (j->op == JSRV_OP_STATUS) {
+            /* Counters only. */
+        } else if (s->closing) {
+            j->rep.status = JSRV_CLOSING;
+        } else if (s->queued >= s->max_queue) {
+            j->rep.status = JSRV_BUSY;
+        } else {
+            j->t_submit = jsrv_now_ns();
+            if (s->tail) s->tail->next = j; else s->head = j;
+            s->tail = j;
+            s->queued++;
+            pthread_cond_signal(&s->cv_work);
+            while (!j->done)
+                pthread_cond_wait(&s->cv_done, &s->mu);
+        }
+        j->rep.queued    = (uint32_t)s->queued;
+        j->rep.jobs_done = s->jobs_done;
+        pthread_mutex_unlock(&s->mu);
+        jsrv_send_all(fd, &j->rep, sizeof(j->rep));
+    }
+    free(j);
+    close(fd);
+
+    pthread_mutex_lock(&s->mu);
+    s->n_conn--;
+    pthread_cond_broadcast(&s->cv_done);
+    pthread_mutex_unlock(&s->mu);
+    return NULL;
+}
+
+/* ----------------------------------------------------------------------- */
+/* Server                                                                   */
+/* ----------------------------------------------------------------------- */
+
+/* Bound, listening socket at path; a stale socket file is replaced, a live
+ * server's is not.  -1 on failure. */
+static int jsrv_listen(const char *path)
+{
+    struct sockaddr_un addr;
+    if (jsrv_addr(path, &addr) != 0) return -1;
+
+    struct stat sb;
+    if (stat(path, &sb) == 0) {
+        if (!S_ISSOCK(sb.st_mode)) {
+            fprintf(stderr, "jsrv: %s exists and is not a socket\n", path);
+            return -1;
+        }
+        int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        int live  = probe >= 0 &&
+                    connect(probe, (struct sockaddr *)&addr, sizeof(addr)) == 0;
+        if (probe >= 0) close(probe);
+        if (live) {
+            fprintf(stderr, "jsrv: a server is already listening on %s\n",
+                    path);
+            return -1;
+        }
+        unlink(path);
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        fprintf(stderr, "jsrv: socket: %s\n", strerror(errno));
+        return -1;
+    }
+    /* Jobs read and write files with the server's rights, so only its
+     * own user may connect; jsrv_peer_ok() rechecks each connection. */
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        fprintf(stderr, "jsrv: bind %s: %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    if (chmod(path, S_IRUSR | S_IWUSR) != 0 || listen(fd, 64) != 0) {
+        fprintf(stderr, "jsrv: chmod/listen %s: %s\n", path, strerror(errno));
+        close(fd);
+        unlink(path);
+        return -1;
+    }
+    return fd;
+}
+
+int jsrv_serve(const char *path, const jsrv_config_t *cfg)
+{
+    jsrv_config_t c;
+    memset(&c, 0, sizeof(c));
+    if (cfg) c = *cfg;
+    if (c.keep_b    <= 0) c.keep_b    = 4;
+    if (c.max_queue <= 0) c.max_queue = 64;
+
+    int lfd = jsrv_listen(path);
+    if (lfd < 0) return -1;
+
+    tensor_engine_config_t ecfg = {.pool_mb      = c.pool_mb,
+                                   .tile_bytes   = c.tile_bytes,
+                                   .shm_cache_mb = c.cache_mb,
+                                   .keep_warm    = 1};
+    JobServer s;
+    memset(&s, 0, sizeof(s));
+    s.max_queue = c.max_queue;
+    s.eng       = tensor_engine_init(&ecfg);
+    pthread_mutex_init(&s.mu, NULL);
+    pthread_cond_init(&s.cv_work, NULL);
+    pthread_cond_init(&s.cv_done, NULL);
+
+    pool_keep_warm(1);
+    if (c.cache_mb > 0) shmc_keep(c.keep_b);
+
+    pthread_t worker;
+    if (!s.eng || pthread_create(&worker, NULL, jsrv_worker_main, &s) != 0) {
+        fprintf(stderr, "jsrv: cannot start the worker\n");
+        if (c.cache_mb > 0) shmc_keep(0);
+        pool_keep_warm(0);
+        tensor_engine_free(s.eng);
+        close(lfd);
+        unlink(path);
+        return -1;
+    }
+    printf("jsrv: serving on %s  (pool cap %zu MiB, B cache %zu MiB x %d, "
+           "queue %d)\n", path, c.pool_mb, c.cache_mb,
+           c.cache_mb ? c.keep_b : 0, c.max_queue);
+    fflush(stdout);
+
+    for (;;) {
+        pthread_mutex_lock(&s.mu);
+        int closing = s.closing;
+        pthread_mutex_unlock(&s.mu);
+        if (closing) break;
+
+        struct pollfd pfd = {.fd = lfd, .events = POLLIN};
+        if (poll(&pfd, 1, JSRV_POLL_MS) <= 0) continue;
+        int fd = accept(lfd, NULL, NULL);
+        if (fd < 0) continue;
+        if (!jsrv_peer_ok(fd)) {
+            fprintf(stderr, "jsrv: rejected a connection from another user\n");
+            close(fd);
+            continue;
+        }
+
+        struct timeval tv = {.tv_sec = JSRV_RECV_S};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        jsrv_no_sigpipe(fd);
+        jsrv_conn_t   *cn = (jsrv_conn_t *)malloc(sizeof(jsrv_conn_t));
+        pthread_t      t;
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        pthread_mutex_lock(&s.mu);
+        s.n_conn++;
+        pthread_mutex_unlock(&s.mu);
+        if (cn) { cn->srv = &s; cn->fd = fd; }
+        if (!cn || pthread_create(&t, &attr, jsrv_conn_main, cn) != 0) {
+            free(cn);
+            close(fd);
+            pthread_mutex_lock(&s.mu);
+            s.n_conn--;
+            pthread_mutex_unlock(&s.mu);
+        }
+        pthread_attr_destroy(&attr);
+    }
+
+    close(lfd);
+    unlink(path);
+    pthread_join(worker, NULL);
+    pthread_mutex_lock(&s.mu);
+    while (s.n_conn > 0)
+        pthread_cond_wait(&s.cv_done, &s.mu);
+    pthread_mutex_unlock(&s.mu);
+
+    printf("jsrv: shut down after %llu jobs\n",
+           (unsigned long long)s.jobs_done);
+    if (c.cache_mb > 0) shmc_keep(0);
+    pool_keep_warm(0);
+    tensor_engine_free(s.eng);
+    pthread_cond_destroy(&s.cv_done);
+    pthread_cond_destroy(&s.cv_work);
+    pthread_mutex_destroy(&s.mu);
+    return 0;
+}
+
+/* ----------------------------------------------------------------------- */
+/* Client                                                                   */
+/* ----------------------------------------------------------------------- */
+
+int jsrv_call(const char *path, int op, const char *const *args, int n_args,
+              jsrv_reply_t *rep)
+{
+    if (n_args < 0 || n_args > JSRV_MAX_ARGS || !rep) return -1;
+
+    char   payload[JSRV_MAX_LEN];
+    size_t len = 0;
+    for (int i = 0; i < n_args; i++) {
+        size_t n = strlen(args[i]) + 1;
+        if (len + n > sizeof(payload)) {
+            fprintf(stderr, "jsrv_call: arguments exceed %d bytes\n",
+                    JSRV_MAX_LEN);
+            return -1;
+        }
+        memcpy(payload + len, args[i], n);
+        len += n;
+    }
+
+    struct sockaddr_un addr;
+    if (jsrv_addr(path, &addr) != 0) return -1;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        fprintf(stderr, "jsrv_call: cannot connect to %s: %s\n", path,
+                strerror(errno));
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    jsrv_no_sigpipe(fd);
+
+    jsrv_hdr_t h = {JSRV_MAGIC, (uint32_t)op, (uint32_t)n_args,
+                    (uint32_t)len};
+    int rc = (jsrv_send_all(fd, &h, sizeof(h)) == 0 &&
+              jsrv_send_all(fd, payload, len) == 0 &&
+              jsrv_recv_all(fd, rep, sizeof(*rep)) == 0 &&
+              rep->magic == JSRV_MAGIC) ? 0 : -1;
+    if (rc != 0)
+        fprintf(stderr, "jsrv_call: no reply from %s\n", path);
+    close(fd);
+    return rc;
+}
@@ -1,4 +1,5 @@
 #include "memory.h"
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -8,8 +9,15 @@ struct BufferPool {
     size_t  top;        /* Stack pointer; equals free count                  */
     size_t  num_pages;
     size_t  page_bytes; /* Bytes per page                                    */
+    size_t  data_bytes; /* Size of data (a reused warm slab may be larger)   */
 };
 
+/* Slab kept by pool_keep_warm between pools. */
+static pthread_mutex_t g_warm_mu    = PTHREAD_MUTEX_INITIALIZER;
+static int             g_warm_on    = 0;
+static char           *g_warm       = NULL;
+static size_t          g_warm_bytes = 0;
+
 BufferPool *pool_create(size_t num_pages, size_t bytes_per_page)
 {
     BufferPool *pool = (BufferPool *)malloc(sizeof(BufferPool));
@@ -19,11 +27,23 @@ BufferPool *pool_create(size_t num_pages, size_t bytes_per_page)
     pool->page_bytes = bytes_per_page;
     pool->top        = num_pages;  /* all pages free initially */
 
+    pool->data       = NULL;
+    pool->data_bytes = num_pages * bytes_per_page;
+
+    pthread_mutex_lock(&g_warm_mu);
+    if (g_warm && g_warm_bytes >= pool->data_bytes) {
+        pool->data       = g_warm;
+        pool->data_bytes = g_warm_bytes;
+        g_warm           = NULL;
+        g_warm_bytes     = 0;
+    }
+    pthread_mutex_unlock(&g_warm_mu);
+
     /* 16 KB alignment matches Apple NVMe hardware page size, eliminating
      * read-amplification when the OS DMA-transfers chunks directly into
      * pool pages.  posix_memalign guarantees alignment and is POSIX. */
-    if (posix_memalign((void **)&pool->data, 16384,
-                       num_pages * bytes_per_page) != 0) {
+    if (!pool->data && posix_memalign((void **)&pool->data, 16384,
+                                      pool->data_bytes) != 0) {
         pool->data = NULL;
     }
     if (!pool->data) { free(pool); return NULL; }
@@ -40,12 +60,30 @@ BufferPool *pool_create(size_t num_pages, size_t bytes_per_page)
 void pool_destroy(BufferPool *pool)
 {
     if (pool) {
-        free(pool->data);
+        char *spare = pool->data;
+        pthread_mutex_lock(&g_warm_mu);
+        if (g_warm_on && pool->data_bytes > g_warm_bytes) {
+            spare        = g_warm;
+            g_warm       = pool->data;
+            g_warm_bytes = pool->data_bytes;
+        }
+        pthread_mutex_unlock(&g_warm_mu);
+        free(spare);
         free(pool->free_stack);
         free(pool);
     }
 }
 
+void pool_keep_warm(int on)
+{
+    pthread_mutex_lock(&g_warm_mu);
+    g_warm_on = on;
+    char *spare = on ? NULL : g_warm;
+    if (!on) { g_warm = NULL; g_warm_bytes = 0; }
+    pthread_mutex_unlock(&g_warm_mu);
+    free(spare);
+}
+
 void *pool_acquire(BufferPool *pool, size_t *out_id)
 {
     if (pool->top == 0) {
@@ -88,3 +126,38 @@ size_t pool_free_count(BufferPool *pool)
 {
     return pool->top;
 }
+
+/* thread_scratch: one key per process, a slot table per thread. */
+typedef struct { size_t cap[SCRATCH_N_SLOTS]; void *buf[SCRATCH_N_SLOTS]; } Scratch;
+
+static pthread_key_t  g_scratch_key;
+static pthread_once_t g_scratch_once = PTHREAD_ONCE_INIT;
+
+static void scratch_free(void *p)
+{
+    Scratch *s = (Scratch *)p;
+    for (int i = 0; i < SCRATCH_N_SLOTS; i++) free(s->buf[i]);
+    free(s);
+}
+
+static void scratch_key_init(void)
+{
+    pthread_key_create(&g_scratch_key, scratch_free);
+}
+
+void *thread_scratch(int slot, size_t bytes)
+{
+    pthread_once(&g_scratch_once, scratch_key_init);
+    Scratch *s = (Scratch *)pthread_getspecific(g_scratch_key);
+    if (!s) {
+        s = (Scratch *)calloc(1, sizeof(Scratch));
+        if (!s) return NULL;
+        pthread_setspecific(g_scratch_key, s);
+    }
+    if (s->cap[slot] < bytes) {
+        free(s->buf[slot]);
+        s->buf[slot] = malloc(bytes);
+        s->cap[slot] = s->buf[slot] ? bytes : 0;
+    }
+    return s->buf[slot];
+}
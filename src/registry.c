@@ -44,6 +44,7 @@ static TensorRegistry *registry_alloc_and_init(int rank,
         TileMetadata *t = &reg->tiles[idx];
         t->status    = TILE_STATUS_NULL;
         t->buffer_id = SIZE_MAX;
+        t->file_addr = HADDR_UNDEF;
 
         for (int d = 0; d < rank; d++) {
             t->global_coords[d] = coords[d];
@@ -70,6 +71,29 @@ TensorRegistry *registry_create(int rank, const hsize_t *global_dims,
     return reg;
 }
 
+void registry_virtual_chunk_dims(int rank, const hsize_t *global_dims,
+                                 tensor_dtype_t dtype, hsize_t *chunk_dims)
+{
+    const char *env    = getenv("TENSOR_VIRTUAL_TILE_BYTES");
+    size_t      target = (env && *env) ? (size_t)strtoull(env, NULL, 10) : 0;
+    if (target == 0) target = REGISTRY_VIRTUAL_TILE_BYTES;
+    /* calculate_chunk_dims counts 8-byte elements. */
+    if (dtype == DTYPE_COMPLEX128) target /= 2;
+    calculate_chunk_dims(target, rank, global_dims, chunk_dims);
+}
+
+TensorRegistry *registry_create_chunked(int rank, const hsize_t *global_dims,
+                                        const hsize_t *chunk_dims,
+                                        tensor_dtype_t dtype)
+{
+    if (rank <= 0 || rank > MAX_RANK) return NULL;
+    for (int d = 0; d < rank; d++)
+        if (chunk_dims[d] == 0) return NULL;
+    TensorRegistry *reg = registry_alloc_and_init(rank, global_dims, chunk_dims);
+    if (reg) reg->dtype = dtype;
+    return reg;
+}
+
 TensorRegistry *registry_create_from_dset(hid_t dset_id)
 {
     /* Read rank and global shape from the dataspace. */
@@ -89,34 +113,33 @@ TensorRegistry *registry_create_from_dset(hid_t dset_id)
     }
     H5Sclose(fspace_id);
 
-    /* Read chunk dims from the dataset creation property list. */
+    /*
+     * Detect element type: compound (two-field real/imag) → COMPLEX128,
+     * everything else → FP64.
+     */
+    tensor_dtype_t dtype  = DTYPE_FP64;
+    hid_t          h5type = H5Dget_type(dset_id);
+    if (h5type >= 0) {
+        if (H5Tget_class(h5type) == H5T_COMPOUND) dtype = DTYPE_COMPLEX128;
+        H5Tclose(h5type);
+    }
+
+    /* Read chunk dims from the dataset creation property list; contiguous
+     * and compact datasets get the default virtual tiling. */
     hid_t dcpl_id = H5Dget_create_plist(dset_id);
     if (dcpl_id < 0) return NULL;
 
     hsize_t chunk_dims[MAX_RANK];
-    if (H5Pget_chunk(dcpl_id, rank, chunk_dims) < 0) {
+    if (H5Pget_layout(dcpl_id) != H5D_CHUNKED) {
+        registry_virtual_chunk_dims(rank, global_dims, dtype, chunk_dims);
+    } else if (H5Pget_chunk(dcpl_id, rank, chunk_dims) < 0) {
         H5Pclose(dcpl_id);
         return NULL;
     }
     H5Pclose(dcpl_id);
 
     TensorRegistry *reg = registry_alloc_and_init(rank, global_dims, chunk_dims);
-    if (!reg) return NULL;
-
-    /*
-     * Detect element type: compound (two-field real/imag) → COMPLEX128,
-     * everything else → FP64.
-     */
-    hid_t h5type = H5Dget_type(dset_id);
-    if (h5type >= 0) {
-        reg->dtype = (H5Tget_class(h5type) == H5T_COMPOUND)
-                     ? DTYPE_COMPLEX128
-                     : DTYPE_FP64;
-        H5Tclose(h5type);
-    } else {
-        reg->dtype = DTYPE_FP64;
-    }
-
+    if (reg) reg->dtype = dtype;
     return reg;
 }
 
@@ -158,8 +181,49 @@ TileMetadata *registry_get_tile(TensorRegistry *reg,
 /* registry_scan_file                                                       */
 /* ----------------------------------------------------------------------- */
 
+/*
+ * A contiguous dataset is stored whole or not at all: every virtual tile
+ * is ON_DISK once its storage is allocated.  file_addr/file_bytes give the
+ * byte span from a tile's first to its last element.  That is the tile
+ * itself only if it is one run; the HDF5 backend gives readahead hints
+ * for no other tiling.
+ */
+static long registry_scan_contiguous(hid_t dset_id, TensorRegistry *reg)
+{
+    if (H5Dget_storage_size(dset_id) == 0) return 0;
+
+    haddr_t base  = H5Dget_offset(dset_id);
+    hid_t   ftype = H5Dget_type(dset_id);
+    size_t  esz   = (ftype >= 0) ? H5Tget_size(ftype) : 0;
+    if (ftype >= 0) H5Tclose(ftype);
+
+    for (size_t idx = 0; idx < reg->total_tiles; idx++) {
+        TileMetadata *t = &reg->tiles[idx];
+        t->status = TILE_STATUS_ON_DISK;
+        if (base == HADDR_UNDEF || esz == 0) continue;
+        hsize_t first = 0, last = 0;
+        for (int d = 0; d < reg->rank; d++) {
+            hsize_t end = t->phys_offset[d] + reg->chunk_dims[d];
+            if (end > reg->global_dims[d]) end = reg->global_dims[d];
+            first = first * reg->global_dims[d] + t->phys_offset[d];
+            last  = last  * reg->global_dims[d] + end - 1;
+        }
+        t->file_addr  = base + first * esz;
+        t->file_bytes = (last - first + 1) * esz;
+    }
+    return (long)reg->total_tiles;
+}
+
 long registry_scan_file(hid_t dset_id, TensorRegistry *reg)
 {
+    hid_t dcpl_id = H5Dget_create_plist(dset_id);
+    if (dcpl_id >= 0) {
+        H5D_layout_t layout = H5Pget_layout(dcpl_id);
+        H5Pclose(dcpl_id);
+        if (layout == H5D_CONTIGUOUS || layout == H5D_COMPACT)
+            return registry_scan_contiguous(dset_id, reg);
+    }
+
     hid_t fspace_id = H5Dget_space(dset_id);
     if (fspace_id < 0) {
         fprintf(stderr, "registry_scan_file: H5Dget_space failed\n");
@@ -177,10 +241,12 @@ long registry_scan_file(hid_t dset_id, TensorRegistry *reg)
 
     for (hsize_t ci = 0; ci < num_chunks; ci++) {
         hsize_t chunk_offset[MAX_RANK];
+        haddr_t addr  = HADDR_UNDEF;
+        hsize_t bytes = 0;
         memset(chunk_offset, 0, sizeof(chunk_offset));
 
         if (H5Dget_chunk_info(dset_id, fspace_id, ci,
-                              chunk_offset, NULL, NULL, NULL) < 0) {
+                              chunk_offset, NULL, &addr, &bytes) < 0) {
             fprintf(stderr,
                     "registry_scan_file: H5Dget_chunk_info failed at idx %llu"
                     " (skipping)\n", (unsigned long long)ci);
@@ -200,7 +266,9 @@ long registry_scan_file(hid_t dset_id, TensorRegistry *reg)
             continue;
         }
 
-        tile->status = TILE_STATUS_ON_DISK;
+        tile->status     = TILE_STATUS_ON_DISK;
+        tile->file_addr  = addr;
+        tile->file_bytes = bytes;
         found_count++;
     }
 
@@ -0,0 +1,406 @@
+/*
+ * shm_cache.c — Node-local shared-memory tile cache (see shm_cache.h).
+ */
+
+#include "shm_cache.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SHMC_MAGIC      0x4f4354494c455331ull   /* "OCTILES1" */
+#define SHMC_ALIGN      16384                    /* NVMe page, as the pools */
+#define SHMC_INIT_NS    2000000000ull            /* creator must finish     */
+#define SHMC_EMPTY_NS   1000000000ull            /* claim → LOADING         */
+#define SHMC_LOAD_NS    60000000000ull           /* live owner, give up     */
+
+enum { E_EMPTY = 0, E_LOADING, E_READY, E_UNCACHED };
+
+typedef struct {
+    _Atomic uint64_t key;          /* tile index + 1; 0 = free              */
+    _Atomic uint32_t state;        /* E_*                                   */
+    _Atomic int32_t  owner;        /* pid loading the tile                  */
+    uint64_t         slot;         /* written before state leaves EMPTY     */
+    uint64_t         pad;
+} ShmEntry;
+
+struct ShmHeader {
+    _Atomic uint64_t magic;        /* stored last by the creator            */
+    uint64_t         tile_bytes;
+    uint64_t         slot_bytes;
+    uint64_t         n_slots;
+    uint64_t         n_entries;    /* power of two                          */
+    uint64_t         data_off;
+    _Atomic uint64_t next_slot;
+    _Atomic int32_t  pids[SHMC_MAX_PROCS];
+};
+
+static uint64_t shmc_now_ns(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000ull + (uint64_t)t.tv_nsec;
+}
+
+static void shmc_pause(void)
+{
+    struct timespec ts = {0, 20000};
+    nanosleep(&ts, NULL);
+}
+
+static int shmc_dead(int32_t pid)
+{
+    return pid > 0 && kill((pid_t)pid, 0) != 0 && errno == ESRCH;
+}
+
+static ShmEntry *shmc_entries(ShmHeader *h)
+{
+    return (ShmEntry *)(h + 1);
+}
+
+static uint64_t shmc_fnv(uint64_t h, const void *p, size_t n)
+{
+    const unsigned char *b = (const unsigned char *)p;
+    for (size_t i = 0; i < n; i++) { h ^= b[i]; h *= 0x100000001b3ull; }
+    return h;
+}
+
+/* Clear dead pids; returns how many other live processes remain. */
+static int shmc_sweep(ShmHeader *h, int32_t self)
+{
+    int live = 0;
+    for (int i = 0; i < SHMC_MAX_PROCS; i++) {
+        int32_t p = atomic_load(&h->pids[i]);
+        if (p == 0 || p == self) continue;
+        if (shmc_dead(p)) atomic_compare_exchange_strong(&h->pids[i], &p, 0);
+        else              live++;
+    }
+    return live;
+}
+
+/* ----------------------------------------------------------------------- */
+/* Attach / detach                                                          */
+/* ----------------------------------------------------------------------- */
+
+#define SHMC_KEEP_MAX 16
+
+/* Caches parked by shmc_detach under shmc_keep, most recent first. */
+static pthread_mutex_t g_keep_mu = PTHREAD_MUTEX_INITIALIZER;
+static int             g_keep_n  = 0;
+static int             g_n_kept  = 0;
+static ShmTileCache   *g_kept[SHMC_KEEP_MAX + 1];
+
+/* Take the kept cache named name out of the list, or NULL. */
+static ShmTileCache *shmc_unkeep(const char *name, size_t tile_bytes)
+{
+    ShmTileCache *c = NULL;
+    pthread_mutex_lock(&g_keep_mu);
+    for (int i = 0; i < g_n_kept && !c; i++)
+        if (strcmp(g_kept[i]->name, name) == 0 &&
+            g_kept[i]->hdr->tile_bytes == tile_bytes) {
+            c = g_kept[i];
+            memmove(&g_kept[i], &g_kept[i + 1],
+                    (size_t)(g_n_kept - i - 1) * sizeof(g_kept[0]));
+            g_n_kept--;
+        }
+    pthread_mutex_unlock(&g_keep_mu);
+    if (c) {
+        atomic_store(&c->n_hit, 0);
+        atomic_store(&c->n_fill, 0);
+        atomic_store(&c->n_miss, 0);
+    }
+    return c;
+}
+
+ShmTileCache *shmc_attach(const char *path, const char *dset, int rank,
+                          const size_t *chunk_dims, size_t tile_bytes,
+                          size_t n_tiles, size_t cap_bytes)
+{
+    struct stat sb;
+    if (stat(path, &sb) != 0) {
+        fprintf(stderr, "shmc_attach: cannot stat '%s'\n", path);
+        return NULL;
+    }
+
+    uint64_t key = 0xcbf29ce484222325ull;
+#if defined(__APPLE__)
+    uint64_t mt  = (uint64_t)sb.st_mtimespec.tv_sec * 1000000000ull
+                 + (uint64_t)sb.st_mtimespec.tv_nsec;
+#else
+    uint64_t mt  = (uint64_t)sb.st_mtim.tv_sec * 1000000000ull
+                 + (uint64_t)sb.st_mtim.tv_nsec;
+#endif
+    uint64_t tb  = (uint64_t)tile_bytes;
+    uint64_t nt  = (uint64_t)n_tiles;
+    key = shmc_fnv(key, &sb.st_dev,  sizeof(sb.st_dev));
+    key = shmc_fnv(key, &sb.st_ino,  sizeof(sb.st_ino));
+    key = shmc_fnv(key, &sb.st_size, sizeof(sb.st_size));
+    key = shmc_fnv(key, &mt, sizeof(mt));
+    key = shmc_fnv(key, &tb, sizeof(tb));
+    key = shmc_fnv(key, &nt, sizeof(nt));
+    if (dset) key = shmc_fnv(key, dset, strlen(dset) + 1);
+    for (int d = 0; d < rank; d++) {
+        uint64_t cd = (uint64_t)chunk_dims[d];
+        key = shmc_fnv(key, &cd, sizeof(cd));
+    }
+
+    char name[32];
+    snprintf(name, sizeof(name), "/oc_tiles_%016llx", (unsigned long long)key);
+    ShmTileCache *c = shmc_unkeep(name, tile_bytes);
+    if (c) return c;
+
+    c = (ShmTileCache *)calloc(1, sizeof(ShmTileCache));
+    if (!c) return NULL;
+    memcpy(c->name, name, sizeof(c->name));
+    c->pid_slot = -1;
+
+    uint64_t slot_bytes = ((uint64_t)tile_bytes + SHMC_ALIGN - 1)
+                        & ~(uint64_t)(SHMC_ALIGN - 1);
+    uint64_t n_slots    = cap_bytes / slot_bytes;
+    if (n_slots > n_tiles) n_slots = n_tiles;
+    if (n_slots == 0) {
+        fprintf(stderr, "shmc_attach: budget below one tile\n");
+        free(c);
+        return NULL;
+    }
+    uint64_t n_entries = 1;
+    while (n_entries < 2 * n_slots) n_entries *= 2;
+    uint64_t data_off = (sizeof(ShmHeader) + n_entries * sizeof(ShmEntry)
+                         + SHMC_ALIGN - 1) & ~(uint64_t)(SHMC_ALIGN - 1);
+    size_t   bytes    = (size_t)(data_off + n_slots * slot_bytes);
+
+    ShmHeader *h = NULL;
+    for (int attempt = 0; attempt < 2 && !h; attempt++) {
+        int fd = shm_open(c->name, O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd >= 0) {
+            /* Creator: size, map and publish the header. */
+            if (ftruncate(fd, (off_t)bytes) != 0) {
+                fprintf(stderr, "shmc_attach: ftruncate %s: %s\n", c->name,
+                        strerror(errno));
+                close(fd);
+                shm_unlink(c->name);
+                break;
+            }
+            void *p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED,
+                           fd, 0);
+            close(fd);
+            if (p == MAP_FAILED) { shm_unlink(c->name); break; }
+            h = (ShmHeader *)p;
+            h->tile_bytes = tile_bytes;
+            h->slot_bytes = slot_bytes;
+            h->n_slots    = n_slots;
+            h->n_entries  = n_entries;
+            h->data_off   = data_off;
+            atomic_store(&h->magic, SHMC_MAGIC);
+            c->map_bytes  = bytes;
+            break;
+        }
+        if (errno != EEXIST) {
+            fprintf(stderr, "shmc_attach: shm_open %s: %s\n", c->name,
+                    strerror(errno));
+            break;
+        }
+
+        /* Existing segment: wait for its creator to publish the header. */
+        fd = shm_open(c->name, O_RDWR, 0);
+        if (fd < 0) continue;                  /* unlinked meanwhile: retry */
+        uint64_t t0 = shmc_now_ns();
+        while (fstat(fd, &sb) == 0 && (size_t)sb.st_size < sizeof(ShmHeader)
+               && shmc_now_ns() - t0 < SHMC_INIT_NS)
+            shmc_pause();
+        void *p = ((size_t)sb.st_size >= sizeof(ShmHeader))
+            ? mmap(NULL, (size_t)sb.st_size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED, fd, 0)
+            : MAP_FAILED;
+        close(fd);
+        if (p != MAP_FAILED) {
+            ShmHeader *e = (ShmHeader *)p;
+            while (atomic_load(&e->magic) != SHMC_MAGIC &&
+                   shmc_now_ns() - t0 < SHMC_INIT_NS)
+                shmc_pause();
+            if (atomic_load(&e->magic) == SHMC_MAGIC &&
+                e->tile_bytes == tile_bytes) {
+                h = e;
+                c->map_bytes = (size_t)sb.st_size;
+                break;
+            }
+            munmap(p, (size_t)sb.st_size);
+        }
+        /* Creator died before publishing, or a foreign layout: replace. */
+        fprintf(stderr, "shmc_attach: discarding stale segment %s\n", c->name);
+        shm_unlink(c->name);
+    }
+    if (!h) {
+        free(c);
+        return NULL;
+    }
+    c->hdr = h;
+
+    /* Reference: claim a pid slot (free, or left by a dead process). */
+    int32_t self = (int32_t)getpid();
+    shmc_sweep(h, self);
+    for (int i = 0; i < SHMC_MAX_PROCS && c->pid_slot < 0; i++) {
+        int32_t p = atomic_load(&h->pids[i]);
+        if ((p == 0 || shmc_dead(p)) &&
+            atomic_compare_exchange_strong(&h->pids[i], &p, self))
+            c->pid_slot = i;
+    }
+    return c;
+}
+
+/* Drop c's reference and mapping; unlink if no other process is left. */
+static void shmc_release(ShmTileCache *c)
+{
+    ShmHeader *h    = c->hdr;
+    int32_t    self = (int32_t)getpid();
+    if (c->pid_slot >= 0) atomic_store(&h->pids[c->pid_slot], 0);
+    if (shmc_sweep(h, self) == 0)
+        shm_unlink(c->name);
+    munmap(h, c->map_bytes);
+    free(c);
+}
+
+void shmc_detach(ShmTileCache *c)
+{
+    if (!c) return;
+    ShmTileCache *evict = c;
+    pthread_mutex_lock(&g_keep_mu);
+    if (g_keep_n > 0) {
+        memmove(&g_kept[1], &g_kept[0], (size_t)g_n_kept * sizeof(g_kept[0]));
+        g_kept[0] = c;
+        evict     = (g_n_kept == g_keep_n) ? g_kept[g_n_kept] : NULL;
+        if (!evict) g_n_kept++;
+    }
+    pthread_mutex_unlock(&g_keep_mu);
+    if (evict) shmc_release(evict);
+}
+
+void shmc_keep(int n)
+{
+    if (n < 0) n = 0;
+    if (n > SHMC_KEEP_MAX) n = SHMC_KEEP_MAX;
+    ShmTileCache *drop[SHMC_KEEP_MAX];
+    int           n_drop = 0;
+    pthread_mutex_lock(&g_keep_mu);
+    g_keep_n = n;
+    while (g_n_kept > n) drop[n_drop++] = g_kept[--g_n_kept];
+    pthread_mutex_unlock(&g_keep_mu);
+    for (int i = 0; i < n_drop; i++) shmc_release(drop[i]);
+}
+
+/* ----------------------------------------------------------------------- */
+/* Lookup / publish                                                         */
+/* ----------------------------------------------------------------------- */
+
+static void *shmc_slot_ptr(ShmHeader *h, const ShmEntry *e)
+{
+    return (char *)h + h->data_off + e->slot * h->slot_bytes;
+}
+
+/* Entry for idx, claiming a free one when claim is set; NULL if absent.
+ * *claimed is set when this call took the entry. */
+static ShmEntry *shmc_find(ShmHeader *h, uint64_t idx, int claim,
+                           int *claimed)
+{
+    uint64_t  key  = idx + 1;
+    uint64_t  mask = h->n_entries - 1;
+    uint64_t  i    = (idx * 0x9e3779b97f4a7c15ull) >> 17;
+    ShmEntry *tab  = shmc_entries(h);
+    *claimed = 0;
+    for (uint64_t probe = 0; probe < h->n_entries; probe++) {
+        ShmEntry *e = &tab[(i + probe) & mask];
+        uint64_t  k = atomic_load(&e->key);
+        if (k == 0) {
+            if (!claim) return NULL;
+            if (atomic_compare_exchange_strong(&e->key, &k, key)) {
+                *claimed = 1;
+                return e;
+            }
+        }
+        if (k == key) return e;
+    }
+    return NULL;
+}
+
+int shmc_lookup(ShmTileCache *c, uint64_t idx, void **data)
+{
+    ShmHeader *h    = c->hdr;
+    int32_t    self = (int32_t)getpid();
+    int        claimed;
+    *data = NULL;
+
+    ShmEntry *e = shmc_find(h, idx, 1, &claimed);
+    if (!e) {
+        atomic_fetch_add(&c->n_miss, 1);
+        return SHMC_MISS;
+    }
+    if (claimed) {
+        atomic_store(&e->owner, self);
+        uint64_t s = atomic_fetch_add(&h->next_slot, 1);
+        if (s >= h->n_slots) {
+            atomic_store(&e->state, E_UNCACHED);
+            atomic_fetch_add(&c->n_miss, 1);
+            return SHMC_MISS;
+        }
+        e->slot = s;
+        atomic_store(&e->state, E_LOADING);
+        *data = shmc_slot_ptr(h, e);
+        atomic_fetch_add(&c->n_fill, 1);
+        return SHMC_FILL;
+    }
+
+    uint64_t t0 = shmc_now_ns();
+    for (;;) {
+        uint32_t st = atomic_load(&e->state);
+        uint64_t dt = shmc_now_ns() - t0;
+        if (st == E_READY) {
+            *data = shmc_slot_ptr(h, e);
+            atomic_fetch_add(&c->n_hit, 1);
+            return SHMC_HIT;
+        }
+        if (st == E_EMPTY && dt > SHMC_EMPTY_NS) {
+            /* Claimer died before taking a slot: stop others waiting. */
+            atomic_compare_exchange_strong(&e->state, &st, E_UNCACHED);
+            break;
+        }
+        if (st == E_UNCACHED || (st == E_LOADING && dt > SHMC_LOAD_NS))
+            break;
+        if (st == E_LOADING) {
+            int32_t o = atomic_load(&e->owner);
+            if (o != self && shmc_dead(o) &&
+                atomic_compare_exchange_strong(&e->owner, &o, self)) {
+                *data = shmc_slot_ptr(h, e);
+                atomic_fetch_add(&c->n_fill, 1);
+                return SHMC_FILL;
+            }
+        }
+        shmc_pause();
+    }
+    atomic_fetch_add(&c->n_miss, 1);
+    return SHMC_MISS;
+}
+
+void shmc_publish(ShmTileCache *c, uint64_t idx, int ok)
+{
+    int       claimed;
+    ShmEntry *e = shmc_find(c->hdr, idx, 0, &claimed);
+    if (e) atomic_store(&e->state, ok ? E_READY : E_UNCACHED);
+}
+
+size_t shmc_slots(const ShmTileCache *c)
+{
+    return (size_t)c->hdr->n_slots;
+}
+
+size_t shmc_slots_used(const ShmTileCache *c)
+{
+    uint64_t u = atomic_load(&c->hdr->next_slot);
+    return (size_t)(u < c->hdr->n_slots ? u : c->hdr->n_slots);
+}
@@ -0,0 +1,188 @@
+/*
+ * sparse_pattern.c — tile-level block-sparsity patterns.
+ */
+
+#include "sparse_pattern.h"
+#include "odometer.h"
+#include "rng.h"
+#include "tile_writer.h"
+
+#include <complex.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Salt separating the selection stream from the tile-content stream, which
+ * uses rng_derive(seed, tile_index) directly (tile_fill_random). */
+#define SP_SELECT_SALT  0x5350415253450001ULL
+
+static const char *const sp_names[] = {
+    "dense", "random", "banded", "blockdiag", "symmetric"
+};
+
+int sparse_pattern_parse(const char *name, sp_kind_t *kind_out)
+{
+    for (int k = 0; k < (int)(sizeof(sp_names) / sizeof(sp_names[0])); k++) {
+        if (strcmp(name, sp_names[k]) == 0) {
+            *kind_out = (sp_kind_t)k;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+const char *sparse_pattern_name(sp_kind_t kind)
+{
+    if ((int)kind < 0 ||
+        (int)kind >= (int)(sizeof(sp_names) / sizeof(sp_names[0])))
+        return "?";
+    return sp_names[kind];
+}
+
+int sparse_pattern_validate(const sparse_pattern_t *pat,
+                            const TensorRegistry *reg)
+{
+    switch (pat->kind) {
+    case SP_DENSE:
+        return 0;
+    case SP_RANDOM:
+    case SP_SYMMETRIC:
+        if (!(pat->density >= 0.0 && pat->density <= 1.0)) {
+            fprintf(stderr, "sparse_pattern: density %g not in [0, 1]\n",
+                    pat->density);
+            return -1;
+        }
+        if (pat->kind == SP_SYMMETRIC) {
+            for (int d = 1; d < reg->rank; d++) {
+                if (reg->global_dims[d] != reg->global_dims[0] ||
+                    reg->chunk_dims[d]  != reg->chunk_dims[0]) {
+                    fprintf(stderr, "sparse_pattern: symmetric pattern "
+                            "needs equal extents and chunk dims in every "
+                            "dimension\n");
+                    return -1;
+                }
+            }
+        }
+        return 0;
+    case SP_BANDED:
+        if (pat->bandwidth < 0) {
+            fprintf(stderr, "sparse_pattern: bandwidth must be >= 0\n");
+            return -1;
+        }
+        return 0;
+    case SP_BLOCK_DIAG:
+        if (pat->n_blocks < 1) {
+            fprintf(stderr, "sparse_pattern: n_blocks must be >= 1\n");
+            return -1;
+        }
+        return 0;
+    }
+    fprintf(stderr, "sparse_pattern: unknown pattern %d\n", (int)pat->kind);
+    return -1;
+}
+
+/* Insertion sort of a short coordinate vector (rank <= MAX_RANK). */
+static void sp_sort(uint64_t *v, int n)
+{
+    for (int i = 1; i < n; i++) {
+        uint64_t x = v[i];
+        int      j = i - 1;
+        while (j >= 0 && v[j] > x) { v[j + 1] = v[j]; j--; }
+        v[j + 1] = x;
+    }
+}
+
+/* Bernoulli(density) draw keyed by a flattened coordinate index. */
+static int sp_coin(const sparse_pattern_t *pat, uint64_t key)
+{
+    uint64_t s = rng_derive(pat->seed ^ SP_SELECT_SALT, key);
+    return rng_uniform01(&s) < pat->density;
+}
+
+int sparse_pattern_select(const TensorRegistry *reg, size_t tile_index,
+                          void *user)
+{
+    const sparse_pattern_t *pat = (const sparse_pattern_t *)user;
+    const hsize_t          *c   = reg->tiles[tile_index].global_coords;
+    int                     r   = reg->rank;
+
+    switch (pat->kind) {
+    case SP_DENSE:
+        return 1;
+
+    case SP_RANDOM:
+        return sp_coin(pat, (uint64_t)tile_index);
+
+    case SP_BANDED: {
+        hsize_t lo = c[0], hi = c[0];
+        for (int d = 1; d < r; d++) {
+            if (c[d] < lo) lo = c[d];
+            if (c[d] > hi) hi = c[d];
+        }
+        return (hi - lo) <= (hsize_t)pat->bandwidth;
+    }
+
+    case SP_BLOCK_DIAG: {
+        /* Slab of coordinate c_d along a grid of g_d tiles: c_d*nb/g_d. */
+        hsize_t nb    = (hsize_t)pat->n_blocks;
+        hsize_t slab0 = c[0] * nb / reg->grid_dims[0];
+        for (int d = 1; d < r; d++)
+            if (c[d] * nb / reg->grid_dims[d] != slab0) return 0;
+        return 1;
+    }
+
+    case SP_SYMMETRIC: {
+        /* Key on the sorted coordinates so every permutation of a tile
+         * gets the same draw. */
+        uint64_t s[MAX_RANK];
+        for (int d = 0; d < r; d++) s[d] = (uint64_t)c[d];
+        sp_sort(s, r);
+        uint64_t key = 0;
+        for (int d = 0; d < r; d++)
+            key = key * (uint64_t)reg->grid_dims[0] + s[d];
+        return sp_coin(pat, key);
+    }
+    }
+    return 0;
+}
+
+size_t sparse_pattern_count(const sparse_pattern_t *pat,
+                            const TensorRegistry *reg)
+{
+    size_t n = 0;
+    for (size_t t = 0; t < reg->total_tiles; t++)
+        n += (size_t)sparse_pattern_select(reg, t, (void *)pat);
+    return n;
+}
+
+int sparse_pattern_fill_symmetric(void *buf, const TensorRegistry *reg,
+                                  size_t tile_index, void *user)
+{
+    const sparse_pattern_t *pat = (const sparse_pattern_t *)user;
+    int            r   = reg->rank;
+    const hsize_t *off = reg->tiles[tile_index].phys_offset;
+    uint64_t       n0  = (uint64_t)reg->global_dims[0];
+
+    size_t nominal[MAX_RANK], x[MAX_RANK] = {0};
+    for (int d = 0; d < r; d++) nominal[d] = (size_t)reg->chunk_dims[d];
+
+    double *p = (double *)buf;
+    do {
+        /* Sorted global index → one key → one stream per element orbit. */
+        uint64_t s[MAX_RANK];
+        for (int d = 0; d < r; d++) s[d] = (uint64_t)(off[d] + x[d]);
+        sp_sort(s, r);
+        uint64_t key = 0;
+        for (int d = 0; d < r; d++) key = key * n0 + s[d];
+
+        uint64_t st = rng_derive(pat->seed, key);
+        if (reg->dtype == DTYPE_COMPLEX128) {
+            *p++ = rng_uniform(&st);
+            *p++ = rng_uniform(&st);
+        } else {
+            *p++ = rng_uniform(&st);
+        }
+    } while (odometer_step((size_t)r, x, nominal));
+
+    tile_zero_padding(buf, reg, tile_index);
+    return 0;
+}
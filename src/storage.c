@@ -0,0 +1,550 @@
+/*
+ * storage.c — Storage backend dispatch, the HDF5 backend and the format
+ * converter (see storage.h).  The native backend is in storage_raw.c and
+ * the striped one in storage_stripe.c.
+ */
+
+#include "storage.h"
+#include "tensor_store.h"
+#include <hdf5.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <complex.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/* HDF5 raw-data chunk cache per file handle.
+ * 1 GB keeps the HDF5 B-tree metadata and hot chunks resident in RAM
+ * when the pool has space to spare. */
+#define HDF5_CHUNK_CACHE_BYTES (1UL << 30)
+
+/* ----------------------------------------------------------------------- */
+/* HDF5 backend                                                             */
+/* ----------------------------------------------------------------------- */
+
+typedef struct {
+    StorageFile base;
+    hid_t       fid;
+    hid_t       dset;
+    hid_t       mem_type;      /* H5T_NATIVE_DOUBLE or the complex compound */
+    int         fd;            /* sec2 descriptor, or -1                    */
+    int         raw_chunks;    /* chunks hold memory-layout bytes: no
+                                  type conversion, H5D{read,write}_chunk   */
+    /* Direct access to a contiguous dataset (data_addr != HADDR_UNDEF). */
+    haddr_t     data_addr;     /* file offset of element 0                  */
+    void       *map;           /* mmap from the page below data_addr        */
+    size_t      map_len;
+    const char *data;          /* element 0 in map, or NULL: use pread      */
+} StgHdf5;
+
+/* Open an HDF5 file with a large chunk cache. */
+static hid_t stg_h5_fopen(const char *path, unsigned flags)
+{
+    hid_t fapl = H5Pcreate(H5P_FILE_ACCESS);
+    if (fapl < 0) return H5Fopen(path, flags, H5P_DEFAULT);
+
+    /* Large prime slot count: keeps the hash table collision rate low.
+     * rdcc_w0 = 0.75 — prefer evicting chunks that are not repeated. */
+    H5Pset_cache(fapl, 0, 100003, HDF5_CHUNK_CACHE_BYTES, 0.75);
+
+    hid_t fid = H5Fopen(path, flags, fapl);
+    H5Pclose(fapl);
+    return fid;
+}
+
+/* True if the file type of a dtype element is bit-identical in memory. */
+static int stg_h5_native_type(hid_t type, tensor_dtype_t dtype)
+{
+    if (dtype == DTYPE_FP64) return H5Tequal(type, H5T_NATIVE_DOUBLE) > 0;
+    if (H5Tget_class(type) != H5T_COMPOUND || H5Tget_size(type) != 16 ||
+        H5Tget_nmembers(type) != 2)
+        return 0;
+    int ok = 1;
+    for (unsigned m = 0; m < 2 && ok; m++) {
+        hid_t mt = H5Tget_member_type(type, m);
+        ok = mt >= 0 && H5Tequal(mt, H5T_NATIVE_DOUBLE) > 0 &&
+             H5Tget_member_offset(type, m) == m * sizeof(double);
+        if (mt >= 0) H5Tclose(mt);
+    }
+    return ok;
+}
+
+/*
+ * Enable direct reads of a read-only contiguous dataset whose bytes are
+ * already in memory layout: map them, or fall back to pread on the fd.
+ */
+static void stg_h5_direct_init(StgHdf5 *f, hid_t type)
+{
+    hsize_t n = 1;
+    for (int d = 0; d < f->base.rank; d++) n *= f->base.global_dims[d];
+    const size_t bytes = (size_t)n * f->base.element_size;
+    haddr_t      addr  = H5Dget_offset(f->dset);
+    if (f->fd < 0 || addr == HADDR_UNDEF ||
+        H5Dget_storage_size(f->dset) != bytes ||
+        !stg_h5_native_type(type, f->base.dtype))
+        return;
+    f->data_addr = addr;
+
+    const char *env = getenv("TENSOR_MMAP");
+    if (env && strcmp(env, "0") == 0) return;
+    const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    const size_t skip = (size_t)addr & (page - 1);
+    void *m = mmap(NULL, skip + bytes, PROT_READ, MAP_SHARED, f->fd,
+                   (off_t)(addr - skip));
+    if (m == MAP_FAILED) return;
+    f->map     = m;
+    f->map_len = skip + bytes;
+    f->data    = (const char *)m + skip;
+}
+
+/*
+ * Chunks can bypass HDF5's type conversion when they hold exactly the
+ * memory bytes: no filters and a native file type (for COMPLEX128, the
+ * compound conversion otherwise dominates the cost of a cached read).
+ * TENSOR_H5_DIRECT=0 forces the converting path.
+ */
+static int stg_h5_raw_chunks(StgHdf5 *f, hid_t dcpl, hid_t type)
+{
+    const char *env = getenv("TENSOR_H5_DIRECT");
+    return !(env && strcmp(env, "0") == 0) &&
+           H5Pget_layout(dcpl) == H5D_CHUNKED && H5Pget_nfilters(dcpl) == 0 &&
+           stg_h5_native_type(type, f->base.dtype);
+}
+
+/* Zero the part of tile buf (nominal strides) outside the dataset. */
+static void stg_h5_zero_padding(const StorageFile *sf, const hsize_t *off,
+                                char *buf)
+{
+    const int r = sf->rank;
+    hsize_t   act[MAX_RANK], c[MAX_RANK];
+    int       partial = 0;
+    for (int d = 0; d < r; d++) {
+        hsize_t end = off[d] + sf->chunk_dims[d];
+        act[d] = (end > sf->global_dims[d]) ? sf->global_dims[d] - off[d]
+                                            : sf->chunk_dims[d];
+        partial |= act[d] != sf->chunk_dims[d];
+    }
+    if (!partial) return;
+
+    /* Per row of the last dimension: its tail, or all of it when an outer
+     * index is past the extent. */
+    const size_t esz = sf->element_size;
+    const size_t row = (size_t)sf->chunk_dims[r - 1];
+    memset(c, 0, sizeof(c));
+    for (;;) {
+        size_t lin = 0;
+        int    out = 0;
+        for (int d = 0; d < r - 1; d++) {
+            lin  = (lin + (size_t)c[d]) * (size_t)sf->chunk_dims[d + 1];
+            out |= c[d] >= act[d];
+        }
+        size_t keep = out ? 0 : (size_t)act[r - 1];
+        memset(buf + (lin + keep) * esz, 0, (row - keep) * esz);
+        int d = r - 2;
+        while (d >= 0 && ++c[d] == sf->chunk_dims[d]) c[d--] = 0;
+        if (d < 0) break;
+    }
+}
+
+static void stg_h5_release(StgHdf5 *f)
+{
+    if (f->map) munmap(f->map, f->map_len);
+    if (f->mem_type >= 0 && f->base.dtype != DTYPE_FP64)
+        H5Tclose(f->mem_type);
+    if (f->dset >= 0) H5Dclose(f->dset);
+    if (f->fid  >= 0) H5Fclose(f->fid);
+    free(f);
+}
+
+static StorageFile *stg_h5_open(const char *path, const char *dset,
+                                int writable)
+{
+    StgHdf5 *f = (StgHdf5 *)calloc(1, sizeof(StgHdf5));
+    if (!f) return NULL;
+    f->base.ops = &stg_hdf5_ops;
+    f->fid = f->dset = f->mem_type = -1;
+    f->fd  = -1;
+    f->data_addr = HADDR_UNDEF;
+
+    tensor_store_lock();
+    int          ok     = 0;
+    hid_t        space  = -1, dcpl = -1, type = -1;
+    H5D_layout_t layout = H5D_LAYOUT_ERROR;
+    f->fid = stg_h5_fopen(path, writable ? H5F_ACC_RDWR : H5F_ACC_RDONLY);
+    if (f->fid >= 0) f->dset = dset_open_no_cache(f->fid, dset);
+    if (f->dset >= 0) {
+        space = H5Dget_space(f->dset);
+        dcpl  = H5Dget_create_plist(f->dset);
+        type  = H5Dget_type(f->dset);
+    }
+    if (space >= 0 && dcpl >= 0 && type >= 0) {
+        int rank = H5Sget_simple_extent_ndims(space);
+        layout   = H5Pget_layout(dcpl);
+        f->base.dtype = (H5Tget_class(type) == H5T_COMPOUND)
+                        ? DTYPE_COMPLEX128 : DTYPE_FP64;
+        f->base.element_size = (f->base.dtype == DTYPE_FP64)
+                               ? sizeof(double) : sizeof(double _Complex);
+        f->base.virtual_tiles = (layout != H5D_CHUNKED);
+        if (rank > 0 && rank <= MAX_RANK &&
+            H5Sget_simple_extent_dims(space, f->base.global_dims, NULL) >= 0) {
+            f->base.rank = rank;
+            if (f->base.virtual_tiles)
+                registry_virtual_chunk_dims(rank, f->base.global_dims,
+                                            f->base.dtype, f->base.chunk_dims);
+            ok = f->base.virtual_tiles ||
+                 H5Pget_chunk(dcpl, rank, f->base.chunk_dims) >= 0;
+        }
+    }
+    if (ok) {
+        f->mem_type = (f->base.dtype == DTYPE_FP64)
+                      ? H5T_NATIVE_DOUBLE : create_h5_complex_type();
+        ok = f->mem_type >= 0;
+    }
+    if (ok) f->fd = dset_posix_fd(f->dset);
+    if (ok) f->raw_chunks = stg_h5_raw_chunks(f, dcpl, type);
+    f->base.hints   = (f->fd >= 0);
+    f->base.devices = 1;
+    if (ok && layout == H5D_CONTIGUOUS && !writable)
+        stg_h5_direct_init(f, type);
+    if (type  >= 0) H5Tclose(type);
+    if (dcpl  >= 0) H5Pclose(dcpl);
+    if (space >= 0) H5Sclose(space);
+    if (!ok) {
+        stg_h5_release(f);
+        tensor_store_unlock();
+        return NULL;
+    }
+    tensor_store_unlock();
+
+    f->base.tile_bytes = f->base.element_size;
+    for (int d = 0; d < f->base.rank; d++)
+        f->base.tile_bytes *= (size_t)f->base.chunk_dims[d];
+    return &f->base;
+}
+
+static StorageFile *stg_h5_create(const char *path, const char *dset,
+                                  int rank, const hsize_t *global_dims,
+                                  const hsize_t *chunk_dims,
+                                  tensor_dtype_t dtype)
+{
+    tensor_store_lock();
+    herr_t rc = create_chunked_dataset_einsum(path, dset, rank, global_dims,
+                                              chunk_dims, dtype);
+    tensor_store_unlock();
+    return (rc < 0) ? NULL : stg_h5_open(path, dset, 1);
+}
+
+/*
+ * 1 if every virtual tile of sf is one contiguous run of the dataset:
+ * past the first dim with a side above 1, each side spans its dim.
+ */
+static int stg_h5_tiles_are_runs(const StorageFile *sf)
+{
+    int d = 0;
+    while (d < sf->rank && sf->chunk_dims[d] == 1) d++;
+    for (d++; d < sf->rank; d++)
+        if (sf->chunk_dims[d] != sf->global_dims[d]) return 0;
+    return 1;
+}
+
+static TensorRegistry *stg_h5_scan(StorageFile *sf)
+{
+    StgHdf5 *f = (StgHdf5 *)sf;
+    /* A virtual tile that is not one run spans the rows of its neighbours
+     * too; hinting that span would prefetch and then drop their data. */
+    if (sf->virtual_tiles)
+        sf->hints = f->fd >= 0 && stg_h5_tiles_are_runs(sf);
+    tensor_store_lock();
+    TensorRegistry *reg = sf->virtual_tiles
+        ? registry_create_chunked(sf->rank, sf->global_dims, sf->chunk_dims,
+                                  sf->dtype)
+        : registry_create_from_dset(f->dset);
+    if (reg && registry_scan_file(f->dset, reg) < 0) {
+        registry_destroy(reg);
+        reg = NULL;
+    }
+    tensor_store_unlock();
+    return reg;
+}
+
+/*
+ * Gather tile off of a contiguous dataset into buf (nominal strides,
+ * padding zeroed) from the mapping or with one pread per run.
+ */
+static int stg_h5_gather(StgHdf5 *f, const hsize_t *off, char *buf)
+{
+    const StorageFile *b   = &f->base;
+    const int          r   = b->rank;
+    const size_t       esz = b->element_size;
+    hsize_t act[MAX_RANK];
+    int     partial = 0;
+    for (int d = 0; d < r; d++) {
+        hsize_t end = off[d] + b->chunk_dims[d];
+        act[d] = (end > b->global_dims[d]) ? b->global_dims[d] - off[d]
+                                           : b->chunk_dims[d];
+        partial |= act[d] != b->chunk_dims[d];
+    }
+    if (partial) memset(buf, 0, b->tile_bytes);
+
+    /* Dims after j span the whole extent in both the tile and the file,
+     * so one run covers act[j] rows of them. */
+    int j = r - 1;
+    while (j > 0 && b->chunk_dims[j] == b->global_dims[j]) j--;
+    size_t run = (size_t)act[j];
+    for (int d = j + 1; d < r; d++) run *= (size_t)b->global_dims[d];
+    run *= esz;
+
+    hsize_t c[MAX_RANK];
+    memset(c, 0, sizeof(c));
+    for (;;) {
+        uint64_t fl = 0, bl = 0;
+        for (int d = 0; d < r; d++) {
+            hsize_t cd = (d < j) ? c[d] : 0;
+            fl = fl * b->global_dims[d] + ((d <= j) ? off[d] + cd : 0);
+            bl = bl * b->chunk_dims[d]  + cd;
+        }
+        char *dst = buf + bl * esz;
+        if (f->data) {
+            memcpy(dst, f->data + fl * esz, run);
+        } else {
+            size_t   left = run;
+            uint64_t pos  = (uint64_t)f->data_addr + fl * esz;
+            while (left > 0) {
+                ssize_t n = pread(f->fd, dst, left, (off_t)pos);
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) {
+                    fprintf(stderr, "stg_read_tile: short read at %llu\n",
+                            (unsigned long long)pos);
+                    return -1;
+                }
+                dst += n; left -= (size_t)n; pos += (uint64_t)n;
+            }
+        }
+        int d = j - 1;
+        while (d >= 0 && ++c[d] == act[d]) c[d--] = 0;
+        if (d < 0) break;
+    }
+    return 0;
+}
+
+static int stg_h5_read_tile(StorageFile *sf, const hsize_t *off, void *buf)
+{
+    StgHdf5 *f = (StgHdf5 *)sf;
+    if (f->data_addr != HADDR_UNDEF) return stg_h5_gather(f, off, buf);
+    herr_t st;
+    tensor_store_lock();
+    if (f->raw_chunks) {
+        /* An unallocated chunk reads as zeros, as through H5Dread. */
+        hsize_t  n       = 0;
+        uint32_t filters = 0;
+        st = H5Dget_chunk_storage_size(f->dset, off, &n);
+        if (st >= 0 && n == 0)
+            memset(buf, 0, sf->tile_bytes);
+        else if (st >= 0)
+            st = (n == sf->tile_bytes)
+                 ? H5Dread_chunk(f->dset, H5P_DEFAULT, off, &filters, buf)
+                 : -1;
+    } else {
+        st = read_chunk_typed(f->dset, off, buf, sf->element_size,
+                              sf->rank, sf->chunk_dims, f->mem_type);
+    }
+    tensor_store_unlock();
+    /* Stored padding is whatever the writer's buffer held. */
+    if (st >= 0 && f->raw_chunks) stg_h5_zero_padding(sf, off, (char *)buf);
+    return (st < 0) ? -1 : 0;
+}
+
+/* One tile write; the caller holds the store lock. */
+static herr_t stg_h5_put(StgHdf5 *f, const hsize_t *off, const void *buf)
+{
+    const StorageFile *sf = &f->base;
+    if (f->raw_chunks)
+        return H5Dwrite_chunk(f->dset, H5P_DEFAULT, 0, off, sf->tile_bytes,
+                              buf);
+    return write_chunk_typed(f->dset, off, buf, sf->element_size, sf->rank,
+                             sf->chunk_dims, f->mem_type);
+}
+
+static int stg_h5_write_tile(StorageFile *sf, const hsize_t *off,
+                             const void *buf)
+{
+    StgHdf5 *f = (StgHdf5 *)sf;
+    tensor_store_lock();
+    herr_t st = stg_h5_put(f, off, buf);
+    tensor_store_unlock();
+    return (st < 0) ? -1 : 0;
+}
+
+/* One lock hold for the batch: the chunks are allocated back to back. */
+static int stg_h5_write_tiles(StorageFile *sf, size_t n,
+                              const hsize_t *const *off,
+                              const void *const *buf)
+{
+    StgHdf5 *f  = (StgHdf5 *)sf;
+    herr_t   st = 0;
+    tensor_store_lock();
+    for (size_t i = 0; i < n && st >= 0; i++)
+        st = stg_h5_put(f, off[i], buf[i]);
+    tensor_store_unlock();
+    return (st < 0) ? -1 : 0;
+}
+
+static void stg_h5_advise(StorageFile *sf, const TileMetadata *m,
+                          int willneed)
+{
+    file_advise(((StgHdf5 *)sf)->fd, m->file_addr, m->file_bytes, willneed);
+}
+
+static void stg_h5_close(StorageFile *sf)
+{
+    tensor_store_lock();
+    stg_h5_release((StgHdf5 *)sf);
+    tensor_store_unlock();
+}
+
+const storage_ops_t stg_hdf5_ops = {
+    "hdf5", stg_h5_open, stg_h5_create, stg_h5_scan, stg_h5_read_tile,
+    stg_h5_write_tile, stg_h5_write_tiles, stg_h5_advise, stg_h5_close
+};
+
+/* ----------------------------------------------------------------------- */
+/* Dispatch                                                                 */
+/* ----------------------------------------------------------------------- */
+
+const storage_ops_t *stg_probe(const char *path)
+{
+    char  magic[8] = {0};
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return NULL;
+    size_t n = fread(magic, 1, sizeof(magic), fp);
+    fclose(fp);
+    if (n == sizeof(magic) && memcmp(magic, STG_RAW_MAGIC, 8) == 0)
+        return &stg_raw_ops;
+    if (n == sizeof(magic) && memcmp(magic, STG_STRIPE_MAGIC, 8) == 0)
+        return &stg_stripe_ops;
+
+    tensor_store_lock();
+    htri_t is_h5 = H5Fis_hdf5(path);
+    tensor_store_unlock();
+    return (is_h5 > 0) ? &stg_hdf5_ops : NULL;
+}
+
+const storage_ops_t *stg_backend_for(const char *path)
+{
+    size_t n = strlen(path);
+    if (n > 4 && strcmp(path + n - 4, ".oct") == 0) return &stg_raw_ops;
+    if (n > 4 && strcmp(path + n - 4, ".ocs") == 0) return &stg_stripe_ops;
+    return &stg_hdf5_ops;
+}
+
+StorageFile *stg_open(const char *path, const char *dset, int writable)
+{
+    const storage_ops_t *ops = stg_probe(path);
+    if (!ops) {
+        fprintf(stderr, "stg_open: '%s' is not a readable tensor file\n",
+                path);
+        return NULL;
+    }
+    return ops->open(path, dset, writable);
+}
+
+StorageFile *stg_create(const char *path, const char *dset, int rank,
+                        const hsize_t *global_dims, const hsize_t *chunk_dims,
+                        tensor_dtype_t dtype)
+{
+    return stg_backend_for(path)->create(path, dset, rank, global_dims,
+                                         chunk_dims, dtype);
+}
+
+int stg_set_tiling(StorageFile *f, const hsize_t *chunk_dims)
+{
+    if (!f->virtual_tiles) return -1;
+    for (int d = 0; d < f->rank; d++)
+        if (chunk_dims[d] == 0) return -1;
+    f->tile_bytes = f->element_size;
+    for (int d = 0; d < f->rank; d++) {
+        f->chunk_dims[d] = (chunk_dims[d] < f->global_dims[d])
+                           ? chunk_dims[d] : f->global_dims[d];
+        f->tile_bytes   *= (size_t)f->chunk_dims[d];
+    }
+    return 0;
+}
+
+/* Boundary tile with the padding zeroed (see storage.h). */
+void *stg_pad_zero(const StorageFile *sf, const hsize_t *off,
+                   const void *buf, int *err)
+{
+    const int r = sf->rank;
+    hsize_t   act[MAX_RANK];
+    int       partial = 0;
+    for (int d = 0; d < r; d++) {
+        hsize_t end = off[d] + sf->chunk_dims[d];
+        act[d] = (end > sf->global_dims[d]) ? sf->global_dims[d] - off[d]
+                                            : sf->chunk_dims[d];
+        partial |= act[d] != sf->chunk_dims[d];
+    }
+    *err = 0;
+    if (!partial) return NULL;
+
+    char *out = (char *)calloc(1, sf->tile_bytes);
+    if (!out) { *err = 1; return NULL; }
+    /* Copy the valid run of the last dimension for every outer index. */
+    const size_t run = (size_t)act[r - 1] * sf->element_size;
+    hsize_t      c[MAX_RANK];
+    memset(c, 0, sizeof(c));
+    for (;;) {
+        size_t lin = 0;
+        for (int d = 0; d < r - 1; d++)
+            lin = (lin + (size_t)c[d]) * (size_t)sf->chunk_dims[d + 1];
+        memcpy(out + lin * sf->element_size,
+               (const char *)buf + lin * sf->element_size, run);
+        int d = r - 2;
+        while (d >= 0 && ++c[d] == act[d]) c[d--] = 0;
+        if (d < 0) break;
+    }
+    return out;
+}
+
+/* ----------------------------------------------------------------------- */
+/* Converter                                                                */
+/* ----------------------------------------------------------------------- */
+
+long stg_convert(const char *src, const char *src_dset,
+                 const char *dst, const char *dst_dset)
+{
+    StorageFile *in = stg_open(src, src_dset, 0);
+    if (!in) return -1;
+    TensorRegistry *reg = stg_scan(in);
+    StorageFile    *out = reg ? stg_create(dst, dst_dset, in->rank,
+                                           in->global_dims, in->chunk_dims,
+                                           in->dtype)
+                              : NULL;
+    void *buf = NULL;
+    long  n   = -1;
+    if (out && posix_memalign(&buf, STG_RAW_ALIGN,
+                              (in->tile_bytes + STG_RAW_ALIGN - 1)
+                              & ~(size_t)(STG_RAW_ALIGN - 1)) == 0) {
+        n = 0;
+        for (size_t t = 0; t < reg->total_tiles && n >= 0; t++) {
+            const TileMetadata *m = &reg->tiles[t];
+            if (m->status != TILE_STATUS_ON_DISK) continue;
+            memset(buf, 0, in->tile_bytes);
+            if (stg_read_tile(in, m->phys_offset, buf) < 0 ||
+                stg_write_tile(out, m->phys_offset, buf) < 0) {
+                fprintf(stderr, "stg_convert: tile %zu failed\n", t);
+                n = -1;
+            } else {
+                n++;
+            }
+        }
+    } else if (!out) {
+        fprintf(stderr, "stg_convert: cannot create '%s'\n", dst);
+    }
+    free(buf);
+    stg_close(out);
+    registry_destroy(reg);
+    stg_close(in);
+    return n;
+}
@@ -0,0 +1,323 @@
+/*
+ * storage_raw.c — Native tile-aligned storage backend (see storage.h).
+ *
+ * Every tile has a fixed slot, so reads and writes are single positional
+ * syscalls with no allocation, metadata tree or lock: concurrent readers
+ * and writers of different tiles never interact.  A write stores the
+ * payload first and its index entry second, so a process killed mid-write
+ * leaves the tile absent rather than half-present.  Nothing is fsynced:
+ * after a power loss or OS crash either write may be lost or torn.
+ */
+
+#include "storage.h"
+#include "tensor_store.h"   /* file_advise */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <complex.h>
+
+typedef struct {
+    StorageFile      base;
+    int              fd;
+    stg_raw_header_t h;
+} StgRaw;
+
+/* Row-major tile index of the tile starting at element offset off. */
+static uint64_t stg_raw_index(const StgRaw *f, const hsize_t *off)
+{
+    uint64_t idx = 0;
+    for (int d = 0; d < f->base.rank; d++) {
+        uint64_t grid = (f->h.global_dims[d] + f->h.chunk_dims[d] - 1)
+                        / f->h.chunk_dims[d];
+        idx = idx * grid + off[d] / f->h.chunk_dims[d];
+    }
+    return idx;
+}
+
+static int stg_raw_pread(int fd, void *buf, size_t n, uint64_t off)
+{
+    char *p = (char *)buf;
+    while (n > 0) {
+        ssize_t r = pread(fd, p, n, (off_t)off);
+        if (r < 0 && errno == EINTR) continue;
+        if (r < 0) return -1;
+        if (r == 0) { memset(p, 0, n); break; }    /* hole past EOF */
+        p += r; n -= (size_t)r; off += (uint64_t)r;
+    }
+    return 0;
+}
+
+static int stg_raw_pwrite(int fd, const void *buf, size_t n, uint64_t off)
+{
+    const char *p = (const char *)buf;
+    while (n > 0) {
+        ssize_t r = pwrite(fd, p, n, (off_t)off);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return -1;
+        p += r; n -= (size_t)r; off += (uint64_t)r;
+    }
+    return 0;
+}
+
+static void stg_raw_fill_base(StgRaw *f)
+{
+    f->base.ops          = &stg_raw_ops;
+    f->base.rank         = (int)f->h.rank;
+    f->base.dtype        = (tensor_dtype_t)f->h.dtype;
+    f->base.element_size = f->h.element_size;
+    f->base.tile_bytes   = (size_t)f->h.tile_bytes;
+    f->base.hints        = 1;
+    f->base.devices      = 1;
+    for (int d = 0; d < f->base.rank; d++) {
+        f->base.global_dims[d] = (hsize_t)f->h.global_dims[d];
+        f->base.chunk_dims[d]  = (hsize_t)f->h.chunk_dims[d];
+    }
+}
+
+/*
+ * Derive the layout fields of h (element size, tile count and size,
+ * alignment, offsets) from its dtype, rank and dims.  -1 if rank or dtype
+ * is out of range or a chunk dim is 0 or larger than its global dim.
+ */
+static int stg_raw_layout(stg_raw_header_t *h)
+{
+    if (h->rank == 0 || h->rank > MAX_RANK || h->dtype > DTYPE_COMPLEX128)
+        return -1;
+    h->element_size = (h->dtype == DTYPE_FP64) ? sizeof(double)
+                                               : sizeof(double _Complex);
+    h->n_tiles      = 1;
+    h->tile_bytes   = h->element_size;
+    for (uint32_t d = 0; d < h->rank; d++) {
+        if (h->chunk_dims[d] == 0 || h->chunk_dims[d] > h->global_dims[d])
+            return -1;
+        h->n_tiles    *= (h->global_dims[d] + h->chunk_dims[d] - 1)
+                         / h->chunk_dims[d];
+        h->tile_bytes *= h->chunk_dims[d];
+    }
+    /* Small tiles align to 4 KiB so padding stays under one block. */
+    h->align      = (h->tile_bytes >= STG_RAW_ALIGN) ? STG_RAW_ALIGN
+                                                     : STG_RAW_ALIGN_MIN;
+    h->slot_bytes = (h->tile_bytes + h->align - 1) & ~(h->align - 1);
+    h->index_off  = STG_RAW_HEADER;
+    h->data_off   = (h->index_off + h->n_tiles * sizeof(uint64_t)
+                     + h->align - 1) & ~(h->align - 1);
+    return 0;
+}
+
+/* 1 if the header read from disk is one stg_raw_create would write. */
+static int stg_raw_header_ok(const stg_raw_header_t *h)
+{
+    stg_raw_header_t want = *h;
+    return memcmp(h->magic, STG_RAW_MAGIC, 8) == 0 && h->version == 1 &&
+           stg_raw_layout(&want) == 0 &&
+           want.element_size == h->element_size &&
+           want.n_tiles      == h->n_tiles      &&
+           want.tile_bytes   == h->tile_bytes   &&
+           want.align        == h->align        &&
+           want.slot_bytes   == h->slot_bytes   &&
+           want.index_off    == h->index_off    &&
+           want.data_off     == h->data_off;
+}
+
+static StorageFile *stg_raw_open(const char *path, const char *dset,
+                                 int writable)
+{
+    (void)dset;
+    StgRaw *f = (StgRaw *)calloc(1, sizeof(StgRaw));
+    if (!f) return NULL;
+    f->fd = open(path, writable ? O_RDWR : O_RDONLY);
+    if (f->fd < 0 || stg_raw_pread(f->fd, &f->h, sizeof(f->h), 0) != 0 ||
+        !stg_raw_header_ok(&f->h)) {
+        fprintf(stderr, "stg_open: '%s' is not a valid native tensor file\n",
+                path);
+        if (f->fd >= 0) close(f->fd);
+        free(f);
+        return NULL;
+    }
+    stg_raw_fill_base(f);
+    return &f->base;
+}
+
+static StorageFile *stg_raw_create(const char *path, const char *dset,
+                                   int rank, const hsize_t *global_dims,
+                                   const hsize_t *chunk_dims,
+                                   tensor_dtype_t dtype)
+{
+    (void)dset;
+    if (rank <= 0 || rank > MAX_RANK) return NULL;
+    StgRaw *f = (StgRaw *)calloc(1, sizeof(StgRaw));
+    if (!f) return NULL;
+
+    stg_raw_header_t *h = &f->h;
+    memcpy(h->magic, STG_RAW_MAGIC, 8);
+    h->version = 1;
+    h->dtype   = (uint32_t)dtype;
+    h->rank    = (uint32_t)rank;
+    for (int d = 0; d < rank; d++) {
+        h->global_dims[d] = global_dims[d];
+        h->chunk_dims[d]  = chunk_dims[d];
+    }
+    if (stg_raw_layout(h) != 0) { free(f); return NULL; }
+
+    char block[STG_RAW_HEADER];
+    memset(block, 0, sizeof(block));
+    memcpy(block, h, sizeof(*h));
+    f->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (f->fd < 0 || stg_raw_pwrite(f->fd, block, sizeof(block), 0) != 0 ||
+        ftruncate(f->fd, (off_t)h->data_off) != 0) {
+        fprintf(stderr, "stg_create: cannot write '%s': %s\n", path,
+                strerror(errno));
+        if (f->fd >= 0) close(f->fd);
+        free(f);
+        return NULL;
+    }
+    stg_raw_fill_base(f);
+    return &f->base;
+}
+
+static TensorRegistry *stg_raw_scan(StorageFile *sf)
+{
+    StgRaw         *f   = (StgRaw *)sf;
+    TensorRegistry *reg = registry_create_chunked(sf->rank, sf->global_dims,
+                                                  sf->chunk_dims, sf->dtype);
+    uint64_t       *idx = reg ? (uint64_t *)malloc(f->h.n_tiles
+                                                   * sizeof(uint64_t))
+                              : NULL;
+    if (!idx || stg_raw_pread(f->fd, idx, f->h.n_tiles * sizeof(uint64_t),
+                              f->h.index_off) != 0) {
+        fprintf(stderr, "stg_scan: cannot read the tile index\n");
+        free(idx);
+        registry_destroy(reg);
+        return NULL;
+    }
+    for (size_t t = 0; t < reg->total_tiles; t++) {
+        if (!idx[t]) continue;
+        reg->tiles[t].status     = TILE_STATUS_ON_DISK;
+        reg->tiles[t].file_addr  = (haddr_t)idx[t];
+        reg->tiles[t].file_bytes = (hsize_t)f->h.tile_bytes;
+    }
+    free(idx);
+    return reg;
+}
+
+static int stg_raw_read_tile(StorageFile *sf, const hsize_t *off, void *buf)
+{
+    StgRaw  *f   = (StgRaw *)sf;
+    uint64_t idx = stg_raw_index(f, off);
+    if (idx >= f->h.n_tiles) return -1;
+    return stg_raw_pread(f->fd, buf, sf->tile_bytes,
+                         f->h.data_off + idx * f->h.slot_bytes);
+}
+
+static int stg_raw_write_tile(StorageFile *sf, const hsize_t *off,
+                              const void *buf)
+{
+    StgRaw  *f   = (StgRaw *)sf;
+    uint64_t idx = stg_raw_index(f, off);
+    if (idx >= f->h.n_tiles) return -1;
+
+    int   err;
+    void *pad = stg_pad_zero(sf, off, buf, &err);
+    if (err) return -1;
+    uint64_t pos = f->h.data_off + idx * f->h.slot_bytes;
+    int rc = stg_raw_pwrite(f->fd, pad ? pad : buf, sf->tile_bytes, pos);
+    free(pad);
+    if (rc == 0)
+        rc = stg_raw_pwrite(f->fd, &pos, sizeof(pos),
+                            f->h.index_off + idx * sizeof(uint64_t));
+    return rc;
+}
+
+/* pwritev of the whole iovec list at off, resuming after short writes. */
+static int stg_raw_pwritev(int fd, struct iovec *iov, int cnt, uint64_t off)
+{
+    while (cnt > 0) {
+        ssize_t r = pwritev(fd, iov, cnt, (off_t)off);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return -1;
+        off += (uint64_t)r;
+        while (cnt > 0 && (size_t)r >= iov->iov_len) {
+            r -= (ssize_t)iov->iov_len;
+            iov++; cnt--;
+        }
+        if (cnt > 0) {
+            iov->iov_base = (char *)iov->iov_base + r;
+            iov->iov_len -= (size_t)r;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Tiles with consecutive indices have adjacent slots and index entries:
+ * each such run is one pwritev of the payloads (slot padding included)
+ * followed by one pwrite of its index entries.
+ */
+#define STG_RAW_RUN_MAX 256              /* 2 iovecs per tile < IOV_MAX */
+
+static int stg_raw_write_tiles(StorageFile *sf, size_t n,
+                               const hsize_t *const *off,
+                               const void *const *buf)
+{
+    static const char zeros[STG_RAW_ALIGN];
+    StgRaw      *f   = (StgRaw *)sf;
+    const size_t gap = (size_t)(f->h.slot_bytes - f->h.tile_bytes);
+    struct iovec iov[2 * STG_RAW_RUN_MAX];
+    uint64_t     pos[STG_RAW_RUN_MAX];
+    void        *pad[STG_RAW_RUN_MAX];
+    size_t       i = 0;
+    int          rc = 0;
+
+    while (i < n && rc == 0) {
+        uint64_t first = stg_raw_index(f, off[i]);
+        size_t   len   = 0;
+        int      cnt   = 0;
+        while (i + len < n && len < STG_RAW_RUN_MAX &&
+               stg_raw_index(f, off[i + len]) == first + len) {
+            int err = first + len >= f->h.n_tiles;
+            pad[len] = err ? NULL : stg_pad_zero(sf, off[i + len],
+                                                     buf[i + len], &err);
+            if (err) { rc = -1; break; }
+            pos[len] = f->h.data_off + (first + len) * f->h.slot_bytes;
+            iov[cnt].iov_base   = pad[len] ? pad[len] : (void *)buf[i + len];
+            iov[cnt++].iov_len  = sf->tile_bytes;
+            if (gap) {
+                iov[cnt].iov_base  = (void *)zeros;
+                iov[cnt++].iov_len = gap;
+            }
+            len++;
+        }
+        if (rc == 0 && gap) cnt--;          /* no padding after the last */
+        if (rc == 0)
+            rc = stg_raw_pwritev(f->fd, iov, cnt, pos[0]);
+        if (rc == 0)
+            rc = stg_raw_pwrite(f->fd, pos, len * sizeof(uint64_t),
+                                f->h.index_off + first * sizeof(uint64_t));
+        for (size_t k = 0; k < len; k++) free(pad[k]);
+        i += len;
+    }
+    return rc;
+}
+
+static void stg_raw_advise(StorageFile *sf, const TileMetadata *m,
+                           int willneed)
+{
+    file_advise(((StgRaw *)sf)->fd, m->file_addr, m->file_bytes, willneed);
+}
+
+static void stg_raw_close(StorageFile *sf)
+{
+    StgRaw *f = (StgRaw *)sf;
+    close(f->fd);
+    free(f);
+}
+
+const storage_ops_t stg_raw_ops = {
+    "raw", stg_raw_open, stg_raw_create, stg_raw_scan, stg_raw_read_tile,
+    stg_raw_write_tile, stg_raw_write_tiles, stg_raw_advise, stg_raw_close
+};
@@ -0,0 +1,442 @@
+/*
+ * storage_retile.c — A tensor accessed under a tiling other than its own
+ * (see storage.h).
+ *
+ * The wrapper keeps the inner file and its scanned registry.  A virtual
+ * tile covers a box of inner tiles; it is stored if any of them is, and
+ * reading it reads each stored inner tile once and copies the overlap
+ * into place, row by row along the last dim.  When every virtual side is
+ * a multiple of the inner side the boxes do not overlap, so each inner
+ * tile is read exactly once per pass over the tensor.
+ *
+ * Writes (after stg_retile_stage) go the other way.  An inner tile that
+ * a virtual tile covers entirely is written at once.  One it only partly
+ * covers is staged in memory until the virtual tiles written so far fill
+ * it, then written whole.  Staged tiles beyond the byte budget, and any
+ * left at stg_retile_flush, are merged into the file oldest first: read,
+ * overlay the staged parts, write back.  Virtual tiles are disjoint, so
+ * such a merge never touches elements another virtual tile still has to
+ * read.  All writes, and reads of a writable view, hold one mutex.
+ */
+
+#include "storage.h"
+#include "memory.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* A partly written inner tile.  src lists the virtual tiles copied in. */
+typedef struct StgStage {
+    TileMetadata    *it;                   /* the inner tile               */
+    const hsize_t   *off;                  /* it->phys_offset              */
+    size_t           filled, valid;        /* elements written / in range  */
+    size_t           n_src, cap_src;
+    hsize_t        (*src)[MAX_RANK];
+    char            *buf;                  /* nominal inner tile           */
+    struct StgStage *next;
+} StgStage;
+
+typedef struct {
+    StorageFile      base;
+    StorageFile     *inner;
+    TensorRegistry  *inner_reg;
+    /* Write staging (stg_retile_stage). */
+    int              writable;
+    size_t           budget, staged;       /* bytes                        */
+    StgStage        *head, *tail;          /* oldest first                 */
+    pthread_mutex_t  mu;
+} StgRetile;
+
+/* Box of inner tile coordinates [lo, hi] under the virtual tile at off. */
+static void stg_retile_box(const StgRetile *f, const hsize_t *off,
+                           hsize_t *lo, hsize_t *hi)
+{
+    const StorageFile *in = f->inner;
+    for (int d = 0; d < f->base.rank; d++) {
+        hsize_t end = off[d] + f->base.chunk_dims[d];
+        if (end > f->base.global_dims[d]) end = f->base.global_dims[d];
+        lo[d] = off[d] / in->chunk_dims[d];
+        hi[d] = (end - 1) / in->chunk_dims[d];
+    }
+}
+
+/* Next inner tile coordinate in the box; 0 after the last. */
+static int stg_retile_step(int rank, hsize_t *c, const hsize_t *lo,
+                           const hsize_t *hi)
+{
+    for (int d = rank - 1; d >= 0; d--) {
+        if (c[d] < hi[d]) { c[d]++; return 1; }
+        c[d] = lo[d];
+    }
+    return 0;
+}
+
+/*
+ * Overlap [o0, o1) of the virtual tile at voff and the inner tile at ioff,
+ * clamped to the tensor.  Returns its element count.
+ */
+static size_t stg_retile_overlap(const StgRetile *f, const hsize_t *voff,
+                                 const hsize_t *ioff, hsize_t *o0, hsize_t *o1)
+{
+    size_t n = 1;
+    for (int d = 0; d < f->base.rank; d++) {
+        hsize_t ve = voff[d] + f->base.chunk_dims[d];
+        hsize_t ie = ioff[d] + f->inner->chunk_dims[d];
+        if (ve > f->base.global_dims[d]) ve = f->base.global_dims[d];
+        o0[d] = (voff[d] > ioff[d]) ? voff[d] : ioff[d];
+        o1[d] = (ve < ie) ? ve : ie;
+        n    *= (o1[d] > o0[d]) ? (size_t)(o1[d] - o0[d]) : 0;
+    }
+    return n;
+}
+
+/* Copy box [o0, o1) from src (tile at soff, sides sc) to dst (doff, dc). */
+static void stg_retile_copy(int r, size_t esz, const hsize_t *o0,
+                            const hsize_t *o1, char *dst, const hsize_t *doff,
+                            const hsize_t *dc, const char *src,
+                            const hsize_t *soff, const hsize_t *sc)
+{
+    const size_t run = (size_t)(o1[r - 1] - o0[r - 1]) * esz;
+    hsize_t      p[MAX_RANK];
+    memcpy(p, o0, sizeof(p));
+    for (;;) {
+        uint64_t di = 0, si = 0;
+        for (int d = 0; d < r; d++) {
+            di = di * dc[d] + (p[d] - doff[d]);
+            si = si * sc[d] + (p[d] - soff[d]);
+        }
+        memcpy(dst + di * esz, src + si * esz, run);
+        int d = r - 2;
+        while (d >= 0 && ++p[d] == o1[d]) { p[d] = o0[d]; d--; }
+        if (d < 0) break;
+    }
+}
+
+/* Per-thread inner-tile scratch; I/O threads free theirs on exit. */
+static char *rt_scratch(size_t n)
+{
+    return (char *)thread_scratch(SCRATCH_RETILE, n);
+}
+
+/* Elements of the inner tile at ioff that lie inside the tensor. */
+static size_t stg_retile_valid(const StgRetile *f, const hsize_t *ioff)
+{
+    size_t n = 1;
+    for (int d = 0; d < f->base.rank; d++) {
+        hsize_t end = ioff[d] + f->inner->chunk_dims[d];
+        n *= (size_t)(((end > f->base.global_dims[d])
+                       ? f->base.global_dims[d] : end) - ioff[d]);
+    }
+    return n;
+}
+
+static StgStage *stg_retile_find(StgRetile *f, const TileMetadata *it)
+{
+    for (StgStage *s = f->head; s; s = s->next)
+        if (s->it == it) return s;
+    return NULL;
+}
+
+/* Overlay every staged part of s onto tile (an inner tile at s->off). */
+static void stg_retile_overlay(StgRetile *f, const StgStage *s, char *tile)
+{
+    hsize_t o0[MAX_RANK], o1[MAX_RANK];
+    for (size_t k = 0; k < s->n_src; k++) {
+        stg_retile_overlap(f, s->src[k], s->off, o0, o1);
+        stg_retile_copy(f->base.rank, f->base.element_size, o0, o1, tile,
+                        s->off, f->inner->chunk_dims, s->buf, s->off,
+                        f->inner->chunk_dims);
+    }
+}
+
+static void stg_retile_unlink(StgRetile *f, StgStage *s)
+{
+    StgStage **pp = &f->head, *prev = NULL;
+    while (*pp != s) { prev = *pp; pp = &(*pp)->next; }
+    *pp = s->next;
+    if (f->tail == s) f->tail = prev;
+    f->staged -= f->inner->tile_bytes;
+    free(s->src);
+    free(s->buf);
+    free(s);
+}
+
+/* Write staged tile s to the inner file — merged with what is there
+ * unless s is complete — and drop it (also on failure). */
+static int stg_retile_commit(StgRetile *f, StgStage *s)
+{
+    const char *out = s->buf;
+    int         rc  = 0;
+    if (s->filled < s->valid && s->it->status == TILE_STATUS_ON_DISK) {
+        char *tmp = rt_scratch(f->inner->tile_bytes);
+        rc  = (tmp && stg_read_tile(f->inner, s->off, tmp) == 0) ? 0 : -1;
+        if (rc == 0) stg_retile_overlay(f, s, tmp);
+        out = tmp;
+    }
+    if (rc == 0) rc = stg_write_tile(f->inner, s->off, out);
+    if (rc == 0) s->it->status = TILE_STATUS_ON_DISK;
+    stg_retile_unlink(f, s);
+    return rc;
+}
+
+static StorageFile *stg_retile_open(const char *path, const char *dset,
+                                    int writable)
+{
+    (void)dset; (void)writable;
+    fprintf(stderr, "stg_open: '%s': retiled views are made with "
+                    "stg_retile, not opened\n", path);
+    return NULL;
+}
+
+static StorageFile *stg_retile_create(const char *path, const char *dset,
+                                      int rank, const hsize_t *global_dims,
+                                      const hsize_t *chunk_dims,
+                                      tensor_dtype_t dtype)
+{
+    (void)dset; (void)rank; (void)global_dims; (void)chunk_dims; (void)dtype;
+    fprintf(stderr, "stg_create: '%s': retiled views are made with "
+                    "stg_retile, not created\n", path);
+    return NULL;
+}
+
+static TensorRegistry *stg_retile_scan(StorageFile *sf)
+{
+    StgRetile      *f   = (StgRetile *)sf;
+    TensorRegistry *reg = registry_create_chunked(sf->rank, sf->global_dims,
+                                                  sf->chunk_dims, sf->dtype);
+    for (size_t t = 0; reg && t < reg->total_tiles; t++) {
+        TileMetadata *vt = &reg->tiles[t];
+        hsize_t lo[MAX_RANK], hi[MAX_RANK], c[MAX_RANK];
+        stg_retile_box(f, vt->phys_offset, lo, hi);
+        memcpy(c, lo, sizeof(c));
+        do {
+            const TileMetadata *it = registry_get_tile(f->inner_reg, c);
+            if (!it || it->status != TILE_STATUS_ON_DISK) continue;
+            if (vt->status != TILE_STATUS_ON_DISK) {
+                vt->status    = TILE_STATUS_ON_DISK;
+                vt->file_addr = it->file_addr;
+            }
+            vt->file_bytes += it->file_bytes;
+        } while (stg_retile_step(sf->rank, c, lo, hi));
+    }
+    return reg;
+}
+
+static int stg_retile_read_locked(StgRetile *f, const hsize_t *off, void *buf)
+{
+    const StorageFile *sf  = &f->base;
+    const StorageFile *in  = f->inner;
+    char              *tmp = rt_scratch(in->tile_bytes);
+    if (!tmp) return -1;
+    memset(buf, 0, sf->tile_bytes);
+
+    hsize_t lo[MAX_RANK], hi[MAX_RANK], c[MAX_RANK];
+    stg_retile_box(f, off, lo, hi);
+    memcpy(c, lo, sizeof(c));
+    do {
+        TileMetadata *it = registry_get_tile(f->inner_reg, c);
+        if (!it) continue;
+        StgStage *s = f->writable ? stg_retile_find(f, it) : NULL;
+        if (it->status == TILE_STATUS_ON_DISK) {
+            if (stg_read_tile(f->inner, it->phys_offset, tmp) != 0) return -1;
+        } else if (s) {
+            memset(tmp, 0, in->tile_bytes);
+        } else {
+            continue;
+        }
+        if (s) stg_retile_overlay(f, s, tmp);
+
+        hsize_t o0[MAX_RANK], o1[MAX_RANK];
+        stg_retile_overlap(f, off, it->phys_offset, o0, o1);
+        stg_retile_copy(sf->rank, sf->element_size, o0, o1, (char *)buf, off,
+                        sf->chunk_dims, tmp, it->phys_offset, in->chunk_dims);
+    } while (stg_retile_step(sf->rank, c, lo, hi));
+    return 0;
+}
+
+static int stg_retile_read_tile(StorageFile *sf, const hsize_t *off,
+                                void *buf)
+{
+    StgRetile *f = (StgRetile *)sf;
+    if (!f->writable) return stg_retile_read_locked(f, off, buf);
+    pthread_mutex_lock(&f->mu);
+    int rc = stg_retile_read_locked(f, off, buf);
+    pthread_mutex_unlock(&f->mu);
+    return rc;
+}
+
+static int stg_retile_write_locked(StgRetile *f, const hsize_t *off,
+                                   const void *buf)
+{
+    const StorageFile *sf = &f->base;
+    const StorageFile *in = f->inner;
+    hsize_t lo[MAX_RANK], hi[MAX_RANK], c[MAX_RANK];
+    stg_retile_box(f, off, lo, hi);
+    memcpy(c, lo, sizeof(c));
+    do {
+        TileMetadata *it = registry_get_tile(f->inner_reg, c);
+        if (!it) return -1;
+        hsize_t   o0[MAX_RANK], o1[MAX_RANK];
+        size_t    n     = stg_retile_overlap(f, off, it->phys_offset, o0, o1);
+        size_t    valid = stg_retile_valid(f, it->phys_offset);
+        StgStage *s     = stg_retile_find(f, it);
+        if (!s && n == valid) {
+            /* Covered entirely: write it now. */
+            char *tmp = rt_scratch(in->tile_bytes);
+            if (!tmp) return -1;
+            memset(tmp, 0, in->tile_bytes);
+            stg_retile_copy(sf->rank, sf->element_size, o0, o1, tmp,
+                            it->phys_offset, in->chunk_dims, (const char *)buf,
+                            off, sf->chunk_dims);
+            if (stg_write_tile(f->inner, it->phys_offset, tmp) != 0) return -1;
+            it->status = TILE_STATUS_ON_DISK;
+            continue;
+        }
+        if (!s) {
+            s = (StgStage *)calloc(1, sizeof(StgStage));
+            if (s) s->buf = (char *)calloc(1, in->tile_bytes);
+            if (!s || !s->buf) { if (s) free(s); return -1; }
+            s->it    = it;
+            s->off   = it->phys_offset;
+            s->valid = valid;
+            if (f->tail) f->tail->next = s; else f->head = s;
+            f->tail    = s;
+            f->staged += in->tile_bytes;
+        }
+        if (s->n_src == s->cap_src) {
+            size_t cap = s->cap_src ? 2 * s->cap_src : 4;
+            void  *p   = realloc(s->src, cap * sizeof(*s->src));
+            if (!p) return -1;
+            s->src     = (hsize_t (*)[MAX_RANK])p;
+            s->cap_src = cap;
+        }
+        memcpy(s->src[s->n_src++], off, sizeof(s->src[0]));
+        stg_retile_copy(sf->rank, sf->element_size, o0, o1, s->buf, s->off,
+                        in->chunk_dims, (const char *)buf, off, sf->chunk_dims);
+        s->filled += n;
+        if (s->filled >= s->valid && stg_retile_commit(f, s) != 0)
+            return -1;
+    } while (stg_retile_step(sf->rank, c, lo, hi));
+
+    /* Over budget: merge the oldest staged tiles into the file. */
+    while (f->head && f->staged > f->budget)
+        if (stg_retile_commit(f, f->head) != 0) return -1;
+    return 0;
+}
+
+static int stg_retile_write_tile(StorageFile *sf, const hsize_t *off,
+                                 const void *buf)
+{
+    StgRetile *f = (StgRetile *)sf;
+    if (!f->writable) {
+        fprintf(stderr, "stg_write_tile: retiled view is read-only\n");
+        return -1;
+    }
+    pthread_mutex_lock(&f->mu);
+    int rc = stg_retile_write_locked(f, off, buf);
+    pthread_mutex_unlock(&f->mu);
+    return rc;
+}
+
+static int stg_retile_write_tiles(StorageFile *sf, size_t n,
+                                  const hsize_t *const *off,
+                                  const void *const *buf)
+{
+    StgRetile *f = (StgRetile *)sf;
+    if (!f->writable) {
+        fprintf(stderr, "stg_write_tiles: retiled view is read-only\n");
+        return -1;
+    }
+    int rc = 0;
+    pthread_mutex_lock(&f->mu);
+    for (size_t i = 0; i < n && rc == 0; i++)
+        rc = stg_retile_write_locked(f, off[i], buf[i]);
+    pthread_mutex_unlock(&f->mu);
+    return rc;
+}
+
+/* Hint every stored inner tile under m. */
+static void stg_retile_advise(StorageFile *sf, const TileMetadata *m,
+                              int willneed)
+{
+    StgRetile *f = (StgRetile *)sf;
+    hsize_t lo[MAX_RANK], hi[MAX_RANK], c[MAX_RANK];
+    stg_retile_box(f, m->phys_offset, lo, hi);
+    memcpy(c, lo, sizeof(c));
+    do {
+        const TileMetadata *it = registry_get_tile(f->inner_reg, c);
+        if (it && it->status == TILE_STATUS_ON_DISK)
+            stg_advise(f->inner, it, willneed);
+    } while (stg_retile_step(sf->rank, c, lo, hi));
+}
+
+static void stg_retile_close(StorageFile *sf)
+{
+    StgRetile *f = (StgRetile *)sf;
+    if (f->head && stg_retile_flush(sf) != 0)
+        fprintf(stderr, "stg_close: retiled view lost staged tiles\n");
+    if (f->writable) pthread_mutex_destroy(&f->mu);
+    registry_destroy(f->inner_reg);
+    stg_close(f->inner);
+    free(f);
+}
+
+const storage_ops_t stg_retile_ops = {
+    "retile", stg_retile_open, stg_retile_create, stg_retile_scan,
+    stg_retile_read_tile, stg_retile_write_tile, stg_retile_write_tiles,
+    stg_retile_advise, stg_retile_close
+};
+
+StorageFile *stg_retile(StorageFile *inner, const hsize_t *chunk_dims)
+{
+    StgRetile *f = inner ? (StgRetile *)calloc(1, sizeof(StgRetile)) : NULL;
+    if (f) f->inner_reg = stg_scan(inner);
+    if (!f || !f->inner_reg) {
+        fprintf(stderr, "stg_retile: cannot scan the inner tensor\n");
+        free(f);
+        stg_close(inner);
+        return NULL;
+    }
+    f->inner             = inner;
+    f->base.ops          = &stg_retile_ops;
+    f->base.rank         = inner->rank;
+    f->base.dtype        = inner->dtype;
+    f->base.element_size = inner->element_size;
+    f->base.tile_bytes   = inner->element_size;
+    memcpy(f->base.global_dims, inner->global_dims, sizeof(inner->global_dims));
+    for (int d = 0; d < inner->rank; d++) {
+        f->base.chunk_dims[d] = (chunk_dims[d] == 0) ? inner->chunk_dims[d]
+                              : (chunk_dims[d] < inner->global_dims[d])
+                              ? chunk_dims[d] : inner->global_dims[d];
+        f->base.tile_bytes   *= (size_t)f->base.chunk_dims[d];
+    }
+    f->base.hints   = inner->hints;
+    f->base.devices = inner->devices;
+    return &f->base;
+}
+
+int stg_retile_stage(StorageFile *sf, size_t budget_bytes)
+{
+    if (sf->ops != &stg_retile_ops) return -1;
+    StgRetile *f = (StgRetile *)sf;
+    if (!f->writable) {
+        if (pthread_mutex_init(&f->mu, NULL) != 0) return -1;
+        f->writable = 1;
+    }
+    f->budget = budget_bytes;
+    return 0;
+}
+
+int stg_retile_flush(StorageFile *sf)
+{
+    if (sf->ops != &stg_retile_ops) return 0;
+    StgRetile *f  = (StgRetile *)sf;
+    int        rc = 0;
+    if (!f->writable) return 0;
+    pthread_mutex_lock(&f->mu);
+    while (f->head)
+        if (stg_retile_commit(f, f->head) != 0) rc = -1;
+    pthread_mutex_unlock(&f->mu);
+    return rc;
+}
@@ -0,0 +1,333 @@
+/*
+ * storage_stripe.c — Tensors striped over several drives (see storage.h).
+ *
+ * A striped tensor is a manifest plus one native member file per drive.
+ * Tile t (row-major tile index) lives in member t mod n, so any run of
+ * consecutive tiles — a B group, a row of A tiles — touches every drive
+ * and the page-cache readahead the engine issues ahead of its reads keeps
+ * all of them busy at once.  Members are independent native files, so
+ * tile reads and writes stay lock-free.
+ *
+ * Inside member t mod n the tile is local tile t / n of a rank-1 native
+ * file of whole tiles, so a member holds only its own share, densely:
+ * tiles t and t + n are adjacent slots, and a batch of consecutive tiles
+ * becomes one coalesced write per member.  The tensor's shape lives in
+ * the manifest; boundary padding is zeroed here, since a member sees
+ * every tile as interior.
+ */
+
+#include "storage.h"
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    StorageFile  base;
+    int          n;
+    uint64_t     n_tiles;
+    StorageFile *member[STG_STRIPE_MAX];
+} StgStripe;
+
+/* Index of the member holding the tile at off; *loc is its offset there. */
+static int stg_stripe_member(const StgStripe *f, const hsize_t *off,
+                             hsize_t *loc)
+{
+    uint64_t idx = 0;
+    for (int d = 0; d < f->base.rank; d++) {
+        uint64_t grid = (f->base.global_dims[d] + f->base.chunk_dims[d] - 1)
+                        / f->base.chunk_dims[d];
+        idx = idx * grid + off[d] / f->base.chunk_dims[d];
+    }
+    *loc = (hsize_t)(idx / (uint64_t)f->n)
+           * (f->base.tile_bytes / f->base.element_size);
+    return (int)(idx % (uint64_t)f->n);
+}
+
+/* Extent (in elements) of member k: its share of the tiles, at least 1. */
+static hsize_t stg_stripe_extent(const StgStripe *f, int k)
+{
+    uint64_t share = (f->n_tiles + (uint64_t)(f->n - 1 - k)) / (uint64_t)f->n;
+    return (hsize_t)(share ? share : 1)
+           * (f->base.tile_bytes / f->base.element_size);
+}
+
+static void stg_stripe_release(StgStripe *f)
+{
+    for (int k = 0; k < f->n; k++) stg_close(f->member[k]);
+    free(f);
+}
+
+/* Set the shape fields of f->base; -1 if rank, dtype or dims are bad. */
+static int stg_stripe_set_shape(StgStripe *f, int rank,
+                                const hsize_t *global_dims,
+                                const hsize_t *chunk_dims,
+                                tensor_dtype_t dtype)
+{
+    if (rank <= 0 || rank > MAX_RANK ||
+        (dtype != DTYPE_FP64 && dtype != DTYPE_COMPLEX128))
+        return -1;
+    f->base.ops          = &stg_stripe_ops;
+    f->base.rank         = rank;
+    f->base.dtype        = dtype;
+    f->base.element_size = (dtype == DTYPE_FP64) ? sizeof(double)
+                                                 : 2 * sizeof(double);
+    f->base.tile_bytes   = f->base.element_size;
+    f->base.hints        = 1;
+    f->n_tiles           = 1;
+    for (int d = 0; d < rank; d++) {
+        if (chunk_dims[d] == 0 || chunk_dims[d] > global_dims[d]) return -1;
+        f->base.global_dims[d] = global_dims[d];
+        f->base.chunk_dims[d]  = chunk_dims[d];
+        f->base.tile_bytes    *= (size_t)chunk_dims[d];
+        f->n_tiles *= (global_dims[d] + chunk_dims[d] - 1) / chunk_dims[d];
+    }
+    return 0;
+}
+
+/* 1 if every member is the rank-1 file of whole tiles its share needs. */
+static int stg_stripe_members_ok(StgStripe *f)
+{
+    const hsize_t tile = f->base.tile_bytes / f->base.element_size;
+    for (int k = 0; k < f->n; k++) {
+        const StorageFile *m = f->member[k];
+        if (m->rank != 1 || m->dtype != f->base.dtype ||
+            m->chunk_dims[0] != tile ||
+            m->global_dims[0] != stg_stripe_extent(f, k))
+            return 0;
+    }
+    f->base.devices = f->n;
+    return 1;
+}
+
+static StorageFile *stg_stripe_open(const char *path, const char *dset,
+                                    int writable)
+{
+    (void)dset;
+    FILE *fp = fopen(path, "r");
+    if (!fp) return NULL;
+    StgStripe *f = (StgStripe *)calloc(1, sizeof(StgStripe));
+    char       line[PATH_MAX];
+    int        ok = f && fgets(line, sizeof(line), fp) &&
+                    strncmp(line, STG_STRIPE_MAGIC, 8) == 0;
+
+    /* Shape line: dtype rank global_dims… chunk_dims… */
+    if (ok && (ok = fgets(line, sizeof(line), fp) != NULL)) {
+        char   *p     = line, *end;
+        long    dtype = strtol(p, &end, 10);
+        long    rank  = strtol(end, &p, 10);
+        hsize_t gd[MAX_RANK], cd[MAX_RANK];
+        ok = p != end && rank > 0 && rank <= MAX_RANK;
+        for (long d = 0; ok && d < 2 * rank; d++) {
+            unsigned long long v = strtoull(p, &end, 10);
+            ok = end != p;
+            if (d < rank) gd[d] = (hsize_t)v; else cd[d - rank] = (hsize_t)v;
+            p = end;
+        }
+        ok = ok && stg_stripe_set_shape(f, (int)rank, gd, cd,
+                                        (tensor_dtype_t)dtype) == 0;
+    }
+
+    /* Relative member paths are relative to the manifest's directory. */
+    const char *slash = strrchr(path, '/');
+    int         dlen  = slash ? (int)(slash - path) + 1 : 0;
+    while (ok && fgets(line, sizeof(line), fp)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (!line[0]) continue;
+        char full[2 * PATH_MAX];
+        if (line[0] == '/') snprintf(full, sizeof(full), "%s", line);
+        else snprintf(full, sizeof(full), "%.*s%s", dlen, path, line);
+        if (f->n == STG_STRIPE_MAX) { ok = 0; break; }
+        f->member[f->n] = stg_raw_ops.open(full, NULL, writable);
+        ok = f->member[f->n++] != NULL;
+    }
+    fclose(fp);
+    if (!ok || f->n == 0 || !stg_stripe_members_ok(f)) {
+        fprintf(stderr, "stg_open: '%s' is not a valid stripe manifest\n",
+                path);
+        if (f) stg_stripe_release(f);
+        return NULL;
+    }
+    return &f->base;
+}
+
+static StorageFile *stg_stripe_create(const char *path, const char *dset,
+                                      int rank, const hsize_t *global_dims,
+                                      const hsize_t *chunk_dims,
+                                      tensor_dtype_t dtype)
+{
+    (void)dset;
+    const char *env = getenv("TENSOR_STRIPE_DIRS");
+    if (!env || !*env) {
+        fprintf(stderr, "stg_create: set TENSOR_STRIPE_DIRS to create "
+                        "striped tensor '%s'\n", path);
+        return NULL;
+    }
+    StgStripe *f = (StgStripe *)calloc(1, sizeof(StgStripe));
+    if (!f || stg_stripe_set_shape(f, rank, global_dims, chunk_dims,
+                                   dtype) != 0) {
+        free(f);
+        return NULL;
+    }
+    FILE *fp = fopen(path, "w");
+    if (!fp) {
+        fprintf(stderr, "stg_create: cannot write '%s': %s\n", path,
+                strerror(errno));
+        free(f);
+        return NULL;
+    }
+    fprintf(fp, "%s\n%d %d", STG_STRIPE_MAGIC, (int)dtype, rank);
+    for (int d = 0; d < 2 * rank; d++)
+        fprintf(fp, " %llu", (unsigned long long)(d < rank
+                             ? global_dims[d] : chunk_dims[d - rank]));
+    fprintf(fp, "\n");
+
+    /* Member k: <dir k>/<manifest base name>.<k>.oct, holding
+     * ceil((n_tiles - k) / n) whole tiles once n is known. */
+    int n_dirs = 0;
+    for (const char *p = env; *p; ) {
+        size_t len = strcspn(p, ":");
+        n_dirs += len > 0;
+        p += len + (p[len] == ':');
+    }
+    f->n = n_dirs;
+    const hsize_t tile = f->base.tile_bytes / f->base.element_size;
+    const char *base = strrchr(path, '/');
+    base = base ? base + 1 : path;
+    int blen = (int)strlen(base) - 4;
+    int ok   = n_dirs > 0 && n_dirs <= STG_STRIPE_MAX;
+    int k    = 0;
+    if (!ok)
+        fprintf(stderr, "stg_create: TENSOR_STRIPE_DIRS must name 1 to %d "
+                        "directories\n", STG_STRIPE_MAX);
+    for (const char *p = env; ok && *p; ) {
+        size_t len = strcspn(p, ":");
+        char   dir[PATH_MAX], abs_dir[PATH_MAX], member[2 * PATH_MAX];
+        snprintf(dir, sizeof(dir), "%.*s", (int)len, p);
+        p += len + (p[len] == ':');
+        if (!dir[0]) continue;
+        if (!realpath(dir, abs_dir)) {
+            fprintf(stderr, "stg_create: bad stripe directory '%s'\n", dir);
+            ok = 0;
+            break;
+        }
+        snprintf(member, sizeof(member), "%s/%.*s.%d.oct", abs_dir, blen,
+                 base, k);
+        hsize_t extent = stg_stripe_extent(f, k);
+        f->member[k] = stg_raw_ops.create(member, NULL, 1, &extent, &tile,
+                                          dtype);
+        ok = f->member[k++] != NULL;
+        if (ok) fprintf(fp, "%s\n", member);
+    }
+    ok = (fclose(fp) == 0) && ok;
+    if (!ok) {
+        f->n = k;
+        stg_stripe_release(f);
+        return NULL;
+    }
+    f->base.devices = f->n;
+    return &f->base;
+}
+
+static TensorRegistry *stg_stripe_scan(StorageFile *sf)
+{
+    StgStripe      *f   = (StgStripe *)sf;
+    TensorRegistry *reg = registry_create_chunked(sf->rank, sf->global_dims,
+                                                  sf->chunk_dims, sf->dtype);
+    for (int k = 0; reg && k < f->n; k++) {
+        TensorRegistry *mr = stg_scan(f->member[k]);
+        if (!mr) {
+            registry_destroy(reg);
+            return NULL;
+        }
+        size_t j = 0;
+        for (size_t t = (size_t)k; t < reg->total_tiles; t += (size_t)f->n) {
+            reg->tiles[t].status     = mr->tiles[j].status;
+            reg->tiles[t].file_addr  = mr->tiles[j].file_addr;
+            reg->tiles[t].file_bytes = mr->tiles[j].file_bytes;
+            j++;
+        }
+        registry_destroy(mr);
+    }
+    return reg;
+}
+
+static int stg_stripe_read_tile(StorageFile *sf, const hsize_t *off,
+                                void *buf)
+{
+    StgStripe *f = (StgStripe *)sf;
+    hsize_t    loc;
+    int        k = stg_stripe_member(f, off, &loc);
+    return stg_read_tile(f->member[k], &loc, buf);
+}
+
+static int stg_stripe_write_tile(StorageFile *sf, const hsize_t *off,
+                                 const void *buf)
+{
+    StgStripe *f = (StgStripe *)sf;
+    hsize_t    loc;
+    int        k = stg_stripe_member(f, off, &loc);
+    int        err;
+    void      *pad = stg_pad_zero(sf, off, buf, &err);
+    int        rc  = err ? -1 : stg_write_tile(f->member[k], &loc,
+                                               pad ? pad : buf);
+    free(pad);
+    return rc;
+}
+
+/* Each member gets its share of the batch, in the original order. */
+static int stg_stripe_write_tiles(StorageFile *sf, size_t n,
+                                  const hsize_t *const *off,
+                                  const void *const *buf)
+{
+    StgStripe      *f   = (StgStripe *)sf;
+    hsize_t        *loc = (hsize_t *)malloc(n * sizeof(*loc));
+    int            *own = (int *)malloc(n * sizeof(*own));
+    void          **pad = (void **)calloc(n, sizeof(*pad));
+    const hsize_t **mo  = (const hsize_t **)malloc(n * sizeof(*mo));
+    const void    **mb  = (const void **)malloc(n * sizeof(*mb));
+    int             rc  = (loc && own && pad && mo && mb) ? 0 : -1;
+    for (size_t i = 0; i < n && rc == 0; i++) {
+        int err;
+        own[i] = stg_stripe_member(f, off[i], &loc[i]);
+        pad[i] = stg_pad_zero(sf, off[i], buf[i], &err);
+        if (err) rc = -1;
+    }
+    for (int k = 0; k < f->n && rc == 0; k++) {
+        size_t m = 0;
+        for (size_t i = 0; i < n; i++) {
+            if (own[i] != k) continue;
+            mo[m]   = &loc[i];
+            mb[m++] = pad[i] ? pad[i] : buf[i];
+        }
+        if (m) rc = stg_write_tiles(f->member[k], m, mo, mb);
+    }
+    for (size_t i = 0; pad && i < n; i++) free(pad[i]);
+    free(loc);
+    free(own);
+    free(pad);
+    free(mo);
+    free(mb);
+    return rc;
+}
+
+static void stg_stripe_advise(StorageFile *sf, const TileMetadata *m,
+                              int willneed)
+{
+    StgStripe *f = (StgStripe *)sf;
+    hsize_t    loc;
+    stg_advise(f->member[stg_stripe_member(f, m->phys_offset, &loc)], m,
+               willneed);
+}
+
+static void stg_stripe_close(StorageFile *sf)
+{
+    stg_stripe_release((StgStripe *)sf);
+}
+
+const storage_ops_t stg_stripe_ops = {
+    "stripe", stg_stripe_open, stg_stripe_create, stg_stripe_scan,
+    stg_stripe_read_tile, stg_stripe_write_tile, stg_stripe_write_tiles,
+    stg_stripe_advise, stg_stripe_close
+};
@@ -0,0 +1,375 @@
+/*
+ * task_pool.c
+ *
+ * Work-stealing task runtime — see task_pool.h.
+ *
+ * Deques follow Chase & Lev (SPAA 2005) with the C11 memory orderings of
+ * Lê, Pop, Cohen & Zappa Nardelli (PPoPP 2013).  The ring is fixed-size;
+ * a push that finds it full falls back to the shared inbox.
+ *
+ * Sleeping: a thread that finds nothing to run re-checks n_ready under
+ * pool->mu before waiting on pool->cv, and every task that becomes ready
+ * bumps n_ready before broadcasting under the same mutex, so wake-ups are
+ * never lost.
+ */
+
+#include "task_pool.h"
+#include "engine.h"     /* query_num_threads */
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TP_DEQUE_CAP 4096               /* power of two */
+
+struct tp_task {
+    tp_fn        fn;
+    void        *arg;
+    size_t       idx;
+    atomic_int   pending;   /* unfinished predecessors, +1 until submitted */
+    int          done;      /* guarded by pool->dep_mu                     */
+    tp_task_t  **succ;      /* successors to release on completion         */
+    int          n_succ, cap_succ;
+    task_pool_t *pool;
+    tp_task_t   *next_all;  /* allocation list, freed by task_pool_wait    */
+    tp_task_t   *next_in;   /* inbox link                                  */
+};
+
+typedef struct {
+    atomic_llong           top;
+    atomic_llong           bottom;
+    _Atomic(tp_task_t *)   buf[TP_DEQUE_CAP];
+} tp_deque_t;
+
+struct task_pool {
+    int              n_workers;
+    pthread_t       *thr;
+    tp_deque_t      *dq;            /* [n_workers]                          */
+
+    pthread_mutex_t  mu;            /* inbox, sleeping, shutdown            */
+    pthread_cond_t   cv;
+    tp_task_t       *in_head, *in_tail;
+    atomic_long      n_inbox;
+    int              shutdown;
+
+    atomic_long      n_ready;       /* runnable, not yet taken              */
+    atomic_long      n_unfinished;  /* submitted, not yet finished          */
+
+    pthread_mutex_t  dep_mu;        /* task->done and successor lists       */
+    pthread_mutex_t  alloc_mu;
+    tp_task_t       *all;
+};
+
+static _Thread_local task_pool_t *tls_pool   = NULL;
+static _Thread_local int          tls_worker = -1;
+static _Thread_local uint64_t     tls_rng    = 0;
+
+/* ----------------------------------------------------------------------- */
+/* Chase-Lev deque                                                           */
+/* ----------------------------------------------------------------------- */
+
+/* Owner only.  Returns 0, or -1 if the ring is full. */
+static int dq_push(tp_deque_t *d, tp_task_t *t)
+{
+    long long b   = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+    long long top = atomic_load_explicit(&d->top, memory_order_acquire);
+    if (b - top >= TP_DEQUE_CAP) return -1;
+    atomic_store_explicit(&d->buf[b & (TP_DEQUE_CAP - 1)], t,
+                          memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    return 0;
+}
+
+/* Owner only: newest task, or NULL. */
+static tp_task_t *dq_pop(tp_deque_t *d)
+{
+    long long b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long long t = atomic_load_explicit(&d->top, memory_order_relaxed);
+    tp_task_t *x = NULL;
+    if (t <= b) {
+        x = atomic_load_explicit(&d->buf[b & (TP_DEQUE_CAP - 1)],
+                                 memory_order_relaxed);
+        if (t == b) {
+            /* Last element: race the thieves for it. */
+            if (!atomic_compare_exchange_strong_explicit(
+                    &d->top, &t, t + 1,
+                    memory_order_seq_cst, memory_order_relaxed))
+                x = NULL;
+            atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        }
+    } else {
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    }
+    return x;
+}
+
+/* Any thread: oldest task, or NULL (empty or lost a race). */
+static tp_task_t *dq_steal(tp_deque_t *d)
+{
+    long long t = atomic_load_explicit(&d->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long long b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+    if (t >= b) return NULL;
+    tp_task_t *x = atomic_load_explicit(&d->buf[t & (TP_DEQUE_CAP - 1)],
+                                        memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(
+            &d->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+        return NULL;
+    return x;
+}
+
+/* ----------------------------------------------------------------------- */
+/* Scheduling                                                                */
+/* ----------------------------------------------------------------------- */
+
+static void tp_wake(task_pool_t *p)
+{
+    pthread_mutex_lock(&p->mu);
+    pthread_cond_broadcast(&p->cv);
+    pthread_mutex_unlock(&p->mu);
+}
+
+/* t has no unfinished predecessors: hand it to a deque or the inbox. */
+static void tp_make_ready(task_pool_t *p, tp_task_t *t)
+{
+    atomic_fetch_add(&p->n_ready, 1);
+    if (tls_pool == p && tls_worker >= 0 &&
+        dq_push(&p->dq[tls_worker], t) == 0) {
+        tp_wake(p);
+        return;
+    }
+    pthread_mutex_lock(&p->mu);
+    t->next_in = NULL;
+    if (p->in_tail) p->in_tail->next_in = t;
+    else            p->in_head = t;
+    p->in_tail = t;
+    atomic_fetch_add(&p->n_inbox, 1);
+    pthread_cond_broadcast(&p->cv);
+    pthread_mutex_unlock(&p->mu);
+}
+
+/* Own deque, then the inbox, then a steal sweep from a random victim. */
+static tp_task_t *tp_take(task_pool_t *p, int self)
+{
+    tp_task_t *t = (self >= 0) ? dq_pop(&p->dq[self]) : NULL;
+
+    if (!t && atomic_load(&p->n_inbox) > 0) {
+        pthread_mutex_lock(&p->mu);
+        t = p->in_head;
+        if (t) {
+            p->in_head = t->next_in;
+            if (!p->in_head) p->in_tail = NULL;
+            atomic_fetch_sub(&p->n_inbox, 1);
+        }
+        pthread_mutex_unlock(&p->mu);
+    }
+
+    if (!t && p->n_workers > 0) {
+        if (tls_rng == 0)
+            tls_rng = 0x9E3779B97F4A7C15ULL ^ (uint64_t)(uintptr_t)&t;
+        tls_rng ^= tls_rng << 13;
+        tls_rng ^= tls_rng >> 7;
+        tls_rng ^= tls_rng << 17;
+        int start = (int)(tls_rng % (uint64_t)p->n_workers);
+        for (int k = 0; k < p->n_workers && !t; k++) {
+            int v = (start + k) % p->n_workers;
+            if (v != self) t = dq_steal(&p->dq[v]);
+        }
+    }
+
+    if (t) atomic_fetch_sub(&p->n_ready, 1);
+    return t;
+}
+
+static void tp_run(task_pool_t *p, tp_task_t *t)
+{
+    t->fn(t->arg, t->idx);
+
+    pthread_mutex_lock(&p->dep_mu);
+    t->done = 1;
+    pthread_mutex_unlock(&p->dep_mu);
+    /* No successor can be added once done is set. */
+    for (int i = 0; i < t->n_succ; i++)
+        if (atomic_fetch_sub(&t->succ[i]->pending, 1) == 1)
+            tp_make_ready(p, t->succ[i]);
+
+    if (atomic_fetch_sub(&p->n_unfinished, 1) == 1)
+        tp_wake(p);
+}
+
+typedef struct {
+    task_pool_t *pool;
+    int          id;
+} tp_worker_arg_t;
+
+static void *tp_worker_main(void *arg)
+{
+    tp_worker_arg_t *wa = (tp_worker_arg_t *)arg;
+    task_pool_t     *p  = wa->pool;
+    tls_pool   = p;
+    tls_worker = wa->id;
+    free(wa);
+
+    for (;;) {
+        tp_task_t *t = tp_take(p, tls_worker);
+        if (t) { tp_run(p, t); continue; }
+        pthread_mutex_lock(&p->mu);
+        while (!p->shutdown && atomic_load(&p->n_ready) == 0)
+            pthread_cond_wait(&p->cv, &p->mu);
+        int stop = p->shutdown;
+        pthread_mutex_unlock(&p->mu);
+        if (stop) break;
+    }
+    return NULL;
+}
+
+/* ----------------------------------------------------------------------- */
+/* Public API                                                                */
+/* ----------------------------------------------------------------------- */
+
+task_pool_t *task_pool_create(int n_workers)
+{
+    if (n_workers < 0) n_workers = query_num_threads() - 1;
+    if (n_workers < 0) n_workers = 0;
+
+    task_pool_t *p = (task_pool_t *)calloc(1, sizeof(*p));
+    if (!p) return NULL;
+    if (n_workers > 0) {
+        p->dq  = (tp_deque_t *)calloc((size_t)n_workers, sizeof(tp_deque_t));
+        p->thr = (pthread_t *)calloc((size_t)n_workers, sizeof(pthread_t));
+        if (!p->dq || !p->thr) {
+            free(p->dq);
+            free(p->thr);
+            free(p);
+            return NULL;
+        }
+    }
+    pthread_mutex_init(&p->mu, NULL);
+    pthread_cond_init(&p->cv, NULL);
+    pthread_mutex_init(&p->dep_mu, NULL);
+    pthread_mutex_init(&p->alloc_mu, NULL);
+
+    for (int i = 0; i < n_workers; i++) {
+        tp_worker_arg_t *wa = (tp_worker_arg_t *)malloc(sizeof(*wa));
+        if (wa) { wa->pool = p; wa->id = i; }
+        if (!wa || pthread_create(&p->thr[i], NULL, tp_worker_main, wa) != 0) {
+            fprintf(stderr, "task_pool_create: cannot start worker %d\n", i);
+            free(wa);
+            p->n_workers = i;
+            task_pool_destroy(p);
+            return NULL;
+        }
+        p->n_workers = i + 1;
+    }
+    return p;
+}
+
+void task_pool_destroy(task_pool_t *pool)
+{
+    if (!pool) return;
+    pthread_mutex_lock(&pool->mu);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->cv);
+    pthread_mutex_unlock(&pool->mu);
+    for (int i = 0; i < pool->n_workers; i++)
+        pthread_join(pool->thr[i], NULL);
+
+    task_pool_wait(pool);               /* frees any never-submitted tasks */
+    pthread_mutex_destroy(&pool->mu);
+    pthread_cond_destroy(&pool->cv);
+    pthread_mutex_destroy(&pool->dep_mu);
+    pthread_mutex_destroy(&pool->alloc_mu);
+    free(pool->thr);
+    free(pool->dq);
+    free(pool);
+}
+
+int task_pool_size(const task_pool_t *pool)
+{
+    return pool ? pool->n_workers + 1 : 1;
+}
+
+tp_task_t *task_pool_task(task_pool_t *pool, tp_fn fn, void *arg, size_t idx)
+{
+    tp_task_t *t = (tp_task_t *)calloc(1, sizeof(*t));
+    if (!t) return NULL;
+    t->fn   = fn;
+    t->arg  = arg;
+    t->idx  = idx;
+    t->pool = pool;
+    atomic_init(&t->pending, 1);
+    pthread_mutex_lock(&pool->alloc_mu);
+    t->next_all = pool->all;
+    pool->all   = t;
+    pthread_mutex_unlock(&pool->alloc_mu);
+    return t;
+}
+
+int task_pool_depend(tp_task_t *succ, tp_task_t *pred)
+{
+    if (!succ || !pred) return 0;
+    task_pool_t *p  = pred->pool;
+    int          rc = 0;
+    pthread_mutex_lock(&p->dep_mu);
+    if (!pred->done) {
+        if (pred->n_succ == pred->cap_succ) {
+            int cap = pred->cap_succ ? 2 * pred->cap_succ : 4;
+            tp_task_t **s = (tp_task_t **)realloc(pred->succ,
+                                                  (size_t)cap * sizeof(*s));
+            if (!s) rc = -1;
+            else { pred->succ = s; pred->cap_succ = cap; }
+        }
+        if (rc == 0) {
+            pred->succ[pred->n_succ++] = succ;
+            atomic_fetch_add(&succ->pending, 1);
+        }
+    }
+    pthread_mutex_unlock(&p->dep_mu);
+    return rc;
+}
+
+void task_pool_submit(task_pool_t *pool, tp_task_t *task)
+{
+    atomic_fetch_add(&pool->n_unfinished, 1);
+    if (atomic_fetch_sub(&task->pending, 1) == 1)
+        tp_make_ready(pool, task);
+}
+
+void task_pool_wait(task_pool_t *pool)
+{
+    for (;;) {
+        if (atomic_load(&pool->n_unfinished) == 0) break;
+        tp_task_t *t = tp_take(pool, -1);
+        if (t) { tp_run(pool, t); continue; }
+        pthread_mutex_lock(&pool->mu);
+        while (atomic_load(&pool->n_unfinished) > 0 &&
+               atomic_load(&pool->n_ready) == 0)
+            pthread_cond_wait(&pool->cv, &pool->mu);
+        pthread_mutex_unlock(&pool->mu);
+    }
+
+    pthread_mutex_lock(&pool->alloc_mu);
+    tp_task_t *t = pool->all;
+    pool->all = NULL;
+    pthread_mutex_unlock(&pool->alloc_mu);
+    while (t) {
+        tp_task_t *next = t->next_all;
+        free(t->succ);
+        free(t);
+        t = next;
+    }
+}
+
+void task_pool_parallel_for(task_pool_t *pool, size_t n, tp_fn fn, void *arg)
+{
+    for (size_t i = 0; i < n; i++) {
+        tp_task_t *t = task_pool_task(pool, fn, arg, i);
+        if (t) task_pool_submit(pool, t);
+        else   fn(arg, i);
+    }
+    task_pool_wait(pool);
+}
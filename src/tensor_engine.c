@@ -9,9 +9,12 @@
 
 #include "tensor_engine.h"
 #include "engine.h"
+#include "elementwise.h"
+#include "tile_writer.h"
+#include "sparse_pattern.h"
+#include "verify.h"
 #include "tensor_store.h"
 #include "registry.h"
-#include "odometer.h"
 
 #include <hdf5.h>
 #include <math.h>
@@ -28,8 +31,10 @@
  * -----------------------------------------------------------------------*/
 
 struct tensor_engine {
-    size_t pool_mb;
-    size_t tile_bytes;
+    size_t      pool_mb;
+    size_t      tile_bytes;
+    size_t      shm_cache_mb;
+    EngineWarm *warm;           /* kept executor state (keep_warm), or NULL */
 };
 
 /* -------------------------------------------------------------------------
@@ -43,11 +48,18 @@ tensor_engine_t *tensor_engine_init(const tensor_engine_config_t *cfg)
         return NULL;
 
     if (cfg) {
-        eng->pool_mb    = cfg->pool_mb;
-        eng->tile_bytes = cfg->tile_bytes;
+        eng->pool_mb      = cfg->pool_mb;
+        eng->tile_bytes   = cfg->tile_bytes;
+        eng->shm_cache_mb = cfg->shm_cache_mb;
     } else {
-        eng->pool_mb    = 0;
-        eng->tile_bytes = 0;
+        eng->pool_mb      = 0;
+        eng->tile_bytes   = 0;
+        eng->shm_cache_mb = 0;
+    }
+    eng->warm = NULL;
+    if (cfg && cfg->keep_warm && !(eng->warm = engine_warm_create())) {
+        free(eng);
+        return NULL;
     }
 
     return eng;
@@ -55,6 +67,9 @@ tensor_engine_t *tensor_engine_init(const tensor_engine_config_t *cfg)
 
 void tensor_engine_free(tensor_engine_t *engine)
 {
+    if (!engine)
+        return;
+    engine_warm_destroy(engine->warm);
     free(engine);
 }
 
@@ -81,10 +96,13 @@ int tensor_engine_contract(tensor_engine_t *engine,
         setenv("TENSOR_POOL_MB", pool_buf, /*overwrite=*/1);
     }
 
-    int rc = run_contraction_einsum(einsum_expr,
-                                    file_A, DEFAULT_DSET,
-                                    file_B, DEFAULT_DSET,
-                                    file_C, DEFAULT_DSET);
+    engine_run_opts_t opts = {.warm         = engine->warm,
+                              .shm_cache_mb = engine->shm_cache_mb};
+    int rc = run_contraction_einsum_opts(einsum_expr,
+                                         file_A, DEFAULT_DSET,
+                                         file_B, DEFAULT_DSET,
+                                         file_C, DEFAULT_DSET,
+                                         /*accumulate=*/0, &opts);
 
     /* Clear the env-var after the call so it does not bleed into a subsequent
      * invocation that omits pool_mb. */
@@ -94,6 +112,36 @@ int tensor_engine_contract(tensor_engine_t *engine,
     return (rc == 0) ? TENSOR_ENGINE_OK : TENSOR_ENGINE_ERR;
 }
 
+int tensor_engine_contract_chunked(tensor_engine_t *engine,
+                                   const char      *einsum_expr,
+                                   const char      *file_A,
+                                   const char      *file_B,
+                                   const char      *file_C,
+                                   const size_t    *c_chunk_dims)
+{
+    if (!c_chunk_dims)
+        return tensor_engine_contract(engine, einsum_expr, file_A, file_B,
+                                      file_C);
+    const char *arrow = einsum_expr ? strstr(einsum_expr, "->") : NULL;
+    if (!arrow) return TENSOR_ENGINE_ERR;
+
+    /* One side per output index, published as "s0,s1,...". */
+    char chunk_buf[MAX_RANK * 21];
+    int  len = 0, d = 0;
+    for (const char *p = arrow + 2; *p; p++) {
+        if (*p == ' ') continue;
+        if (d == MAX_RANK) return TENSOR_ENGINE_ERR;
+        len += snprintf(chunk_buf + len, sizeof(chunk_buf) - (size_t)len,
+                        "%s%zu", d ? "," : "", c_chunk_dims[d]);
+        d++;
+    }
+    setenv("TENSOR_C_CHUNK_DIMS", chunk_buf, /*overwrite=*/1);
+    int rc = tensor_engine_contract(engine, einsum_expr, file_A, file_B,
+                                    file_C);
+    unsetenv("TENSOR_C_CHUNK_DIMS");
+    return rc;
+}
+
 int tensor_engine_accumulate(tensor_engine_t *engine,
                              const char      *einsum_expr,
                              const char      *file_A,
@@ -109,10 +157,13 @@ int tensor_engine_accumulate(tensor_engine_t *engine,
         setenv("TENSOR_POOL_MB", pool_buf, /*overwrite=*/1);
     }
 
-    int rc = run_contraction_einsum_acc(einsum_expr,
-                                        file_A, DEFAULT_DSET,
-                                        file_B, DEFAULT_DSET,
-                                        file_C, DEFAULT_DSET);
+    engine_run_opts_t opts = {.warm         = engine->warm,
+                              .shm_cache_mb = engine->shm_cache_mb};
+    int rc = run_contraction_einsum_opts(einsum_expr,
+                                         file_A, DEFAULT_DSET,
+                                         file_B, DEFAULT_DSET,
+                                         file_C, DEFAULT_DSET,
+                                         /*accumulate=*/1, &opts);
 
     if (engine->pool_mb > 0)
         unsetenv("TENSOR_POOL_MB");
@@ -120,6 +171,82 @@ int tensor_engine_accumulate(tensor_engine_t *engine,
     return (rc == 0) ? TENSOR_ENGINE_OK : TENSOR_ENGINE_ERR;
 }
 
+/* -------------------------------------------------------------------------
+ * Elementwise expressions
+ * -----------------------------------------------------------------------*/
+
+int tensor_engine_elementwise(tensor_engine_t    *engine,
+                              const char         *expr,
+                              const char *const  *files_in,
+                              int                 n_in,
+                              const char         *file_out)
+{
+    if (!engine || !expr || !files_in || !file_out ||
+        n_in < 1 || n_in > EW_MAX_INPUTS)
+        return TENSOR_ENGINE_ERR;
+
+    const char *names[EW_MAX_INPUTS];
+    for (int k = 0; k < n_in; k++) {
+        if (!files_in[k]) return TENSOR_ENGINE_ERR;
+        names[k] = DEFAULT_DSET;
+    }
+
+    char pool_buf[32];
+    if (engine->pool_mb > 0) {
+        snprintf(pool_buf, sizeof(pool_buf), "%zu", engine->pool_mb);
+        setenv("TENSOR_POOL_MB", pool_buf, /*overwrite=*/1);
+    }
+
+    int rc = run_elementwise(expr, files_in, names, n_in,
+                             file_out, DEFAULT_DSET);
+
+    if (engine->pool_mb > 0)
+        unsetenv("TENSOR_POOL_MB");
+
+    /* run_elementwise returns the public error codes directly. */
+    return (rc == 0) ? TENSOR_ENGINE_OK :
+           (rc >= TENSOR_ENGINE_ERR_MEM) ? rc : TENSOR_ENGINE_ERR;
+}
+
+/* -------------------------------------------------------------------------
+ * Result verification
+ * -----------------------------------------------------------------------*/
+
+int tensor_engine_verify(tensor_engine_t        *engine,
+                         const char             *expr,
+                         const char             *file_A,
+                         const char             *file_B,
+                         const char             *file_C,
+                         tensor_engine_verify_t *v)
+{
+    if (!engine || !expr || !file_A || !file_B || !file_C)
+        return TENSOR_ENGINE_ERR;
+
+    verify_opts_t opts;
+    memset(&opts, 0, sizeof(opts));
+    if (v) {
+        opts.n_vectors = v->n_vectors;
+        opts.seed      = v->seed;
+        opts.rtol      = v->rtol;
+    }
+
+    verify_report_t rep;
+    int rc = verify_contraction(expr, file_A, file_B, file_C, &opts, &rep);
+    if (v) {
+        v->max_abs_err = rep.max_abs_err;
+        v->max_rel_err = rep.max_rel_err;
+        v->n_checked   = rep.n_checked;
+        v->n_failed    = rep.n_failed;
+        v->seconds     = rep.seconds;
+    }
+
+    /* verify_contraction returns 1 for a mismatch and the public error
+     * codes for failures. */
+    return (rc == 0) ? TENSOR_ENGINE_OK :
+           (rc == 1) ? TENSOR_ENGINE_ERR_MISMATCH :
+           (rc >= TENSOR_ENGINE_ERR_MEM) ? rc : TENSOR_ENGINE_ERR;
+}
+
 /* -------------------------------------------------------------------------
  * Error descriptions
  * -----------------------------------------------------------------------*/
@@ -133,6 +260,7 @@ const char *tensor_engine_strerror(int err)
     case TENSOR_ENGINE_ERR_EXPR:  return "malformed einsum expression";
     case TENSOR_ENGINE_ERR_MEM:   return "memory allocation failed";
     case TENSOR_ENGINE_ERR:       return "internal engine error";
+    case TENSOR_ENGINE_ERR_MISMATCH: return "result does not match operands";
     default:                      return "unknown error";
     }
 }
@@ -207,13 +335,15 @@ int tensor_engine_create(tensor_engine_t *engine,
  * Tensor fill
  * -----------------------------------------------------------------------*/
 
-int tensor_engine_fill(tensor_engine_t *engine,
-                       const char      *file_path,
-                       const void      *value)
+/*
+ * Shared body of tensor_engine_fill / _fill_random / _fill_sparse: open the
+ * "tensor" dataset and hand it to the parallel tile writer.  pattern, when
+ * non-NULL, restricts the written tiles.
+ */
+static int engine_fill_impl(const char *file_path,
+                            tile_writer_opts_t *opts,
+                            sparse_pattern_t *pattern)
 {
-    if (!engine || !file_path || !value)
-        return TENSOR_ENGINE_ERR;
-
     hid_t fid = H5Fopen(file_path, H5F_ACC_RDWR, H5P_DEFAULT);
     if (fid < 0)
         return TENSOR_ENGINE_ERR_FILE;
@@ -231,10 +361,6 @@ int tensor_engine_fill(tensor_engine_t *engine,
         return TENSOR_ENGINE_ERR_MEM;
     }
 
-    int    rank      = reg->rank;
-    size_t elem_size = (reg->dtype == DTYPE_COMPLEX128)
-                       ? sizeof(double _Complex) : sizeof(double);
-
     /* Build the HDF5 memory type.  For FP64 use the predefined constant
      * (no lifetime management needed).  For COMPLEX128 allocate a compound. */
     hid_t mem_type;
@@ -252,49 +378,86 @@ int tensor_engine_fill(tensor_engine_t *engine,
         mem_type = H5T_NATIVE_DOUBLE;
     }
 
-    /* Allocate one nominal tile buffer and broadcast the scalar into it. */
-    size_t tile_elems = 1;
-    size_t ntiles[MAX_RANK];
-    for (int d = 0; d < rank; d++) {
-        tile_elems *= (size_t)reg->chunk_dims[d];
-        ntiles[d]   = ((size_t)reg->global_dims[d]
-                       + (size_t)reg->chunk_dims[d] - 1)
-                      / (size_t)reg->chunk_dims[d];
-    }
-
-    void *buf = malloc(tile_elems * elem_size);
-    if (!buf) {
-        if (own_mem_type) H5Tclose(mem_type);
-        registry_destroy(reg);
-        H5Dclose(dset);
-        H5Fclose(fid);
-        return TENSOR_ENGINE_ERR_MEM;
+    if (pattern) {
+        if (sparse_pattern_validate(pattern, reg) < 0) {
+            if (own_mem_type) H5Tclose(mem_type);
+            registry_destroy(reg);
+            H5Dclose(dset);
+            H5Fclose(fid);
+            return TENSOR_ENGINE_ERR_DIMS;
+        }
+        opts->select      = sparse_pattern_select;
+        opts->select_user = pattern;
+        if (pattern->kind == SP_SYMMETRIC) {
+            opts->fill      = TW_FILL_CALLBACK;
+            opts->tile_fn   = sparse_pattern_fill_symmetric;
+            opts->tile_user = pattern;
+        }
     }
 
-    /* Broadcast: copy the scalar into every element slot of the tile buffer. */
-    for (size_t i = 0; i < tile_elems; i++)
-        memcpy((char *)buf + i * elem_size, value, elem_size);
-
-    /* Iterate over every tile in row-major order and write it. */
-    int    ret  = TENSOR_ENGINE_OK;
-    size_t tile[MAX_RANK];
-    memset(tile, 0, sizeof(tile));
-    do {
-        hsize_t phys_off[MAX_RANK];
-        for (int d = 0; d < rank; d++)
-            phys_off[d] = (hsize_t)tile[d] * reg->chunk_dims[d];
-
-        if (write_chunk_typed(dset, phys_off, buf, elem_size,
-                              rank, reg->chunk_dims, mem_type) < 0) {
-            ret = TENSOR_ENGINE_ERR_FILE;
-            break;
-        }
-    } while (odometer_step((size_t)rank, tile, ntiles));
+    /* Producers generate tiles in parallel; one writer thread streams them
+     * to disk with direct chunk writes when the dataset allows it. */
+    opts->direct = 1;
+    int rc  = tile_writer_run(dset, reg, mem_type, opts, NULL);
+    int ret = (rc == 0)  ? TENSOR_ENGINE_OK :
+              (rc == -4) ? TENSOR_ENGINE_ERR_MEM : TENSOR_ENGINE_ERR_FILE;
 
-    free(buf);
     if (own_mem_type) H5Tclose(mem_type);
     registry_destroy(reg);
     H5Dclose(dset);
     H5Fclose(fid);
     return ret;
 }
+
+int tensor_engine_fill(tensor_engine_t *engine,
+                       const char      *file_path,
+                       const void      *value)
+{
+    if (!engine || !file_path || !value)
+        return TENSOR_ENGINE_ERR;
+
+    tile_writer_opts_t opts;
+    memset(&opts, 0, sizeof(opts));
+    opts.fill  = TW_FILL_CONST;
+    opts.value = value;
+    return engine_fill_impl(file_path, &opts, NULL);
+}
+
+int tensor_engine_fill_random(tensor_engine_t *engine,
+                              const char      *file_path,
+                              uint64_t         seed)
+{
+    if (!engine || !file_path)
+        return TENSOR_ENGINE_ERR;
+
+    tile_writer_opts_t opts;
+    memset(&opts, 0, sizeof(opts));
+    opts.fill = TW_FILL_RANDOM;
+    opts.seed = seed;
+    return engine_fill_impl(file_path, &opts, NULL);
+}
+
+int tensor_engine_fill_sparse(tensor_engine_t                *engine,
+                              const char                     *file_path,
+                              const tensor_engine_sparsity_t *sparsity)
+{
+    if (!engine || !file_path || !sparsity)
+        return TENSOR_ENGINE_ERR;
+    if (sparsity->pattern < TENSOR_SPARSITY_DENSE ||
+        sparsity->pattern > TENSOR_SPARSITY_SYMMETRIC)
+        return TENSOR_ENGINE_ERR;
+
+    /* TENSOR_SPARSITY_* values mirror sp_kind_t. */
+    sparse_pattern_t pat;
+    pat.kind      = (sp_kind_t)sparsity->pattern;
+    pat.density   = sparsity->density;
+    pat.bandwidth = sparsity->bandwidth;
+    pat.n_blocks  = sparsity->n_blocks;
+    pat.seed      = sparsity->seed;
+
+    tile_writer_opts_t opts;
+    memset(&opts, 0, sizeof(opts));
+    opts.fill = TW_FILL_RANDOM;
+    opts.seed = sparsity->seed;
+    return engine_fill_impl(file_path, &opts, &pat);
+}
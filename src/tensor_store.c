@@ -4,6 +4,8 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <pthread.h>
+#include <fcntl.h>
 #include <hdf5.h>
 
 /* ----------------------------------------------------------------------- */
@@ -36,6 +38,15 @@ void calculate_chunk_dims(size_t target_bytes, int rank,
                                                         : side_int;
 }
 
+/* ----------------------------------------------------------------------- */
+/* HDF5 lock                                                                */
+/* ----------------------------------------------------------------------- */
+
+static pthread_mutex_t g_h5_mu = PTHREAD_MUTEX_INITIALIZER;
+
+void tensor_store_lock(void)   { pthread_mutex_lock(&g_h5_mu); }
+void tensor_store_unlock(void) { pthread_mutex_unlock(&g_h5_mu); }
+
 /* ----------------------------------------------------------------------- */
 /* dset_open_no_cache                                                       */
 /* ----------------------------------------------------------------------- */
@@ -60,6 +71,86 @@ hid_t dset_open_no_cache(hid_t file_id, const char *dset_name)
     return dset_id;
 }
 
+/* ----------------------------------------------------------------------- */
+/* On-disk layout of new tensor files                                       */
+/* ----------------------------------------------------------------------- */
+
+static size_t env_bytes(const char *name, size_t dflt)
+{
+    const char *v = getenv(name);
+    return (v && *v) ? (size_t)strtoull(v, NULL, 10) : dflt;
+}
+
+/*
+ * Create filename for chunks of chunk_bytes.  Unless TENSOR_H5_ALIGN=0 the
+ * file uses the paged file-space strategy with TENSOR_H5_ALIGN-byte pages
+ * (default 16 KiB, 4 KiB for smaller chunks).  The page size is stored in
+ * the file, so every chunk at least one page long starts on a page
+ * boundary whichever handle later writes it, and small metadata is packed
+ * into pages of its own instead of interleaving with tile data.  The
+ * chunk B-tree gets a wide fan-out so lookups touch fewer metadata nodes.
+ *
+ * Paged files need an HDF5 1.10 or newer reader.  TENSOR_H5_PAGED=0 keeps
+ * them readable by 1.8: only the creating handle aligns its allocations,
+ * so chunks written later through other handles may not be aligned.
+ */
+static hid_t create_tensor_file(const char *filename, size_t chunk_bytes)
+{
+    size_t align = env_bytes("TENSOR_H5_ALIGN",
+                             chunk_bytes >= 16384 ? 16384 : 4096);
+    hid_t  fcpl  = H5P_DEFAULT, fapl = H5P_DEFAULT;
+    if (align > 0) {
+        fcpl = H5Pcreate(H5P_FILE_CREATE);
+        fapl = H5Pcreate(H5P_FILE_ACCESS);
+        int paged = env_bytes("TENSOR_H5_PAGED", 1) != 0;
+        if (fcpl < 0 || fapl < 0 ||
+            (paged &&
+             (H5Pset_file_space_strategy(fcpl, H5F_FSPACE_STRATEGY_PAGE,
+                                         0, 1) < 0 ||
+              H5Pset_file_space_page_size(fcpl, (hsize_t)align) < 0)) ||
+            H5Pset_istore_k(fcpl, 256) < 0 ||
+            H5Pset_alignment(fapl, (hsize_t)align, (hsize_t)align) < 0 ||
+            H5Pset_meta_block_size(fapl,
+                                   env_bytes("TENSOR_H5_META_BLOCK",
+                                             1UL << 20)) < 0) {
+            fprintf(stderr, "create_chunked_dataset: bad TENSOR_H5_ALIGN "
+                            "%zu\n", align);
+            if (fcpl >= 0) H5Pclose(fcpl);
+            if (fapl >= 0) H5Pclose(fapl);
+            return -1;
+        }
+    }
+    hid_t fid = H5Fcreate(filename, H5F_ACC_TRUNC, fcpl, fapl);
+    if (fcpl != H5P_DEFAULT) H5Pclose(fcpl);
+    if (fapl != H5P_DEFAULT) H5Pclose(fapl);
+    return fid;
+}
+
+/*
+ * Chunk allocation for a new dataset.  By default a chunk is allocated
+ * when first written, so absent tiles cost nothing.  TENSOR_H5_PREALLOC=1
+ * allocates every chunk at creation, in row-major tile order, without
+ * writing it (the space reads as zeros).  Tiles then lie on disk in the
+ * order the planner streams an operand stored in loop order, however it
+ * is filled.  Every tile is present, so leave it off for block-sparse
+ * tensors.
+ */
+static void set_chunk_alloc(hid_t dcpl_id)
+{
+    if (env_bytes("TENSOR_H5_PREALLOC", 0)) {
+        H5Pset_alloc_time(dcpl_id, H5D_ALLOC_TIME_EARLY);
+        H5Pset_fill_time(dcpl_id, H5D_FILL_TIME_NEVER);
+    } else {
+        H5Pset_alloc_time(dcpl_id, H5D_ALLOC_TIME_INCR);
+    }
+}
+
+static size_t chunk_bytes_of(int rank, const hsize_t *chunk_dims, size_t elem)
+{
+    for (int d = 0; d < rank; d++) elem *= (size_t)chunk_dims[d];
+    return elem;
+}
+
 /* ----------------------------------------------------------------------- */
 /* create_chunked_dataset                                                   */
 /* ----------------------------------------------------------------------- */
@@ -71,8 +162,9 @@ static herr_t create_chunked_impl(const char *filename,
                                    const hsize_t *global_dims,
                                    const hsize_t *chunk_dims)
 {
-    hid_t file_id = H5Fcreate(filename, H5F_ACC_TRUNC,
-                               H5P_DEFAULT, H5P_DEFAULT);
+    hid_t file_id = create_tensor_file(filename,
+                                       chunk_bytes_of(rank, chunk_dims,
+                                                      sizeof(double)));
     if (file_id < 0) {
         fprintf(stderr, "create_chunked_dataset: H5Fcreate failed for '%s'\n",
                 filename);
@@ -92,7 +184,7 @@ static herr_t create_chunked_impl(const char *filename,
 
     double fill_value = 0.0;
     H5Pset_fill_value(dcpl_id, H5T_NATIVE_DOUBLE, &fill_value);
-    H5Pset_alloc_time(dcpl_id, H5D_ALLOC_TIME_INCR);
+    set_chunk_alloc(dcpl_id);
 
     hid_t dapl_id = H5Pcreate(H5P_DATASET_ACCESS);
     if (dapl_id < 0) {
@@ -432,6 +524,72 @@ herr_t write_chunk_typed(hid_t dset_id, const hsize_t *phys_offset,
     return status;
 }
 
+/* ----------------------------------------------------------------------- */
+/* Direct chunk I/O                                                         */
+/* ----------------------------------------------------------------------- */
+
+int dset_supports_direct_io(hid_t dset_id, hid_t mem_type)
+{
+    int   ok   = 0;
+    hid_t dcpl = H5Dget_create_plist(dset_id);
+    hid_t ftyp = H5Dget_type(dset_id);
+
+    if (dcpl >= 0 && ftyp >= 0 &&
+        H5Pget_layout(dcpl) == H5D_CHUNKED &&
+        H5Pget_nfilters(dcpl) == 0 &&
+        H5Tequal(ftyp, mem_type) > 0)
+        ok = 1;
+
+    if (ftyp >= 0) H5Tclose(ftyp);
+    if (dcpl >= 0) H5Pclose(dcpl);
+    return ok;
+}
+
+herr_t write_chunk_direct(hid_t dset_id, const hsize_t *phys_offset,
+                          const void *data_ptr, size_t nbytes)
+{
+    return (H5Dwrite_chunk(dset_id, H5P_DEFAULT, 0, phys_offset,
+                           nbytes, data_ptr) < 0) ? -1 : 0;
+}
+
+/* ----------------------------------------------------------------------- */
+/* Page-cache hints                                                         */
+/* ----------------------------------------------------------------------- */
+
+int dset_posix_fd(hid_t dset_id)
+{
+    int   fd   = -1;
+    hid_t fid  = H5Iget_file_id(dset_id);
+    hid_t fapl = (fid >= 0) ? H5Fget_access_plist(fid) : -1;
+    void *h    = NULL;
+
+    if (fapl >= 0 && H5Pget_driver(fapl) == H5FD_SEC2 &&
+        H5Fget_vfd_handle(fid, fapl, &h) >= 0 && h)
+        fd = *(int *)h;
+
+    if (fapl >= 0) H5Pclose(fapl);
+    if (fid  >= 0) H5Fclose(fid);
+    return fd;
+}
+
+void file_advise(int fd, haddr_t addr, hsize_t len, int willneed)
+{
+    if (fd < 0 || addr == HADDR_UNDEF || len == 0) return;
+#if defined(POSIX_FADV_WILLNEED)
+    posix_fadvise(fd, (off_t)addr, (off_t)len,
+                  willneed ? POSIX_FADV_WILLNEED : POSIX_FADV_DONTNEED);
+#elif defined(F_RDADVISE)
+    if (willneed) {
+        struct radvisory ra;
+        ra.ra_offset = (off_t)addr;
+        ra.ra_count  = (int)len;
+        fcntl(fd, F_RDADVISE, &ra);
+    }
+#else
+    (void)willneed;
+#endif
+}
+
 /* ----------------------------------------------------------------------- */
 /* create_chunked_dataset_einsum                                            */
 /* ----------------------------------------------------------------------- */
@@ -443,8 +601,10 @@ herr_t create_chunked_dataset_einsum(const char *filename,
                                      const hsize_t *chunk_dims,
                                      tensor_dtype_t dtype)
 {
-    hid_t file_id = H5Fcreate(filename, H5F_ACC_TRUNC,
-                               H5P_DEFAULT, H5P_DEFAULT);
+    size_t elem    = (dtype == DTYPE_FP64) ? sizeof(double)
+                                           : 2 * sizeof(double);
+    hid_t  file_id = create_tensor_file(filename,
+                                        chunk_bytes_of(rank, chunk_dims, elem));
     if (file_id < 0) {
         fprintf(stderr,
                 "create_chunked_dataset_einsum: H5Fcreate failed for '%s'\n",
@@ -466,7 +626,7 @@ herr_t create_chunked_dataset_einsum(const char *filename,
         double fill = 0.0;
         H5Pset_fill_value(dcpl_id, H5T_NATIVE_DOUBLE, &fill);
     }
-    H5Pset_alloc_time(dcpl_id, H5D_ALLOC_TIME_INCR);
+    set_chunk_alloc(dcpl_id);
 
     hid_t dapl_id = H5Pcreate(H5P_DATASET_ACCESS);
     if (dapl_id < 0) {
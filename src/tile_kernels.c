@@ -0,0 +1,383 @@
+/*
+ * tile_kernels.c — BLAS dispatch and scalar fallbacks for tile GEMM.
+ *
+ * Packed-A fallback layout (no BLAS): A is split into ceil(M/TK_MR) row
+ * panels; panel p stores, for k = 0..K-1, the TK_MR values
+ * A[p·TK_MR + r, k] contiguously (zero-padded past M).  The micro-kernel
+ * broadcasts those TK_MR values against one row of B and updates TK_MR
+ * rows of C, so every B element loaded is used TK_MR times.  Columns are
+ * processed in TK_NC-wide strips to keep the C rows and B row in L1.
+ *
+ * Planar complex (3M): the planar kernels only call the real tile_gemm, so
+ * they are shared by every backend, BLAS or not.
+ */
+
+#include "tile_kernels.h"
+#include "memory.h"
+
+#include <complex.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TK_MR  4
+#define TK_NC  256
+
+#ifdef USE_ACCELERATE
+#  include <Accelerate/Accelerate.h>
+#elif defined(USE_MKL)
+#  include <mkl_cblas.h>
+#elif defined(HAVE_CBLAS)
+#  include <cblas.h>
+#endif
+
+/* ----------------------------------------------------------------------- */
+/* Scalar fallbacks (no BLAS)                                               */
+/*                                                                           */
+/* Compute C[0:M, 0:N] += A[0:M, 0:K] × B[0:K, 0:N].                       */
+/* Buffers are row-major with nominal strides lda / ldb / ldc.             */
+/* ----------------------------------------------------------------------- */
+#ifndef HAVE_CBLAS
+static void compute_tile(const double * restrict A, int lda,
+                         const double * restrict B, int ldb,
+                         double       * restrict C, int ldc,
+                         int M, int N, int K)
+{
+    for (int m = 0; m < M; m++) {
+        for (int k = 0; k < K; k++) {
+            double a_val = A[m * lda + k];
+            if (a_val == 0.0) continue;          /* skip sparse columns    */
+            for (int n = 0; n < N; n++)
+                C[m * ldc + n] += a_val * B[k * ldb + n];
+        }
+    }
+}
+
+static void compute_tile_z(const double _Complex * restrict A, int lda,
+                           const double _Complex * restrict B, int ldb,
+                           double _Complex       * restrict C, int ldc,
+                           int M, int N, int K)
+{
+    for (int m = 0; m < M; m++)
+        for (int k = 0; k < K; k++) {
+            double _Complex a = A[m * lda + k];
+            for (int n = 0; n < N; n++)
+                C[m * ldc + n] += a * B[k * ldb + n];
+        }
+}
+#endif /* !HAVE_CBLAS */
+
+/* ----------------------------------------------------------------------- */
+/* tile_gemm                                                                */
+/* ----------------------------------------------------------------------- */
+
+void tile_gemm(tensor_dtype_t dtype, int M, int N, int K,
+               const void *A, int lda,
+               const void *B, int ldb,
+               void *C, int ldc, int accumulate)
+{
+#ifdef HAVE_CBLAS
+    if (dtype == DTYPE_FP64) {
+        cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans,
+                    M, N, K, 1.0,
+                    (const double *)A, lda,
+                    (const double *)B, ldb,
+                    accumulate ? 1.0 : 0.0, (double *)C, ldc);
+    } else {
+        double _Complex alpha = CMPLX(1.0, 0.0);
+        double _Complex beta  = CMPLX(accumulate ? 1.0 : 0.0, 0.0);
+        cblas_zgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans,
+                    M, N, K, &alpha,
+                    (const double _Complex *)A, lda,
+                    (const double _Complex *)B, ldb,
+                    &beta, (double _Complex *)C, ldc);
+    }
+#else
+    size_t esz = (dtype == DTYPE_FP64) ? sizeof(double)
+                                       : sizeof(double _Complex);
+    if (!accumulate)
+        for (int m = 0; m < M; m++)
+            memset((char *)C + (size_t)m * (size_t)ldc * esz, 0,
+                   (size_t)N * esz);
+    if (dtype == DTYPE_FP64)
+        compute_tile((const double *)A, lda, (const double *)B, ldb,
+                     (double *)C, ldc, M, N, K);
+    else
+        compute_tile_z((const double _Complex *)A, lda,
+                       (const double _Complex *)B, ldb,
+                       (double _Complex *)C, ldc, M, N, K);
+#endif
+}
+
+/* ----------------------------------------------------------------------- */
+/* Packed A operand                                                         */
+/* ----------------------------------------------------------------------- */
+
+#if defined(USE_MKL)
+
+size_t tile_gemm_pack_size(tensor_dtype_t dtype, int M, int N, int K)
+{
+    if (dtype != DTYPE_FP64) return 0;   /* MKL packs real types only */
+    return cblas_dgemm_pack_get_size(CblasAMatrix, M, N, K);
+}
+
+const char *tile_gemm_pack_name(void) { return "MKL packed GEMM"; }
+
+int tile_gemm_packed_any_n(void) { return 0; }
+
+void tile_gemm_pack_a(tensor_dtype_t dtype, int M, int N, int K,
+                      const void *A, int lda, void *Ap)
+{
+    (void)dtype;
+    cblas_dgemm_pack(CblasRowMajor, CblasAMatrix, CblasNoTrans,
+                     M, N, K, 1.0, (const double *)A, lda, (double *)Ap);
+}
+
+void tile_gemm_packed(tensor_dtype_t dtype, int M, int N, int K,
+                      const void *Ap,
+                      const void *B, int ldb,
+                      void *C, int ldc, int accumulate)
+{
+    (void)dtype;
+    cblas_dgemm_compute(CblasRowMajor, CblasPacked, CblasNoTrans,
+                        M, N, K, (const double *)Ap, K,
+                        (const double *)B, ldb,
+                        accumulate ? 1.0 : 0.0, (double *)C, ldc);
+}
+
+#elif !defined(HAVE_CBLAS)
+
+size_t tile_gemm_pack_size(tensor_dtype_t dtype, int M, int N, int K)
+{
+    (void)N;
+    size_t esz = (dtype == DTYPE_FP64) ? sizeof(double)
+                                       : sizeof(double _Complex);
+    size_t panels = ((size_t)M + TK_MR - 1) / TK_MR;
+    return panels * TK_MR * (size_t)K * esz;
+}
+
+const char *tile_gemm_pack_name(void) { return "engine micro-kernel"; }
+
+/* Panels hold whole A rows; B's width only sets the column loop. */
+int tile_gemm_packed_any_n(void) { return 1; }
+
+void tile_gemm_pack_a(tensor_dtype_t dtype, int M, int N, int K,
+                      const void *A, int lda, void *Ap)
+{
+    size_t esz = (dtype == DTYPE_FP64) ? sizeof(double)
+                                       : sizeof(double _Complex);
+    memset(Ap, 0, tile_gemm_pack_size(dtype, M, N, K));
+    for (int m = 0; m < M; m++) {
+        const char *src = (const char *)A + (size_t)m * (size_t)lda * esz;
+        char       *dst = (char *)Ap
+                        + (size_t)(m / TK_MR) * TK_MR * (size_t)K * esz
+                        + (size_t)(m % TK_MR) * esz;
+        for (int k = 0; k < K; k++)
+            memcpy(dst + (size_t)k * TK_MR * esz, src + (size_t)k * esz, esz);
+    }
+}
+
+static void packed_kernel_d(int M, int N, int K, const double *Ap,
+                            const double *B, int ldb, double *C, int ldc)
+{
+    for (int r0 = 0; r0 < M; r0 += TK_MR) {
+        const double *panel = Ap + (size_t)r0 * (size_t)K;
+        int           mr    = (M - r0 < TK_MR) ? M - r0 : TK_MR;
+        double       *c0    = C + (size_t)r0 * (size_t)ldc;
+        for (int n0 = 0; n0 < N; n0 += TK_NC) {
+            int nc = (N - n0 < TK_NC) ? N - n0 : TK_NC;
+            for (int k = 0; k < K; k++) {
+                const double *a = panel + (size_t)k * TK_MR;
+                const double *b = B + (size_t)k * (size_t)ldb + n0;
+                if (mr == TK_MR) {
+                    double a0 = a[0], a1 = a[1], a2 = a[2], a3 = a[3];
+                    if (a0 == 0.0 && a1 == 0.0 && a2 == 0.0 && a3 == 0.0)
+                        continue;
+                    double *restrict x0 = c0 + n0;
+                    double *restrict x1 = x0 + ldc;
+                    double *restrict x2 = x1 + ldc;
+                    double *restrict x3 = x2 + ldc;
+                    for (int n = 0; n < nc; n++) {
+                        double bn = b[n];
+                        x0[n] += a0 * bn;
+                        x1[n] += a1 * bn;
+                        x2[n] += a2 * bn;
+                        x3[n] += a3 * bn;
+                    }
+                } else {
+                    for (int r = 0; r < mr; r++) {
+                        double ar = a[r];
+                        if (ar == 0.0) continue;
+                        double *x = c0 + (size_t)r * (size_t)ldc + n0;
+                        for (int n = 0; n < nc; n++) x[n] += ar * b[n];
+                    }
+                }
+            }
+        }
+    }
+}
+
+static void packed_kernel_z(int M, int N, int K, const double _Complex *Ap,
+                            const double _Complex *B, int ldb,
+                            double _Complex *C, int ldc)
+{
+    for (int r0 = 0; r0 < M; r0 += TK_MR) {
+        const double _Complex *panel = Ap + (size_t)r0 * (size_t)K;
+        int                    mr    = (M - r0 < TK_MR) ? M - r0 : TK_MR;
+        double _Complex       *c0    = C + (size_t)r0 * (size_t)ldc;
+        for (int n0 = 0; n0 < N; n0 += TK_NC) {
+            int nc = (N - n0 < TK_NC) ? N - n0 : TK_NC;
+            for (int k = 0; k < K; k++) {
+                const double _Complex *a = panel + (size_t)k * TK_MR;
+                const double _Complex *b = B + (size_t)k * (size_t)ldb + n0;
+                if (mr == TK_MR) {
+                    double _Complex a0 = a[0], a1 = a[1], a2 = a[2], a3 = a[3];
+                    double _Complex *restrict x0 = c0 + n0;
+                    double _Complex *restrict x1 = x0 + ldc;
+                    double _Complex *restrict x2 = x1 + ldc;
+                    double _Complex *restrict x3 = x2 + ldc;
+                    for (int n = 0; n < nc; n++) {
+                        double _Complex bn = b[n];
+                        x0[n] += a0 * bn;
+                        x1[n] += a1 * bn;
+                        x2[n] += a2 * bn;
+                        x3[n] += a3 * bn;
+                    }
+                } else {
+                    for (int r = 0; r < mr; r++) {
+                        double _Complex  ar = a[r];
+                        double _Complex *x  = c0 + (size_t)r * (size_t)ldc + n0;
+                        for (int n = 0; n < nc; n++) x[n] += ar * b[n];
+                    }
+                }
+            }
+        }
+    }
+}
+
+void tile_gemm_packed(tensor_dtype_t dtype, int M, int N, int K,
+                      const void *Ap,
+                      const void *B, int ldb,
+                      void *C, int ldc, int accumulate)
+{
+    size_t esz = (dtype == DTYPE_FP64) ? sizeof(double)
+                                       : sizeof(double _Complex);
+    if (!accumulate)
+        for (int m = 0; m < M; m++)
+            memset((char *)C + (size_t)m * (size_t)ldc * esz, 0,
+                   (size_t)N * esz);
+    if (dtype == DTYPE_FP64)
+        packed_kernel_d(M, N, K, (const double *)Ap,
+                        (const double *)B, ldb, (double *)C, ldc);
+    else
+        packed_kernel_z(M, N, K, (const double _Complex *)Ap,
+                        (const double _Complex *)B, ldb,
+                        (double _Complex *)C, ldc);
+}
+
+#else /* BLAS without a pack API */
+
+size_t tile_gemm_pack_size(tensor_dtype_t dtype, int M, int N, int K)
+{
+    (void)dtype; (void)M; (void)N; (void)K;
+    return 0;
+}
+
+const char *tile_gemm_pack_name(void) { return "unavailable"; }
+
+int tile_gemm_packed_any_n(void) { return 1; }
+
+/* Never selected (pack size 0); kept so callers link unconditionally.
+ * The "packed" form is a dense row-major copy with leading dimension K. */
+void tile_gemm_pack_a(tensor_dtype_t dtype, int M, int N, int K,
+                      const void *A, int lda, void *Ap)
+{
+    (void)N;
+    size_t esz = (dtype == DTYPE_FP64) ? sizeof(double)
+                                       : sizeof(double _Complex);
+    for (int m = 0; m < M; m++)
+        memcpy((char *)Ap + (size_t)m * (size_t)K * esz,
+               (const char *)A + (size_t)m * (size_t)lda * esz,
+               (size_t)K * esz);
+}
+
+void tile_gemm_packed(tensor_dtype_t dtype, int M, int N, int K,
+                      const void *Ap,
+                      const void *B, int ldb,
+                      void *C, int ldc, int accumulate)
+{
+    tile_gemm(dtype, M, N, K, Ap, K, B, ldb, C, ldc, accumulate);
+}
+
+#endif
+
+/* ----------------------------------------------------------------------- */
+/* Planar complex operands (3M)                                             */
+/* ----------------------------------------------------------------------- */
+
+size_t tile_zplanar_a_size(int M, int K)
+{
+    return 3 * (size_t)M * (size_t)K * sizeof(double);
+}
+
+void tile_zplanar_pack_a(int M, int K, const void *A, int lda, double *Ap)
+{
+    const size_t plane = (size_t)M * (size_t)K;
+    tile_zplanar_split(M, K, A, lda, Ap, Ap + plane, K);
+    for (size_t i = 0; i < plane; i++)
+        Ap[2 * plane + i] = Ap[i] + Ap[plane + i];
+}
+
+void tile_zplanar_split(int rows, int cols, const void *src, int lds,
+                        double *re, double *im, int ldp)
+{
+    for (int r = 0; r < rows; r++) {
+        const double *s  = (const double *)src + 2 * (size_t)r * (size_t)lds;
+        double       *xr = re + (size_t)r * (size_t)ldp;
+        double       *xi = im + (size_t)r * (size_t)ldp;
+        for (int c = 0; c < cols; c++) {
+            xr[c] = s[2 * c];
+            xi[c] = s[2 * c + 1];
+        }
+    }
+}
+
+/* Per-thread Br+Bi scratch of n doubles; pool threads free theirs on exit. */
+static double *zp_scratch(size_t n)
+{
+    return (double *)thread_scratch(SCRATCH_ZPLANAR, n * sizeof(double));
+}
+
+void tile_gemm_zplanar(int M, int N, int K, const double *Ap,
+                       const double *Br, const double *Bi, int ldb,
+                       double *Cr, double *Ci, int ldc)
+{
+    const size_t  plane = (size_t)M * (size_t)K;
+    const double *Ar = Ap, *Ai = Ap + plane, *As = Ap + 2 * plane;
+
+    tile_gemm(DTYPE_FP64, M, N, K, Ar, K, Br, ldb, Cr, ldc, 0);
+    tile_gemm(DTYPE_FP64, M, N, K, Ai, K, Bi, ldb, Ci, ldc, 0);
+    for (int m = 0; m < M; m++) {
+        double *restrict xr = Cr + (size_t)m * (size_t)ldc;
+        double *restrict xi = Ci + (size_t)m * (size_t)ldc;
+        for (int n = 0; n < N; n++) {
+            double t1 = xr[n], t2 = xi[n];
+            xr[n] = t1 - t2;
+            xi[n] = -(t1 + t2);
+        }
+    }
+
+    /* Ci += As·Bs.  Without scratch memory, As·Br + As·Bi instead. */
+    double *Bs = zp_scratch((size_t)K * (size_t)N);
+    if (!Bs) {
+        tile_gemm(DTYPE_FP64, M, N, K, As, K, Br, ldb, Ci, ldc, 1);
+        tile_gemm(DTYPE_FP64, M, N, K, As, K, Bi, ldb, Ci, ldc, 1);
+        return;
+    }
+    for (int k = 0; k < K; k++) {
+        const double *restrict br = Br + (size_t)k * (size_t)ldb;
+        const double *restrict bi = Bi + (size_t)k * (size_t)ldb;
+        double       *restrict bs = Bs + (size_t)k * (size_t)N;
+        for (int n = 0; n < N; n++) bs[n] = br[n] + bi[n];
+    }
+    tile_gemm(DTYPE_FP64, M, N, K, As, K, Bs, N, Ci, ldc, 1);
+}
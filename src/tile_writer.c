@@ -0,0 +1,343 @@
+/*
+ * tile_writer.c — parallel tile producers feeding one HDF5 writer thread.
+ */
+
+#include "tile_writer.h"
+#include "engine.h"
+#include "memory.h"
+#include "odometer.h"
+#include "rng.h"
+#include "tensor_store.h"
+#include "write_queue.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* NVMe page alignment for pool pages — matches engine.c. */
+#define TW_PAGE_ALIGN  16384UL
+
+/* Writer ring capacity (tiles in flight to HDF5). */
+#define TW_WQ_CAP      8
+
+/* Page content state for TW_FILL_CONST: pages are recycled through the pool,
+ * so a page that already holds the broadcast scalar is not rewritten. */
+#define TW_PAGE_DIRTY  0
+#define TW_PAGE_CONST  1
+
+/* ----------------------------------------------------------------------- */
+/* Tile content helpers                                                     */
+/* ----------------------------------------------------------------------- */
+
+static size_t tw_elem_size(const TensorRegistry *reg)
+{
+    return (reg->dtype == DTYPE_COMPLEX128) ? sizeof(double _Complex)
+                                            : sizeof(double);
+}
+
+static size_t tw_tile_elems(const TensorRegistry *reg)
+{
+    size_t n = 1;
+    for (int d = 0; d < reg->rank; d++) n *= (size_t)reg->chunk_dims[d];
+    return n;
+}
+
+void tile_zero_padding(void *buf, const TensorRegistry *reg,
+                       size_t tile_index)
+{
+    int     rank = reg->rank;
+    size_t  esz  = tw_elem_size(reg);
+    size_t  actual[MAX_RANK], nominal[MAX_RANK];
+    int     partial = 0;
+    const hsize_t *off = reg->tiles[tile_index].phys_offset;
+
+    for (int d = 0; d < rank; d++) {
+        nominal[d] = (size_t)reg->chunk_dims[d];
+        hsize_t rem = reg->global_dims[d] - off[d];
+        actual[d] = (rem < reg->chunk_dims[d]) ? (size_t)rem : nominal[d];
+        if (actual[d] < nominal[d]) partial = 1;
+    }
+    if (!partial) return;
+
+    /* Walk rows of the last dimension: rows outside the extent are cleared
+     * whole, rows inside only past actual[rank-1]. */
+    size_t row_len = nominal[rank - 1];
+    size_t row[MAX_RANK] = {0};
+    size_t n_outer = (size_t)rank - 1;
+    char  *p = (char *)buf;
+    do {
+        int outside = 0;
+        for (size_t d = 0; d < n_outer; d++)
+            if (row[d] >= actual[d]) { outside = 1; break; }
+        if (outside)
+            memset(p, 0, row_len * esz);
+        else if (actual[rank - 1] < row_len)
+            memset(p + actual[rank - 1] * esz, 0,
+                   (row_len - actual[rank - 1]) * esz);
+        p += row_len * esz;
+    } while (n_outer > 0 && odometer_step(n_outer, row, nominal));
+}
+
+void tile_fill_random(void *buf, const TensorRegistry *reg,
+                      size_t tile_index, uint64_t seed)
+{
+    size_t   n     = tw_tile_elems(reg);
+    uint64_t state = rng_derive(seed, (uint64_t)tile_index);
+
+    if (reg->dtype == DTYPE_COMPLEX128) {
+        double *p = (double *)buf;           /* interleaved re, im */
+        for (size_t i = 0; i < 2 * n; i++) p[i] = rng_uniform(&state);
+    } else {
+        double *p = (double *)buf;
+        for (size_t i = 0; i < n; i++) p[i] = rng_uniform(&state);
+    }
+    tile_zero_padding(buf, reg, tile_index);
+}
+
+/* 1 if tile_index touches the tensor boundary (has padding). */
+static int tw_is_boundary(const TensorRegistry *reg, size_t tile_index)
+{
+    const hsize_t *off = reg->tiles[tile_index].phys_offset;
+    for (int d = 0; d < reg->rank; d++)
+        if (off[d] + reg->chunk_dims[d] > reg->global_dims[d]) return 1;
+    return 0;
+}
+
+/* ----------------------------------------------------------------------- */
+/* Shared state                                                             */
+/* ----------------------------------------------------------------------- */
+
+typedef struct {
+    const TensorRegistry     *reg;
+    const tile_writer_opts_t *opts;
+    size_t                    esz;
+    size_t                    tile_elems;
+
+    BufferPool               *pool;
+    unsigned char            *page_state;   /* TW_PAGE_*, per pool page   */
+    pthread_mutex_t           pool_mu;
+    pthread_cond_t            pool_cond;
+
+    pthread_mutex_t           next_mu;
+    size_t                    next_tile;    /* next unclaimed tile index   */
+
+    WriteQueue               *wq;
+    volatile int              err;
+
+    /* Progress reporting (writer thread only) */
+    size_t                    total_sel;    /* tiles expected, 0 = unknown */
+    size_t                    report_every;
+    struct timespec           t0;
+} tw_shared_t;
+
+static double tw_elapsed(const struct timespec *t0)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)(t.tv_sec - t0->tv_sec)
+         + (double)(t.tv_nsec - t0->tv_nsec) * 1e-9;
+}
+
+static void tw_on_write(void *user, size_t n_written)
+{
+    tw_shared_t *sh = (tw_shared_t *)user;
+    if (n_written % sh->report_every != 0 && n_written != sh->total_sel)
+        return;
+    double el  = tw_elapsed(&sh->t0);
+    double mib = (double)(n_written * sh->tile_elems * sh->esz)
+                 / (1024.0 * 1024.0);
+    printf("\r  %5.1f%%  %zu/%zu tiles  %9.1f MiB  %6.1f s  %8.1f MiB/s",
+           sh->total_sel ? 100.0 * (double)n_written / (double)sh->total_sel
+                         : 0.0,
+           n_written, sh->total_sel, mib, el, el > 0.0 ? mib / el : 0.0);
+    fflush(stdout);
+}
+
+/* ----------------------------------------------------------------------- */
+/* Producer threads                                                         */
+/* ----------------------------------------------------------------------- */
+
+static void *tw_producer_main(void *arg)
+{
+    tw_shared_t              *sh   = (tw_shared_t *)arg;
+    const TensorRegistry     *reg  = sh->reg;
+    const tile_writer_opts_t *opts = sh->opts;
+
+    for (;;) {
+        pthread_mutex_lock(&sh->next_mu);
+        size_t t = sh->next_tile++;
+        pthread_mutex_unlock(&sh->next_mu);
+        if (t >= reg->total_tiles || sh->err || sh->wq->err) break;
+
+        if (opts->select && !opts->select(reg, t, opts->select_user))
+            continue;
+
+        size_t id;
+        pthread_mutex_lock(&sh->pool_mu);
+        while (pool_free_count(sh->pool) == 0)
+            pthread_cond_wait(&sh->pool_cond, &sh->pool_mu);
+        void *buf = pool_acquire(sh->pool, &id);
+        pthread_mutex_unlock(&sh->pool_mu);
+
+        int rc = 0;
+        switch (opts->fill) {
+        case TW_FILL_CONST: {
+            int boundary = tw_is_boundary(reg, t);
+            if (sh->page_state[id] != TW_PAGE_CONST || boundary) {
+                for (size_t i = 0; i < sh->tile_elems; i++)
+                    memcpy((char *)buf + i * sh->esz, opts->value, sh->esz);
+                sh->page_state[id] = TW_PAGE_CONST;
+            }
+            if (boundary) {
+                tile_zero_padding(buf, reg, t);
+                sh->page_state[id] = TW_PAGE_DIRTY;
+            }
+            break;
+        }
+        case TW_FILL_RANDOM:
+            tile_fill_random(buf, reg, t, opts->seed);
+            sh->page_state[id] = TW_PAGE_DIRTY;
+            break;
+        case TW_FILL_CALLBACK:
+            rc = opts->tile_fn(buf, reg, t, opts->tile_user);
+            sh->page_state[id] = TW_PAGE_DIRTY;
+            break;
+        }
+
+        if (rc != 0) {
+            fprintf(stderr, "tile_writer_run: tile callback failed "
+                    "(tile %zu)\n", t);
+            sh->err = 1;
+            pthread_mutex_lock(&sh->pool_mu);
+            pool_release(sh->pool, id);
+            pthread_cond_broadcast(&sh->pool_cond);
+            pthread_mutex_unlock(&sh->pool_mu);
+            break;
+        }
+
+        write_task_t wt;
+        memset(&wt, 0, sizeof(wt));
+        wt.buf_C       = buf;
+        wt.id_C        = id;
+        memcpy(wt.phys_off, reg->tiles[t].phys_offset, sizeof(wt.phys_off));
+        wt.owning_pool = sh->pool;
+        wt.pool_mu     = &sh->pool_mu;
+        wt.pool_cond   = &sh->pool_cond;
+        wq_push(sh->wq, &wt);
+    }
+    return NULL;
+}
+
+/* ----------------------------------------------------------------------- */
+/* tile_writer_run                                                          */
+/* ----------------------------------------------------------------------- */
+
+int tile_writer_run(hid_t dset, const TensorRegistry *reg, hid_t mem_type,
+                    const tile_writer_opts_t *opts,
+                    tile_writer_stats_t *stats)
+{
+    if (!reg || !opts || reg->total_tiles == 0) return -1;
+    if (opts->fill == TW_FILL_CONST && !opts->value) return -1;
+    if (opts->fill == TW_FILL_CALLBACK && !opts->tile_fn) return -1;
+
+    tw_shared_t sh;
+    memset(&sh, 0, sizeof(sh));
+    sh.reg        = reg;
+    sh.opts       = opts;
+    sh.esz        = tw_elem_size(reg);
+    sh.tile_elems = tw_tile_elems(reg);
+
+    size_t bpp = (sh.tile_elems * sh.esz + TW_PAGE_ALIGN - 1)
+                 & ~(TW_PAGE_ALIGN - 1);
+
+    /* Two pages per producer (one being filled, one queued) plus the
+     * writer ring, capped by the pool budget (TENSOR_POOL_MB or 25 % of
+     * RAM — generation never needs more than a few tiles in flight). */
+    int    n_prod = (opts->n_producers > 0) ? opts->n_producers
+                                            : query_num_threads();
+    size_t budget = query_physical_ram() / 4;
+    const char *env_mb = getenv("TENSOR_POOL_MB");
+    if (env_mb) {
+        size_t cap = (size_t)strtoul(env_mb, NULL, 10) * 1024UL * 1024UL;
+        if (cap > 0 && cap < budget) budget = cap;
+    }
+    size_t num_pages = 2 * (size_t)n_prod + TW_WQ_CAP;
+    if (num_pages * bpp > budget) num_pages = budget / bpp;
+    if (num_pages < 2) num_pages = 2;
+    if ((size_t)n_prod > num_pages - 1) n_prod = (int)(num_pages - 1);
+
+    sh.pool       = pool_create(num_pages, bpp);
+    sh.page_state = (unsigned char *)calloc(num_pages, 1);
+    sh.wq         = wq_create(TW_WQ_CAP);
+    if (!sh.pool || !sh.page_state || !sh.wq) {
+        if (sh.wq)   wq_destroy(sh.wq);
+        if (sh.pool) pool_destroy(sh.pool);
+        free(sh.page_state);
+        return -4;
+    }
+    pthread_mutex_init(&sh.pool_mu, NULL);
+    pthread_cond_init(&sh.pool_cond, NULL);
+    pthread_mutex_init(&sh.next_mu, NULL);
+
+    if (opts->progress) {
+        if (opts->select) {
+            for (size_t t = 0; t < reg->total_tiles; t++)
+                sh.total_sel += (size_t)opts->select(reg, t,
+                                                     opts->select_user);
+        } else {
+            sh.total_sel = reg->total_tiles;
+        }
+        sh.report_every = sh.total_sel / 200 + 1;
+    }
+
+    wq_writer_t writer;
+    memset(&writer, 0, sizeof(writer));
+    writer.wq           = sh.wq;
+    writer.dset         = dset;
+    writer.rank         = reg->rank;
+    writer.element_size = sh.esz;
+    writer.mem_type     = mem_type;
+    writer.direct       = opts->direct && dset_supports_direct_io(dset,
+                                                                  mem_type);
+    memcpy(writer.chunk_dims, reg->chunk_dims, sizeof(writer.chunk_dims));
+    if (opts->progress) {
+        writer.on_write      = tw_on_write;
+        writer.on_write_user = &sh;
+    }
+
+    int        rc = 0;
+    pthread_t  th_writer;
+    pthread_t *th = (pthread_t *)calloc((size_t)n_prod, sizeof(pthread_t));
+    if (!th) { rc = -4; goto done; }
+
+    clock_gettime(CLOCK_MONOTONIC, &sh.t0);
+    pthread_create(&th_writer, NULL, wq_writer_main, &writer);
+    for (int i = 0; i < n_prod; i++)
+        pthread_create(&th[i], NULL, tw_producer_main, &sh);
+    for (int i = 0; i < n_prod; i++)
+        pthread_join(th[i], NULL);
+    wq_push_sentinel(sh.wq);
+    pthread_join(th_writer, NULL);
+    free(th);
+
+    if (opts->progress && writer.n_written > 0) printf("\n");
+    if (sh.err || sh.wq->err) rc = -1;
+
+    if (stats) {
+        stats->tiles   = writer.n_written;
+        stats->bytes   = writer.n_written * sh.tile_elems * sh.esz;
+        stats->seconds = tw_elapsed(&sh.t0);
+        stats->direct  = writer.direct;
+    }
+
+done:
+    pthread_mutex_destroy(&sh.next_mu);
+    pthread_cond_destroy(&sh.pool_cond);
+    pthread_mutex_destroy(&sh.pool_mu);
+    wq_destroy(sh.wq);
+    pool_destroy(sh.pool);
+    free(sh.page_state);
+    return rc;
+}
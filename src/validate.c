@@ -0,0 +1,514 @@
+/*
+ * validate.c — sampled-tile recomputation of C = einsum(A, B).
+ *
+ * For one C tile the free indices are fixed to the tile's ranges, so
+ *
+ *   C_tile[free_A, free_B] = Σ_blocks  A[free_A, blk] · B[blk, free_B]
+ *
+ * where blk walks the contracted index space in A-chunk-sized blocks.
+ * Each block is read as a dense hyperslab, permuted into the matricized
+ * layouts described by the einsum plan and accumulated with tile_gemm into
+ * an M × N buffer in BLAS layout [free_A | free_B].  The stored C tile is
+ * permuted into the same layout before comparison.
+ */
+
+#include "validate.h"
+#include "verify.h"      /* verify_set_extent */
+#include "einsum.h"
+#include "engine.h"
+#include "odometer.h"
+#include "registry.h"
+#include "rng.h"
+#include "tensor_store.h"
+#include "tile_kernels.h"
+
+#include <complex.h>
+#include <hdf5.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* ----------------------------------------------------------------------- */
+/* Operands                                                                 */
+/* ----------------------------------------------------------------------- */
+
+typedef struct {
+    hid_t          fid, dset;
+    int            rank;
+    hsize_t        dims[MAX_RANK];
+    hsize_t        chunk[MAX_RANK];  /* full extent for contiguous layout */
+    char           letters[MAX_RANK];
+    tensor_dtype_t dtype;
+} vd_tensor_t;
+
+static void vd_close(vd_tensor_t *t)
+{
+    if (t->dset >= 0) H5Dclose(t->dset);
+    if (t->fid  >= 0) H5Fclose(t->fid);
+}
+
+static int vd_open(vd_tensor_t *t, const char *file, const char *dset_name,
+                   const char *letters, int rank)
+{
+    memset(t, 0, sizeof(*t));
+    t->fid  = -1;
+    t->dset = -1;
+    memcpy(t->letters, letters, (size_t)rank);
+
+    t->fid = H5Fopen(file, H5F_ACC_RDONLY, H5P_DEFAULT);
+    if (t->fid < 0) {
+        fprintf(stderr, "validate_contraction: cannot open '%s'\n", file);
+        return -1;
+    }
+    t->dset = H5Dopen2(t->fid, dset_name, H5P_DEFAULT);
+    if (t->dset < 0) {
+        fprintf(stderr, "validate_contraction: no \"%s\" in '%s'\n",
+                dset_name, file);
+        return -1;
+    }
+
+    hid_t space = H5Dget_space(t->dset);
+    t->rank = H5Sget_simple_extent_ndims(space);
+    if (t->rank == rank)
+        H5Sget_simple_extent_dims(space, t->dims, NULL);
+    H5Sclose(space);
+    if (t->rank != rank) {
+        fprintf(stderr, "validate_contraction: '%s' has rank %d, expression "
+                "expects %d\n", file, t->rank, rank);
+        return -2;
+    }
+
+    hid_t dcpl = H5Dget_create_plist(t->dset);
+    if (H5Pget_layout(dcpl) != H5D_CHUNKED ||
+        H5Pget_chunk(dcpl, rank, t->chunk) != rank)
+        memcpy(t->chunk, t->dims, (size_t)rank * sizeof(hsize_t));
+    H5Pclose(dcpl);
+
+    hid_t ftype = H5Dget_type(t->dset);
+    t->dtype = (H5Tget_class(ftype) == H5T_COMPOUND) ? DTYPE_COMPLEX128
+                                                     : DTYPE_FP64;
+    H5Tclose(ftype);
+    return 0;
+}
+
+/* ----------------------------------------------------------------------- */
+/* Shared state                                                             */
+/* ----------------------------------------------------------------------- */
+
+typedef struct {
+    double          max_abs, max_rel;
+    size_t          shape[MAX_RANK];
+    size_t          worst[MAX_RANK];   /* global C coordinates */
+    double _Complex worst_c, worst_ref;
+} vd_result_t;
+
+typedef struct {
+    const contraction_plan_t *plan;
+    const vd_tensor_t        *A, *B, *C;
+    hid_t                     mem_type;
+    size_t                    esz;
+    int                       cplx;
+
+    hsize_t  ext_of[26];               /* global extent per letter        */
+    hsize_t  blk_of[26];               /* contracted block size per letter */
+    size_t   grid_C[MAX_RANK];
+    size_t   M_max, N_max, K_max;
+
+    const size_t   *sel;               /* selected C tiles (linear index) */
+    size_t          n_sel;
+    vd_result_t    *res;
+
+    pthread_mutex_t mu;
+    size_t          next;
+    volatile int    err;
+} vd_ctx_t;
+
+typedef struct {
+    void *raw_A, *perm_A, *raw_B, *perm_B;
+    void *ref, *raw_C, *blas_C;
+} vd_bufs_t;
+
+/* Read the dense box [lo, lo+len) of T (letters → ranges) into buf. */
+static int vd_read_box(const vd_ctx_t *x, const vd_tensor_t *T,
+                       const hsize_t *lo_of, const hsize_t *len_of,
+                       void *buf, size_t *count_out)
+{
+    hsize_t start[MAX_RANK], count[MAX_RANK];
+    for (int d = 0; d < T->rank; d++) {
+        start[d]     = lo_of[T->letters[d] - 'a'];
+        count[d]     = len_of[T->letters[d] - 'a'];
+        count_out[d] = (size_t)count[d];
+    }
+    hsize_t one = 1;
+    int     r   = T->rank;
+
+    tensor_store_lock();
+    hid_t fspace = H5Dget_space(T->dset);
+    hid_t mspace = (r > 0) ? H5Screate_simple(r, count, NULL)
+                           : H5Screate_simple(1, &one, NULL);
+    herr_t rc = 0;
+    if (r > 0)
+        rc = H5Sselect_hyperslab(fspace, H5S_SELECT_SET, start, NULL,
+                                 count, NULL);
+    if (rc >= 0)
+        rc = H5Dread(T->dset, x->mem_type, mspace, fspace, H5P_DEFAULT, buf);
+    H5Sclose(mspace);
+    H5Sclose(fspace);
+    tensor_store_unlock();
+    return rc < 0 ? -1 : 0;
+}
+
+/* Recompute and compare one C tile. */
+static int vd_tile(const vd_ctx_t *x, size_t lin, vd_bufs_t *b,
+                   vd_result_t *out)
+{
+    const contraction_plan_t *p = x->plan;
+    const vd_tensor_t        *C = x->C;
+    int                       rC = C->rank;
+
+    hsize_t lo_of[26] = {0}, len_of[26] = {0};
+    size_t  tc[MAX_RANK];
+    for (int d = rC - 1; d >= 0; d--) {
+        tc[d] = lin % x->grid_C[d];
+        lin  /= x->grid_C[d];
+    }
+    for (int d = 0; d < rC; d++) {
+        hsize_t off = (hsize_t)tc[d] * C->chunk[d];
+        hsize_t rem = C->dims[d] - off;
+        int     c   = C->letters[d] - 'a';
+        lo_of[c]      = off;
+        len_of[c]     = rem < C->chunk[d] ? rem : C->chunk[d];
+        out->shape[d] = (size_t)len_of[c];
+    }
+
+    size_t M = 1, N = 1;
+    for (int i = 0; i < p->n_free_A; i++)
+        M *= (size_t)len_of[p->free_A_chars[i] - 'a'];
+    for (int i = 0; i < p->n_free_B; i++)
+        N *= (size_t)len_of[p->free_B_chars[i] - 'a'];
+    memset(b->ref, 0, M * N * x->esz);
+
+    /* Walk the contracted index space block by block. */
+    int    nc = p->n_contracted;
+    size_t nblk[MAX_RANK], bi[MAX_RANK] = {0};
+    for (int i = 0; i < nc; i++) {
+        int c = p->contracted_chars[i] - 'a';
+        nblk[i] = (size_t)((x->ext_of[c] + x->blk_of[c] - 1) / x->blk_of[c]);
+    }
+    size_t cnt_A[MAX_RANK], cnt_B[MAX_RANK];
+    do {
+        size_t K = 1;
+        for (int i = 0; i < nc; i++) {
+            int     c   = p->contracted_chars[i] - 'a';
+            hsize_t off = (hsize_t)bi[i] * x->blk_of[c];
+            hsize_t rem = x->ext_of[c] - off;
+            lo_of[c]  = off;
+            len_of[c] = rem < x->blk_of[c] ? rem : x->blk_of[c];
+            K        *= (size_t)len_of[c];
+        }
+        if (vd_read_box(x, x->A, lo_of, len_of, b->raw_A, cnt_A) < 0 ||
+            vd_read_box(x, x->B, lo_of, len_of, b->raw_B, cnt_B) < 0)
+            return -1;
+        tensor_permute(b->raw_A, b->perm_A, (size_t)p->rank_A, cnt_A, cnt_A,
+                       p->perm_A, x->esz);
+        tensor_permute(b->raw_B, b->perm_B, (size_t)p->rank_B, cnt_B, cnt_B,
+                       p->perm_B, x->esz);
+        tile_gemm(x->C->dtype, (int)M, (int)N, (int)K,
+                  b->perm_A, (int)K, b->perm_B, (int)N, b->ref, (int)N, 1);
+    } while (nc > 0 && odometer_step((size_t)nc, bi, nblk));
+
+    /* Stored tile → BLAS layout: blas dim perm_C[d] ← C dim d. */
+    size_t cnt_C[MAX_RANK];
+    int    inv[MAX_RANK];
+    if (vd_read_box(x, C, lo_of, len_of, b->raw_C, cnt_C) < 0) return -1;
+    for (int d = 0; d < rC; d++) inv[p->perm_C[d]] = d;
+    tensor_permute(b->raw_C, b->blas_C, (size_t)rC, cnt_C, cnt_C, inv,
+                   x->esz);
+
+    double max_abs = 0.0, max_ref = 0.0;
+    size_t worst   = 0;
+    for (size_t f = 0; f < M * N; f++) {
+        double _Complex v, r;
+        if (x->cplx) {
+            v = ((const double _Complex *)b->blas_C)[f];
+            r = ((const double _Complex *)b->ref)[f];
+        } else {
+            v = ((const double *)b->blas_C)[f];
+            r = ((const double *)b->ref)[f];
+        }
+        double e = cabs(v - r), a = cabs(r);
+        if (a > max_ref) max_ref = a;
+        if (e > max_abs || f == 0) { max_abs = e; worst = f; }
+        if (isnan(e)) { max_abs = INFINITY; worst = f; break; }
+    }
+    out->max_abs = max_abs;
+    out->max_rel = (max_ref > 0.0) ? max_abs / max_ref : max_abs;
+
+    /* Worst element back to global C coordinates. */
+    size_t bc[MAX_RANK], rem = worst;
+    for (int j = rC - 1; j >= 0; j--) {
+        bc[j] = rem % cnt_C[inv[j]];
+        rem  /= cnt_C[inv[j]];
+    }
+    for (int d = 0; d < rC; d++)
+        out->worst[d] = (size_t)lo_of[C->letters[d] - 'a'] + bc[p->perm_C[d]];
+    if (x->cplx) {
+        out->worst_c   = ((const double _Complex *)b->blas_C)[worst];
+        out->worst_ref = ((const double _Complex *)b->ref)[worst];
+    } else {
+        out->worst_c   = ((const double *)b->blas_C)[worst];
+        out->worst_ref = ((const double *)b->ref)[worst];
+    }
+    return 0;
+}
+
+static void *vd_worker_main(void *arg)
+{
+    vd_ctx_t *x = (vd_ctx_t *)arg;
+    size_t    MK = x->M_max * x->K_max, KN = x->K_max * x->N_max;
+    size_t    MN = x->M_max * x->N_max;
+    vd_bufs_t b;
+    b.raw_A  = malloc(MK * x->esz);
+    b.perm_A = malloc(MK * x->esz);
+    b.raw_B  = malloc(KN * x->esz);
+    b.perm_B = malloc(KN * x->esz);
+    b.ref    = malloc(MN * x->esz);
+    b.raw_C  = malloc(MN * x->esz);
+    b.blas_C = malloc(MN * x->esz);
+
+    if (!b.raw_A || !b.perm_A || !b.raw_B || !b.perm_B ||
+        !b.ref || !b.raw_C || !b.blas_C) {
+        x->err = -4;
+    } else {
+        for (;;) {
+            pthread_mutex_lock(&x->mu);
+            size_t i = x->next++;
+            pthread_mutex_unlock(&x->mu);
+            if (i >= x->n_sel || x->err) break;
+            if (vd_tile(x, x->sel[i], &b, &x->res[i]) < 0) {
+                x->err = -1;
+                break;
+            }
+        }
+    }
+    free(b.raw_A); free(b.perm_A); free(b.raw_B); free(b.perm_B);
+    free(b.ref);   free(b.raw_C);  free(b.blas_C);
+    return NULL;
+}
+
+/* ----------------------------------------------------------------------- */
+/* Tile selection                                                           */
+/* ----------------------------------------------------------------------- */
+
+static size_t vd_linear(int rank, const size_t *grid, const size_t *tc)
+{
+    size_t lin = 0;
+    for (int d = 0; d < rank; d++) lin = lin * grid[d] + tc[d];
+    return lin;
+}
+
+static int vd_contains(const size_t *sel, size_t n, size_t v)
+{
+    for (size_t i = 0; i < n; i++)
+        if (sel[i] == v) return 1;
+    return 0;
+}
+
+/*
+ * Corner, last and centre tile, then random distinct tiles until n are
+ * selected; every tile when n >= total.  Returns the count written to sel.
+ */
+static size_t vd_select(int rank, const size_t *grid, size_t total,
+                        size_t n, uint64_t seed, size_t *sel)
+{
+    if (n >= total) {
+        for (size_t i = 0; i < total; i++) sel[i] = i;
+        return total;
+    }
+    size_t tc[MAX_RANK], k = 0;
+    for (int d = 0; d < rank; d++) tc[d] = 0;
+    sel[k++] = 0;
+    for (int pass = 0; pass < 2 && k < n; pass++) {
+        for (int d = 0; d < rank; d++)
+            tc[d] = pass == 0 ? grid[d] - 1 : grid[d] / 2;
+        size_t v = vd_linear(rank, grid, tc);
+        if (!vd_contains(sel, k, v)) sel[k++] = v;
+    }
+    uint64_t st = rng_derive(seed, 0);
+    while (k < n) {
+        for (int d = 0; d < rank; d++) tc[d] = (size_t)(rng_next(&st) % grid[d]);
+        size_t v = vd_linear(rank, grid, tc);
+        if (!vd_contains(sel, k, v)) sel[k++] = v;
+    }
+    return k;
+}
+
+/* ----------------------------------------------------------------------- */
+/* validate_contraction                                                     */
+/* ----------------------------------------------------------------------- */
+
+static void vd_print_tile(const vd_ctx_t *x, size_t i, double rtol,
+                          int verbose)
+{
+    const vd_result_t *r  = &x->res[i];
+    int                rC = x->C->rank;
+    size_t             tc[MAX_RANK], lin = x->sel[i];
+    for (int d = rC - 1; d >= 0; d--) {
+        tc[d] = lin % x->grid_C[d];
+        lin  /= x->grid_C[d];
+    }
+    int fail = !(r->max_rel <= rtol);
+
+    printf("  tile (");
+    for (int d = 0; d < rC; d++) printf(d ? ",%zu" : "%zu", tc[d]);
+    printf(")  shape ");
+    for (int d = 0; d < rC; d++) printf(d ? "x%zu" : "%zu", r->shape[d]);
+    printf("  max_rel=%.2e  max_abs=%.2e  [%s]\n",
+           r->max_rel, r->max_abs, fail ? "FAIL" : "PASS");
+
+    if (verbose > 1 && fail) {
+        printf("    worst element (");
+        for (int d = 0; d < rC; d++) printf(d ? ",%zu" : "%zu", r->worst[d]);
+        printf("):  actual=%.6g%+.6gi  ref=%.6g%+.6gi\n",
+               creal(r->worst_c), cimag(r->worst_c),
+               creal(r->worst_ref), cimag(r->worst_ref));
+    }
+}
+
+int validate_contraction(const char *expr,
+                         const char *file_A, const char *file_B,
+                         const char *file_C,
+                         const validate_opts_t *opts,
+                         validate_report_t *report)
+{
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    long        n_req   = (opts && opts->n_tiles != 0) ? opts->n_tiles : 5;
+    double      rtol    = (opts && opts->rtol > 0.0) ? opts->rtol : 1e-9;
+    uint64_t    seed    = (opts && opts->seed) ? opts->seed : 42;
+    int         verbose = opts ? opts->verbose : 0;
+    const char *dA = (opts && opts->dset_A) ? opts->dset_A : "tensor";
+    const char *dB = (opts && opts->dset_B) ? opts->dset_B : "tensor";
+    const char *dC = (opts && opts->dset_C) ? opts->dset_C : "tensor";
+
+    contraction_plan_t plan;
+    if (!expr || einsum_parse(expr, &plan) < 0) return -3;
+
+    char sA[MAX_RANK], sB[MAX_RANK], sC[MAX_RANK];
+    const char *comma = strchr(expr, ',');
+    const char *arrow = strstr(expr, "->");
+    memcpy(sA, expr, (size_t)plan.rank_A);
+    memcpy(sB, comma + 1, (size_t)plan.rank_B);
+    memcpy(sC, arrow + 2, (size_t)plan.rank_C);
+
+    vd_tensor_t A, B, C;
+    int ret = vd_open(&A, file_A, dA, sA, plan.rank_A);
+    int rB  = vd_open(&B, file_B, dB, sB, plan.rank_B);
+    int rC  = vd_open(&C, file_C, dC, sC, plan.rank_C);
+    if (ret == 0) ret = rB;
+    if (ret == 0) ret = rC;
+
+    vd_ctx_t x;
+    memset(&x, 0, sizeof(x));
+    x.mem_type = -1;
+    pthread_mutex_init(&x.mu, NULL);
+    size_t            *sel = NULL;
+    pthread_t         *thr = NULL;
+    validate_report_t  rep;
+    memset(&rep, 0, sizeof(rep));
+    if (ret < 0) goto done;
+
+    if (A.dtype != C.dtype || B.dtype != C.dtype) {
+        fprintf(stderr, "validate_contraction: operands differ in dtype\n");
+        ret = -2;
+        goto done;
+    }
+    const char *me = "validate_contraction";
+    for (int d = 0; d < plan.rank_A && ret == 0; d++)
+        ret = verify_set_extent(x.ext_of, sA[d], A.dims[d], me);
+    for (int d = 0; d < plan.rank_B && ret == 0; d++)
+        ret = verify_set_extent(x.ext_of, sB[d], B.dims[d], me);
+    for (int d = 0; d < plan.rank_C && ret == 0; d++)
+        ret = verify_set_extent(x.ext_of, sC[d], C.dims[d], me);
+    if (ret < 0) goto done;
+
+    x.plan = &plan;
+    x.A = &A; x.B = &B; x.C = &C;
+    x.cplx = (C.dtype == DTYPE_COMPLEX128);
+    x.esz  = x.cplx ? sizeof(double _Complex) : sizeof(double);
+    x.mem_type = x.cplx ? create_h5_complex_type() : H5T_NATIVE_DOUBLE;
+    if (x.mem_type < 0) { ret = -1; goto done; }
+
+    /* Block sizes: A's chunking along each contracted index. */
+    x.K_max = 1;
+    for (int d = 0; d < plan.rank_A; d++) {
+        int c = sA[d] - 'a';
+        if (memchr(sC, sA[d], (size_t)plan.rank_C)) continue;
+        x.blk_of[c] = A.chunk[d] < A.dims[d] ? A.chunk[d] : A.dims[d];
+        if (x.blk_of[c] == 0) x.blk_of[c] = 1;
+        x.K_max *= (size_t)x.blk_of[c];
+    }
+    x.M_max = 1;
+    x.N_max = 1;
+    size_t total = 1;
+    for (int d = 0; d < plan.rank_C; d++) {
+        hsize_t cs = C.chunk[d] < C.dims[d] ? C.chunk[d] : C.dims[d];
+        if (cs == 0) cs = 1;
+        C.chunk[d]  = cs;
+        x.grid_C[d] = (size_t)((C.dims[d] + cs - 1) / cs);
+        total      *= x.grid_C[d];
+        if (memchr(sA, sC[d], (size_t)plan.rank_A)) x.M_max *= (size_t)cs;
+        else                   x.N_max *= (size_t)cs;
+    }
+
+    size_t n_want = (n_req < 0) ? total : (size_t)n_req;
+    sel   = malloc((n_want < total ? n_want : total) * sizeof(size_t) + 1);
+    x.res = calloc((n_want < total ? n_want : total) + 1, sizeof(vd_result_t));
+    if (!sel || !x.res) { ret = -4; goto done; }
+    x.sel   = sel;
+    x.n_sel = vd_select(plan.rank_C, x.grid_C, total, n_want, seed, sel);
+
+    int n_thr = query_num_threads();
+    if ((size_t)n_thr > x.n_sel) n_thr = (int)x.n_sel;
+    if (n_thr < 1) n_thr = 1;
+    thr = calloc((size_t)n_thr, sizeof(pthread_t));
+    if (!thr) { ret = -4; goto done; }
+
+    int started = 0;
+    for (; started < n_thr; started++)
+        if (pthread_create(&thr[started], NULL, vd_worker_main, &x) != 0)
+            break;
+    if (started == 0) vd_worker_main(&x);
+    for (int i = 0; i < started; i++) pthread_join(thr[i], NULL);
+    if (x.err) { ret = x.err; goto done; }
+
+    for (size_t i = 0; i < x.n_sel; i++) {
+        const vd_result_t *r = &x.res[i];
+        if (verbose > 0) vd_print_tile(&x, i, rtol, verbose);
+        if (r->max_abs > rep.max_abs_err) rep.max_abs_err = r->max_abs;
+        if (r->max_rel > rep.max_rel_err) rep.max_rel_err = r->max_rel;
+        if (!(r->max_rel <= rtol)) rep.n_failed++;
+    }
+    rep.n_checked = x.n_sel;
+    ret = (rep.n_failed > 0) ? 1 : 0;
+
+done:
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    rep.seconds = (double)(t1.tv_sec - t0.tv_sec)
+                + (double)(t1.tv_nsec - t0.tv_nsec) * 1e-9;
+    if (report) *report = rep;
+
+    free(thr);
+    free(sel);
+    free(x.res);
+    if (x.cplx && x.mem_type >= 0) H5Tclose(x.mem_type);
+    pthread_mutex_destroy(&x.mu);
+    vd_close(&A);
+    vd_close(&B);
+    vd_close(&C);
+    return ret;
+}
@@ -0,0 +1,430 @@
+/*
+ * verify.c — Freivalds-style randomized verification of C = einsum(A, B).
+ *
+ * Three streaming passes, each a tile-parallel "tensor × vector" product:
+ *
+ *   pass C : w[free_A]     = Σ_free_B     C · x[free_B]
+ *   pass B : y[contracted] = Σ_free_B     B · x[free_B]
+ *   pass A : z[free_A]     = Σ_contracted A · y[contracted]
+ *
+ * Every vector carries k interleaved columns (element i, vector t at
+ * i·k + t) so one pass serves all k random vectors.  Alongside each value
+ * accumulator we carry |T|·|in|, which bounds the rounding error of the
+ * sums and scales the tolerance.
+ */
+
+#include "verify.h"
+#include "einsum.h"
+#include "engine.h"
+#include "odometer.h"
+#include "registry.h"
+#include "rng.h"
+#include "tensor_store.h"
+
+#include <complex.h>
+#include <hdf5.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Cap on per-thread accumulator memory across all workers of one pass. */
+#define VT_ACC_BUDGET  (1UL << 30)
+
+/* ----------------------------------------------------------------------- */
+/* Vector index spaces                                                      */
+/* ----------------------------------------------------------------------- */
+
+/* Row-major index space over a subset of einsum letters. */
+typedef struct {
+    int     n;
+    char    letters[MAX_RANK];
+    hsize_t ext[MAX_RANK];
+    size_t  len;                     /* product of ext (1 when n == 0) */
+} vt_space_t;
+
+/* Element stride of letter c in s, or 0 if c is not an index of s. */
+static size_t vt_stride(const vt_space_t *s, char c)
+{
+    size_t stride = 1;
+    for (int i = s->n - 1; i >= 0; i--) {
+        if (s->letters[i] == c) return stride;
+        stride *= (size_t)s->ext[i];
+    }
+    return 0;
+}
+
+/* ----------------------------------------------------------------------- */
+/* Input tensors                                                            */
+/* ----------------------------------------------------------------------- */
+
+typedef struct {
+    hid_t           fid, dset, mem_type;
+    int             own_type;
+    TensorRegistry *reg;
+    char            letters[MAX_RANK];
+    size_t         *tiles;           /* indices of on-disk tiles */
+    size_t          n_tiles;
+} vt_tensor_t;
+
+static void vt_close(vt_tensor_t *t)
+{
+    free(t->tiles);
+    if (t->reg)      registry_destroy(t->reg);
+    if (t->own_type) H5Tclose(t->mem_type);
+    if (t->dset >= 0) H5Dclose(t->dset);
+    if (t->fid  >= 0) H5Fclose(t->fid);
+}
+
+static int vt_open(vt_tensor_t *t, const char *file, const char *letters,
+                   int rank)
+{
+    memset(t, 0, sizeof(*t));
+    t->fid  = -1;
+    t->dset = -1;
+    memcpy(t->letters, letters, (size_t)rank);
+
+    t->fid = H5Fopen(file, H5F_ACC_RDONLY, H5P_DEFAULT);
+    if (t->fid < 0) {
+        fprintf(stderr, "verify_contraction: cannot open '%s'\n", file);
+        return -1;
+    }
+    t->dset = dset_open_no_cache(t->fid, "tensor");
+    if (t->dset < 0) {
+        fprintf(stderr, "verify_contraction: no \"tensor\" in '%s'\n", file);
+        return -1;
+    }
+    t->reg = registry_create_from_dset(t->dset);
+    if (!t->reg) return -4;
+    if (t->reg->rank != rank) {
+        fprintf(stderr, "verify_contraction: '%s' has rank %d, expression "
+                "expects %d\n", file, t->reg->rank, rank);
+        return -2;
+    }
+    if (registry_scan_file(t->dset, t->reg) < 0) return -1;
+
+    if (t->reg->dtype == DTYPE_COMPLEX128) {
+        t->mem_type = create_h5_complex_type();
+        t->own_type = 1;
+        if (t->mem_type < 0) return -1;
+    } else {
+        t->mem_type = H5T_NATIVE_DOUBLE;
+    }
+
+    t->tiles = malloc((t->reg->total_tiles + 1) * sizeof(size_t));
+    if (!t->tiles) return -4;
+    for (size_t i = 0; i < t->reg->total_tiles; i++)
+        if (t->reg->tiles[i].status == TILE_STATUS_ON_DISK)
+            t->tiles[t->n_tiles++] = i;
+    return 0;
+}
+
+/* ----------------------------------------------------------------------- */
+/* Tensor × vector pass                                                     */
+/* ----------------------------------------------------------------------- */
+
+typedef struct {
+    const vt_tensor_t     *T;
+    int                    k;
+    const double _Complex *in;       /* [in_len · k]  */
+    const double          *in_abs;   /* [in_len · k]  */
+    size_t                 in_stride[MAX_RANK];
+    size_t                 out_stride[MAX_RANK];
+    size_t                 out_n;    /* out_len · k   */
+
+    pthread_mutex_t        mu;
+    size_t                 next;     /* next entry of T->tiles */
+    volatile int           err;
+} vt_pass_t;
+
+typedef struct {
+    vt_pass_t       *p;
+    double _Complex *out;
+    double          *out_abs;
+} vt_worker_t;
+
+/* Accumulate one tile into the worker's private out / out_abs. */
+static void vt_tile(const vt_pass_t *p, size_t t, const void *buf,
+                    double _Complex *out, double *out_abs)
+{
+    const TensorRegistry *reg  = p->T->reg;
+    int                   r    = reg->rank;
+    int                   k    = p->k;
+    int                   cplx = (reg->dtype == DTYPE_COMPLEX128);
+    const hsize_t        *off  = reg->tiles[t].phys_offset;
+
+    size_t act[MAX_RANK], row[MAX_RANK] = {0};
+    for (int d = 0; d < r; d++) {
+        hsize_t rem = reg->global_dims[d] - off[d];
+        act[d] = (size_t)(rem < reg->chunk_dims[d] ? rem : reg->chunk_dims[d]);
+    }
+    size_t row_len = (size_t)reg->chunk_dims[r - 1];
+    size_t sin  = p->in_stride[r - 1]  * (size_t)k;
+    size_t sout = p->out_stride[r - 1] * (size_t)k;
+
+    do {
+        size_t ib = 0, ob = 0, eb = 0;
+        for (int d = 0; d < r - 1; d++) {
+            ib += (size_t)(off[d] + row[d]) * p->in_stride[d];
+            ob += (size_t)(off[d] + row[d]) * p->out_stride[d];
+            eb  = eb * (size_t)reg->chunk_dims[d] + row[d];
+        }
+        ib  = (ib + (size_t)off[r - 1] * p->in_stride[r - 1])  * (size_t)k;
+        ob  = (ob + (size_t)off[r - 1] * p->out_stride[r - 1]) * (size_t)k;
+        eb *= row_len;
+
+        for (size_t j = 0; j < act[r - 1]; j++) {
+            double _Complex v = cplx
+                ? ((const double _Complex *)buf)[eb + j]
+                : ((const double *)buf)[eb + j];
+            double av = cabs(v);
+            const double _Complex *xi  = p->in     + ib + j * sin;
+            const double          *xa  = p->in_abs + ib + j * sin;
+            double _Complex       *o   = out       + ob + j * sout;
+            double                *oa  = out_abs   + ob + j * sout;
+            for (int c = 0; c < k; c++) {
+                o[c]  += v  * xi[c];
+                oa[c] += av * xa[c];
+            }
+        }
+    } while (r > 1 && odometer_step((size_t)(r - 1), row, act));
+}
+
+static void *vt_worker_main(void *arg)
+{
+    vt_worker_t          *w   = (vt_worker_t *)arg;
+    vt_pass_t            *p   = w->p;
+    const TensorRegistry *reg = p->T->reg;
+
+    size_t esz = (reg->dtype == DTYPE_COMPLEX128) ? sizeof(double _Complex)
+                                                  : sizeof(double);
+    size_t tile_elems = 1;
+    for (int d = 0; d < reg->rank; d++)
+        tile_elems *= (size_t)reg->chunk_dims[d];
+    void *buf = malloc(tile_elems * esz);
+    if (!buf) { p->err = -4; return NULL; }
+
+    for (;;) {
+        pthread_mutex_lock(&p->mu);
+        size_t i = p->next++;
+        pthread_mutex_unlock(&p->mu);
+        if (i >= p->T->n_tiles || p->err) break;
+
+        size_t t = p->T->tiles[i];
+        tensor_store_lock();
+        herr_t rc = read_chunk_typed(p->T->dset, reg->tiles[t].phys_offset,
+                                     buf, esz, reg->rank, reg->chunk_dims,
+                                     p->T->mem_type);
+        tensor_store_unlock();
+        if (rc < 0) { p->err = -1; break; }
+
+        vt_tile(p, t, buf, w->out, w->out_abs);
+    }
+    free(buf);
+    return NULL;
+}
+
+/*
+ * out[·] = Σ T · in[·] over the letters of T not in `out_space`.
+ * out / out_abs (out_space.len · k) are overwritten.
+ */
+static int vt_pass(const vt_tensor_t *T, int k,
+                   const vt_space_t *in_space,
+                   const double _Complex *in, const double *in_abs,
+                   const vt_space_t *out_space,
+                   double _Complex *out, double *out_abs)
+{
+    vt_pass_t p;
+    memset(&p, 0, sizeof(p));
+    p.T      = T;
+    p.k      = k;
+    p.in     = in;
+    p.in_abs = in_abs;
+    p.out_n  = out_space->len * (size_t)k;
+    for (int d = 0; d < T->reg->rank; d++) {
+        p.in_stride[d]  = vt_stride(in_space,  T->letters[d]);
+        p.out_stride[d] = vt_stride(out_space, T->letters[d]);
+    }
+    pthread_mutex_init(&p.mu, NULL);
+
+    /* Worker count: TENSOR_NUM_THREADS, at most one per tile, and few
+     * enough that the private accumulators fit the budget. */
+    size_t acc_bytes = p.out_n * (sizeof(double _Complex) + sizeof(double));
+    int n_thr = query_num_threads();
+    if ((size_t)n_thr > T->n_tiles) n_thr = (int)T->n_tiles;
+    if (acc_bytes > 0 && (size_t)n_thr * acc_bytes > VT_ACC_BUDGET)
+        n_thr = (int)(VT_ACC_BUDGET / acc_bytes);
+    if (n_thr < 1) n_thr = 1;
+
+    /* Worker 0 accumulates straight into out; the others get scratch. */
+    vt_worker_t *w   = calloc((size_t)n_thr, sizeof(vt_worker_t));
+    pthread_t   *thr = calloc((size_t)n_thr, sizeof(pthread_t));
+    int          ret = 0;
+    if (!w || !thr) { ret = -4; goto done; }
+
+    memset(out,     0, p.out_n * sizeof(double _Complex));
+    memset(out_abs, 0, p.out_n * sizeof(double));
+    w[0].p = &p; w[0].out = out; w[0].out_abs = out_abs;
+    for (int i = 1; i < n_thr; i++) {
+        w[i].p       = &p;
+        w[i].out     = calloc(p.out_n, sizeof(double _Complex));
+        w[i].out_abs = calloc(p.out_n, sizeof(double));
+        if (!w[i].out || !w[i].out_abs) { ret = -4; goto done; }
+    }
+
+    int started = 0;
+    for (; started < n_thr; started++)
+        if (pthread_create(&thr[started], NULL, vt_worker_main,
+                           &w[started]) != 0)
+            break;
+    if (started == 0) vt_worker_main(&w[0]);
+    for (int i = 0; i < started; i++) pthread_join(thr[i], NULL);
+    if (p.err) { ret = p.err; goto done; }
+    /* Threads that failed to start left their tiles to the others. */
+
+    for (int i = 1; i < n_thr; i++) {
+        for (size_t j = 0; j < p.out_n; j++) {
+            out[j]     += w[i].out[j];
+            out_abs[j] += w[i].out_abs[j];
+        }
+    }
+
+done:
+    for (int i = 1; w && i < n_thr; i++) {
+        free(w[i].out);
+        free(w[i].out_abs);
+    }
+    free(w);
+    free(thr);
+    pthread_mutex_destroy(&p.mu);
+    return ret;
+}
+
+/* ----------------------------------------------------------------------- */
+/* verify_contraction                                                       */
+/* ----------------------------------------------------------------------- */
+
+int verify_set_extent(hsize_t *ext_of, char c, hsize_t e, const char *caller)
+{
+    hsize_t *slot = &ext_of[c - 'a'];
+    if (*slot != 0 && *slot != e) {
+        fprintf(stderr, "%s: index '%c' has extents %llu and %llu\n",
+                caller, c, (unsigned long long)*slot, (unsigned long long)e);
+        return -2;
+    }
+    *slot = e;
+    return 0;
+}
+
+static void vt_space_init(vt_space_t *s, const char *letters, int n,
+                          const hsize_t *ext_of)
+{
+    s->n   = n;
+    s->len = 1;
+    for (int i = 0; i < n; i++) {
+        s->letters[i] = letters[i];
+        s->ext[i]     = ext_of[letters[i] - 'a'];
+        s->len       *= (size_t)s->ext[i];
+    }
+}
+
+int verify_contraction(const char *expr,
+                       const char *file_A, const char *file_B,
+                       const char *file_C,
+                       const verify_opts_t *opts,
+                       verify_report_t *report)
+{
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    int      k    = (opts && opts->n_vectors > 0) ? opts->n_vectors : 2;
+    uint64_t seed = opts ? opts->seed : 0;
+    double   rtol = (opts && opts->rtol > 0.0) ? opts->rtol : 1e-9;
+
+    contraction_plan_t plan;
+    if (!expr || einsum_parse(expr, &plan) < 0) return -3;
+
+    /* Operand letters, in operand order (einsum_parse validated them). */
+    char sA[MAX_RANK], sB[MAX_RANK], sC[MAX_RANK];
+    const char *comma = strchr(expr, ',');
+    const char *arrow = strstr(expr, "->");
+    memcpy(sA, expr, (size_t)plan.rank_A);
+    memcpy(sB, comma + 1, (size_t)plan.rank_B);
+    memcpy(sC, arrow + 2, (size_t)plan.rank_C);
+
+    vt_tensor_t A, B, C;
+    int ret = vt_open(&A, file_A, sA, plan.rank_A);
+    int rB  = vt_open(&B, file_B, sB, plan.rank_B);
+    int rC  = vt_open(&C, file_C, sC, plan.rank_C);
+    if (ret == 0) ret = rB;
+    if (ret == 0) ret = rC;
+
+    double _Complex *x = NULL, *y = NULL, *z = NULL, *w = NULL;
+    double *xa = NULL, *ya = NULL, *za = NULL, *wa = NULL;
+    verify_report_t rep;
+    memset(&rep, 0, sizeof(rep));
+    if (ret < 0) goto done;
+
+    const char *me = "verify_contraction";
+    hsize_t ext_of[26] = {0};
+    for (int d = 0; d < plan.rank_A && ret == 0; d++)
+        ret = verify_set_extent(ext_of, sA[d], A.reg->global_dims[d], me);
+    for (int d = 0; d < plan.rank_B && ret == 0; d++)
+        ret = verify_set_extent(ext_of, sB[d], B.reg->global_dims[d], me);
+    for (int d = 0; d < plan.rank_C && ret == 0; d++)
+        ret = verify_set_extent(ext_of, sC[d], C.reg->global_dims[d], me);
+    if (ret < 0) goto done;
+
+    vt_space_t X, Y, Z;
+    vt_space_init(&X, plan.free_B_chars,     plan.n_free_B,     ext_of);
+    vt_space_init(&Y, plan.contracted_chars, plan.n_contracted, ext_of);
+    vt_space_init(&Z, plan.free_A_chars,     plan.n_free_A,     ext_of);
+
+    size_t nx = X.len * (size_t)k, ny = Y.len * (size_t)k;
+    size_t nz = Z.len * (size_t)k;
+    x  = malloc(nx * sizeof(*x));  xa = malloc(nx * sizeof(*xa));
+    y  = malloc(ny * sizeof(*y));  ya = malloc(ny * sizeof(*ya));
+    z  = malloc(nz * sizeof(*z));  za = malloc(nz * sizeof(*za));
+    w  = malloc(nz * sizeof(*w));  wa = malloc(nz * sizeof(*wa));
+    if (!x || !xa || !y || !ya || !z || !za || !w || !wa) {
+        ret = -4;
+        goto done;
+    }
+
+    uint64_t st = rng_derive(seed, 0);
+    for (size_t i = 0; i < nx; i++) {
+        x[i]  = rng_uniform(&st);
+        xa[i] = fabs(creal(x[i]));
+    }
+
+    if ((ret = vt_pass(&C, k, &X, x, xa, &Z, w, wa)) < 0) goto done;
+    if ((ret = vt_pass(&B, k, &X, x, xa, &Y, y, ya)) < 0) goto done;
+    if ((ret = vt_pass(&A, k, &Y, y, ya, &Z, z, za)) < 0) goto done;
+
+    for (size_t i = 0; i < nz; i++) {
+        double err   = cabs(z[i] - w[i]);
+        double scale = za[i] + wa[i];
+        double rel   = (scale > 0.0) ? err / scale : (err > 0.0 ? INFINITY
+                                                                 : 0.0);
+        if (err > rep.max_abs_err) rep.max_abs_err = err;
+        if (rel > rep.max_rel_err) rep.max_rel_err = rel;
+        if (!(err <= rtol * scale)) rep.n_failed++;
+    }
+    rep.n_checked = nz;
+    ret = (rep.n_failed > 0) ? 1 : 0;
+
+done:
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    rep.seconds = (double)(t1.tv_sec - t0.tv_sec)
+                + (double)(t1.tv_nsec - t0.tv_nsec) * 1e-9;
+    if (report) *report = rep;
+
+    free(x); free(xa); free(y); free(ya);
+    free(z); free(za); free(w); free(wa);
+    vt_close(&A);
+    vt_close(&B);
+    vt_close(&C);
+    return ret;
+}
@@ -3,6 +3,7 @@
  */
 
 #include "write_queue.h"
+#include "tensor_store.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -61,3 +62,44 @@ void wq_push_sentinel(WriteQueue *wq)
     t.id_C = SIZE_MAX;  /* sentinel value */
     wq_push(wq, &t);
 }
+
+void *wq_writer_main(void *arg)
+{
+    wq_writer_t *w = (wq_writer_t *)arg;
+
+    for (;;) {
+        write_task_t t = wq_pop(w->wq);
+        if (t.id_C == SIZE_MAX) break;
+
+        if (!w->wq->err) {
+            herr_t st;
+            tensor_store_lock();
+            if (w->direct) {
+                size_t nbytes = w->element_size;
+                for (int d = 0; d < w->rank; d++)
+                    nbytes *= (size_t)w->chunk_dims[d];
+                st = write_chunk_direct(w->dset, t.phys_off, t.buf_C, nbytes);
+            } else {
+                st = write_chunk_typed(w->dset, t.phys_off, t.buf_C,
+                                       w->element_size, w->rank,
+                                       w->chunk_dims, w->mem_type);
+            }
+            tensor_store_unlock();
+            if (st < 0) {
+                fprintf(stderr, "wq_writer_main: tile write failed\n");
+                w->wq->err = 1;
+            } else {
+                w->n_written++;
+                if (w->on_write) w->on_write(w->on_write_user, w->n_written);
+            }
+        }
+
+        if (t.owning_pool) {
+            pthread_mutex_lock(t.pool_mu);
+            pool_release(t.owning_pool, t.id_C);
+            pthread_cond_broadcast(t.pool_cond);
+            pthread_mutex_unlock(t.pool_mu);
+        }
+    }
+    return NULL;
+}
@@ -3,7 +3,7 @@
  *
  * Correctness tests for tensor_engine_create() and tensor_engine_fill().
  *
- * Seven test cases:
+ * Nine test cases:
  *   T1 – create FP64 rank-2 with default tile_bytes, check dims
  *   T2 – create COMPLEX128 rank-3, check dims and dtype
  *   T3 – tile_bytes config controls chunk dimensions
@@ -11,6 +11,8 @@
  *   T5 – fill COMPLEX128 tensor, read back and verify
  *   T6 – boundary tiles: non-divisible shapes still fill correctly
  *   T7 – end-to-end: create A + B, fill, contract, verify result
+ *   T8 – fill_random is in [-1,1) and identical for 1 and 4 threads
+ *   T9 – fill_random tiles match tile_fill_random() regenerated in memory
  *
  * All files use the prefix "cf_t{N}_" in the current working directory.
  *
@@ -23,6 +25,7 @@
 #include "tensor_store.h"
 #include "registry.h"
 #include "odometer.h"
+#include "tile_writer.h"
 #include <hdf5.h>
 #include <complex.h>
 #include <math.h>
@@ -518,6 +521,149 @@ static int t7_create_fill_contract(void)
     return (g_fail == 0) ? 0 : 1;
 }
 
+/* ----------------------------------------------------------------------- */
+/* Helper: read a whole FP64 "tensor" dataset into a malloc'd buffer         */
+/* ----------------------------------------------------------------------- */
+static double *read_all_fp64(const char *file, size_t *n_out)
+{
+    hid_t fid = H5Fopen(file, H5F_ACC_RDONLY, H5P_DEFAULT);
+    if (fid < 0) return NULL;
+    hid_t dset = H5Dopen2(fid, "tensor", H5P_DEFAULT);
+    if (dset < 0) { H5Fclose(fid); return NULL; }
+
+    hid_t   space = H5Dget_space(dset);
+    hssize_t n    = H5Sget_simple_extent_npoints(space);
+    H5Sclose(space);
+
+    double *buf = (n > 0) ? malloc((size_t)n * sizeof(double)) : NULL;
+    if (buf && H5Dread(dset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL,
+                       H5P_DEFAULT, buf) < 0) {
+        free(buf);
+        buf = NULL;
+    }
+    H5Dclose(dset);
+    H5Fclose(fid);
+    if (buf) *n_out = (size_t)n;
+    return buf;
+}
+
+/* ----------------------------------------------------------------------- */
+/* T8 — fill_random: range check and thread-count independence              */
+/* ----------------------------------------------------------------------- */
+static int t8_fill_random_threads(void)
+{
+    printf("\n=== T8: fill_random identical for 1 and 4 threads ===\n");
+    tensor_engine_config_t cfg = {.tile_bytes = 4UL * 1024};
+    tensor_engine_t *eng = tensor_engine_init(&cfg);
+    CHECK(eng != NULL, "engine init");
+    if (!eng) return 1;
+
+    const size_t shape[3] = {23, 17, 9};
+    const char *files[2] = {"cf_t8_A1.h5", "cf_t8_A4.h5"};
+    const char *nthr[2]  = {"1", "4"};
+
+    for (int f = 0; f < 2; f++) {
+        CHECK(tensor_engine_create(eng, files[f], 3, shape,
+                                   TENSOR_DTYPE_FP64) == TENSOR_ENGINE_OK,
+              "create");
+        setenv("TENSOR_NUM_THREADS", nthr[f], 1);
+        CHECK(tensor_engine_fill_random(eng, files[f], 12345)
+                  == TENSOR_ENGINE_OK,
+              "fill_random returns OK");
+        unsetenv("TENSOR_NUM_THREADS");
+    }
+
+    size_t n1 = 0, n4 = 0;
+    double *a1 = read_all_fp64(files[0], &n1);
+    double *a4 = read_all_fp64(files[1], &n4);
+    CHECK(a1 && a4 && n1 == n4 && n1 == 23 * 17 * 9, "read back both");
+    if (a1 && a4 && n1 == n4) {
+        int    in_range = 1;
+        double sum      = 0.0;
+        for (size_t i = 0; i < n1; i++) {
+            if (!(a1[i] >= -1.0 && a1[i] < 1.0)) in_range = 0;
+            sum += a1[i];
+        }
+        CHECK(in_range, "every element in [-1, 1)");
+        CHECK(fabs(sum / (double)n1) < 0.1, "sample mean near 0");
+        CHECK(memcmp(a1, a4, n1 * sizeof(double)) == 0,
+              "1-thread and 4-thread fills are bit-identical");
+    }
+    free(a1);
+    free(a4);
+
+    tensor_engine_free(eng);
+    return (g_fail == 0) ? 0 : 1;
+}
+
+/* ----------------------------------------------------------------------- */
+/* T9 — fill_random tiles can be regenerated from (seed, tile index)        */
+/* ----------------------------------------------------------------------- */
+static int t9_fill_random_regenerate(void)
+{
+    printf("\n=== T9: fill_random tiles match tile_fill_random() ===\n");
+    tensor_engine_config_t cfg = {.tile_bytes = 4UL * 1024};
+    tensor_engine_t *eng = tensor_engine_init(&cfg);
+    CHECK(eng != NULL, "engine init");
+    if (!eng) return 1;
+
+    const size_t shape[2] = {50, 37};
+    CHECK(tensor_engine_create(eng, "cf_t9_A.h5", 2, shape,
+                               TENSOR_DTYPE_COMPLEX128) == TENSOR_ENGINE_OK,
+          "create COMPLEX128");
+    CHECK(tensor_engine_fill_random(eng, "cf_t9_A.h5", 99)
+              == TENSOR_ENGINE_OK,
+          "fill_random returns OK");
+
+    hid_t fid  = H5Fopen("cf_t9_A.h5", H5F_ACC_RDONLY, H5P_DEFAULT);
+    hid_t dset = dset_open_no_cache(fid, "tensor");
+    hid_t ctype = create_h5_complex_type();
+    TensorRegistry *reg = registry_create_from_dset(dset);
+    CHECK(reg != NULL && reg->total_tiles > 1, "registry has several tiles");
+
+    size_t esz  = sizeof(double _Complex);
+    size_t tile = 1;
+    for (int d = 0; reg && d < reg->rank; d++)
+        tile *= (size_t)reg->chunk_dims[d];
+    double _Complex *disk = malloc(tile * esz);
+    double _Complex *ref  = malloc(tile * esz);
+    int mismatches = 0;
+    for (size_t t = 0; reg && disk && ref && t < reg->total_tiles; t++) {
+        memset(disk, 0, tile * esz);
+        if (read_chunk_typed(dset, reg->tiles[t].phys_offset, disk, esz,
+                             reg->rank, reg->chunk_dims, ctype) < 0) {
+            mismatches++;
+            continue;
+        }
+        tile_fill_random(ref, reg, t, 99);
+        /* Compare only the valid region; padding on disk is unspecified
+         * for hyperslab writes. */
+        size_t coords[MAX_RANK] = {0};
+        size_t ext[MAX_RANK];
+        for (int d = 0; d < reg->rank; d++) {
+            hsize_t left = reg->global_dims[d] - reg->tiles[t].phys_offset[d];
+            ext[d] = (size_t)(left < reg->chunk_dims[d]
+                              ? left : reg->chunk_dims[d]);
+        }
+        do {
+            size_t off = 0;
+            for (int d = 0; d < reg->rank; d++)
+                off = off * (size_t)reg->chunk_dims[d] + coords[d];
+            if (disk[off] != ref[off]) mismatches++;
+        } while (odometer_step((size_t)reg->rank, coords, ext));
+    }
+    CHECK(mismatches == 0, "every tile equals its regenerated contents");
+
+    free(disk);
+    free(ref);
+    if (reg) registry_destroy(reg);
+    H5Tclose(ctype);
+    H5Dclose(dset);
+    H5Fclose(fid);
+    tensor_engine_free(eng);
+    return (g_fail == 0) ? 0 : 1;
+}
+
 /* ----------------------------------------------------------------------- */
 /* main                                                                      */
 /* ----------------------------------------------------------------------- */
@@ -532,6 +678,8 @@ int main(void)
     t5_fill_complex();
     t6_boundary_fill();
     t7_create_fill_contract();
+    t8_fill_random_threads();
+    t9_fill_random_regenerate();
 
     printf("\n--- Results: %d passed, %d failed ---\n", g_pass, g_fail);
     return (g_fail == 0) ? 0 : 1;
@@ -0,0 +1,393 @@
+/*
+ * tests/test_elementwise.c
+ *
+ * Correctness tests for tensor_engine_elementwise().
+ *
+ * Seven test cases:
+ *   T1 – expression compiler: precedence, constant folding, syntax errors
+ *   T2 – FP64 axpy "2*A + B" into a new file (boundary tiles)
+ *   T3 – FP64 in-place amplitude update T = T + R/D
+ *   T4 – COMPLEX128 Hadamard product minus a third tensor
+ *   T5 – block sparsity: A*B keeps the intersection, A+B the union
+ *   T6 – error paths: non-co-tiled inputs, malformed expression
+ *   T7 – in-place where the aliased operand is the second input from the
+ *        output's file, after another dataset of that file
+ *
+ * All files use the prefix "ew_t{N}_" in the current working directory.
+ *
+ * Build: added to CMakeLists.txt as test_elementwise.
+ * Run:   ./build/test_elementwise
+ * Exit:  0 on success, 1 on any failure.
+ */
+
+#include "tensor_engine.h"
+#include "elementwise.h"
+#include "tensor_store.h"
+#include "registry.h"
+#include "test_util.h"
+#include <hdf5.h>
+#include <complex.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ----------------------------------------------------------------------- */
+/* Test infrastructure                                                       */
+/* ----------------------------------------------------------------------- */
+
+/* Deterministic element values; `salt` distinguishes tensors. */
+static double val(size_t i, int salt)
+{
+    return (double)((i * (size_t)(37 + salt)) % 101) / 10.0 - 5.0 + salt;
+}
+
+/*
+ * Write a rank-2 tensor tile-by-tile.  keep(ti, tj) decides whether tile
+ * (ti, tj) is written; skipped tiles stay unallocated (block-sparse).
+ */
+typedef int (*tile_keep_fn)(hsize_t ti, hsize_t tj);
+
+static int keep_all(hsize_t ti, hsize_t tj) { (void)ti; (void)tj; return 1; }
+
+static int write_2d(const char *file, const hsize_t *dims,
+                    const hsize_t *chunk, tensor_dtype_t dtype,
+                    int salt, tile_keep_fn keep)
+{
+    if (create_chunked_dataset_einsum(file, "tensor", 2, dims, chunk,
+                                      dtype) < 0)
+        return -1;
+
+    hid_t fid  = H5Fopen(file, H5F_ACC_RDWR, H5P_DEFAULT);
+    hid_t dset = dset_open_no_cache(fid, "tensor");
+    hid_t ctype = create_h5_complex_type();
+    hid_t mtype = (dtype == DTYPE_COMPLEX128) ? ctype : H5T_NATIVE_DOUBLE;
+    size_t esz  = (dtype == DTYPE_COMPLEX128) ? sizeof(double _Complex)
+                                              : sizeof(double);
+    void *buf = calloc((size_t)(chunk[0] * chunk[1]), esz);
+    int   rc  = 0;
+
+    for (hsize_t ti = 0; ti * chunk[0] < dims[0]; ti++)
+        for (hsize_t tj = 0; tj * chunk[1] < dims[1]; tj++) {
+            if (!keep(ti, tj)) continue;
+            hsize_t off[2] = { ti * chunk[0], tj * chunk[1] };
+            for (hsize_t r = 0; r < chunk[0]; r++)
+                for (hsize_t c = 0; c < chunk[1]; c++) {
+                    size_t g = (size_t)((off[0] + r) * dims[1] + off[1] + c);
+                    size_t l = (size_t)(r * chunk[1] + c);
+                    if (dtype == DTYPE_COMPLEX128)
+                        ((double _Complex *)buf)[l] =
+                            val(g, salt) + val(g, salt + 3) * _Complex_I;
+                    else
+                        ((double *)buf)[l] = val(g, salt);
+                }
+            if (write_chunk_typed(dset, off, buf, esz, 2, chunk, mtype) < 0)
+                rc = -1;
+        }
+
+    free(buf);
+    H5Tclose(ctype);
+    H5Dclose(dset);
+    H5Fclose(fid);
+    return rc;
+}
+
+/* Read a whole (small) dataset; unallocated tiles read as the fill value. */
+static void *read_all(const char *file, tensor_dtype_t dtype, size_t n)
+{
+    size_t esz = (dtype == DTYPE_COMPLEX128) ? sizeof(double _Complex)
+                                             : sizeof(double);
+    void  *buf = calloc(n, esz);
+    hid_t  fid = H5Fopen(file, H5F_ACC_RDONLY, H5P_DEFAULT);
+    if (fid < 0) { free(buf); return NULL; }
+    hid_t dset  = H5Dopen2(fid, "tensor", H5P_DEFAULT);
+    hid_t ctype = create_h5_complex_type();
+    H5Dread(dset, dtype == DTYPE_COMPLEX128 ? ctype : H5T_NATIVE_DOUBLE,
+            H5S_ALL, H5S_ALL, H5P_DEFAULT, buf);
+    H5Tclose(ctype);
+    H5Dclose(dset);
+    H5Fclose(fid);
+    return buf;
+}
+
+/* Number of allocated tiles in a file. */
+static long count_tiles(const char *file)
+{
+    hid_t fid  = H5Fopen(file, H5F_ACC_RDONLY, H5P_DEFAULT);
+    if (fid < 0) return -1;
+    hid_t dset = dset_open_no_cache(fid, "tensor");
+    TensorRegistry *reg = registry_create_from_dset(dset);
+    long n = registry_scan_file(dset, reg);
+    registry_destroy(reg);
+    H5Dclose(dset);
+    H5Fclose(fid);
+    return n;
+}
+
+/* ----------------------------------------------------------------------- */
+/* T1 — expression compiler                                                 */
+/* ----------------------------------------------------------------------- */
+static void t1_compile(void)
+{
+    printf("\n=== T1: expression compiler ===\n");
+    ew_program_t p;
+
+    CHECK(ew_compile("A + B / C", &p) == 0, "compile 'A + B / C'");
+    CHECK(p.n_instr == 5 && p.code[3].op == EW_OP_DIV &&
+          p.code[4].op == EW_OP_ADD, "'/' binds tighter than '+'");
+    CHECK(p.n_inputs == 3, "n_inputs == 3");
+
+    CHECK(ew_compile("(1 + 2) * 0.5 * A", &p) == 0, "compile constants");
+    CHECK(p.n_instr == 3 && p.code[0].op == EW_OP_CONST &&
+          p.code[0].value == 1.5, "constants folded to 1.5");
+
+    CHECK(ew_compile("-(A - -2)", &p) == 0, "compile unary minus");
+
+    double a[3] = { 1, 2, 3 }, b[3] = { 4, 5, 6 }, o[3];
+    const double *in[2] = { a, b };
+    ew_compile("2*A - B/2", &p);
+    ew_eval_fp64(&p, in, o, 3);
+    CHECK(o[0] == 0.0 && o[1] == 1.5 && o[2] == 3.0, "eval 2*A - B/2");
+
+    in[1] = NULL;   /* absent B reads as zero */
+    ew_compile("A + B", &p);
+    ew_eval_fp64(&p, in, o, 3);
+    CHECK(o[0] == 1.0 && o[2] == 3.0, "absent operand evaluates as zero");
+
+    CHECK(ew_compile("A +", &p) < 0,   "reject dangling operator");
+    CHECK(ew_compile("A B", &p) < 0,   "reject juxtaposition");
+    CHECK(ew_compile("(A", &p) < 0,    "reject unbalanced paren");
+    CHECK(ew_compile("Ax", &p) < 0,    "reject unknown identifier");
+    CHECK(ew_compile("", &p) < 0,      "reject empty expression");
+}
+
+/* ----------------------------------------------------------------------- */
+/* T2 — axpy into a new file                                                */
+/* ----------------------------------------------------------------------- */
+static void t2_axpy(tensor_engine_t *eng)
+{
+    printf("\n=== T2: FP64 axpy 2*A + B (boundary tiles) ===\n");
+    const hsize_t dims[2] = { 23, 17 }, chunk[2] = { 8, 5 };
+    const size_t  n = 23 * 17;
+
+    CHECK(write_2d("ew_t2_A.h5", dims, chunk, DTYPE_FP64, 0, keep_all) == 0,
+          "write A");
+    CHECK(write_2d("ew_t2_B.h5", dims, chunk, DTYPE_FP64, 1, keep_all) == 0,
+          "write B");
+
+    const char *in[2] = { "ew_t2_A.h5", "ew_t2_B.h5" };
+    CHECK(tensor_engine_elementwise(eng, "2*A + B", in, 2, "ew_t2_C.h5")
+          == TENSOR_ENGINE_OK, "elementwise returns OK");
+
+    double *c = read_all("ew_t2_C.h5", DTYPE_FP64, n);
+    double max_err = 0.0;
+    for (size_t i = 0; c && i < n; i++) {
+        double err = fabs(c[i] - (2.0 * val(i, 0) + val(i, 1)));
+        if (err > max_err) max_err = err;
+    }
+    CHECK(c && max_err < 1e-12, "C == 2A + B for all 391 elements");
+    printf("  max_err = %.2e\n", max_err);
+    free(c);
+}
+
+/* ----------------------------------------------------------------------- */
+/* T3 — in-place T = T + R/D                                                */
+/* ----------------------------------------------------------------------- */
+static void t3_inplace(tensor_engine_t *eng)
+{
+    printf("\n=== T3: in-place amplitude update T = T + R/D ===\n");
+    const hsize_t dims[2] = { 30, 12 }, chunk[2] = { 7, 7 };
+    const size_t  n = 30 * 12;
+
+    write_2d("ew_t3_T.h5", dims, chunk, DTYPE_FP64, 2, keep_all);
+    write_2d("ew_t3_R.h5", dims, chunk, DTYPE_FP64, 3, keep_all);
+    write_2d("ew_t3_D.h5", dims, chunk, DTYPE_FP64, 20, keep_all);
+
+    double *t0 = read_all("ew_t3_T.h5", DTYPE_FP64, n);
+
+    const char *in[3] = { "ew_t3_T.h5", "ew_t3_R.h5", "ew_t3_D.h5" };
+    CHECK(tensor_engine_elementwise(eng, "A + B / C", in, 3, "ew_t3_T.h5")
+          == TENSOR_ENGINE_OK, "in-place elementwise returns OK");
+
+    double *t1 = read_all("ew_t3_T.h5", DTYPE_FP64, n);
+    double max_err = 0.0;
+    for (size_t i = 0; t0 && t1 && i < n; i++) {
+        double err = fabs(t1[i] - (t0[i] + val(i, 3) / val(i, 20)));
+        if (err > max_err) max_err = err;
+    }
+    CHECK(t0 && t1 && max_err < 1e-12, "T' == T + R/D");
+    printf("  max_err = %.2e\n", max_err);
+    free(t0);
+    free(t1);
+}
+
+/* ----------------------------------------------------------------------- */
+/* T4 — COMPLEX128 Hadamard                                                 */
+/* ----------------------------------------------------------------------- */
+static void t4_complex(tensor_engine_t *eng)
+{
+    printf("\n=== T4: COMPLEX128 A*B - C ===\n");
+    const hsize_t dims[2] = { 13, 11 }, chunk[2] = { 4, 6 };
+    const size_t  n = 13 * 11;
+
+    write_2d("ew_t4_A.h5", dims, chunk, DTYPE_COMPLEX128, 4, keep_all);
+    write_2d("ew_t4_B.h5", dims, chunk, DTYPE_COMPLEX128, 5, keep_all);
+    write_2d("ew_t4_C.h5", dims, chunk, DTYPE_COMPLEX128, 6, keep_all);
+
+    const char *in[3] = { "ew_t4_A.h5", "ew_t4_B.h5", "ew_t4_C.h5" };
+    CHECK(tensor_engine_elementwise(eng, "A*B - C", in, 3, "ew_t4_O.h5")
+          == TENSOR_ENGINE_OK, "elementwise returns OK");
+
+    double _Complex *o = read_all("ew_t4_O.h5", DTYPE_COMPLEX128, n);
+    double max_err = 0.0;
+    for (size_t i = 0; o && i < n; i++) {
+        double _Complex a = val(i, 4) + val(i, 7) * _Complex_I;
+        double _Complex b = val(i, 5) + val(i, 8) * _Complex_I;
+        double _Complex c = val(i, 6) + val(i, 9) * _Complex_I;
+        double err = cabs(o[i] - (a * b - c));
+        if (err > max_err) max_err = err;
+    }
+    CHECK(o && max_err < 1e-12, "O == A*B - C");
+    printf("  max_err = %.2e\n", max_err);
+    free(o);
+}
+
+/* ----------------------------------------------------------------------- */
+/* T5 — block sparsity                                                      */
+/* ----------------------------------------------------------------------- */
+static int keep_even_row(hsize_t ti, hsize_t tj) { (void)tj; return ti % 2 == 0; }
+static int keep_even_col(hsize_t ti, hsize_t tj) { (void)ti; return tj % 2 == 0; }
+
+static void t5_sparsity(tensor_engine_t *eng)
+{
+    printf("\n=== T5: block sparsity preserved ===\n");
+    /* 4×4 tile grid: A has rows {0,2}, B has cols {0,2}. */
+    const hsize_t dims[2] = { 16, 16 }, chunk[2] = { 4, 4 };
+    const size_t  n = 16 * 16;
+
+    write_2d("ew_t5_A.h5", dims, chunk, DTYPE_FP64, 7, keep_even_row);
+    write_2d("ew_t5_B.h5", dims, chunk, DTYPE_FP64, 8, keep_even_col);
+    CHECK(count_tiles("ew_t5_A.h5") == 8, "A has 8 tiles");
+
+    const char *in[2] = { "ew_t5_A.h5", "ew_t5_B.h5" };
+    CHECK(tensor_engine_elementwise(eng, "A * B", in, 2, "ew_t5_P.h5")
+          == TENSOR_ENGINE_OK, "A*B returns OK");
+    CHECK(tensor_engine_elementwise(eng, "A + B", in, 2, "ew_t5_S.h5")
+          == TENSOR_ENGINE_OK, "A+B returns OK");
+
+    long np = count_tiles("ew_t5_P.h5"), ns = count_tiles("ew_t5_S.h5");
+    printf("  tiles: A*B=%ld  A+B=%ld\n", np, ns);
+    CHECK(np == 4,  "A*B allocates only the 4 intersection tiles");
+    CHECK(ns == 12, "A+B allocates the 12 union tiles");
+
+    double *s = read_all("ew_t5_S.h5", DTYPE_FP64, n);
+    double max_err = 0.0;
+    for (size_t i = 0; s && i < n; i++) {
+        size_t ti = (i / 16) / 4, tj = (i % 16) / 4;
+        double ref = (ti % 2 == 0 ? val(i, 7) : 0.0)
+                   + (tj % 2 == 0 ? val(i, 8) : 0.0);
+        double err = fabs(s[i] - ref);
+        if (err > max_err) max_err = err;
+    }
+    CHECK(s && max_err < 1e-12, "A+B values correct across sparse tiles");
+    free(s);
+
+    /* In-place with a structurally-zero result must clear existing tiles. */
+    write_2d("ew_t5_T.h5", dims, chunk, DTYPE_FP64, 9, keep_all);
+    const char *in2[2] = { "ew_t5_T.h5", "ew_t5_A.h5" };
+    CHECK(tensor_engine_elementwise(eng, "0 * A + B", in2, 2, "ew_t5_T.h5")
+          == TENSOR_ENGINE_OK, "in-place T = 0*T + A returns OK");
+    double *t = read_all("ew_t5_T.h5", DTYPE_FP64, n);
+    max_err = 0.0;
+    for (size_t i = 0; t && i < n; i++) {
+        size_t ti = (i / 16) / 4;
+        double err = fabs(t[i] - (ti % 2 == 0 ? val(i, 7) : 0.0));
+        if (err > max_err) max_err = err;
+    }
+    CHECK(t && max_err == 0.0, "stale tiles overwritten with zeros");
+    free(t);
+}
+
+/* ----------------------------------------------------------------------- */
+/* T6 — error paths                                                         */
+/* ----------------------------------------------------------------------- */
+static void t6_errors(tensor_engine_t *eng)
+{
+    printf("\n=== T6: error paths ===\n");
+    const hsize_t dims[2] = { 8, 8 }, c1[2] = { 4, 4 }, c2[2] = { 8, 2 };
+    write_2d("ew_t6_A.h5", dims, c1, DTYPE_FP64, 0, keep_all);
+    write_2d("ew_t6_B.h5", dims, c2, DTYPE_FP64, 1, keep_all);
+
+    const char *in[2] = { "ew_t6_A.h5", "ew_t6_B.h5" };
+    CHECK(tensor_engine_elementwise(eng, "A + B", in, 2, "ew_t6_C.h5")
+          == TENSOR_ENGINE_ERR_DIMS, "mismatched chunks → ERR_DIMS");
+    CHECK(tensor_engine_elementwise(eng, "A + * B", in, 2, "ew_t6_C.h5")
+          == TENSOR_ENGINE_ERR_EXPR, "bad syntax → ERR_EXPR");
+    CHECK(tensor_engine_elementwise(eng, "A + C", in, 2, "ew_t6_C.h5")
+          == TENSOR_ENGINE_ERR_EXPR, "operand beyond n_in → ERR_EXPR");
+}
+
+/* ----------------------------------------------------------------------- */
+/* T7 — in-place through the second same-file input                         */
+/* ----------------------------------------------------------------------- */
+static void t7_inplace_second(void)
+{
+    printf("\n=== T7: in-place T = R + T, R and T in one file ===\n");
+    const hsize_t dims[2] = { 20, 9 }, chunk[2] = { 6, 6 };
+    const size_t  n = 20 * 9;
+
+    write_2d("ew_t7_T.h5", dims, chunk, DTYPE_FP64, 4, keep_all);
+    write_2d("ew_t7_R.h5", dims, chunk, DTYPE_FP64, 5, keep_all);
+    hid_t src = H5Fopen("ew_t7_R.h5", H5F_ACC_RDONLY, H5P_DEFAULT);
+    hid_t dst = H5Fopen("ew_t7_T.h5", H5F_ACC_RDWR, H5P_DEFAULT);
+    herr_t cp = (src >= 0 && dst >= 0)
+                ? H5Ocopy(src, "tensor", dst, "R", H5P_DEFAULT, H5P_DEFAULT)
+                : -1;
+    if (dst >= 0) H5Fclose(dst);
+    if (src >= 0) H5Fclose(src);
+    CHECK(cp >= 0, "second dataset R copied into T's file");
+
+    double *t0 = read_all("ew_t7_T.h5", DTYPE_FP64, n);
+    const char *files[2] = { "ew_t7_T.h5", "ew_t7_T.h5" };
+    const char *names[2] = { "R", "tensor" };
+    CHECK(run_elementwise("A + B", files, names, 2, "ew_t7_T.h5", "tensor")
+          == 0, "output aliasing the second input runs in place");
+
+    double *t1 = read_all("ew_t7_T.h5", DTYPE_FP64, n);
+    double max_err = 0.0;
+    for (size_t i = 0; t0 && t1 && i < n; i++) {
+        double err = fabs(t1[i] - (val(i, 5) + t0[i]));
+        if (err > max_err) max_err = err;
+    }
+    CHECK(t0 && t1 && max_err < 1e-12, "T' == R + T");
+    free(t0);
+    free(t1);
+
+    const char *bad[2] = { "R", "R" };
+    CHECK(run_elementwise("A + B", files, bad, 2, "ew_t7_T.h5", "tensor")
+          == -1, "no input is the output dataset: still rejected");
+}
+
+/* ----------------------------------------------------------------------- */
+/* main                                                                      */
+/* ----------------------------------------------------------------------- */
+int main(void)
+{
+    printf("=== test_elementwise: tensor_engine_elementwise() ===\n");
+
+    tensor_engine_config_t cfg = {0};
+    tensor_engine_t *eng = tensor_engine_init(&cfg);
+    if (!eng) return 1;
+
+    t1_compile();
+    t2_axpy(eng);
+    t3_inplace(eng);
+    t4_complex(eng);
+    t5_sparsity(eng);
+    t6_errors(eng);
+    t7_inplace_second();
+
+    tensor_engine_free(eng);
+    printf("\n--- Results: %d passed, %d failed ---\n", g_pass, g_fail);
+    return (g_fail == 0) ? 0 : 1;
+}
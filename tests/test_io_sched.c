@@ -0,0 +1,370 @@
+/*
+ * tests/test_io_sched.c
+ *
+ * Correctness tests for the prioritized I/O scheduler (io_sched.c).
+ *
+ * Each ordering test parks the I/O thread on a "gate" request, queues
+ * requests behind it, then opens the gate and checks the service order.
+ *
+ * Seven test cases:
+ *   T1 – classes are served demand > prefetch > speculative > writeback
+ *   T2 – within a class, earliest deadline first; no deadline last
+ *   T3 – ios_wait on a queued writeback promotes it ahead of a prefetch
+ *   T4 – a submit beyond the class depth blocks until a slot frees
+ *   T5 – return codes propagate and late requests count as missed
+ *   T6 – contraction with TENSOR_IO_DEPTH=1,1,1,1 matches the default
+ *   T7 – a write-bandwidth cap and an IOPS cap throttle to their rate;
+ *        reads are untouched by the write cap
+ *
+ * T6 uses the prefix "ios_t6_" in the current working directory.
+ *
+ * Build: added to CMakeLists.txt as test_io_sched.
+ * Run:   ./build/test_io_sched
+ * Exit:  0 on success, 1 on any failure.
+ */
+
+#include "io_sched.h"
+#include "tensor_engine.h"
+#include "test_util.h"
+#include <hdf5.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* ----------------------------------------------------------------------- */
+/* Test infrastructure                                                       */
+/* ----------------------------------------------------------------------- */
+
+/* Explicit depths and limits, so an inherited TENSOR_IO_DEPTH or
+ * TENSOR_IO_*_MBPS cannot block or slow T1–T5. */
+static const int          k_unbounded[IOS_N_CLASSES] = {0, 0, 0, 0};
+static const ios_limits_t k_unlimited = {0.0, 0.0, 0.0, IOS_BG_NONE};
+
+/* Service log: each logging request appends its tag. */
+static int        g_log[64];
+static atomic_int g_n_log;
+
+static int log_fn(void *arg)
+{
+    g_log[atomic_fetch_add(&g_n_log, 1)] = (int)(intptr_t)arg;
+    return 0;
+}
+
+/* Gate: parks the I/O thread until opened. */
+static atomic_int g_gate_running, g_gate_open;
+
+static int gate_fn(void *arg)
+{
+    (void)arg;
+    atomic_store(&g_gate_running, 1);
+    while (!atomic_load(&g_gate_open)) usleep(100);
+    return 0;
+}
+
+static void gate_close(IOScheduler *s, ios_req_t *gate)
+{
+    memset(gate, 0, sizeof(*gate));
+    gate->fn  = gate_fn;
+    gate->cls = IOS_DEMAND;
+    atomic_store(&g_gate_running, 0);
+    atomic_store(&g_gate_open, 0);
+    atomic_store(&g_n_log, 0);
+    ios_submit(s, gate);
+    while (!atomic_load(&g_gate_running)) usleep(100);
+}
+
+static void req_init(ios_req_t *r, int tag, ios_class_t cls, uint64_t dl)
+{
+    memset(r, 0, sizeof(*r));
+    r->fn          = log_fn;
+    r->arg         = (void *)(intptr_t)tag;
+    r->cls         = cls;
+    r->deadline_ns = dl;
+}
+
+/* Open the gate and let n logging requests run without waiting on them
+ * (ios_wait would promote whatever it waits for). */
+static void gate_open_drain(int n)
+{
+    atomic_store(&g_gate_open, 1);
+    while (atomic_load(&g_n_log) < n) usleep(100);
+}
+
+static int log_is(const int *want, int n)
+{
+    if (atomic_load(&g_n_log) != n) return 0;
+    for (int i = 0; i < n; i++)
+        if (g_log[i] != want[i]) return 0;
+    return 1;
+}
+
+/* ----------------------------------------------------------------------- */
+/* T1 — class order                                                          */
+/* ----------------------------------------------------------------------- */
+static void t1_classes(void)
+{
+    printf("\n=== T1: class priority ===\n");
+    IOScheduler *s = ios_create(k_unbounded, &k_unlimited);
+    ios_req_t gate, r[4];
+    gate_close(s, &gate);
+    req_init(&r[0], IOS_WRITEBACK,   IOS_WRITEBACK,   0);
+    req_init(&r[1], IOS_SPECULATIVE, IOS_SPECULATIVE, 0);
+    req_init(&r[2], IOS_PREFETCH,    IOS_PREFETCH,    0);
+    req_init(&r[3], IOS_DEMAND,      IOS_DEMAND,      0);
+    for (int i = 0; i < 4; i++) ios_submit(s, &r[i]);
+    gate_open_drain(4);
+    for (int i = 0; i < 4; i++) ios_wait(s, &r[i]);
+    ios_wait(s, &gate);
+    const int want[4] = {IOS_DEMAND, IOS_PREFETCH, IOS_SPECULATIVE,
+                         IOS_WRITEBACK};
+    CHECK(log_is(want, 4), "submitted W,S,P,D — served D,P,S,W");
+    CHECK(ios_stats(s, IOS_WRITEBACK).n == 1 &&
+          ios_stats(s, IOS_DEMAND).n == 2, "per-class request counts");
+    ios_destroy(s);
+}
+
+/* ----------------------------------------------------------------------- */
+/* T2 — EDF within a class                                                   */
+/* ----------------------------------------------------------------------- */
+static void t2_edf(void)
+{
+    printf("\n=== T2: earliest deadline first ===\n");
+    IOScheduler *s = ios_create(k_unbounded, &k_unlimited);
+    uint64_t far = ios_now_ns() + 60ull * 1000000000ull;
+    ios_req_t gate, r[4];
+    gate_close(s, &gate);
+    req_init(&r[0], 0, IOS_WRITEBACK, 0);          /* no deadline */
+    req_init(&r[1], 3, IOS_WRITEBACK, far + 300);
+    req_init(&r[2], 1, IOS_WRITEBACK, far + 100);
+    req_init(&r[3], 2, IOS_WRITEBACK, far + 200);
+    for (int i = 0; i < 4; i++) ios_submit(s, &r[i]);
+    gate_open_drain(4);
+    for (int i = 0; i < 4; i++) ios_wait(s, &r[i]);
+    const int want[4] = {1, 2, 3, 0};
+    CHECK(log_is(want, 4), "deadlines 300,100,200,none — served 100,200,300,none");
+    CHECK(ios_stats(s, IOS_WRITEBACK).n_missed == 0, "no deadline missed");
+    ios_destroy(s);
+}
+
+/* ----------------------------------------------------------------------- */
+/* T3 — promotion on wait                                                    */
+/* ----------------------------------------------------------------------- */
+typedef struct { IOScheduler *s; ios_req_t *r; int rc; } Waiter;
+
+static void *waiter_main(void *arg)
+{
+    Waiter *w = (Waiter *)arg;
+    w->rc = ios_wait(w->s, w->r);
+    return NULL;
+}
+
+static void t3_promotion(void)
+{
+    printf("\n=== T3: waiting promotes a queued writeback ===\n");
+    IOScheduler *s = ios_create(k_unbounded, &k_unlimited);
+    ios_req_t gate, wb, pf;
+    gate_close(s, &gate);
+    req_init(&wb, IOS_WRITEBACK, IOS_WRITEBACK, 0);
+    req_init(&pf, IOS_PREFETCH,  IOS_PREFETCH,  0);
+    ios_submit(s, &wb);
+    ios_submit(s, &pf);
+
+    Waiter    w = {s, &wb, -1};
+    pthread_t th;
+    pthread_create(&th, NULL, waiter_main, &w);
+    for (int promoted = 0; !promoted; usleep(100)) {
+        pthread_mutex_lock(&s->mu);
+        promoted = wb.promoted;
+        pthread_mutex_unlock(&s->mu);
+    }
+    atomic_store(&g_gate_open, 1);
+    pthread_join(th, NULL);
+    ios_wait(s, &pf);
+    const int want[2] = {IOS_WRITEBACK, IOS_PREFETCH};
+    CHECK(w.rc == 0, "waiter returned the request's rc");
+    CHECK(log_is(want, 2), "promoted writeback served before prefetch");
+    CHECK(ios_stats(s, IOS_WRITEBACK).n_promoted == 1 &&
+          ios_stats(s, IOS_PREFETCH).n_promoted == 0,
+          "promotion charged to the writeback class");
+    ios_destroy(s);
+}
+
+/* ----------------------------------------------------------------------- */
+/* T4 — queue depth                                                          */
+/* ----------------------------------------------------------------------- */
+typedef struct { IOScheduler *s; ios_req_t *r; } Submitter;
+
+static void *submitter_main(void *arg)
+{
+    Submitter *u = (Submitter *)arg;
+    ios_submit(u->s, u->r);
+    return NULL;
+}
+
+static void t4_depth(void)
+{
+    printf("\n=== T4: per-class depth limit ===\n");
+    IOScheduler *s = ios_create((const int[IOS_N_CLASSES]){0, 0, 0, 1},
+                                &k_unlimited);
+    ios_req_t gate, w1, w2;
+    gate_close(s, &gate);
+    req_init(&w1, 1, IOS_WRITEBACK, 0);
+    req_init(&w2, 2, IOS_WRITEBACK, 0);
+    ios_submit(s, &w1);
+
+    Submitter u = {s, &w2};
+    pthread_t th;
+    pthread_create(&th, NULL, submitter_main, &u);
+    while (ios_stats(s, IOS_WRITEBACK).n_blocked == 0) usleep(100);
+    CHECK(1, "second writeback blocked at depth 1");
+    atomic_store(&g_gate_open, 1);
+    pthread_join(th, NULL);
+    ios_wait(s, &w1);
+    ios_wait(s, &w2);
+    const int want[2] = {1, 2};
+    CHECK(log_is(want, 2), "both served in order once a slot freed");
+    ios_destroy(s);
+}
+
+/* ----------------------------------------------------------------------- */
+/* T5 — return codes and missed deadlines                                    */
+/* ----------------------------------------------------------------------- */
+static int fail_fn(void *arg)
+{
+    (void)arg;
+    usleep(2000);
+    return -1;
+}
+
+static void t5_rc_deadline(void)
+{
+    printf("\n=== T5: rc propagation and deadline misses ===\n");
+    IOScheduler *s = ios_create(k_unbounded, &k_unlimited);
+    ios_req_t r;
+    memset(&r, 0, sizeof(r));
+    r.fn          = fail_fn;
+    r.cls         = IOS_PREFETCH;
+    r.deadline_ns = ios_now_ns() + 1000;           /* 1 µs: certain miss */
+    CHECK(ios_run(s, &r) == -1, "ios_run returns fn's error");
+    ios_stats_t st = ios_stats(s, IOS_PREFETCH);
+    CHECK(st.n == 1 && st.n_missed == 1 && st.n_promoted == 0,
+          "late request counted as missed, not promoted by ios_run");
+    CHECK(st.max_latency_s >= 0.002, "latency includes service time");
+    ios_destroy(s);
+}
+
+/* ----------------------------------------------------------------------- */
+/* T6 — engine with minimal depths                                           */
+/* ----------------------------------------------------------------------- */
+
+static void t6_engine(tensor_engine_t *eng)
+{
+    printf("\n=== T6: TENSOR_IO_DEPTH=1,1,1,1 matches default ===\n");
+    const size_t shA[4] = {9, 8, 7, 6}, shB[4] = {7, 5, 6, 4};
+    CHECK(tensor_engine_create(eng, "ios_t6_A.h5", 4, shA,
+                               TENSOR_DTYPE_FP64) == TENSOR_ENGINE_OK &&
+          tensor_engine_create(eng, "ios_t6_B.h5", 4, shB,
+                               TENSOR_DTYPE_FP64) == TENSOR_ENGINE_OK,
+          "create A, B");
+    CHECK(tensor_engine_fill_random(eng, "ios_t6_A.h5", 5) == TENSOR_ENGINE_OK &&
+          tensor_engine_fill_random(eng, "ios_t6_B.h5", 6) == TENSOR_ENGINE_OK,
+          "fill_random A, B");
+    CHECK(tensor_engine_contract(eng, "ijab,akbl->klji", "ios_t6_A.h5",
+                                 "ios_t6_B.h5", "ios_t6_C1.h5")
+              == TENSOR_ENGINE_OK,
+          "contract (default depths)");
+    setenv("TENSOR_IO_DEPTH", "1,1,1,1", 1);
+    CHECK(tensor_engine_contract(eng, "ijab,akbl->klji", "ios_t6_A.h5",
+                                 "ios_t6_B.h5", "ios_t6_C2.h5")
+              == TENSOR_ENGINE_OK,
+          "contract (TENSOR_IO_DEPTH=1,1,1,1)");
+    unsetenv("TENSOR_IO_DEPTH");
+
+    size_t n1, n2;
+    double *c1 = read_raw("ios_t6_C1.h5", &n1);
+    double *c2 = read_raw("ios_t6_C2.h5", &n2);
+    CHECK(c1 && c2 && n1 == n2 && n1 > 0 &&
+          memcmp(c1, c2, n1 * sizeof(double)) == 0,
+          "results identical bit for bit");
+    free(c1);
+    free(c2);
+}
+
+/* ----------------------------------------------------------------------- */
+/* T7 — bandwidth and IOPS caps                                              */
+/* ----------------------------------------------------------------------- */
+static int noop_fn(void *arg)
+{
+    (void)arg;
+    return 0;
+}
+
+/* Run n requests of the given size back to back; returns elapsed seconds. */
+static double run_n(IOScheduler *s, int n, size_t bytes, int write)
+{
+    ios_req_t r;
+    uint64_t  t0 = ios_now_ns();
+    for (int i = 0; i < n; i++) {
+        memset(&r, 0, sizeof(r));
+        r.fn    = noop_fn;
+        r.cls   = IOS_WRITEBACK;
+        r.bytes = bytes;
+        r.write = write;
+        ios_run(s, &r);
+    }
+    return (double)(ios_now_ns() - t0) * 1e-9;
+}
+
+static void t7_caps(void)
+{
+    printf("\n=== T7: bandwidth and IOPS caps ===\n");
+    const size_t MiB = 1048576;
+
+    /* 20 MiB/s write cap, 2 MiB of burst credit: 8 × 1 MiB must wait off
+     * at least 5 MiB of debt before the last one starts (0.25 s). */
+    ios_limits_t lim = {0.0, 20.0 * MiB, 0.0, IOS_BG_NONE};
+    IOScheduler *s = ios_create(k_unbounded, &lim);
+    double t_w = run_n(s, 8, MiB, 1);
+    ios_stats_t st = ios_stats(s, IOS_WRITEBACK);
+    CHECK(t_w >= 0.2, "write cap: 8 MiB at 20 MiB/s takes ≥ 0.2 s");
+    CHECK(st.throttle_s >= 0.2 && st.bytes == 8 * MiB,
+          "throttle time and charged bytes recorded");
+    double t_r = run_n(s, 8, MiB, 0);
+    CHECK(t_r < 0.1, "reads are not charged to the write bucket");
+    ios_destroy(s);
+
+    /* 100 IOPS, 10 ops of burst: 30 ops wait off 19 ops (0.19 s). */
+    lim = (ios_limits_t){0.0, 0.0, 100.0, IOS_BG_NONE};
+    s = ios_create(k_unbounded, &lim);
+    double t_o = run_n(s, 30, 0, 0);
+    CHECK(t_o >= 0.15 && t_o < 2.0, "IOPS cap: 30 ops at 100/s takes ≈ 0.2 s");
+    ios_destroy(s);
+}
+
+/* ----------------------------------------------------------------------- */
+/* main                                                                      */
+/* ----------------------------------------------------------------------- */
+int main(void)
+{
+    printf("=== test_io_sched: prioritized I/O scheduler ===\n");
+    H5Eset_auto2(H5E_DEFAULT, NULL, NULL);
+
+    t1_classes();
+    t2_edf();
+    t3_promotion();
+    t4_depth();
+    t5_rc_deadline();
+    t7_caps();
+
+    tensor_engine_config_t cfg = {.tile_bytes = 16UL * 1024};
+    tensor_engine_t *eng = tensor_engine_init(&cfg);
+    if (!eng) { printf("FAIL: engine init\n"); return 1; }
+    t6_engine(eng);
+    tensor_engine_free(eng);
+
+    printf("\n--- Results: %d passed, %d failed ---\n", g_pass, g_fail);
+    return (g_fail == 0) ? 0 : 1;
+}
@@ -0,0 +1,259 @@
+/*
+ * tests/test_job_server.c
+ *
+ * Correctness tests for the contraction service (job_server.c).  The
+ * server runs on a thread of this process; clients connect over the
+ * socket from other threads.
+ *
+ * Six test cases:
+ *   T1 – status on an idle server; malformed requests are rejected; the
+ *        socket is private to the owner
+ *   T2 – two concurrent clients' contractions both run and match a
+ *        direct tensor_engine_contract bit for bit
+ *   T3 – elementwise and verify jobs; a failing job reports its error
+ *   T4 – the shared B cache stays attached between jobs
+ *   T5 – shutdown drains, removes the socket and the kept B cache
+ *   T6 – an engine kept warm (as the server's is) matches a cold one when
+ *        consecutive contractions differ in shape
+ *
+ * Files use the prefix "jsrv_" in the current working directory.
+ *
+ * Build: added to CMakeLists.txt as test_job_server.
+ * Run:   ./build/test_job_server
+ * Exit:  0 on success, 1 on any failure.
+ */
+
+#include "job_server.h"
+#include "tensor_engine.h"
+#include "test_util.h"
+#include <dirent.h>
+#include <hdf5.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* ----------------------------------------------------------------------- */
+/* Test infrastructure                                                       */
+/* ----------------------------------------------------------------------- */
+
+#define SOCK "jsrv_test.sock"
+#define EXPR "ijab,akbl->klji"
+
+static int g_serve_rc = -1;
+
+static void *server_main(void *arg)
+{
+    g_serve_rc = jsrv_serve(SOCK, (const jsrv_config_t *)arg);
+    return NULL;
+}
+
+/* Shared B cache segments currently in /dev/shm (Linux); -1 if unknown. */
+static int count_segments(void)
+{
+    DIR *d = opendir("/dev/shm");
+    if (!d) return -1;
+    int n = 0;
+    struct dirent *e;
+    while ((e = readdir(d)))
+        if (strncmp(e->d_name, "oc_tiles_", 9) == 0) n++;
+    closedir(d);
+    return n;
+}
+
+/* ----------------------------------------------------------------------- */
+/* T1 — status and rejects                                                   */
+/* ----------------------------------------------------------------------- */
+static void t1_status(void)
+{
+    printf("\n=== T1: status and malformed requests ===\n");
+    jsrv_reply_t rep;
+    CHECK(jsrv_call(SOCK, JSRV_OP_STATUS, NULL, 0, &rep) == 0 &&
+          rep.status == JSRV_DONE && rep.jobs_done == 0 && rep.queued == 0,
+          "idle server: 0 jobs done, 0 queued");
+
+    const char *two[] = {EXPR, "jsrv_A.h5"};
+    CHECK(jsrv_call(SOCK, JSRV_OP_CONTRACT, two, 2, &rep) == 0 &&
+          rep.status == JSRV_BAD_REQUEST,
+          "contract with two arguments is a bad request");
+    CHECK(jsrv_call(SOCK, 99, NULL, 0, &rep) == 0 &&
+          rep.status == JSRV_BAD_REQUEST, "unknown op is a bad request");
+
+    struct stat sb;
+    CHECK(stat(SOCK, &sb) == 0 && (sb.st_mode & 0777) == 0600,
+          "socket mode is 0600");
+}
+
+/* ----------------------------------------------------------------------- */
+/* T2 — concurrent clients                                                   */
+/* ----------------------------------------------------------------------- */
+typedef struct {
+    const char  *out;
+    int          call_rc;
+    jsrv_reply_t rep;
+} client_t;
+
+static void *client_main(void *arg)
+{
+    client_t   *c      = (client_t *)arg;
+    const char *args[] = {EXPR, "jsrv_A.h5", "jsrv_B.h5", c->out};
+    c->call_rc = jsrv_call(SOCK, JSRV_OP_CONTRACT, args, 4, &c->rep);
+    return NULL;
+}
+
+static void t2_concurrent(void)
+{
+    printf("\n=== T2: concurrent contractions ===\n");
+    client_t  c[2] = {{.out = "jsrv_C1.h5"}, {.out = "jsrv_C2.h5"}};
+    pthread_t t[2];
+    for (int k = 0; k < 2; k++) pthread_create(&t[k], NULL, client_main, &c[k]);
+    for (int k = 0; k < 2; k++) pthread_join(t[k], NULL);
+
+    CHECK(c[0].call_rc == 0 && c[1].call_rc == 0 &&
+          c[0].rep.status == JSRV_DONE && c[1].rep.status == JSRV_DONE,
+          "both clients got replies");
+    CHECK(c[0].rep.rc == TENSOR_ENGINE_OK && c[1].rep.rc == TENSOR_ENGINE_OK,
+          "both contractions succeeded");
+    CHECK(same_file_data("jsrv_C0.h5", "jsrv_C1.h5") &&
+          same_file_data("jsrv_C0.h5", "jsrv_C2.h5"),
+          "results identical to the direct contraction");
+}
+
+/* ----------------------------------------------------------------------- */
+/* T3 — elementwise, verify, failure                                         */
+/* ----------------------------------------------------------------------- */
+static void t3_other_jobs(void)
+{
+    printf("\n=== T3: elementwise, verify and a failing job ===\n");
+    jsrv_reply_t rep;
+    const char *ew[] = {"2 * A - B", "jsrv_D.h5", "jsrv_C1.h5", "jsrv_C2.h5"};
+    CHECK(jsrv_call(SOCK, JSRV_OP_ELEMENTWISE, ew, 4, &rep) == 0 &&
+          rep.status == JSRV_DONE && rep.rc == TENSOR_ENGINE_OK &&
+          same_file_data("jsrv_D.h5", "jsrv_C0.h5"),
+          "elementwise 2*C1 - C2 equals C");
+
+    const char *vf[] = {EXPR, "jsrv_A.h5", "jsrv_B.h5", "jsrv_C1.h5"};
+    CHECK(jsrv_call(SOCK, JSRV_OP_VERIFY, vf, 4, &rep) == 0 &&
+          rep.rc == TENSOR_ENGINE_OK && rep.max_rel_err < 1e-12,
+          "verify passes with a tiny error");
+
+    const char *bad[] = {EXPR, "jsrv_A.h5", "jsrv_missing.h5", "jsrv_X.h5"};
+    CHECK(jsrv_call(SOCK, JSRV_OP_CONTRACT, bad, 4, &rep) == 0 &&
+          rep.status == JSRV_DONE && rep.rc != TENSOR_ENGINE_OK,
+          "a missing operand fails the job, not the server");
+
+    CHECK(jsrv_call(SOCK, JSRV_OP_STATUS, NULL, 0, &rep) == 0 &&
+          rep.jobs_done == 5, "five jobs counted");
+}
+
+/* ----------------------------------------------------------------------- */
+/* T4 / T5 — warm B cache, shutdown                                          */
+/* ----------------------------------------------------------------------- */
+static void t4_warm_cache(int before)
+{
+    printf("\n=== T4: B cache kept between jobs ===\n");
+    int now = count_segments();
+    if (now < 0) {
+        printf("  (no /dev/shm; skipped)\n");
+        return;
+    }
+    CHECK(now == before + 1, "one B cache segment still attached");
+}
+
+static void t5_shutdown(pthread_t srv, int before)
+{
+    printf("\n=== T5: shutdown ===\n");
+    jsrv_reply_t rep;
+    CHECK(jsrv_call(SOCK, JSRV_OP_SHUTDOWN, NULL, 0, &rep) == 0 &&
+          rep.status == JSRV_DONE, "shutdown acknowledged");
+    pthread_join(srv, NULL);
+    struct stat sb;
+    CHECK(g_serve_rc == 0 && stat(SOCK, &sb) != 0,
+          "server returned 0 and removed its socket");
+    if (before >= 0)
+        CHECK(count_segments() == before, "kept B cache released");
+}
+
+/* ----------------------------------------------------------------------- */
+/* T6 — warm executor state across shapes                                    */
+/* ----------------------------------------------------------------------- */
+static void t6_keep_warm(void)
+{
+    printf("\n=== T6: warm engine across shapes ===\n");
+    const size_t shA[4] = {11, 10, 9, 7}, shB[4] = {9, 6, 7, 5};
+    tensor_engine_config_t ecfg = {.tile_bytes = 16UL * 1024};
+    tensor_engine_t *cold = tensor_engine_init(&ecfg);
+    ecfg.keep_warm = 1;
+    tensor_engine_t *warm = tensor_engine_init(&ecfg);
+    int ok = cold && warm &&
+        tensor_engine_create(cold, "jsrv_A2.h5", 4, shA,
+                             TENSOR_DTYPE_COMPLEX128) == TENSOR_ENGINE_OK &&
+        tensor_engine_create(cold, "jsrv_B2.h5", 4, shB,
+                             TENSOR_DTYPE_COMPLEX128) == TENSOR_ENGINE_OK &&
+        tensor_engine_fill_random(cold, "jsrv_A2.h5", 7) == TENSOR_ENGINE_OK &&
+        tensor_engine_fill_random(cold, "jsrv_B2.h5", 8) == TENSOR_ENGINE_OK &&
+        tensor_engine_contract(cold, EXPR, "jsrv_A2.h5", "jsrv_B2.h5",
+                               "jsrv_E0.h5") == TENSOR_ENGINE_OK;
+    CHECK(ok, "setup");
+    CHECK(ok && tensor_engine_contract(warm, EXPR, "jsrv_A2.h5", "jsrv_B2.h5",
+                                       "jsrv_E1.h5") == TENSOR_ENGINE_OK &&
+          same_file_data("jsrv_E0.h5", "jsrv_E1.h5"),
+          "first warm run matches the cold engine");
+    CHECK(ok && tensor_engine_contract(warm, EXPR, "jsrv_A.h5", "jsrv_B.h5",
+                                       "jsrv_E2.h5") == TENSOR_ENGINE_OK &&
+          same_file_data("jsrv_C0.h5", "jsrv_E2.h5"),
+          "smaller shape on the kept buffers matches");
+    CHECK(ok && tensor_engine_accumulate(warm, EXPR, "jsrv_A2.h5",
+                                         "jsrv_B2.h5",
+                                         "jsrv_E1.h5") == TENSOR_ENGINE_OK &&
+          tensor_engine_elementwise(cold, "A + A",
+                                    (const char *[]){"jsrv_E0.h5"}, 1,
+                                    "jsrv_E3.h5") == TENSOR_ENGINE_OK &&
+          rel_diff("jsrv_E1.h5", "jsrv_E3.h5") < 1e-12,
+          "accumulate on the kept buffers doubles C");
+    tensor_engine_free(warm);
+    tensor_engine_free(cold);
+}
+
+/* ----------------------------------------------------------------------- */
+/* main                                                                      */
+/* ----------------------------------------------------------------------- */
+int main(void)
+{
+    printf("=== test_job_server: contraction service ===\n");
+    H5Eset_auto2(H5E_DEFAULT, NULL, NULL);
+
+    const size_t shA[4] = {9, 8, 7, 6}, shB[4] = {7, 5, 6, 4};
+    tensor_engine_config_t ecfg = {.tile_bytes = 16UL * 1024};
+    tensor_engine_t *eng = tensor_engine_init(&ecfg);
+    int ok = eng &&
+        tensor_engine_create(eng, "jsrv_A.h5", 4, shA,
+                             TENSOR_DTYPE_COMPLEX128) == TENSOR_ENGINE_OK &&
+        tensor_engine_create(eng, "jsrv_B.h5", 4, shB,
+                             TENSOR_DTYPE_COMPLEX128) == TENSOR_ENGINE_OK &&
+        tensor_engine_fill_random(eng, "jsrv_A.h5", 5) == TENSOR_ENGINE_OK &&
+        tensor_engine_fill_random(eng, "jsrv_B.h5", 6) == TENSOR_ENGINE_OK &&
+        tensor_engine_contract(eng, EXPR, "jsrv_A.h5", "jsrv_B.h5",
+                               "jsrv_C0.h5") == TENSOR_ENGINE_OK;
+    tensor_engine_free(eng);
+    if (!ok) { printf("FAIL: setup\n"); return 1; }
+
+    int before = count_segments();
+    jsrv_config_t cfg = {.tile_bytes = 16UL * 1024, .cache_mb = 16};
+    pthread_t srv;
+    pthread_create(&srv, NULL, server_main, &cfg);
+    struct stat sb;
+    for (int i = 0; i < 500 && stat(SOCK, &sb) != 0; i++) usleep(10000);
+
+    t1_status();
+    t2_concurrent();
+    t3_other_jobs();
+    t4_warm_cache(before);
+    t5_shutdown(srv, before);
+    t6_keep_warm();
+
+    printf("\n--- Results: %d passed, %d failed ---\n", g_pass, g_fail);
+    return (g_fail == 0) ? 0 : 1;
+}
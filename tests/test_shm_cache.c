@@ -0,0 +1,273 @@
+/*
+ * tests/test_shm_cache.c
+ *
+ * Correctness tests for the node-local shared-memory tile cache
+ * (shm_cache.c).  Cross-process cases fork children that attach to the
+ * same segment.
+ *
+ * Five test cases:
+ *   T1 – first lookup fills, later lookups hit; a failed fill is not
+ *        cached; another dataset or tiling of the file gets its own
+ *        segment
+ *   T2 – a tile filled by one process is served to another, both ways
+ *   T3 – a tile whose loader died mid-fill is taken over by a waiter;
+ *        tiles beyond the slot budget are not cached
+ *   T4 – the last live process to detach unlinks the segment, even when
+ *        another attached process died without detaching
+ *   T5 – two concurrent contractions sharing TENSOR_SHM_CACHE_MB match a
+ *        contraction without it
+ *
+ * Files use the prefix "shmc_" in the current working directory.
+ *
+ * Build: added to CMakeLists.txt as test_shm_cache.
+ * Run:   ./build/test_shm_cache
+ * Exit:  0 on success, 1 on any failure.
+ */
+
+#include "shm_cache.h"
+#include "tensor_engine.h"
+#include "test_util.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <hdf5.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/* ----------------------------------------------------------------------- */
+/* Test infrastructure                                                       */
+/* ----------------------------------------------------------------------- */
+
+#define TILE  4096
+#define KEYF  "shmc_key.bin"
+
+/* Tile contents: a byte pattern derived from idx. */
+static void fill_tile(void *p, uint64_t idx)
+{
+    memset(p, (int)(0x40 + idx), TILE);
+}
+
+static int tile_is(const void *p, uint64_t idx)
+{
+    const unsigned char *b = (const unsigned char *)p;
+    for (size_t i = 0; i < TILE; i++)
+        if (b[i] != (unsigned char)(0x40 + idx)) return 0;
+    return 1;
+}
+
+/* Run fn in a child process; returns its exit status (0 = success). */
+static int in_child(int (*fn)(void))
+{
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) _exit(fn());
+    int st = 0;
+    waitpid(pid, &st, 0);
+    return WIFEXITED(st) ? WEXITSTATUS(st) : 99;
+}
+
+/* Segment for KEYF: 4 slots of TILE bytes, 8 tiles in the "file". */
+static const size_t g_chunk[1] = {TILE / 8};
+
+static ShmTileCache *attach4(void)
+{
+    return shmc_attach(KEYF, "tensor", 1, g_chunk, TILE, 8, 4 * 16384);
+}
+
+/* ----------------------------------------------------------------------- */
+/* T1 — fill, hit, budget                                                    */
+/* ----------------------------------------------------------------------- */
+static void t1_fill_hit(ShmTileCache *c)
+{
+    printf("\n=== T1: fill then hit ===\n");
+    void *p = NULL;
+    CHECK(shmc_slots(c) == 4, "four slots");
+    int r = shmc_lookup(c, 0, &p);
+    CHECK(r == SHMC_FILL && p, "first lookup of tile 0 fills");
+    if (r == SHMC_FILL) { fill_tile(p, 0); shmc_publish(c, 0, 1); }
+    r = shmc_lookup(c, 0, &p);
+    CHECK(r == SHMC_HIT && tile_is(p, 0), "second lookup hits");
+    r = shmc_lookup(c, 5, &p);
+    if (r == SHMC_FILL) shmc_publish(c, 5, 0);           /* failed read */
+    CHECK(shmc_lookup(c, 5, &p) == SHMC_MISS && !p,
+          "a failed fill leaves the tile uncached");
+    CHECK(shmc_slots_used(c) == 2, "two slots used");
+
+    /* Same file, other dataset or tile shape: separate, empty segments. */
+    const size_t  half[1] = {TILE / 16};
+    ShmTileCache *d = shmc_attach(KEYF, "other", 1, g_chunk, TILE, 8, 16384);
+    ShmTileCache *t = shmc_attach(KEYF, "tensor", 1, half, TILE, 8, 16384);
+    CHECK(d && t && strcmp(d->name, c->name) != 0 &&
+          strcmp(t->name, c->name) != 0 && strcmp(d->name, t->name) != 0 &&
+          shmc_slots_used(d) == 0 && shmc_slots_used(t) == 0,
+          "another dataset or tiling gets its own segment");
+    shmc_detach(d);
+    shmc_detach(t);
+}
+
+/* ----------------------------------------------------------------------- */
+/* T2 — cross-process sharing                                                */
+/* ----------------------------------------------------------------------- */
+static int child_t2(void)
+{
+    ShmTileCache *c = attach4();
+    if (!c) return 1;
+    void *p = NULL;
+    int ok = shmc_lookup(c, 0, &p) == SHMC_HIT && tile_is(p, 0);
+    if (shmc_lookup(c, 1, &p) == SHMC_FILL) {
+        fill_tile(p, 1);
+        shmc_publish(c, 1, 1);
+    } else {
+        ok = 0;
+    }
+    shmc_detach(c);
+    return ok ? 0 : 2;
+}
+
+static void t2_cross_process(ShmTileCache *c)
+{
+    printf("\n=== T2: sharing across processes ===\n");
+    CHECK(in_child(child_t2) == 0,
+          "child hits the parent's tile 0 and fills tile 1");
+    void *p = NULL;
+    CHECK(shmc_lookup(c, 1, &p) == SHMC_HIT && tile_is(p, 1),
+          "parent hits the child's tile 1");
+}
+
+/* ----------------------------------------------------------------------- */
+/* T3 — loader dies mid-fill                                                 */
+/* ----------------------------------------------------------------------- */
+static int child_t3(void)
+{
+    ShmTileCache *c = attach4();
+    void *p = NULL;
+    if (!c || shmc_lookup(c, 2, &p) != SHMC_FILL) return 1;
+    memset(p, 0xee, TILE);                     /* half-written, then dies */
+    return 0;                                  /* no publish, no detach  */
+}
+
+static void t3_dead_loader(ShmTileCache *c)
+{
+    printf("\n=== T3: takeover from a dead loader ===\n");
+    CHECK(in_child(child_t3) == 0, "child claimed tile 2 and exited");
+    void *p = NULL;
+    int r = shmc_lookup(c, 2, &p);
+    CHECK(r == SHMC_FILL, "waiter takes the orphaned fill over");
+    if (r == SHMC_FILL) { fill_tile(p, 2); shmc_publish(c, 2, 1); }
+    CHECK(shmc_lookup(c, 2, &p) == SHMC_HIT && tile_is(p, 2),
+          "tile 2 served after takeover");
+    CHECK(shmc_slots_used(c) == 4 && shmc_lookup(c, 7, &p) == SHMC_MISS,
+          "tiles beyond the slot budget are not cached");
+}
+
+/* ----------------------------------------------------------------------- */
+/* T4 — unlink on last detach                                                */
+/* ----------------------------------------------------------------------- */
+static void t4_unlink(ShmTileCache *c)
+{
+    printf("\n=== T4: last detach unlinks ===\n");
+    char name[32];
+    snprintf(name, sizeof(name), "%s", c->name);
+    int fd = shm_open(name, O_RDONLY, 0);
+    CHECK(fd >= 0, "segment exists while attached");
+    if (fd >= 0) close(fd);
+    shmc_detach(c);                 /* T3's child died still attached */
+    fd = shm_open(name, O_RDONLY, 0);
+    CHECK(fd < 0 && errno == ENOENT, "segment gone after last detach");
+    if (fd >= 0) close(fd);
+}
+
+/* ----------------------------------------------------------------------- */
+/* T5 — concurrent contractions through the cache                            */
+/* ----------------------------------------------------------------------- */
+
+static int contract_to(const char *out)
+{
+    tensor_engine_config_t cfg = {.tile_bytes = 16UL * 1024};
+    tensor_engine_t *eng = tensor_engine_init(&cfg);
+    if (!eng) return 1;
+    int rc = tensor_engine_contract(eng, "ijab,akbl->klji", "shmc_A.h5",
+                                    "shmc_B.h5", out);
+    tensor_engine_free(eng);
+    return rc == TENSOR_ENGINE_OK ? 0 : 1;
+}
+
+static void t5_engine(void)
+{
+    printf("\n=== T5: concurrent contractions share B ===\n");
+    const size_t shA[4] = {9, 8, 7, 6}, shB[4] = {7, 5, 6, 4};
+    tensor_engine_config_t cfg = {.tile_bytes = 16UL * 1024};
+    tensor_engine_t *eng = tensor_engine_init(&cfg);
+    CHECK(eng &&
+          tensor_engine_create(eng, "shmc_A.h5", 4, shA,
+                               TENSOR_DTYPE_COMPLEX128) == TENSOR_ENGINE_OK &&
+          tensor_engine_create(eng, "shmc_B.h5", 4, shB,
+                               TENSOR_DTYPE_COMPLEX128) == TENSOR_ENGINE_OK &&
+          tensor_engine_fill_random(eng, "shmc_A.h5", 3) == TENSOR_ENGINE_OK &&
+          tensor_engine_fill_random(eng, "shmc_B.h5", 4) == TENSOR_ENGINE_OK,
+          "create and fill A, B");
+    tensor_engine_free(eng);
+    CHECK(contract_to("shmc_C0.h5") == 0, "contract without the cache");
+
+    setenv("TENSOR_SHM_CACHE_MB", "16", 1);
+    fflush(stdout);
+    pid_t kid[2];
+    for (int k = 0; k < 2; k++) {
+        kid[k] = fork();
+        if (kid[k] == 0) {
+            int rc = contract_to(k ? "shmc_C2.h5" : "shmc_C1.h5");
+            fflush(stdout);
+            _exit(rc);
+        }
+    }
+    int ok = 1;
+    for (int k = 0; k < 2; k++) {
+        int st = 0;
+        waitpid(kid[k], &st, 0);
+        ok &= WIFEXITED(st) && WEXITSTATUS(st) == 0;
+    }
+    unsetenv("TENSOR_SHM_CACHE_MB");
+    CHECK(ok, "two concurrent cached contractions succeed");
+
+    size_t n0, n1, n2;
+    double *c0 = read_raw("shmc_C0.h5", &n0);
+    double *c1 = read_raw("shmc_C1.h5", &n1);
+    double *c2 = read_raw("shmc_C2.h5", &n2);
+    CHECK(c0 && c1 && c2 && n0 > 0 && n0 == n1 && n0 == n2 &&
+          memcmp(c0, c1, n0 * sizeof(double)) == 0 &&
+          memcmp(c0, c2, n0 * sizeof(double)) == 0,
+          "results identical bit for bit");
+    free(c0);
+    free(c1);
+    free(c2);
+}
+
+/* ----------------------------------------------------------------------- */
+/* main                                                                      */
+/* ----------------------------------------------------------------------- */
+int main(void)
+{
+    printf("=== test_shm_cache: node-local shared tile cache ===\n");
+    H5Eset_auto2(H5E_DEFAULT, NULL, NULL);
+
+    FILE *f = fopen(KEYF, "wb");
+    if (!f) { printf("FAIL: create %s\n", KEYF); return 1; }
+    fputs("tile cache key file\n", f);
+    fclose(f);
+
+    ShmTileCache *c = attach4();
+    if (!c) { printf("FAIL: shmc_attach\n"); return 1; }
+    t1_fill_hit(c);
+    t2_cross_process(c);
+    t3_dead_loader(c);
+    t4_unlink(c);
+    remove(KEYF);
+
+    t5_engine();
+
+    printf("\n--- Results: %d passed, %d failed ---\n", g_pass, g_fail);
+    return (g_fail == 0) ? 0 : 1;
+}
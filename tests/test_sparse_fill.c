@@ -0,0 +1,312 @@
+/*
+ * tests/test_sparse_fill.c
+ *
+ * Correctness tests for tensor_engine_fill_sparse() and sparse_pattern.c.
+ *
+ * Six test cases:
+ *   T1 – random: allocated tiles == selected tiles, density close to target
+ *   T2 – banded rank-3: allocated tiles match brute-force band count
+ *   T3 – block-diagonal: exactly the diagonal blocks are allocated
+ *   T4 – symmetric rank-3: T[i,j,k] == T[j,k,i] == T[k,j,i], sparse pattern
+ *   T5 – sparse A × banded B via contract matches a dense in-memory product
+ *   T6 – error paths: symmetric on a non-cubic tensor, bad density
+ *
+ * All files use the prefix "sp_t{N}_" in the current working directory.
+ *
+ * Build: added to CMakeLists.txt as test_sparse_fill.
+ * Run:   ./build/test_sparse_fill
+ * Exit:  0 on success, 1 on any failure.
+ */
+
+#include "tensor_engine.h"
+#include "sparse_pattern.h"
+#include "tensor_store.h"
+#include "registry.h"
+#include "test_util.h"
+#include <hdf5.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ----------------------------------------------------------------------- */
+/* Test infrastructure                                                       */
+/* ----------------------------------------------------------------------- */
+
+/* Count allocated chunks of file's "tensor" dataset; -1 on error.  When
+ * reg_out is non-NULL the scanned registry is returned to the caller. */
+static long count_on_disk(const char *file, TensorRegistry **reg_out)
+{
+    hid_t fid = H5Fopen(file, H5F_ACC_RDONLY, H5P_DEFAULT);
+    if (fid < 0) return -1;
+    hid_t dset = dset_open_no_cache(fid, "tensor");
+    TensorRegistry *reg = registry_create_from_dset(dset);
+    long n = reg ? registry_scan_file(dset, reg) : -1;
+    H5Dclose(dset);
+    H5Fclose(fid);
+    if (reg_out) *reg_out = reg;
+    else if (reg) registry_destroy(reg);
+    return n;
+}
+
+/* Read a whole FP64 "tensor" dataset (unallocated chunks read as 0). */
+static double *read_all_fp64(const char *file, size_t n)
+{
+    hid_t fid = H5Fopen(file, H5F_ACC_RDONLY, H5P_DEFAULT);
+    if (fid < 0) return NULL;
+    hid_t dset = H5Dopen2(fid, "tensor", H5P_DEFAULT);
+    double *buf = malloc(n * sizeof(double));
+    if (buf && H5Dread(dset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL,
+                       H5P_DEFAULT, buf) < 0) {
+        free(buf);
+        buf = NULL;
+    }
+    H5Dclose(dset);
+    H5Fclose(fid);
+    return buf;
+}
+
+/* ----------------------------------------------------------------------- */
+/* T1 — uniform random density                                               */
+/* ----------------------------------------------------------------------- */
+static void t1_random(tensor_engine_t *eng)
+{
+    printf("\n=== T1: random pattern, density 0.3 ===\n");
+    /* 8×8 tiles; 160×160 → 20×20 = 400 tiles. */
+    const size_t shape[2] = {160, 160};
+    CHECK(create("sp_t1_A.h5", 2, shape, 8, DTYPE_FP64)
+              == TENSOR_ENGINE_OK,
+          "create");
+    tensor_engine_sparsity_t sp = {TENSOR_SPARSITY_RANDOM, 0.3, 0, 0, 7};
+    CHECK(tensor_engine_fill_sparse(eng, "sp_t1_A.h5", &sp)
+              == TENSOR_ENGINE_OK,
+          "fill_sparse returns OK");
+
+    TensorRegistry *reg = NULL;
+    long n = count_on_disk("sp_t1_A.h5", &reg);
+    CHECK(reg && reg->total_tiles == 400, "400 tiles in grid");
+    if (!reg) return;
+
+    sparse_pattern_t pat = {SP_RANDOM, 0.3, 0, 0, 7};
+    size_t expect = sparse_pattern_count(&pat, reg);
+    int    match  = 1;
+    for (size_t t = 0; t < reg->total_tiles; t++) {
+        int on_disk = reg->tiles[t].status == TILE_STATUS_ON_DISK;
+        if (on_disk != sparse_pattern_select(reg, t, &pat)) match = 0;
+    }
+    printf("  allocated %ld / %zu tiles (expected %zu)\n",
+           n, reg->total_tiles, expect);
+    CHECK(n == (long)expect, "allocated count == pattern count");
+    CHECK(match, "allocated set == selected set");
+    CHECK(fabs((double)n / 400.0 - 0.3) < 0.08, "density within 0.08 of 0.3");
+    registry_destroy(reg);
+}
+
+/* ----------------------------------------------------------------------- */
+/* T2 — banded rank-3                                                        */
+/* ----------------------------------------------------------------------- */
+static void t2_banded(tensor_engine_t *eng)
+{
+    printf("\n=== T2: banded pattern, rank 3, bandwidth 1 ===\n");
+    /* 4×4×4 tiles; 24^3 → 6^3 = 216 tiles. */
+    const size_t shape[3] = {24, 24, 24};
+    CHECK(create("sp_t2_A.h5", 3, shape, 4, DTYPE_FP64)
+              == TENSOR_ENGINE_OK,
+          "create");
+    tensor_engine_sparsity_t sp = {TENSOR_SPARSITY_BANDED, 0.0, 1, 0, 3};
+    CHECK(tensor_engine_fill_sparse(eng, "sp_t2_A.h5", &sp)
+              == TENSOR_ENGINE_OK,
+          "fill_sparse returns OK");
+
+    TensorRegistry *reg = NULL;
+    long n = count_on_disk("sp_t2_A.h5", &reg);
+    if (!reg) { CHECK(0, "scan"); return; }
+
+    long expect = 0;
+    int  g      = (int)reg->grid_dims[0];
+    for (int i = 0; i < g; i++)
+        for (int j = 0; j < g; j++)
+            for (int k = 0; k < g; k++) {
+                int lo = i, hi = i;
+                if (j < lo) lo = j;
+                if (k < lo) lo = k;
+                if (j > hi) hi = j;
+                if (k > hi) hi = k;
+                expect += (hi - lo) <= 1;
+            }
+    printf("  grid %d^3  allocated %ld  expected %ld\n", g, n, expect);
+    CHECK(n == expect, "allocated count == brute-force band count");
+    registry_destroy(reg);
+}
+
+/* ----------------------------------------------------------------------- */
+/* T3 — block-diagonal                                                       */
+/* ----------------------------------------------------------------------- */
+static void t3_block_diag(tensor_engine_t *eng)
+{
+    printf("\n=== T3: block-diagonal pattern, 4 blocks ===\n");
+    const size_t shape[2] = {64, 64};      /* 8×8 grid of 8×8 tiles */
+    CHECK(create("sp_t3_A.h5", 2, shape, 8, DTYPE_COMPLEX128)
+              == TENSOR_ENGINE_OK,
+          "create COMPLEX128");
+    tensor_engine_sparsity_t sp = {TENSOR_SPARSITY_BLOCK_DIAG, 0.0, 0, 4, 5};
+    CHECK(tensor_engine_fill_sparse(eng, "sp_t3_A.h5", &sp)
+              == TENSOR_ENGINE_OK,
+          "fill_sparse returns OK");
+
+    TensorRegistry *reg = NULL;
+    long n = count_on_disk("sp_t3_A.h5", &reg);
+    if (!reg) { CHECK(0, "scan"); return; }
+
+    /* Grid side g, 4 blocks of (g/4)^2 tiles each. */
+    size_t g    = (size_t)reg->grid_dims[0];
+    size_t side = g / 4;
+    int    ok   = 1;
+    for (size_t t = 0; t < reg->total_tiles; t++) {
+        size_t i = (size_t)reg->tiles[t].global_coords[0];
+        size_t j = (size_t)reg->tiles[t].global_coords[1];
+        int want = (i / side) == (j / side);
+        if (want != (reg->tiles[t].status == TILE_STATUS_ON_DISK)) ok = 0;
+    }
+    printf("  grid %zu^2  allocated %ld\n", g, n);
+    CHECK(n == (long)(4 * side * side), "4 diagonal blocks allocated");
+    CHECK(ok, "only diagonal-block tiles allocated");
+    registry_destroy(reg);
+}
+
+/* ----------------------------------------------------------------------- */
+/* T4 — symmetric rank-3                                                     */
+/* ----------------------------------------------------------------------- */
+static void t4_symmetric(tensor_engine_t *eng)
+{
+    printf("\n=== T4: symmetric pattern, rank 3 ===\n");
+    const size_t N = 22;           /* side-6 tiles: 4^3 grid, boundary tiles */
+    const size_t shape[3] = {N, N, N};
+    CHECK(create("sp_t4_A.h5", 3, shape, 6, DTYPE_FP64)
+              == TENSOR_ENGINE_OK,
+          "create");
+    tensor_engine_sparsity_t sp = {TENSOR_SPARSITY_SYMMETRIC, 0.5, 0, 0, 11};
+    CHECK(tensor_engine_fill_sparse(eng, "sp_t4_A.h5", &sp)
+              == TENSOR_ENGINE_OK,
+          "fill_sparse returns OK");
+
+    long n = count_on_disk("sp_t4_A.h5", NULL);
+    printf("  allocated %ld tiles\n", n);
+    CHECK(n > 0 && n < 4 * 4 * 4, "pattern is neither empty nor dense");
+
+    double *a = read_all_fp64("sp_t4_A.h5", N * N * N);
+    CHECK(a != NULL, "read back");
+    if (!a) return;
+
+    size_t bad = 0, nz = 0;
+#define IX(i, j, k) (((i) * N + (j)) * N + (k))
+    for (size_t i = 0; i < N; i++)
+        for (size_t j = 0; j < N; j++)
+            for (size_t k = 0; k < N; k++) {
+                double v = a[IX(i, j, k)];
+                if (v != 0.0) nz++;
+                if (v != a[IX(j, k, i)] || v != a[IX(k, j, i)] ||
+                    v != a[IX(i, k, j)])
+                    bad++;
+            }
+#undef IX
+    printf("  nonzeros %zu  asymmetric elements %zu\n", nz, bad);
+    CHECK(nz > 0, "tensor has nonzeros");
+    CHECK(bad == 0, "T[x] == T[perm(x)] for every element");
+    free(a);
+}
+
+/* ----------------------------------------------------------------------- */
+/* T5 — sparse contraction vs dense reference                                */
+/* ----------------------------------------------------------------------- */
+static void t5_contract(tensor_engine_t *eng)
+{
+    printf("\n=== T5: sparse A × banded B vs dense reference ===\n");
+    const size_t M = 37, K = 45, N = 29;
+    const size_t shA[2] = {M, K}, shB[2] = {K, N};
+    CHECK(create("sp_t5_A.h5", 2, shA, 8, DTYPE_FP64)
+              == TENSOR_ENGINE_OK &&
+          create("sp_t5_B.h5", 2, shB, 8, DTYPE_FP64)
+              == TENSOR_ENGINE_OK,
+          "create A, B");
+    tensor_engine_sparsity_t spA = {TENSOR_SPARSITY_RANDOM, 0.4, 0, 0, 21};
+    tensor_engine_sparsity_t spB = {TENSOR_SPARSITY_BANDED, 0.0, 1, 0, 22};
+    CHECK(tensor_engine_fill_sparse(eng, "sp_t5_A.h5", &spA)
+              == TENSOR_ENGINE_OK &&
+          tensor_engine_fill_sparse(eng, "sp_t5_B.h5", &spB)
+              == TENSOR_ENGINE_OK,
+          "fill A random, B banded");
+    CHECK(tensor_engine_contract(eng, "ij,jk->ik", "sp_t5_A.h5",
+                                 "sp_t5_B.h5", "sp_t5_C.h5")
+              == TENSOR_ENGINE_OK,
+          "contract returns OK");
+
+    double *a = read_all_fp64("sp_t5_A.h5", M * K);
+    double *b = read_all_fp64("sp_t5_B.h5", K * N);
+    double *c = read_all_fp64("sp_t5_C.h5", M * N);
+    CHECK(a && b && c, "read back A, B, C");
+    if (a && b && c) {
+        double max_err = 0.0;
+        for (size_t i = 0; i < M; i++)
+            for (size_t k = 0; k < N; k++) {
+                double ref = 0.0;
+                for (size_t j = 0; j < K; j++)
+                    ref += a[i * K + j] * b[j * N + k];
+                double e = fabs(ref - c[i * N + k]);
+                if (e > max_err) max_err = e;
+            }
+        printf("  max_err = %.2e\n", max_err);
+        CHECK(max_err < 1e-12, "C matches dense reference (max_err < 1e-12)");
+    }
+    free(a);
+    free(b);
+    free(c);
+}
+
+/* ----------------------------------------------------------------------- */
+/* T6 — error paths                                                          */
+/* ----------------------------------------------------------------------- */
+static void t6_errors(tensor_engine_t *eng)
+{
+    printf("\n=== T6: error paths ===\n");
+    const size_t shape[2] = {16, 24};
+    CHECK(create("sp_t6_A.h5", 2, shape, 8, DTYPE_FP64)
+              == TENSOR_ENGINE_OK,
+          "create non-square");
+    tensor_engine_sparsity_t sym = {TENSOR_SPARSITY_SYMMETRIC, 0.5, 0, 0, 1};
+    CHECK(tensor_engine_fill_sparse(eng, "sp_t6_A.h5", &sym)
+              == TENSOR_ENGINE_ERR_DIMS,
+          "symmetric on 16×24 → ERR_DIMS");
+    tensor_engine_sparsity_t bad = {TENSOR_SPARSITY_RANDOM, 1.5, 0, 0, 1};
+    CHECK(tensor_engine_fill_sparse(eng, "sp_t6_A.h5", &bad)
+              == TENSOR_ENGINE_ERR_DIMS,
+          "density 1.5 → ERR_DIMS");
+    tensor_engine_sparsity_t unk = {99, 0.5, 0, 0, 1};
+    CHECK(tensor_engine_fill_sparse(eng, "sp_t6_A.h5", &unk)
+              == TENSOR_ENGINE_ERR,
+          "unknown pattern → ERR");
+    CHECK(count_on_disk("sp_t6_A.h5", NULL) == 0, "nothing was written");
+}
+
+/* ----------------------------------------------------------------------- */
+/* main                                                                      */
+/* ----------------------------------------------------------------------- */
+int main(void)
+{
+    printf("=== test_sparse_fill: block-sparse generator correctness ===\n");
+
+    tensor_engine_config_t cfg = {0};
+    tensor_engine_t *eng = tensor_engine_init(&cfg);
+    if (!eng) { printf("FAIL: engine init\n"); return 1; }
+
+    t1_random(eng);
+    t2_banded(eng);
+    t3_block_diag(eng);
+    t4_symmetric(eng);
+    t5_contract(eng);
+    t6_errors(eng);
+
+    tensor_engine_free(eng);
+    printf("\n--- Results: %d passed, %d failed ---\n", g_pass, g_fail);
+    return (g_fail == 0) ? 0 : 1;
+}
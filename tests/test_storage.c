@@ -0,0 +1,627 @@
+/*
+ * tests/test_storage.c
+ *
+ * Correctness tests for the storage backends (storage.c, storage_raw.c,
+ * storage_stripe.c, storage_retile.c).
+ *
+ * Nine test cases:
+ *   T1 – native format: tiles round-trip, boundary padding is zeroed,
+ *        absent tiles read as zeros and scan only the stored tiles,
+ *        payloads are aligned, a batched write matches single writes
+ *   T2 – stg_open recognises both formats by content, not by name, and
+ *        rejects a native header whose layout disagrees with its dims
+ *   T3 – HDF5 -> native -> HDF5 conversion is bit-identical, sparse
+ *        tiles included
+ *   T4 – a contraction with native operands and output matches the
+ *        HDF5 contraction bit for bit
+ *   T5 – contiguous-layout HDF5 operands are tiled virtually: contraction
+ *        and verify accept them; mmap and pread reads agree; readahead
+ *        hints only for tiles that are single runs
+ *   T6 – striped operands and output spread tiles over every member and
+ *        contract bit-identically
+ *   T7 – complex HDF5 tiles move as raw chunk bytes: boundary padding
+ *        reads as zero and results match the converting path
+ *   T8 – retiled views assemble tiles from overlapping chunks, keep block
+ *        sparsity, and let differently chunked operands contract
+ *   T9 – a requested output chunk shape, finer or coarser than the tiles,
+ *        is what lands on disk; results match under any staging budget
+ *        and accumulation into such a C works
+ *
+ * Files use the prefix "stg_" in the current working directory.
+ *
+ * Build: added to CMakeLists.txt as test_storage.
+ * Run:   ./build/test_storage
+ * Exit:  0 on success, 1 on any failure.
+ */
+
+#include "storage.h"
+#include "tensor_engine.h"
+#include "test_util.h"
+#include <hdf5.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* ----------------------------------------------------------------------- */
+/* Test infrastructure                                                       */
+/* ----------------------------------------------------------------------- */
+
+#define EXPR "ijab,akbl->klji"
+
+/* Copy the "tensor" dataset of src into dst, chunked as chunk or, when
+ * chunk is NULL, with the contiguous layout. */
+static int write_layout(const char *src, const char *dst,
+                        const hsize_t *chunk)
+{
+    size_t  n;
+    double *buf = read_raw(src, &n);
+    hid_t   fs  = H5Fopen(src, H5F_ACC_RDONLY, H5P_DEFAULT);
+    hid_t   ds  = (fs >= 0) ? H5Dopen2(fs, "tensor", H5P_DEFAULT) : -1;
+    hid_t   fd  = H5Fcreate(dst, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+    int     ok  = buf && ds >= 0 && fd >= 0;
+    if (ok) {
+        hid_t type  = H5Dget_type(ds);
+        hid_t space = H5Dget_space(ds);
+        hid_t dcpl  = H5Pcreate(H5P_DATASET_CREATE);
+        if (chunk)
+            H5Pset_chunk(dcpl, H5Sget_simple_extent_ndims(space), chunk);
+        hid_t dd    = H5Dcreate2(fd, "tensor", type, space, H5P_DEFAULT,
+                                 dcpl, H5P_DEFAULT);
+        H5Pclose(dcpl);
+        ok = dd >= 0 &&
+             H5Dwrite(dd, type, H5S_ALL, H5S_ALL, H5P_DEFAULT, buf) >= 0;
+        if (dd >= 0) H5Dclose(dd);
+        H5Sclose(space);
+        H5Tclose(type);
+    }
+    if (fd >= 0) H5Fclose(fd);
+    if (ds >= 0) H5Dclose(ds);
+    if (fs >= 0) H5Fclose(fs);
+    free(buf);
+    return ok;
+}
+
+/* 1 if the two files have the same bytes. */
+static int same_bytes(const char *f1, const char *f2)
+{
+    FILE *a = fopen(f1, "rb"), *b = fopen(f2, "rb");
+    int   ok = a && b;
+    while (ok) {
+        int ca = fgetc(a), cb = fgetc(b);
+        ok = (ca == cb);
+        if (ca == EOF) break;
+    }
+    if (a) fclose(a);
+    if (b) fclose(b);
+    return ok;
+}
+
+/* Chunk dims of the "tensor" dataset; returns its rank, or -1. */
+static int chunk_of(const char *file, hsize_t *chunk)
+{
+    hid_t fid  = H5Fopen(file, H5F_ACC_RDONLY, H5P_DEFAULT);
+    hid_t dset = (fid >= 0) ? H5Dopen2(fid, "tensor", H5P_DEFAULT) : -1;
+    hid_t dcpl = (dset >= 0) ? H5Dget_create_plist(dset) : -1;
+    int   rank = (dcpl >= 0) ? H5Pget_chunk(dcpl, MAX_RANK, chunk) : -1;
+    if (dcpl >= 0) H5Pclose(dcpl);
+    if (dset >= 0) H5Dclose(dset);
+    if (fid >= 0)  H5Fclose(fid);
+    return rank;
+}
+
+static long stored_tiles(const TensorRegistry *reg)
+{
+    long n = 0;
+    for (size_t t = 0; t < reg->total_tiles; t++)
+        n += reg->tiles[t].status == TILE_STATUS_ON_DISK;
+    return n;
+}
+
+/* ----------------------------------------------------------------------- */
+/* T1 — native round trip                                                    */
+/* ----------------------------------------------------------------------- */
+static void t1_raw_roundtrip(void)
+{
+    printf("\n=== T1: native format round trip ===\n");
+    const hsize_t global[2] = {10, 7}, chunk[2] = {4, 4};
+    const hsize_t off_full[2] = {0, 0}, off_edge[2] = {8, 4};
+    const hsize_t off_none[2] = {4, 0};
+    double tile[16], back[16];
+
+    StorageFile *f = stg_create("stg_t1.oct", "tensor", 2, global, chunk,
+                                DTYPE_FP64);
+    CHECK(f && f->ops == &stg_raw_ops && f->tile_bytes == sizeof(tile),
+          "create picks the native backend for .oct");
+    if (!f) return;
+
+    for (int i = 0; i < 16; i++) tile[i] = 1.0 + i;
+    int ok = stg_write_tile(f, off_full, tile) == 0;
+    for (int i = 0; i < 16; i++) tile[i] = -1.0 - i;   /* padding included */
+    ok = ok && stg_write_tile(f, off_edge, tile) == 0;
+    stg_close(f);
+    CHECK(ok, "two tiles written");
+
+    f = stg_open("stg_t1.oct", "tensor", 0);
+    TensorRegistry *reg = f ? stg_scan(f) : NULL;
+    CHECK(reg && reg->total_tiles == 6 && stored_tiles(reg) == 2,
+          "scan finds exactly the two stored tiles of six");
+    if (!reg) { stg_close(f); return; }
+
+    ok = stg_read_tile(f, off_full, back) == 0;
+    for (int i = 0; i < 16; i++) ok = ok && back[i] == 1.0 + i;
+    CHECK(ok, "interior tile reads back unchanged");
+
+    /* Edge tile (8,4): 2 × 3 valid of the nominal 4 × 4. */
+    ok = stg_read_tile(f, off_edge, back) == 0;
+    for (int r = 0; r < 4; r++)
+        for (int c = 0; c < 4; c++)
+            ok = ok && back[r * 4 + c] == ((r < 2 && c < 3)
+                                           ? -1.0 - (r * 4 + c) : 0.0);
+    CHECK(ok, "boundary tile keeps its extent and zeroes the padding");
+
+    memset(back, 0xff, sizeof(back));
+    ok = stg_read_tile(f, off_none, back) == 0;
+    for (int i = 0; i < 16; i++) ok = ok && back[i] == 0.0;
+    CHECK(ok, "absent tile reads as zeros");
+
+    ok = 1;
+    for (size_t t = 0; t < reg->total_tiles; t++)
+        if (reg->tiles[t].status == TILE_STATUS_ON_DISK)
+            ok = ok && reg->tiles[t].file_addr % STG_RAW_ALIGN_MIN == 0 &&
+                 reg->tiles[t].file_bytes == sizeof(tile);
+    CHECK(ok, "payload offsets are block-aligned");
+    registry_destroy(reg);
+    stg_close(f);
+
+    /* A run of consecutive tiles, boundary tiles included, then a stray. */
+    const hsize_t  o[5][2] = {{4, 0}, {4, 4}, {8, 0}, {8, 4}, {0, 4}};
+    double         tiles[5][16];
+    const hsize_t *offs[5];
+    const void    *bufs[5];
+    for (int k = 0; k < 5; k++) {
+        for (int i = 0; i < 16; i++) tiles[k][i] = 100.0 * k + i;
+        offs[k] = o[k];
+        bufs[k] = tiles[k];
+    }
+    StorageFile *fb = stg_create("stg_t1b.oct", "tensor", 2, global, chunk,
+                                 DTYPE_FP64);
+    StorageFile *fs = stg_create("stg_t1s.oct", "tensor", 2, global, chunk,
+                                 DTYPE_FP64);
+    ok = fb && fs && stg_write_tiles(fb, 5, offs, bufs) == 0;
+    for (int k = 0; ok && k < 5; k++)
+        ok = stg_write_tile(fs, offs[k], bufs[k]) == 0;
+    stg_close(fb);
+    stg_close(fs);
+    CHECK(ok && same_bytes("stg_t1b.oct", "stg_t1s.oct"),
+          "batched write is byte-identical to single-tile writes");
+}
+
+/* ----------------------------------------------------------------------- */
+/* T2 — probing                                                              */
+/* ----------------------------------------------------------------------- */
+static void t2_probe(void)
+{
+    printf("\n=== T2: format recognised by content ===\n");
+    CHECK(stg_probe("stg_t1.oct") == &stg_raw_ops, "native file probed as raw");
+    CHECK(stg_probe("stg_A.h5") == &stg_hdf5_ops, "HDF5 file probed as hdf5");
+    CHECK(rename("stg_t1.oct", "stg_t1.h5") == 0 &&
+          stg_probe("stg_t1.h5") == &stg_raw_ops,
+          "a native file with an .h5 name is still native");
+    CHECK(stg_probe("stg_missing.h5") == NULL &&
+          stg_open("stg_missing.h5", "tensor", 0) == NULL,
+          "a missing file is rejected");
+
+    /* Header fields that disagree with the dims are rejected. */
+    const size_t at[3] = {offsetof(stg_raw_header_t, chunk_dims),
+                          offsetof(stg_raw_header_t, chunk_dims),
+                          offsetof(stg_raw_header_t, n_tiles)};
+    const uint64_t bad[3] = {0, 11, 7};
+    int fd = open("stg_t1.h5", O_RDWR), ok = fd >= 0;
+    for (int k = 0; ok && k < 3; k++) {
+        uint64_t v;
+        ok = pread(fd, &v, sizeof(v), (off_t)at[k]) == sizeof(v) &&
+             pwrite(fd, &bad[k], sizeof(v), (off_t)at[k]) == sizeof(v) &&
+             stg_open("stg_t1.h5", "tensor", 0) == NULL &&
+             pwrite(fd, &v, sizeof(v), (off_t)at[k]) == sizeof(v);
+    }
+    if (fd >= 0) close(fd);
+    CHECK(ok, "zero or oversized chunk, wrong tile count: rejected");
+    StorageFile *f = ok ? stg_open("stg_t1.h5", "tensor", 0) : NULL;
+    CHECK(f != NULL, "header restored: opens again");
+    stg_close(f);
+}
+
+/* ----------------------------------------------------------------------- */
+/* T3 — conversion                                                           */
+/* ----------------------------------------------------------------------- */
+static void t3_convert(void)
+{
+    printf("\n=== T3: HDF5 -> native -> HDF5 ===\n");
+    long n1 = stg_convert("stg_A.h5", "tensor", "stg_A.oct", "tensor");
+    long n2 = stg_convert("stg_A.oct", "tensor", "stg_A2.h5", "tensor");
+    CHECK(n1 > 0 && n1 == n2, "both conversions copy the same tile count");
+    CHECK(same_file_data("stg_A.h5", "stg_A2.h5"),
+          "round trip is bit-identical");
+
+    long s1 = stg_convert("stg_S.h5", "tensor", "stg_S.oct", "tensor");
+    long s2 = stg_convert("stg_S.oct", "tensor", "stg_S2.h5", "tensor");
+    StorageFile    *f   = stg_open("stg_S.h5", "tensor", 0);
+    TensorRegistry *reg = f ? stg_scan(f) : NULL;
+    CHECK(reg && s1 == stored_tiles(reg) && s2 == s1 &&
+          (size_t)s1 < reg->total_tiles,
+          "a sparse tensor converts only its stored tiles");
+    registry_destroy(reg);
+    stg_close(f);
+    CHECK(same_file_data("stg_S.h5", "stg_S2.h5"),
+          "sparse round trip is bit-identical");
+}
+
+/* ----------------------------------------------------------------------- */
+/* T4 — contraction on native files                                          */
+/* ----------------------------------------------------------------------- */
+static void t4_contract(tensor_engine_t *eng)
+{
+    printf("\n=== T4: contraction with native storage ===\n");
+    int ok = stg_convert("stg_B.h5", "tensor", "stg_B.oct", "tensor") > 0 &&
+             tensor_engine_contract(eng, EXPR, "stg_A.oct", "stg_B.oct",
+                                    "stg_C.oct") == TENSOR_ENGINE_OK;
+    CHECK(ok, "contraction on .oct operands into .oct output");
+    CHECK(ok && stg_convert("stg_C.oct", "tensor", "stg_C2.h5", "tensor") > 0 &&
+          same_file_data("stg_C.h5", "stg_C2.h5"),
+          "result identical to the HDF5 contraction");
+
+    ok = tensor_engine_contract(eng, EXPR, "stg_A.oct", "stg_B.h5",
+                                "stg_C3.h5") == TENSOR_ENGINE_OK;
+    CHECK(ok && same_file_data("stg_C.h5", "stg_C3.h5"),
+          "mixed native and HDF5 operands");
+}
+
+/* ----------------------------------------------------------------------- */
+/* T5 — contiguous datasets                                                  */
+/* ----------------------------------------------------------------------- */
+static void t5_contiguous(tensor_engine_t *eng)
+{
+    printf("\n=== T5: contiguous-layout operands ===\n");
+    int ok = write_layout("stg_A.h5", "stg_Ac.h5", NULL) &&
+             write_layout("stg_B.h5", "stg_Bc.h5", NULL);
+    StorageFile *f = ok ? stg_open("stg_Ac.h5", "tensor", 0) : NULL;
+    CHECK(f && f->virtual_tiles && f->dtype == DTYPE_COMPLEX128,
+          "contiguous dataset opens with a virtual tiling");
+
+    /* Readahead hints only for tilings whose tiles are single runs. */
+    const hsize_t rows[4] = {2, 8, 7, 6}, box[4] = {9, 4, 7, 6};
+    TensorRegistry *r1 = (f && stg_set_tiling(f, rows) == 0) ? stg_scan(f)
+                                                             : NULL;
+    int hint_rows = f ? f->hints : 0;
+    TensorRegistry *r2 = (r1 && stg_set_tiling(f, box) == 0) ? stg_scan(f)
+                                                             : NULL;
+    CHECK(r1 && r2 && hint_rows && !f->hints,
+          "readahead hints for row tiles, none for boxes");
+    registry_destroy(r1);
+    registry_destroy(r2);
+    stg_close(f);
+
+    ok = tensor_engine_contract(eng, EXPR, "stg_Ac.h5", "stg_B.h5",
+                                "stg_C4.h5") == TENSOR_ENGINE_OK;
+    CHECK(ok && rel_diff("stg_C4.h5", "stg_C.h5") < 1e-13,
+          "contiguous A with chunked B matches");
+
+    /* Small virtual tiles: several per dim, with partial boundary tiles. */
+    setenv("TENSOR_VIRTUAL_TILE_BYTES", "16384", 1);
+    ok = tensor_engine_contract(eng, EXPR, "stg_Ac.h5", "stg_Bc.h5",
+                                "stg_C5.h5") == TENSOR_ENGINE_OK;
+    CHECK(ok && rel_diff("stg_C5.h5", "stg_C.h5") < 1e-13,
+          "contiguous A and B match with small virtual tiles");
+
+    setenv("TENSOR_MMAP", "0", 1);
+    ok = tensor_engine_contract(eng, EXPR, "stg_Ac.h5", "stg_Bc.h5",
+                                "stg_C6.h5") == TENSOR_ENGINE_OK;
+    unsetenv("TENSOR_MMAP");
+    unsetenv("TENSOR_VIRTUAL_TILE_BYTES");
+    CHECK(ok && same_file_data("stg_C5.h5", "stg_C6.h5"),
+          "pread reads give the same result as mmap");
+
+    tensor_engine_verify_t v;
+    memset(&v, 0, sizeof(v));
+    CHECK(tensor_engine_verify(eng, EXPR, "stg_Ac.h5", "stg_Bc.h5",
+                               "stg_C.h5", &v) == TENSOR_ENGINE_OK,
+          "verify reads contiguous operands");
+}
+
+/* ----------------------------------------------------------------------- */
+/* T6 — striped files                                                        */
+/* ----------------------------------------------------------------------- */
+static void t6_stripe(tensor_engine_t *eng)
+{
+    printf("\n=== T6: striped storage ===\n");
+    mkdir("stg_d0", 0755);
+    mkdir("stg_d1", 0755);
+    setenv("TENSOR_STRIPE_DIRS", "stg_d0:stg_d1", 1);
+    int ok = stg_convert("stg_A.h5", "tensor", "stg_A.ocs", "tensor") > 0 &&
+             stg_convert("stg_B.h5", "tensor", "stg_B.ocs", "tensor") > 0;
+    CHECK(ok, "convert to a two-way stripe");
+
+    StorageFile *f = ok ? stg_open("stg_A.ocs", "tensor", 0) : NULL;
+    CHECK(f && f->ops == &stg_stripe_ops && f->devices == 2,
+          "stripe manifest opens with both members");
+    stg_close(f);
+    CHECK(stg_probe("stg_A.ocs") == &stg_stripe_ops,
+          "stripe manifest recognised by content");
+
+    StorageFile *m0 = stg_open("stg_d0/stg_A.0.oct", "tensor", 0);
+    StorageFile *m1 = stg_open("stg_d1/stg_A.1.oct", "tensor", 0);
+    TensorRegistry *r0 = m0 ? stg_scan(m0) : NULL;
+    TensorRegistry *r1 = m1 ? stg_scan(m1) : NULL;
+    f = stg_open("stg_A.h5", "tensor", 0);
+    TensorRegistry *ra = f ? stg_scan(f) : NULL;
+    stg_close(f);
+    CHECK(r0 && r1 && ra &&
+          r0->total_tiles == (ra->total_tiles + 1) / 2 &&
+          r1->total_tiles == ra->total_tiles / 2,
+          "each member is sized for its own share of the tiles");
+    CHECK(r0 && r1 && ra && stored_tiles(r0) == (long)r0->total_tiles &&
+          stored_tiles(r1) == (long)r1->total_tiles &&
+          stored_tiles(r0) + stored_tiles(r1) == stored_tiles(ra),
+          "tiles alternate between the member drives, densely packed");
+    registry_destroy(ra);
+    registry_destroy(r0);
+    registry_destroy(r1);
+    stg_close(m0);
+    stg_close(m1);
+
+    ok = tensor_engine_contract(eng, EXPR, "stg_A.ocs", "stg_B.ocs",
+                                "stg_C.ocs") == TENSOR_ENGINE_OK;
+    CHECK(ok && stg_convert("stg_C.ocs", "tensor", "stg_C7.h5", "tensor") > 0 &&
+          same_file_data("stg_C.h5", "stg_C7.h5"),
+          "striped contraction identical to the HDF5 contraction");
+    unsetenv("TENSOR_STRIPE_DIRS");
+
+    const char *members[] = {"stg_d0/stg_A.0.oct", "stg_d1/stg_A.1.oct",
+                             "stg_d0/stg_B.0.oct", "stg_d1/stg_B.1.oct",
+                             "stg_d0/stg_C.0.oct", "stg_d1/stg_C.1.oct"};
+    for (size_t i = 0; i < sizeof(members) / sizeof(members[0]); i++)
+        unlink(members[i]);
+    rmdir("stg_d0");
+    rmdir("stg_d1");
+}
+
+/* ----------------------------------------------------------------------- */
+/* T7 — complex tiles without type conversion                                */
+/* ----------------------------------------------------------------------- */
+static void t7_raw_chunks(tensor_engine_t *eng)
+{
+    printf("\n=== T7: complex HDF5 tiles without conversion ===\n");
+    const hsize_t global[2] = {5, 3}, chunk[2] = {4, 2};
+    const hsize_t off_edge[2] = {4, 2};
+    double tile[16], back[16];
+    for (int i = 0; i < 16; i++) tile[i] = 1.0 + i;  /* padding included */
+
+    StorageFile *f = stg_create("stg_t7.h5", "tensor", 2, global, chunk,
+                                DTYPE_COMPLEX128);
+    int ok = f && stg_write_tile(f, off_edge, tile) == 0;
+    stg_close(f);
+    f = ok ? stg_open("stg_t7.h5", "tensor", 0) : NULL;
+    memset(back, 0xff, sizeof(back));
+    ok = f && stg_read_tile(f, off_edge, back) == 0;
+    /* Tile (4,2): 1 × 1 valid complex element of the nominal 4 × 2. */
+    for (int i = 0; i < 16; i++)
+        ok = ok && back[i] == ((i < 2) ? 1.0 + i : 0.0);
+    CHECK(ok, "boundary tile padding reads as zero");
+    stg_close(f);
+
+    size_t n;
+    double *all = read_raw("stg_t7.h5", &n);
+    CHECK(all && n == 30 && all[28] == 1.0 && all[29] == 2.0,
+          "HDF5 readers see the element the tile wrote");
+    free(all);
+
+    setenv("TENSOR_H5_DIRECT", "0", 1);
+    ok = tensor_engine_contract(eng, EXPR, "stg_A.h5", "stg_B.h5",
+                                "stg_C8.h5") == TENSOR_ENGINE_OK;
+    unsetenv("TENSOR_H5_DIRECT");
+    CHECK(ok && same_file_data("stg_C.h5", "stg_C8.h5"),
+          "converting path gives the same result");
+}
+
+/* ----------------------------------------------------------------------- */
+/* T8 — retiled views                                                        */
+/* ----------------------------------------------------------------------- */
+static void t8_retile(tensor_engine_t *eng)
+{
+    printf("\n=== T8: retiled views ===\n");
+    /* A under tiles one element larger per dim: every tile straddles
+     * chunk boundaries, and boundary tiles are partial. */
+    StorageFile *f = stg_open("stg_A.h5", "tensor", 0);
+    hsize_t      v[MAX_RANK] = {0};
+    for (int d = 0; f && d < f->rank; d++) v[d] = f->chunk_dims[d] + 1;
+    StorageFile    *rv  = f ? stg_retile(f, v) : NULL;
+    TensorRegistry *reg = rv ? stg_scan(rv) : NULL;
+    size_t  n;
+    double *all = read_raw("stg_A.h5", &n);
+    double *buf = rv ? malloc(rv->tile_bytes) : NULL;
+    int     ok  = reg && all && buf && rv->ops == &stg_retile_ops &&
+                  stored_tiles(reg) == (long)reg->total_tiles;
+    for (size_t t = 0; ok && t < reg->total_tiles; t++) {
+        const hsize_t *off = reg->tiles[t].phys_offset;
+        ok = stg_read_tile(rv, off, buf) == 0;
+        size_t elems = rv->tile_bytes / rv->element_size;
+        for (size_t e = 0; ok && e < elems; e++) {
+            /* Element e of the tile -> global flat index, if in range. */
+            size_t  rem = e, g = 0;
+            int     in  = 1;
+            hsize_t c[MAX_RANK];
+            for (int d = rv->rank - 1; d >= 0; d--) {
+                c[d] = off[d] + rem % rv->chunk_dims[d];
+                rem /= rv->chunk_dims[d];
+                in  &= c[d] < rv->global_dims[d];
+            }
+            for (int d = 0; d < rv->rank; d++)
+                g = g * rv->global_dims[d] + c[d];
+            for (int k = 0; k < 2; k++)
+                ok = ok && buf[2 * e + k] == (in ? all[2 * g + k] : 0.0);
+        }
+    }
+    CHECK(ok, "tiles straddling chunk boundaries match the tensor");
+    free(buf);
+    free(all);
+    registry_destroy(reg);
+    stg_close(rv);
+
+    /* Sparse FP64 with a finer, unaligned side along dim 0: a tile is
+     * stored iff one of the chunks it overlaps is. */
+    f = stg_open("stg_S.h5", "tensor", 0);
+    TensorRegistry *inner = f ? stg_scan(f) : NULL;
+    for (int d = 0; f && d < f->rank; d++) v[d] = f->chunk_dims[d];
+    if (f) v[0] = f->chunk_dims[0] * 3 / 4;
+    rv  = inner ? stg_retile(f, v) : NULL;
+    reg = rv ? stg_scan(rv) : NULL;
+    ok  = reg != NULL;
+    long expect = 0;
+    for (size_t t = 0; ok && t < reg->total_tiles; t++) {
+        int any = 0;
+        for (size_t i = 0; i < inner->total_tiles; i++) {
+            const TileMetadata *it = &inner->tiles[i], *vt = &reg->tiles[t];
+            int under = it->status == TILE_STATUS_ON_DISK;
+            for (int d = 0; under && d < rv->rank; d++)
+                under = it->phys_offset[d] < vt->phys_offset[d] + v[d] &&
+                        vt->phys_offset[d] < it->phys_offset[d]
+                                             + inner->chunk_dims[d];
+            any |= under;
+        }
+        expect += any;
+    }
+    CHECK(ok && expect > 0 && expect < (long)reg->total_tiles &&
+          stored_tiles(reg) == expect,
+          "block sparsity carries over to the new tiles");
+    registry_destroy(inner);
+    registry_destroy(reg);
+    stg_close(rv);
+
+    /* B chunked differently from A along both contracted indices. */
+    f = stg_open("stg_A.h5", "tensor", 0);
+    StorageFile *fb = stg_open("stg_B.h5", "tensor", 0);
+    hsize_t cb[MAX_RANK] = {0};
+    ok = f && fb;
+    if (ok) {
+        memcpy(cb, fb->chunk_dims, sizeof(cb));
+        cb[0] = (f->chunk_dims[2] == 3) ? 2 : 3;   /* a */
+        cb[2] = (f->chunk_dims[3] == 4) ? 5 : 4;   /* b */
+    }
+    stg_close(f);
+    stg_close(fb);
+    ok = ok && write_layout("stg_B.h5", "stg_Br.h5", cb) &&
+         tensor_engine_contract(eng, EXPR, "stg_A.h5", "stg_Br.h5",
+                                "stg_C9.h5") == TENSOR_ENGINE_OK;
+    CHECK(ok && rel_diff("stg_C9.h5", "stg_C.h5") < 1e-13,
+          "differently chunked operands contract without a rechunk");
+}
+
+/* ----------------------------------------------------------------------- */
+/* T9 — caller-chosen output chunking                                        */
+/* ----------------------------------------------------------------------- */
+static void t9_out_chunks(tensor_engine_t *eng)
+{
+    printf("\n=== T9: output chunk shape ===\n");
+    hsize_t nat[MAX_RANK], got[MAX_RANK];
+    size_t  fine[MAX_RANK], coarse[MAX_RANK];
+    int     rank = chunk_of("stg_C.h5", nat);
+    int     ok   = rank == 4;
+    for (int d = 0; ok && d < rank; d++) {
+        fine[d]   = (nat[d] > 1) ? (size_t)nat[d] - 1 : 1;
+        coarse[d] = 2 * (size_t)nat[d] + 1;
+    }
+
+    ok = ok && tensor_engine_contract_chunked(eng, EXPR, "stg_A.h5",
+                   "stg_B.h5", "stg_Cf.h5", fine) == TENSOR_ENGINE_OK &&
+         chunk_of("stg_Cf.h5", got) == rank;
+    for (int d = 0; ok && d < rank; d++) ok = got[d] == fine[d];
+    CHECK(ok && rel_diff("stg_Cf.h5", "stg_C.h5") < 1e-13,
+          "finer, unaligned output chunks on disk, same result");
+
+    ok = rank == 4 &&
+         tensor_engine_contract_chunked(eng, EXPR, "stg_A.h5", "stg_B.h5",
+                                        "stg_Cc.h5", coarse) == TENSOR_ENGINE_OK &&
+         chunk_of("stg_Cc.h5", got) == rank;
+    StorageFile *f = ok ? stg_open("stg_C.h5", "tensor", 0) : NULL;
+    ok = f != NULL;
+    for (int d = 0; ok && d < rank; d++)   /* clamped to the shape */
+        ok = got[d] == ((coarse[d] < f->global_dims[d]) ? coarse[d]
+                                                        : f->global_dims[d]);
+    stg_close(f);
+    CHECK(ok && rel_diff("stg_Cc.h5", "stg_C.h5") < 1e-13,
+          "coarser output chunks gather tiles, same result");
+
+    /* No staging room: every partial chunk is read back and rewritten. */
+    setenv("TENSOR_C_STAGE_MB", "0", 1);
+    ok = rank == 4 &&
+         tensor_engine_contract_chunked(eng, EXPR, "stg_A.h5", "stg_B.h5",
+                                        "stg_Cz.h5", coarse) == TENSOR_ENGINE_OK;
+    unsetenv("TENSOR_C_STAGE_MB");
+    CHECK(ok && rel_diff("stg_Cz.h5", "stg_C.h5") < 1e-13,
+          "zero staging budget falls back to read-modify-write");
+
+    /* Accumulating into the finely chunked C doubles it. */
+    ok = rank == 4 &&
+         tensor_engine_accumulate(eng, EXPR, "stg_A.h5", "stg_B.h5",
+                                  "stg_Cf.h5") == TENSOR_ENGINE_OK;
+    size_t  n1, n2;
+    double *a = ok ? read_raw("stg_C.h5", &n1) : NULL;
+    double *b = ok ? read_raw("stg_Cf.h5", &n2) : NULL;
+    ok = a && b && n1 == n2;
+    for (size_t i = 0; ok && i < n1; i++)
+        ok = fabs(b[i] - 2.0 * a[i]) <= 1e-12 * (1.0 + fabs(a[i]));
+    CHECK(ok, "accumulate into differently chunked C");
+    free(a);
+    free(b);
+}
+
+/* ----------------------------------------------------------------------- */
+/* main                                                                      */
+/* ----------------------------------------------------------------------- */
+int main(void)
+{
+    printf("=== test_storage: storage backends ===\n");
+    H5Eset_auto2(H5E_DEFAULT, NULL, NULL);
+
+    const size_t shA[4] = {9, 8, 7, 6}, shB[4] = {7, 5, 6, 4};
+    tensor_engine_config_t ecfg = {.tile_bytes = 16UL * 1024};
+    tensor_engine_sparsity_t sp = {.pattern = TENSOR_SPARSITY_RANDOM,
+                                   .density = 0.5, .seed = 7};
+    tensor_engine_t *eng = tensor_engine_init(&ecfg);
+    int ok = eng &&
+        tensor_engine_create(eng, "stg_A.h5", 4, shA,
+                             TENSOR_DTYPE_COMPLEX128) == TENSOR_ENGINE_OK &&
+        tensor_engine_create(eng, "stg_B.h5", 4, shB,
+                             TENSOR_DTYPE_COMPLEX128) == TENSOR_ENGINE_OK &&
+        tensor_engine_create(eng, "stg_S.h5", 4, shA,
+                             TENSOR_DTYPE_FP64) == TENSOR_ENGINE_OK &&
+        tensor_engine_fill_random(eng, "stg_A.h5", 5) == TENSOR_ENGINE_OK &&
+        tensor_engine_fill_random(eng, "stg_B.h5", 6) == TENSOR_ENGINE_OK &&
+        tensor_engine_fill_sparse(eng, "stg_S.h5", &sp) == TENSOR_ENGINE_OK &&
+        tensor_engine_contract(eng, EXPR, "stg_A.h5", "stg_B.h5",
+                               "stg_C.h5") == TENSOR_ENGINE_OK;
+    if (!ok) {
+        printf("FAIL: setup\n");
+        tensor_engine_free(eng);
+        return 1;
+    }
+
+    t1_raw_roundtrip();
+    t2_probe();
+    t3_convert();
+    t4_contract(eng);
+    t5_contiguous(eng);
+    t6_stripe(eng);
+    t7_raw_chunks(eng);
+    t8_retile(eng);
+    t9_out_chunks(eng);
+    tensor_engine_free(eng);
+
+    printf("\n--- Results: %d passed, %d failed ---\n", g_pass, g_fail);
+    return (g_fail == 0) ? 0 : 1;
+}
@@ -0,0 +1,203 @@
+/*
+ * tests/test_task_pool.c
+ *
+ * Correctness tests for the work-stealing task runtime (task_pool.c).
+ *
+ * Four test cases, each run with 0 and 3 background workers:
+ *   T1 – parallel_for runs every index exactly once
+ *   T2 – a dependency chain runs strictly in order
+ *   T3 – a diamond DAG (one source, many middles, one sink) respects
+ *        every edge, including edges added after a predecessor finished
+ *   T4 – many uneven tasks spawned from inside tasks all complete, and
+ *        the pool is reusable across waits
+ *
+ * No files are written.
+ *
+ * Build: added to CMakeLists.txt as test_task_pool.
+ * Run:   ./build/test_task_pool
+ * Exit:  0 on success, 1 on any failure.
+ */
+
+#include "task_pool.h"
+#include "test_util.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ----------------------------------------------------------------------- */
+/* Test infrastructure                                                       */
+/* ----------------------------------------------------------------------- */
+
+/* Shared state: a per-index hit counter and a global completion clock. */
+typedef struct {
+    task_pool_t *pool;
+    atomic_int  *hits;
+    atomic_long  clock;
+    long        *stamp;      /* clock value at which each index finished */
+    atomic_long  spawned;
+} Ctx;
+
+static void spin(size_t work)
+{
+    volatile double x = 1.0;
+    for (size_t i = 0; i < work; i++) x = x * 1.0000001 + 1e-9;
+}
+
+static void count_fn(void *arg, size_t idx)
+{
+    Ctx *c = arg;
+    spin((idx % 7) * 200);
+    atomic_fetch_add(&c->hits[idx], 1);
+    c->stamp[idx] = atomic_fetch_add(&c->clock, 1);
+}
+
+static Ctx *ctx_new(task_pool_t *pool, size_t n)
+{
+    Ctx *c   = calloc(1, sizeof *c);
+    c->pool  = pool;
+    c->hits  = calloc(n, sizeof *c->hits);
+    c->stamp = calloc(n, sizeof *c->stamp);
+    return c;
+}
+
+static void ctx_free(Ctx *c)
+{
+    free(c->hits);
+    free(c->stamp);
+    free(c);
+}
+
+/* ----------------------------------------------------------------------- */
+/* T1 — parallel_for                                                         */
+/* ----------------------------------------------------------------------- */
+static void t1_parallel_for(task_pool_t *pool)
+{
+    printf("\n=== T1: parallel_for (%d threads) ===\n", task_pool_size(pool));
+    const size_t n = 10000;
+    Ctx *c = ctx_new(pool, n);
+    task_pool_parallel_for(pool, n, count_fn, c);
+    int ok = 1;
+    for (size_t i = 0; i < n; i++) ok &= (atomic_load(&c->hits[i]) == 1);
+    CHECK(ok, "every index ran exactly once");
+    CHECK(atomic_load(&c->clock) == (long)n, "task count matches");
+    ctx_free(c);
+}
+
+/* ----------------------------------------------------------------------- */
+/* T2 — dependency chain                                                     */
+/* ----------------------------------------------------------------------- */
+static void t2_chain(task_pool_t *pool)
+{
+    printf("\n=== T2: dependency chain (%d threads) ===\n",
+           task_pool_size(pool));
+    const size_t n = 500;
+    Ctx *c = ctx_new(pool, n);
+    tp_task_t *prev = NULL;
+    int dep_ok = 1;
+    /* Submit in reverse creation order so the chain, not submission
+     * order, is what serialises the tasks. */
+    tp_task_t **t = malloc(n * sizeof *t);
+    for (size_t i = 0; i < n; i++) {
+        t[i] = task_pool_task(pool, count_fn, c, i);
+        dep_ok &= (t[i] != NULL) && task_pool_depend(t[i], prev) == 0;
+        prev = t[i];
+    }
+    for (size_t i = n; i-- > 0;) task_pool_submit(pool, t[i]);
+    task_pool_wait(pool);
+    CHECK(dep_ok, "tasks and edges allocated");
+    int ok = 1;
+    for (size_t i = 0; i < n; i++) ok &= (c->stamp[i] == (long)i);
+    CHECK(ok, "chain ran in order");
+    free(t);
+    ctx_free(c);
+}
+
+/* ----------------------------------------------------------------------- */
+/* T3 — diamond                                                              */
+/* ----------------------------------------------------------------------- */
+static void t3_diamond(task_pool_t *pool)
+{
+    printf("\n=== T3: diamond DAG (%d threads) ===\n", task_pool_size(pool));
+    const size_t mid = 64, n = mid + 2;        /* 0: source, n-1: sink */
+    Ctx *c = ctx_new(pool, n);
+    tp_task_t *src  = task_pool_task(pool, count_fn, c, 0);
+    tp_task_t *sink = task_pool_task(pool, count_fn, c, n - 1);
+    int dep_ok = (src != NULL) && (sink != NULL);
+    task_pool_submit(pool, src);
+    for (size_t i = 1; i <= mid; i++) {
+        tp_task_t *m = task_pool_task(pool, count_fn, c, i);
+        /* src may already have finished here — depend must still hold. */
+        dep_ok &= (m != NULL) && task_pool_depend(m, src) == 0 &&
+                  task_pool_depend(sink, m) == 0;
+        task_pool_submit(pool, m);
+    }
+    task_pool_submit(pool, sink);
+    task_pool_wait(pool);
+    CHECK(dep_ok, "tasks and edges allocated");
+    int ok = 1;
+    for (size_t i = 1; i <= mid; i++)
+        ok &= (c->stamp[0] < c->stamp[i]) && (c->stamp[i] < c->stamp[n - 1]);
+    CHECK(ok, "source before middles before sink");
+    CHECK(atomic_load(&c->clock) == (long)n, "every task ran once");
+    ctx_free(c);
+}
+
+/* ----------------------------------------------------------------------- */
+/* T4 — uneven tasks spawning tasks                                          */
+/* ----------------------------------------------------------------------- */
+static void spawn_fn(void *arg, size_t idx)
+{
+    Ctx *c = arg;
+    spin((idx % 13 == 0) ? 20000 : 50);       /* a few heavy, mostly light */
+    atomic_fetch_add(&c->hits[idx], 1);
+    /* Binary tree: idx spawns 2·idx+1 and 2·idx+2 (pushed to this worker's
+     * own deque, where idle threads must steal them). */
+    for (size_t k = 2 * idx + 1; k <= 2 * idx + 2 && k < 4095; k++) {
+        tp_task_t *t = task_pool_task(c->pool, spawn_fn, c, k);
+        if (!t) { spawn_fn(c, k); continue; }
+        atomic_fetch_add(&c->spawned, 1);
+        task_pool_submit(c->pool, t);
+    }
+}
+
+static void t4_uneven(task_pool_t *pool)
+{
+    printf("\n=== T4: nested uneven tasks (%d threads) ===\n",
+           task_pool_size(pool));
+    const size_t n = 4095;
+    for (int round = 0; round < 2; round++) {
+        Ctx *c = ctx_new(pool, n);
+        tp_task_t *root = task_pool_task(pool, spawn_fn, c, 0);
+        task_pool_submit(pool, root);
+        task_pool_wait(pool);
+        int ok = (root != NULL);
+        for (size_t i = 0; i < n; i++) ok &= (atomic_load(&c->hits[i]) == 1);
+        CHECK(ok, round ? "second wait on the same pool: all 4095 ran once"
+                        : "all 4095 tree nodes ran exactly once");
+        ctx_free(c);
+    }
+}
+
+/* ----------------------------------------------------------------------- */
+/* main                                                                      */
+/* ----------------------------------------------------------------------- */
+int main(void)
+{
+    printf("=== test_task_pool: work-stealing runtime ===\n");
+
+    const int workers[2] = {0, 3};
+    for (int w = 0; w < 2; w++) {
+        task_pool_t *pool = task_pool_create(workers[w]);
+        if (!pool) { printf("FAIL: task_pool_create(%d)\n", workers[w]); return 1; }
+        CHECK(task_pool_size(pool) == workers[w] + 1, "pool size = workers + 1");
+        t1_parallel_for(pool);
+        t2_chain(pool);
+        t3_diamond(pool);
+        t4_uneven(pool);
+        task_pool_destroy(pool);
+    }
+
+    printf("\n--- Results: %d passed, %d failed ---\n", g_pass, g_fail);
+    return (g_fail == 0) ? 0 : 1;
+}
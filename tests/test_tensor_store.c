@@ -3,6 +3,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 static int test_get_physical_offset(void)
 {
@@ -146,6 +147,170 @@ static int test_read_write_chunk_fast(void)
     return 0;
 }
 
+static int test_chunk_addresses(void)
+{
+    printf("Testing registry chunk addresses / dset_posix_fd...\n");
+
+    const char *fname = "test_addr.h5";
+    const char *dname = "addr_tensor";
+    hsize_t dims[]       = {20, 10};
+    hsize_t chunk_dims[] = {10, 10};
+    const int rank = 2;
+
+    if (create_chunked_dataset_explicit(fname, dname, rank, dims,
+                                        chunk_dims) < 0) {
+        printf("  FAIL: create_chunked_dataset_explicit\n");
+        return 1;
+    }
+    hid_t file_id = H5Fopen(fname, H5F_ACC_RDWR, H5P_DEFAULT);
+    hid_t dset_id = (file_id >= 0) ? dset_open_no_cache(file_id, dname) : -1;
+    if (dset_id < 0) {
+        printf("  FAIL: open\n");
+        if (file_id >= 0) H5Fclose(file_id);
+        return 1;
+    }
+
+    /* Only the second tile is written. */
+    double buf[100], raw[100];
+    for (int i = 0; i < 100; i++) buf[i] = 0.5 * (double)i + 1.0;
+    hsize_t offset[] = {10, 0};
+    int rc = 0;
+    if (write_chunk_fast(dset_id, offset, buf, rank, chunk_dims) < 0 ||
+        H5Fflush(file_id, H5F_SCOPE_LOCAL) < 0) {
+        printf("  FAIL: write\n");
+        rc = 1;
+    }
+
+    TensorRegistry *reg = registry_create_from_dset(dset_id);
+    if (!rc && (!reg || registry_scan_file(dset_id, reg) != 1)) {
+        printf("  FAIL: registry scan\n");
+        rc = 1;
+    }
+    if (!rc) {
+        hsize_t t0[] = {0, 0}, t1[] = {1, 0};
+        TileMetadata *m0 = registry_get_tile(reg, t0);
+        TileMetadata *m1 = registry_get_tile(reg, t1);
+        int fd = dset_posix_fd(dset_id);
+        if (m0->file_addr != HADDR_UNDEF || m1->file_addr == HADDR_UNDEF ||
+            m1->file_bytes != sizeof(buf)) {
+            printf("  FAIL: addresses (unwritten %s, written %llu bytes)\n",
+                   m0->file_addr == HADDR_UNDEF ? "undef" : "set",
+                   (unsigned long long)m1->file_bytes);
+            rc = 1;
+        } else if (fd < 0) {
+            printf("  FAIL: dset_posix_fd\n");
+            rc = 1;
+        } else if (pread(fd, raw, sizeof(raw), (off_t)m1->file_addr)
+                       != (ssize_t)sizeof(raw) ||
+                   memcmp(raw, buf, sizeof(buf)) != 0) {
+            printf("  FAIL: bytes at file_addr differ from the tile\n");
+            rc = 1;
+        } else {
+            /* Hints must be harmless, including on an undefined range. */
+            file_advise(fd, m1->file_addr, m1->file_bytes, 1);
+            file_advise(fd, m1->file_addr, m1->file_bytes, 0);
+            file_advise(fd, m0->file_addr, m0->file_bytes, 1);
+        }
+    }
+
+    registry_destroy(reg);
+    H5Dclose(dset_id);
+    H5Fclose(file_id);
+    remove(fname);
+    if (!rc) printf("  PASS\n");
+    return rc;
+}
+
+static int test_aligned_layout(void)
+{
+    printf("Testing aligned chunk layout / TENSOR_H5_PREALLOC...\n");
+
+    const char *fname = "test_align.h5";
+    const char *dname = "align_tensor";
+    hsize_t dims[]       = {96, 256};
+    hsize_t chunk_dims[] = {32, 256};        /* 64 KiB: 16 KiB pages */
+    const int rank = 2;
+    static double buf[32 * 256];
+    for (int i = 0; i < 32 * 256; i++) buf[i] = (double)i;
+
+    /* Tiles written out of order through a plain handle stay aligned. */
+    int rc = create_chunked_dataset_explicit(fname, dname, rank, dims,
+                                             chunk_dims) < 0;
+    hid_t file_id = rc ? -1 : H5Fopen(fname, H5F_ACC_RDWR, H5P_DEFAULT);
+    hid_t dset_id = (file_id >= 0) ? dset_open_no_cache(file_id, dname) : -1;
+    hsize_t off2[] = {64, 0}, off0[] = {0, 0};
+    TensorRegistry *reg = NULL;
+    if (dset_id < 0 ||
+        write_chunk_fast(dset_id, off2, buf, rank, chunk_dims) < 0 ||
+        write_chunk_fast(dset_id, off0, buf, rank, chunk_dims) < 0 ||
+        !(reg = registry_create_from_dset(dset_id)) ||
+        registry_scan_file(dset_id, reg) != 2) {
+        printf("  FAIL: create/write/scan\n");
+        rc = 1;
+    }
+    for (size_t t = 0; !rc && t < reg->total_tiles; t++) {
+        const TileMetadata *m = &reg->tiles[t];
+        if (m->status == TILE_STATUS_ON_DISK && m->file_addr % 16384 != 0) {
+            printf("  FAIL: tile %zu at unaligned address %llu\n", t,
+                   (unsigned long long)m->file_addr);
+            rc = 1;
+        }
+    }
+    registry_destroy(reg);
+    reg = NULL;
+    if (dset_id >= 0) H5Dclose(dset_id);
+    if (file_id >= 0) H5Fclose(file_id);
+
+    /* Preallocated: every tile present, in row-major order, reading 0. */
+    setenv("TENSOR_H5_PREALLOC", "1", 1);
+    if (!rc && create_chunked_dataset_explicit(fname, dname, rank, dims,
+                                               chunk_dims) < 0) {
+        printf("  FAIL: create with TENSOR_H5_PREALLOC\n");
+        rc = 1;
+    }
+    unsetenv("TENSOR_H5_PREALLOC");
+    file_id = rc ? -1 : H5Fopen(fname, H5F_ACC_RDONLY, H5P_DEFAULT);
+    dset_id = (file_id >= 0) ? dset_open_no_cache(file_id, dname) : -1;
+    if (!rc && (dset_id < 0 || !(reg = registry_create_from_dset(dset_id)) ||
+                registry_scan_file(dset_id, reg) != 3 ||
+                !(reg->tiles[0].file_addr < reg->tiles[1].file_addr &&
+                  reg->tiles[1].file_addr < reg->tiles[2].file_addr) ||
+                read_chunk_fast(dset_id, off2, buf, rank, chunk_dims) < 0 ||
+                buf[0] != 0.0 || buf[32 * 256 - 1] != 0.0)) {
+        printf("  FAIL: preallocated tiles\n");
+        rc = 1;
+    }
+    registry_destroy(reg);
+    if (dset_id >= 0) H5Dclose(dset_id);
+    if (file_id >= 0) H5Fclose(file_id);
+
+    /* TENSOR_H5_PAGED=0: no paged file space, so HDF5 1.8 can read it. */
+    for (int paged = 1; paged >= 0 && !rc; paged--) {
+        setenv("TENSOR_H5_PAGED", paged ? "1" : "0", 1);
+        int bad = create_chunked_dataset_explicit(fname, dname, rank, dims,
+                                                  chunk_dims) < 0;
+        unsetenv("TENSOR_H5_PAGED");
+        H5F_fspace_strategy_t strategy = H5F_FSPACE_STRATEGY_NTYPES;
+        H5F_info2_t           info;
+        hid_t fcpl = -1;
+        file_id = bad ? -1 : H5Fopen(fname, H5F_ACC_RDONLY, H5P_DEFAULT);
+        bad = file_id < 0 || (fcpl = H5Fget_create_plist(file_id)) < 0 ||
+              H5Pget_file_space_strategy(fcpl, &strategy, NULL, NULL) < 0 ||
+              H5Fget_info2(file_id, &info) < 0 ||
+              (strategy == H5F_FSPACE_STRATEGY_PAGE) != paged ||
+              (!paged && info.super.version > 1);
+        if (bad) {
+            printf("  FAIL: TENSOR_H5_PAGED=%d layout\n", paged);
+            rc = 1;
+        }
+        if (fcpl >= 0) H5Pclose(fcpl);
+        if (file_id >= 0) H5Fclose(file_id);
+    }
+    remove(fname);
+    if (!rc) printf("  PASS\n");
+    return rc;
+}
+
 static int test_high_rank_tensor(void)
 {
     printf("Testing 4-D tensor I/O...\n");
@@ -318,6 +483,8 @@ int main(void)
     result |= test_calculate_chunk_dims();
     result |= test_create_chunked_dataset();
     result |= test_read_write_chunk_fast();
+    result |= test_chunk_addresses();
+    result |= test_aligned_layout();
     result |= test_high_rank_tensor();
     result |= test_small_chunks_and_boundaries();
     printf(result == 0 ? "\nAll tests PASSED\n" : "\nSome tests FAILED\n");
@@ -0,0 +1,86 @@
+/*
+ * tests/test_util.c — Helpers shared by the test programs (see test_util.h).
+ */
+
+#include "test_util.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+int g_pass = 0, g_fail = 0;
+
+int create(const char *file, int rank, const size_t *shape, hsize_t c,
+           tensor_dtype_t dtype)
+{
+    hsize_t dims[MAX_RANK], chunk[MAX_RANK];
+    for (int d = 0; d < rank; d++) {
+        dims[d]  = (hsize_t)shape[d];
+        chunk[d] = (c < dims[d]) ? c : dims[d];
+    }
+    return create_chunked_dataset_einsum(file, "tensor", rank, dims, chunk,
+                                         dtype) < 0 ? -1 : TENSOR_ENGINE_OK;
+}
+
+double *read_raw(const char *file, size_t *n_out)
+{
+    *n_out = 0;
+    hid_t fid = H5Fopen(file, H5F_ACC_RDONLY, H5P_DEFAULT);
+    if (fid < 0) return NULL;
+    hid_t dset  = H5Dopen2(fid, "tensor", H5P_DEFAULT);
+    hid_t ftype = H5Dget_type(dset);
+    hid_t space = H5Dget_space(dset);
+    size_t n = (size_t)H5Sget_simple_extent_npoints(space)
+             * (H5Tget_size(ftype) / sizeof(double));
+    double *buf = malloc(n * sizeof(double));
+    if (buf && H5Dread(dset, ftype, H5S_ALL, H5S_ALL, H5P_DEFAULT, buf) < 0) {
+        free(buf);
+        buf = NULL;
+    }
+    H5Sclose(space);
+    H5Tclose(ftype);
+    H5Dclose(dset);
+    H5Fclose(fid);
+    *n_out = buf ? n : 0;
+    return buf;
+}
+
+double rel_diff(const char *fx, const char *fy)
+{
+    size_t nx, ny;
+    double *x = read_raw(fx, &nx), *y = read_raw(fy, &ny);
+    double  d = INFINITY;
+    if (x && y && nx == ny && nx > 0) {
+        double m = 0.0, r = 0.0;
+        for (size_t i = 0; i < nx; i++) {
+            if (fabs(x[i] - y[i]) > m) m = fabs(x[i] - y[i]);
+            if (fabs(y[i]) > r) r = fabs(y[i]);
+        }
+        d = (r > 0.0) ? m / r : m;
+    }
+    free(x);
+    free(y);
+    return d;
+}
+
+int same_file_data(const char *f1, const char *f2)
+{
+    size_t n1, n2;
+    double *a = read_raw(f1, &n1);
+    double *b = read_raw(f2, &n2);
+    int ok = a && b && n1 > 0 && n1 == n2 &&
+             memcmp(a, b, n1 * sizeof(double)) == 0;
+    free(a);
+    free(b);
+    return ok;
+}
+
+int contract_env(tensor_engine_t *eng, const char *expr, const char *A,
+                 const char *B, const char *C, const char *var,
+                 const char *val)
+{
+    if (val) setenv(var, val, 1);
+    else     unsetenv(var);
+    int rc = tensor_engine_contract(eng, expr, A, B, C);
+    unsetenv(var);
+    return rc;
+}
@@ -0,0 +1,53 @@
+/*
+ * tests/test_util.h
+ *
+ * Helpers shared by the test programs: the CHECK macro and its pass/fail
+ * counters, and small HDF5 shortcuts for creating a "tensor" dataset and
+ * comparing results.  Linked into each test that includes it (see
+ * CMakeLists.txt).
+ */
+
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+#include "tensor_engine.h"
+#include "tensor_store.h"
+#include <hdf5.h>
+#include <stdio.h>
+
+extern int g_pass, g_fail;
+
+#define CHECK(cond, msg) \
+    do { \
+        if (cond) { \
+            printf("  PASS: %s\n", msg); \
+            g_pass++; \
+        } else { \
+            printf("  FAIL: %s  (line %d)\n", msg, __LINE__); \
+            g_fail++; \
+        } \
+    } while (0)
+
+/* Create an empty "tensor" dataset with explicit cubic chunks of side c
+ * (tensor_engine_create rounds tile_bytes up to 16 KiB, too coarse here). */
+int create(const char *file, int rank, const size_t *shape, hsize_t c,
+           tensor_dtype_t dtype);
+
+/* Read a whole "tensor" dataset as raw doubles (complex: interleaved);
+ * NULL with *n_out = 0 on error. */
+double *read_raw(const char *file, size_t *n_out);
+
+/* max |X - Y| / max |Y| over two result files, Y the reference;
+ * INFINITY if either is unreadable or the sizes differ. */
+double rel_diff(const char *fx, const char *fy);
+
+/* 1 if both files hold bitwise identical data, else 0. */
+int same_file_data(const char *f1, const char *f2);
+
+/* tensor_engine_contract with the environment knob var set to val (NULL:
+ * unset); var is unset again afterwards. */
+int contract_env(tensor_engine_t *eng, const char *expr, const char *A,
+                 const char *B, const char *C, const char *var,
+                 const char *val);
+
+#endif /* TEST_UTIL_H */
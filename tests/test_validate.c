@@ -0,0 +1,215 @@
+/*
+ * tests/test_validate.c
+ *
+ * Correctness tests for validate_contraction() (validate.c).
+ *
+ * Five test cases:
+ *   T1 – FP64 ij,jk->ik on a multi-tile grid: every C tile passes
+ *   T2 – one corrupted C element fails exactly one tile
+ *   T3 – COMPLEX128 ijab,akbl->klji with multiple contracted blocks passes
+ *   T4 – sampling: corner/last/centre first, count capped at the grid size
+ *   T5 – error paths: bad expression, mismatched extents, missing file
+ *
+ * All files use the prefix "vd_t{N}_" in the current working directory.
+ *
+ * Build: added to CMakeLists.txt as test_validate.
+ * Run:   ./build/test_validate
+ * Exit:  0 on success, 1 on any failure.
+ */
+
+#include "tensor_engine.h"
+#include "validate.h"
+#include "tensor_store.h"
+#include "registry.h"
+#include "test_util.h"
+#include <hdf5.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ----------------------------------------------------------------------- */
+/* Test infrastructure                                                       */
+/* ----------------------------------------------------------------------- */
+
+/* Add delta to the real part of one element of a "tensor" dataset. */
+static int poke(const char *file, const hsize_t *coord, double delta)
+{
+    hid_t fid = H5Fopen(file, H5F_ACC_RDWR, H5P_DEFAULT);
+    if (fid < 0) return -1;
+    hid_t dset  = H5Dopen2(fid, "tensor", H5P_DEFAULT);
+    hid_t ftype = H5Dget_type(dset);
+    hid_t mtype = (H5Tget_class(ftype) == H5T_COMPOUND) ? ftype
+                                                        : H5T_NATIVE_DOUBLE;
+    hid_t   fspace = H5Dget_space(dset);
+    hsize_t one[8] = {1, 1, 1, 1, 1, 1, 1, 1};
+    H5Sselect_hyperslab(fspace, H5S_SELECT_SET, coord, NULL, one, NULL);
+    hid_t   mspace = H5Screate_simple(1, one, NULL);
+
+    double v[2] = {0.0, 0.0};
+    int rc = H5Dread(dset, mtype, mspace, fspace, H5P_DEFAULT, v);
+    v[0] += delta;
+    if (rc >= 0)
+        rc = H5Dwrite(dset, mtype, mspace, fspace, H5P_DEFAULT, v);
+
+    H5Sclose(mspace);
+    H5Sclose(fspace);
+    H5Tclose(ftype);
+    H5Dclose(dset);
+    H5Fclose(fid);
+    return rc < 0 ? -1 : 0;
+}
+
+/* Number of chunks in file's "tensor" dataset; 0 on error. */
+static size_t grid_tiles(const char *file)
+{
+    hid_t fid = H5Fopen(file, H5F_ACC_RDONLY, H5P_DEFAULT);
+    if (fid < 0) return 0;
+    hid_t dset = H5Dopen2(fid, "tensor", H5P_DEFAULT);
+    TensorRegistry *reg = registry_create_from_dset(dset);
+    size_t n = reg ? reg->total_tiles : 0;
+    if (reg) registry_destroy(reg);
+    H5Dclose(dset);
+    H5Fclose(fid);
+    return n;
+}
+
+/* ----------------------------------------------------------------------- */
+/* T1 / T2 — FP64 matmul, then a single corrupted element                   */
+/* ----------------------------------------------------------------------- */
+static void t1_t2_fp64(tensor_engine_t *eng)
+{
+    printf("\n=== T1: FP64 ij,jk->ik, all tiles ===\n");
+    const size_t shA[2] = {70, 90}, shB[2] = {90, 50};
+    CHECK(create("vd_t1_A.h5", 2, shA, 16, DTYPE_FP64) == 0 &&
+          create("vd_t1_B.h5", 2, shB, 16, DTYPE_FP64) == 0,
+          "create A, B (16×16 chunks)");
+    CHECK(tensor_engine_fill_random(eng, "vd_t1_A.h5", 1) == TENSOR_ENGINE_OK &&
+          tensor_engine_fill_random(eng, "vd_t1_B.h5", 2) == TENSOR_ENGINE_OK,
+          "fill_random A, B");
+    CHECK(tensor_engine_contract(eng, "ij,jk->ik", "vd_t1_A.h5",
+                                 "vd_t1_B.h5", "vd_t1_C.h5")
+              == TENSOR_ENGINE_OK,
+          "contract");
+
+    size_t total = grid_tiles("vd_t1_C.h5");
+    validate_opts_t   o = {.n_tiles = -1, .verbose = 1};
+    validate_report_t r;
+    int rc = validate_contraction("ij,jk->ik", "vd_t1_A.h5", "vd_t1_B.h5",
+                                  "vd_t1_C.h5", &o, &r);
+    printf("  checked %zu of %zu  max_rel %.2e  %.3f s\n",
+           r.n_checked, total, r.max_rel_err, r.seconds);
+    CHECK(rc == 0, "validate returns 0");
+    CHECK(total > 1 && r.n_checked == total, "every C tile checked");
+    CHECK(r.max_rel_err < 1e-12, "max_rel_err < 1e-12");
+
+    printf("\n=== T2: corrupted element fails one tile ===\n");
+    const hsize_t at[2] = {33, 17};
+    CHECK(poke("vd_t1_C.h5", at, 1e-3) == 0, "perturb C[33,17] by 1e-3");
+    o.verbose = 2;
+    rc = validate_contraction("ij,jk->ik", "vd_t1_A.h5", "vd_t1_B.h5",
+                              "vd_t1_C.h5", &o, &r);
+    CHECK(rc == 1, "validate returns 1");
+    CHECK(r.n_failed == 1, "exactly one failing tile");
+    CHECK(r.max_abs_err > 0.9e-3 && r.max_abs_err < 1.1e-3,
+          "max_abs_err equals the perturbation");
+}
+
+/* ----------------------------------------------------------------------- */
+/* T3 — COMPLEX128 rank-4                                                    */
+/* ----------------------------------------------------------------------- */
+static void t3_complex_rank4(tensor_engine_t *eng)
+{
+    printf("\n=== T3: COMPLEX128 ijab,akbl->klji ===\n");
+    const size_t shA[4] = {9, 8, 7, 6};       /* A: i j a b */
+    const size_t shB[4] = {7, 5, 6, 4};       /* B: a k b l */
+    CHECK(create("vd_t3_A.h5", 4, shA, 3, DTYPE_COMPLEX128) == 0 &&
+          create("vd_t3_B.h5", 4, shB, 3, DTYPE_COMPLEX128) == 0,
+          "create A, B (side-3 chunks)");
+    CHECK(tensor_engine_fill_random(eng, "vd_t3_A.h5", 3) == TENSOR_ENGINE_OK &&
+          tensor_engine_fill_random(eng, "vd_t3_B.h5", 4) == TENSOR_ENGINE_OK,
+          "fill_random A, B");
+    CHECK(tensor_engine_contract(eng, "ijab,akbl->klji", "vd_t3_A.h5",
+                                 "vd_t3_B.h5", "vd_t3_C.h5")
+              == TENSOR_ENGINE_OK,
+          "contract");
+
+    validate_opts_t   o = {.n_tiles = -1};
+    validate_report_t r;
+    int rc = validate_contraction("ijab,akbl->klji", "vd_t3_A.h5",
+                                  "vd_t3_B.h5", "vd_t3_C.h5", &o, &r);
+    printf("  checked %zu  max_rel %.2e\n", r.n_checked, r.max_rel_err);
+    CHECK(rc == 0, "validate returns 0");
+    CHECK(r.max_rel_err < 1e-12, "max_rel_err < 1e-12");
+
+    const hsize_t at[4] = {2, 3, 5, 1};
+    CHECK(poke("vd_t3_C.h5", at, 1e-6) == 0, "perturb one C element");
+    rc = validate_contraction("ijab,akbl->klji", "vd_t3_A.h5",
+                              "vd_t3_B.h5", "vd_t3_C.h5", &o, &r);
+    CHECK(rc == 1 && r.n_failed == 1, "1e-6 perturbation detected");
+}
+
+/* ----------------------------------------------------------------------- */
+/* T4 — sampling                                                             */
+/* ----------------------------------------------------------------------- */
+static void t4_sampling(void)
+{
+    printf("\n=== T4: tile sampling ===\n");
+    size_t total = grid_tiles("vd_t1_C.h5");
+    validate_opts_t   o = {.n_tiles = 3, .verbose = 1};
+    validate_report_t r;
+    validate_contraction("ij,jk->ik", "vd_t1_A.h5", "vd_t1_B.h5",
+                         "vd_t1_C.h5", &o, &r);
+    CHECK(r.n_checked == 3, "--tiles 3 checks 3 tiles");
+
+    /* T2's corrupted tile is interior: corner/last/centre miss it. */
+    CHECK(r.n_failed == 0, "corner, last, centre tiles pass");
+
+    o.n_tiles = (long)total + 10;
+    o.verbose = 0;
+    validate_contraction("ij,jk->ik", "vd_t1_A.h5", "vd_t1_B.h5",
+                         "vd_t1_C.h5", &o, &r);
+    CHECK(r.n_checked == total, "count capped at the grid size");
+
+    validate_contraction("ij,jk->ik", "vd_t1_A.h5", "vd_t1_B.h5",
+                         "vd_t1_C.h5", NULL, &r);
+    CHECK(r.n_checked == 5, "default samples 5 tiles");
+}
+
+/* ----------------------------------------------------------------------- */
+/* T5 — error paths                                                          */
+/* ----------------------------------------------------------------------- */
+static void t5_errors(void)
+{
+    printf("\n=== T5: error paths ===\n");
+    CHECK(validate_contraction("ij,jk", "vd_t1_A.h5", "vd_t1_B.h5",
+                               "vd_t1_C.h5", NULL, NULL) == -3,
+          "malformed expression → -3");
+    CHECK(validate_contraction("ij,jk->ik", "vd_t1_A.h5", "vd_t1_A.h5",
+                               "vd_t1_C.h5", NULL, NULL) == -2,
+          "mismatched extents → -2");
+    CHECK(validate_contraction("ij,jk->ik", "vd_missing.h5", "vd_t1_B.h5",
+                               "vd_t1_C.h5", NULL, NULL) == -1,
+          "missing file → -1");
+}
+
+/* ----------------------------------------------------------------------- */
+/* main                                                                      */
+/* ----------------------------------------------------------------------- */
+int main(void)
+{
+    printf("=== test_validate: sampled-tile validator ===\n");
+    H5Eset_auto2(H5E_DEFAULT, NULL, NULL);
+
+    tensor_engine_config_t cfg = {.tile_bytes = 16UL * 1024};
+    tensor_engine_t *eng = tensor_engine_init(&cfg);
+    if (!eng) { printf("FAIL: engine init\n"); return 1; }
+
+    t1_t2_fp64(eng);
+    t3_complex_rank4(eng);
+    t4_sampling();
+    t5_errors();
+
+    tensor_engine_free(eng);
+    printf("\n--- Results: %d passed, %d failed ---\n", g_pass, g_fail);
+    return (g_fail == 0) ? 0 : 1;
+}
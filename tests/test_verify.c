@@ -0,0 +1,222 @@
+/*
+ * tests/test_verify.c
+ *
+ * Correctness tests for tensor_engine_verify().
+ *
+ * Five test cases:
+ *   T1 – FP64 matmul result passes
+ *   T2 – one corrupted C element is detected
+ *   T3 – COMPLEX128 ijab,akbl->klji: passes, then a 1e-6 relative
+ *        perturbation of one element is detected
+ *   T4 – block-sparse operands (random A, banded B) pass
+ *   T5 – error paths: bad expression, mismatched extents, missing file
+ *
+ * All files use the prefix "vf_t{N}_" in the current working directory.
+ *
+ * Build: added to CMakeLists.txt as test_verify.
+ * Run:   ./build/test_verify
+ * Exit:  0 on success, 1 on any failure.
+ */
+
+#include "tensor_engine.h"
+#include "test_util.h"
+#include <hdf5.h>
+#include <complex.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ----------------------------------------------------------------------- */
+/* Test infrastructure                                                       */
+/* ----------------------------------------------------------------------- */
+
+/*
+ * Add delta to one element of a "tensor" dataset.  For compound (complex)
+ * datasets only the real part is changed.
+ */
+static int poke(const char *file, int rank, const hsize_t *coord,
+                double delta)
+{
+    hid_t fid = H5Fopen(file, H5F_ACC_RDWR, H5P_DEFAULT);
+    if (fid < 0) return -1;
+    hid_t dset  = H5Dopen2(fid, "tensor", H5P_DEFAULT);
+    hid_t ftype = H5Dget_type(dset);
+    int   cplx  = H5Tget_class(ftype) == H5T_COMPOUND;
+    hid_t mtype = ftype;
+    if (!cplx) mtype = H5T_NATIVE_DOUBLE;
+
+    hid_t   fspace = H5Dget_space(dset);
+    hsize_t one[8] = {1, 1, 1, 1, 1, 1, 1, 1};
+    H5Sselect_hyperslab(fspace, H5S_SELECT_SET, coord, NULL, one, NULL);
+    hid_t   mspace = H5Screate_simple(1, one, NULL);
+
+    double v[2] = {0.0, 0.0};
+    int rc = H5Dread(dset, mtype, mspace, fspace, H5P_DEFAULT, v);
+    v[0] += delta;
+    if (rc >= 0)
+        rc = H5Dwrite(dset, mtype, mspace, fspace, H5P_DEFAULT, v);
+
+    (void)rank;
+    H5Sclose(mspace);
+    H5Sclose(fspace);
+    H5Tclose(ftype);
+    H5Dclose(dset);
+    H5Fclose(fid);
+    return rc < 0 ? -1 : 0;
+}
+
+/* ----------------------------------------------------------------------- */
+/* T1 / T2 — FP64 matmul, then a single corrupted element                   */
+/* ----------------------------------------------------------------------- */
+static void t1_t2_fp64(tensor_engine_t *eng)
+{
+    printf("\n=== T1: FP64 ij,jk->ik passes ===\n");
+    const size_t shA[2] = {70, 90}, shB[2] = {90, 50};
+    CHECK(tensor_engine_create(eng, "vf_t1_A.h5", 2, shA,
+                               TENSOR_DTYPE_FP64) == TENSOR_ENGINE_OK &&
+          tensor_engine_create(eng, "vf_t1_B.h5", 2, shB,
+                               TENSOR_DTYPE_FP64) == TENSOR_ENGINE_OK,
+          "create A, B");
+    CHECK(tensor_engine_fill_random(eng, "vf_t1_A.h5", 1) == TENSOR_ENGINE_OK &&
+          tensor_engine_fill_random(eng, "vf_t1_B.h5", 2) == TENSOR_ENGINE_OK,
+          "fill_random A, B");
+    CHECK(tensor_engine_contract(eng, "ij,jk->ik", "vf_t1_A.h5",
+                                 "vf_t1_B.h5", "vf_t1_C.h5")
+              == TENSOR_ENGINE_OK,
+          "contract");
+
+    tensor_engine_verify_t v = {0};
+    int rc = tensor_engine_verify(eng, "ij,jk->ik", "vf_t1_A.h5",
+                                  "vf_t1_B.h5", "vf_t1_C.h5", &v);
+    printf("  checked %zu  max_abs %.2e  max_rel %.2e  %.3f s\n",
+           v.n_checked, v.max_abs_err, v.max_rel_err, v.seconds);
+    CHECK(rc == TENSOR_ENGINE_OK, "verify returns OK");
+    CHECK(v.n_checked == 70 * 2, "70 elements × 2 vectors checked");
+    CHECK(v.max_rel_err < 1e-12, "max_rel_err < 1e-12");
+
+    printf("\n=== T2: corrupted element detected ===\n");
+    const hsize_t at[2] = {33, 17};
+    CHECK(poke("vf_t1_C.h5", 2, at, 1e-3) == 0, "perturb C[33,17] by 1e-3");
+    memset(&v, 0, sizeof(v));
+    rc = tensor_engine_verify(eng, "ij,jk->ik", "vf_t1_A.h5",
+                              "vf_t1_B.h5", "vf_t1_C.h5", &v);
+    printf("  failed %zu  max_abs %.2e  max_rel %.2e\n",
+           v.n_failed, v.max_abs_err, v.max_rel_err);
+    CHECK(rc == TENSOR_ENGINE_ERR_MISMATCH, "verify returns ERR_MISMATCH");
+    CHECK(v.n_failed >= 1, "at least one failing element");
+    CHECK(strcmp(tensor_engine_strerror(rc), "unknown error") != 0,
+          "strerror knows ERR_MISMATCH");
+}
+
+/* ----------------------------------------------------------------------- */
+/* T3 — COMPLEX128 rank-4                                                    */
+/* ----------------------------------------------------------------------- */
+static void t3_complex_rank4(tensor_engine_t *eng)
+{
+    printf("\n=== T3: COMPLEX128 ijab,akbl->klji ===\n");
+    const size_t sh[4] = {9, 8, 7, 6};        /* A: i j a b */
+    const size_t shB[4] = {7, 5, 6, 4};       /* B: a k b l */
+    CHECK(tensor_engine_create(eng, "vf_t3_A.h5", 4, sh,
+                               TENSOR_DTYPE_COMPLEX128) == TENSOR_ENGINE_OK &&
+          tensor_engine_create(eng, "vf_t3_B.h5", 4, shB,
+                               TENSOR_DTYPE_COMPLEX128) == TENSOR_ENGINE_OK,
+          "create A, B");
+    CHECK(tensor_engine_fill_random(eng, "vf_t3_A.h5", 3) == TENSOR_ENGINE_OK &&
+          tensor_engine_fill_random(eng, "vf_t3_B.h5", 4) == TENSOR_ENGINE_OK,
+          "fill_random A, B");
+    CHECK(tensor_engine_contract(eng, "ijab,akbl->klji", "vf_t3_A.h5",
+                                 "vf_t3_B.h5", "vf_t3_C.h5")
+              == TENSOR_ENGINE_OK,
+          "contract");
+
+    tensor_engine_verify_t v = {0};
+    v.n_vectors = 3;
+    v.seed      = 77;
+    int rc = tensor_engine_verify(eng, "ijab,akbl->klji", "vf_t3_A.h5",
+                                  "vf_t3_B.h5", "vf_t3_C.h5", &v);
+    printf("  checked %zu  max_rel %.2e\n", v.n_checked, v.max_rel_err);
+    CHECK(rc == TENSOR_ENGINE_OK, "verify returns OK");
+    CHECK(v.n_checked == 9 * 8 * 3, "|free_A| × 3 vectors checked");
+
+    /* C is (k, l, j, i) = (5, 4, 8, 9); |C| elements are O(sqrt(42)). */
+    const hsize_t at[4] = {2, 3, 5, 1};
+    CHECK(poke("vf_t3_C.h5", 4, at, 1e-6) == 0, "perturb one C element");
+    rc = tensor_engine_verify(eng, "ijab,akbl->klji", "vf_t3_A.h5",
+                              "vf_t3_B.h5", "vf_t3_C.h5", &v);
+    printf("  after perturbation: failed %zu  max_rel %.2e\n",
+           v.n_failed, v.max_rel_err);
+    CHECK(rc == TENSOR_ENGINE_ERR_MISMATCH, "1e-6 perturbation detected");
+}
+
+/* ----------------------------------------------------------------------- */
+/* T4 — block-sparse operands                                                */
+/* ----------------------------------------------------------------------- */
+static void t4_sparse(tensor_engine_t *eng)
+{
+    printf("\n=== T4: block-sparse operands ===\n");
+    const size_t shA[2] = {300, 260}, shB[2] = {260, 240};
+    CHECK(tensor_engine_create(eng, "vf_t4_A.h5", 2, shA,
+                               TENSOR_DTYPE_FP64) == TENSOR_ENGINE_OK &&
+          tensor_engine_create(eng, "vf_t4_B.h5", 2, shB,
+                               TENSOR_DTYPE_FP64) == TENSOR_ENGINE_OK,
+          "create A, B");
+    tensor_engine_sparsity_t spA = {TENSOR_SPARSITY_RANDOM, 0.5, 0, 0, 8};
+    tensor_engine_sparsity_t spB = {TENSOR_SPARSITY_BANDED, 0.0, 1, 0, 9};
+    CHECK(tensor_engine_fill_sparse(eng, "vf_t4_A.h5", &spA)
+              == TENSOR_ENGINE_OK &&
+          tensor_engine_fill_sparse(eng, "vf_t4_B.h5", &spB)
+              == TENSOR_ENGINE_OK,
+          "fill_sparse A, B");
+    CHECK(tensor_engine_contract(eng, "ij,jk->ik", "vf_t4_A.h5",
+                                 "vf_t4_B.h5", "vf_t4_C.h5")
+              == TENSOR_ENGINE_OK,
+          "contract");
+
+    tensor_engine_verify_t v = {0};
+    int rc = tensor_engine_verify(eng, "ij,jk->ik", "vf_t4_A.h5",
+                                  "vf_t4_B.h5", "vf_t4_C.h5", &v);
+    printf("  checked %zu  max_rel %.2e\n", v.n_checked, v.max_rel_err);
+    CHECK(rc == TENSOR_ENGINE_OK, "verify returns OK");
+}
+
+/* ----------------------------------------------------------------------- */
+/* T5 — error paths                                                          */
+/* ----------------------------------------------------------------------- */
+static void t5_errors(tensor_engine_t *eng)
+{
+    printf("\n=== T5: error paths ===\n");
+    CHECK(tensor_engine_verify(eng, "ij,jk", "vf_t1_A.h5", "vf_t1_B.h5",
+                               "vf_t1_C.h5", NULL) == TENSOR_ENGINE_ERR_EXPR,
+          "malformed expression → ERR_EXPR");
+    /* A is 70×90; using it as B makes j = 90 vs 70. */
+    CHECK(tensor_engine_verify(eng, "ij,jk->ik", "vf_t1_A.h5", "vf_t1_A.h5",
+                               "vf_t1_C.h5", NULL) == TENSOR_ENGINE_ERR_DIMS,
+          "mismatched extents → ERR_DIMS");
+    CHECK(tensor_engine_verify(eng, "ij,jk->ik", "vf_missing.h5",
+                               "vf_t1_B.h5", "vf_t1_C.h5", NULL)
+              == TENSOR_ENGINE_ERR_FILE,
+          "missing file → ERR_FILE");
+}
+
+/* ----------------------------------------------------------------------- */
+/* main                                                                      */
+/* ----------------------------------------------------------------------- */
+int main(void)
+{
+    printf("=== test_verify: randomized result verification ===\n");
+    H5Eset_auto2(H5E_DEFAULT, NULL, NULL);
+
+    tensor_engine_config_t cfg = {.tile_bytes = 16UL * 1024};
+    tensor_engine_t *eng = tensor_engine_init(&cfg);
+    if (!eng) { printf("FAIL: engine init\n"); return 1; }
+
+    t1_t2_fp64(eng);
+    t3_complex_rank4(eng);
+    t4_sparse(eng);
+    t5_errors(eng);
+
+    tensor_engine_free(eng);
+    printf("\n--- Results: %d passed, %d failed ---\n", g_pass, g_fail);
+    return (g_fail == 0) ? 0 : 1;
+}
@@ -0,0 +1,61 @@
+/*
+ * convert_tensor.c
+ *
+ * Copy a tensor between storage formats (storage.h): HDF5 to the native
+ * tile-aligned format or back.  The output format follows the output name
+ * (".oct" = native, ".ocs" = native striped over several drives, anything
+ * else HDF5); shape, chunking and dtype are kept, and absent tiles stay
+ * absent.
+ *
+ * Usage:  convert_tensor IN OUT [--dset NAME] [--out-dset NAME]
+ *                               [--stripe DIR1:DIR2:...]
+ *
+ *   --dset NAME      dataset read from an HDF5 input   (default: tensor)
+ *   --out-dset NAME  dataset written to an HDF5 output (default: --dset)
+ *   --stripe DIRS    member directories of a ".ocs" output, one per drive
+ *                    (default: $TENSOR_STRIPE_DIRS)
+ *
+ * Exit: 0 success, 1 conversion failed, 2 usage error.
+ */
+
+#include "storage.h"
+#include <hdf5.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "Usage: convert_tensor IN OUT [--dset NAME] [--out-dset NAME]\n"
+            "                              [--stripe DIR1:DIR2:...]\n");
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) { usage(); return 2; }
+    const char *dset     = "tensor";
+    const char *out_dset = NULL;
+    for (int i = 3; i < argc; i++) {
+        const char *a   = argv[i];
+        const char *val = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (!val) { usage(); return 2; }
+        if      (strcmp(a, "--dset") == 0)     dset     = val;
+        else if (strcmp(a, "--out-dset") == 0) out_dset = val;
+        else if (strcmp(a, "--stripe") == 0)   setenv("TENSOR_STRIPE_DIRS", val, 1);
+        else { usage(); return 2; }
+        i++;
+    }
+    if (!out_dset) out_dset = dset;
+
+    H5Eset_auto2(H5E_DEFAULT, NULL, NULL);
+    long n = stg_convert(argv[1], dset, argv[2], out_dset);
+    if (n < 0) {
+        fprintf(stderr, "convert_tensor: '%s' -> '%s' failed\n",
+                argv[1], argv[2]);
+        return 1;
+    }
+    printf("%s -> %s (%s): %ld tiles\n", argv[1], argv[2],
+           stg_backend_for(argv[2])->name, n);
+    return 0;
+}
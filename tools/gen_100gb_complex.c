@@ -15,17 +15,19 @@
  * Fill value: 1.0 + 0.5i everywhere.
  * Expected contraction result: 78400 × (0.75 + 1.0i) = 58800 + 78400i.
  *
- * Only one chunk buffer (16 MiB) is held in RAM at any time.
+ * Tiles are produced by TENSOR_NUM_THREADS threads and written by one
+ * writer thread; memory is bounded by a small BufferPool (a few 16 MiB
+ * pages per producer).
  */
 
 #include "tensor_store.h"
-#include "odometer.h"
+#include "registry.h"
+#include "tile_writer.h"
 #include <hdf5.h>
 #include <complex.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
 
 #define GEN_RANK       4
 #define GLOBAL_DIM     280
@@ -94,75 +96,36 @@ static int generate_file(const char *fname, const char *dset_name,
         return -1;
     }
 
-    /* One chunk buffer, pre-filled. */
-    double _Complex *buf = (double _Complex *)malloc(bytes_per_chunk);
-    if (!buf) {
-        fprintf(stderr, "gen: malloc failed (%zu MiB)\n",
-                bytes_per_chunk / (1024 * 1024));
+    TensorRegistry *reg = registry_create_from_dset(dset);
+    if (!reg) {
+        fprintf(stderr, "gen: registry_create_from_dset failed\n");
         H5Tclose(h5ctype); H5Dclose(dset); H5Fclose(fid);
         return -1;
     }
-    for (size_t i = 0; i < elems_per_chunk; i++) buf[i] = fill;
-
-    /* Odometer over the tile grid. */
-    size_t tile_idx[GEN_RANK], grid_sz[GEN_RANK];
-    memset(tile_idx, 0, sizeof(tile_idx));
-    for (int d = 0; d < GEN_RANK; d++) grid_sz[d] = n_tiles[d];
-
-    int    ret     = 0;
-    size_t written = 0;
-
-    struct timespec t0, tnow;
-    clock_gettime(CLOCK_MONOTONIC, &t0);
-
-    do {
-        hsize_t offset[GEN_RANK];
-        for (int d = 0; d < GEN_RANK; d++)
-            offset[d] = (hsize_t)tile_idx[d] * chunk_dims[d];
-
-        if (write_chunk_typed(dset, offset, buf,
-                               sizeof(double _Complex), GEN_RANK,
-                               chunk_dims, h5ctype) < 0) {
-            fprintf(stderr,
-                    "gen: write_chunk_typed failed at tile "
-                    "[%zu,%zu,%zu,%zu]\n",
-                    tile_idx[0], tile_idx[1], tile_idx[2], tile_idx[3]);
-            ret = -1;
-            break;
-        }
-
-        written++;
-        if (written % 250 == 0 || written == total_tiles) {
-            clock_gettime(CLOCK_MONOTONIC, &tnow);
-            double elapsed = (double)(tnow.tv_sec - t0.tv_sec)
-                           + (double)(tnow.tv_nsec - t0.tv_nsec) * 1e-9;
-            double pct = 100.0 * (double)written / (double)total_tiles;
-            double gib = (double)(written * bytes_per_chunk)
-                         / (1024.0 * 1024.0 * 1024.0);
-            double bw  = (elapsed > 0.0)
-                         ? gib / elapsed : 0.0;
-            printf("\r  %5.1f%%  %5zu/%zu tiles  %6.1f GiB  "
-                   "%5.1f s  %5.1f GiB/s",
-                   pct, written, total_tiles, gib, elapsed, bw);
-            fflush(stdout);
-        }
-
-    } while (odometer_step(GEN_RANK, tile_idx, grid_sz));
 
-    printf("\n");
-    free(buf);
+    /* Parallel producers, one writer thread, direct chunk writes. */
+    tile_writer_opts_t opts;
+    memset(&opts, 0, sizeof(opts));
+    opts.fill     = TW_FILL_CONST;
+    opts.value    = &fill;
+    opts.direct   = 1;
+    opts.progress = 1;
+
+    tile_writer_stats_t st;
+    int ret = tile_writer_run(dset, reg, h5ctype, &opts, &st);
+    if (ret < 0)
+        fprintf(stderr, "gen: tile_writer_run failed (%d)\n", ret);
+
+    registry_destroy(reg);
     H5Tclose(h5ctype);
     H5Dclose(dset);
     H5Fclose(fid);
 
     if (ret == 0) {
-        struct timespec tf;
-        clock_gettime(CLOCK_MONOTONIC, &tf);
-        double elapsed = (double)(tf.tv_sec - t0.tv_sec)
-                       + (double)(tf.tv_nsec - t0.tv_nsec) * 1e-9;
-        printf("  done  %.2f GiB  %.1f s  %.2f GiB/s\n",
-               total_gib, elapsed,
-               (elapsed > 0.0) ? total_gib / elapsed : 0.0);
+        printf("  done  %.2f GiB  %.1f s  %.2f GiB/s%s\n",
+               total_gib, st.seconds,
+               (st.seconds > 0.0) ? total_gib / st.seconds : 0.0,
+               st.direct ? "  (direct chunk writes)" : "");
     }
     return ret;
 }
@@ -23,13 +23,13 @@
  */
 
 #include "tensor_store.h"
-#include "odometer.h"
+#include "registry.h"
+#include "tile_writer.h"
 #include <hdf5.h>
 #include <complex.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
 
 #define GEN_RANK    4
 #define FILL_REAL   1.0
@@ -92,71 +92,37 @@ static int generate_file(const char *fname, const char *dset_name,
         return -1;
     }
 
-    double _Complex *buf = (double _Complex *)malloc(bytes_per_chunk);
-    if (!buf) {
-        fprintf(stderr, "gen: malloc failed\n");
+    TensorRegistry *reg = registry_create_from_dset(dset);
+    if (!reg) {
+        fprintf(stderr, "gen: registry_create_from_dset failed\n");
         H5Tclose(h5ctype); H5Dclose(dset); H5Fclose(fid);
         return -1;
     }
-    for (size_t i = 0; i < elems_per_chunk; i++) buf[i] = fill;
-
-    size_t tile_idx[GEN_RANK], grid_sz[GEN_RANK];
-    memset(tile_idx, 0, sizeof(tile_idx));
-    for (int d = 0; d < GEN_RANK; d++) grid_sz[d] = n_tiles[d];
-
-    int    ret     = 0;
-    size_t written = 0;
-
-    struct timespec t0, tnow;
-    clock_gettime(CLOCK_MONOTONIC, &t0);
-
-    do {
-        hsize_t offset[GEN_RANK];
-        for (int d = 0; d < GEN_RANK; d++)
-            offset[d] = (hsize_t)tile_idx[d] * chunk_dims[d];
-
-        if (write_chunk_typed(dset, offset, buf,
-                              sizeof(double _Complex), GEN_RANK,
-                              chunk_dims, h5ctype) < 0) {
-            fprintf(stderr,
-                    "gen: write_chunk_typed failed at tile "
-                    "[%zu,%zu,%zu,%zu]\n",
-                    tile_idx[0], tile_idx[1], tile_idx[2], tile_idx[3]);
-            ret = -1;
-            break;
-        }
-
-        written++;
-        if (written % 50 == 0 || written == total_tiles) {
-            clock_gettime(CLOCK_MONOTONIC, &tnow);
-            double elapsed = (double)(tnow.tv_sec - t0.tv_sec)
-                           + (double)(tnow.tv_nsec - t0.tv_nsec) * 1e-9;
-            double pct = 100.0 * (double)written / (double)total_tiles;
-            double mib = (double)(written * bytes_per_chunk)
-                         / (1024.0 * 1024.0);
-            double bw  = (elapsed > 0.0) ? mib / elapsed : 0.0;
-            printf("\r  %5.1f%%  %4zu/%zu tiles  %7.1f MiB  "
-                   "%5.1f s  %6.1f MiB/s",
-                   pct, written, total_tiles, mib, elapsed, bw);
-            fflush(stdout);
-        }
-
-    } while (odometer_step(GEN_RANK, tile_idx, grid_sz));
 
-    printf("\n");
-    free(buf);
+    /* Producers fill tiles in parallel; a single writer streams them out
+     * (direct chunk writes — the dataset is unfiltered). */
+    tile_writer_opts_t opts;
+    memset(&opts, 0, sizeof(opts));
+    opts.fill     = TW_FILL_CONST;
+    opts.value    = &fill;
+    opts.direct   = 1;
+    opts.progress = 1;
+
+    tile_writer_stats_t st;
+    int ret = tile_writer_run(dset, reg, h5ctype, &opts, &st);
+    if (ret < 0)
+        fprintf(stderr, "gen: tile_writer_run failed (%d)\n", ret);
+
+    registry_destroy(reg);
     H5Tclose(h5ctype);
     H5Dclose(dset);
     H5Fclose(fid);
 
     if (ret == 0) {
-        struct timespec tf;
-        clock_gettime(CLOCK_MONOTONIC, &tf);
-        double elapsed = (double)(tf.tv_sec - t0.tv_sec)
-                       + (double)(tf.tv_nsec - t0.tv_nsec) * 1e-9;
-        printf("  done  %.1f MiB  %.2f s  %.1f MiB/s\n",
-               total_mib, elapsed,
-               (elapsed > 0.0) ? total_mib / elapsed : 0.0);
+        printf("  done  %.1f MiB  %.2f s  %.1f MiB/s%s\n",
+               total_mib, st.seconds,
+               (st.seconds > 0.0) ? total_mib / st.seconds : 0.0,
+               st.direct ? "  (direct chunk writes)" : "");
     }
     return ret;
 }
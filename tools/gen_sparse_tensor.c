@@ -0,0 +1,159 @@
+/*
+ * gen_sparse_tensor.c
+ *
+ * Block-sparse random tensor generator for sparse-path testing and
+ * benchmarking.
+ *
+ * Usage:  gen_sparse_tensor OUT.h5 PATTERN [DIM [CHUNK_SIDE [RANK
+ *                           [PARAM [SEED [DTYPE]]]]]]
+ *
+ *   OUT.h5      output file (dataset "tensor"; overwritten)
+ *   PATTERN     dense | random | banded | blockdiag | symmetric
+ *   DIM         global size per index    (default: 256)
+ *   CHUNK_SIDE  chunk size per index     (default: 32)
+ *   RANK        number of indices        (default: 2)
+ *   PARAM       random/symmetric: tile density in [0,1]   (default: 0.25)
+ *               banded:           bandwidth in tiles      (default: 1)
+ *               blockdiag:        number of blocks        (default: 4)
+ *   SEED        selection/content seed   (default: 1)
+ *   DTYPE       fp64 | c128              (default: fp64)
+ *
+ * Only the selected tiles are written; all others stay unallocated and are
+ * skipped with zero I/O by the engine.  Selected tiles hold uniform [-1, 1)
+ * values — tile t equals tile t of tensor_engine_fill_random(SEED), or for
+ * "symmetric" an element-wise permutation-symmetric tensor — so any tile
+ * can be regenerated for validation.
+ *
+ * Tiles are produced by TENSOR_NUM_THREADS threads and written by one
+ * writer thread (tile_writer.c).
+ */
+
+#include "tensor_store.h"
+#include "registry.h"
+#include "sparse_pattern.h"
+#include "tile_writer.h"
+#include <hdf5.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "Usage: gen_sparse_tensor OUT.h5 PATTERN [DIM [CHUNK_SIDE [RANK "
+            "[PARAM [SEED [DTYPE]]]]]]\n"
+            "  PATTERN: dense | random | banded | blockdiag | symmetric\n"
+            "  DTYPE  : fp64 | c128\n");
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) { usage(); return 1; }
+
+    const char      *fname = argv[1];
+    sparse_pattern_t pat;
+    memset(&pat, 0, sizeof(pat));
+    if (sparse_pattern_parse(argv[2], &pat.kind) < 0) {
+        fprintf(stderr, "gen: unknown pattern '%s'\n", argv[2]);
+        usage();
+        return 1;
+    }
+
+    int            dim        = (argc > 3) ? atoi(argv[3]) : 256;
+    int            chunk_side = (argc > 4) ? atoi(argv[4]) : 32;
+    int            rank       = (argc > 5) ? atoi(argv[5]) : 2;
+    const char    *param      = (argc > 6) ? argv[6]       : NULL;
+    pat.seed                  = (argc > 7) ? strtoull(argv[7], NULL, 10) : 1;
+    tensor_dtype_t dtype      = DTYPE_FP64;
+    if (argc > 8) {
+        if (strcmp(argv[8], "c128") == 0)       dtype = DTYPE_COMPLEX128;
+        else if (strcmp(argv[8], "fp64") != 0) { usage(); return 1; }
+    }
+
+    pat.density   = param ? atof(param) : 0.25;
+    pat.bandwidth = param ? atoi(param) : 1;
+    pat.n_blocks  = param ? atoi(param) : 4;
+
+    if (dim <= 0 || chunk_side <= 0 || rank < 1 || rank > MAX_RANK) {
+        usage();
+        return 1;
+    }
+
+    hsize_t shape[MAX_RANK], chunk_dims[MAX_RANK];
+    for (int d = 0; d < rank; d++) {
+        shape[d]      = (hsize_t)dim;
+        chunk_dims[d] = (hsize_t)(chunk_side < dim ? chunk_side : dim);
+    }
+
+    printf("=== Sparse Tensor Generator ===\n");
+    printf("%s  shape (%d^%d)  chunk (%d^%d)  %s  pattern %s  seed %llu\n",
+           fname, dim, rank, (int)chunk_dims[0], rank,
+           dtype == DTYPE_COMPLEX128 ? "COMPLEX128" : "FP64",
+           sparse_pattern_name(pat.kind), (unsigned long long)pat.seed);
+
+    if (create_chunked_dataset_einsum(fname, "tensor", rank, shape,
+                                      chunk_dims, dtype) < 0) {
+        fprintf(stderr, "gen: create_chunked_dataset_einsum failed '%s'\n",
+                fname);
+        return 1;
+    }
+
+    hid_t fid = H5Fopen(fname, H5F_ACC_RDWR, H5P_DEFAULT);
+    if (fid < 0) { fprintf(stderr, "gen: H5Fopen failed\n"); return 1; }
+    hid_t dset = dset_open_no_cache(fid, "tensor");
+    if (dset < 0) {
+        fprintf(stderr, "gen: dset_open_no_cache failed\n");
+        H5Fclose(fid);
+        return 1;
+    }
+
+    TensorRegistry *reg = registry_create_from_dset(dset);
+    if (!reg || sparse_pattern_validate(&pat, reg) < 0) {
+        if (reg) registry_destroy(reg);
+        H5Dclose(dset);
+        H5Fclose(fid);
+        return 1;
+    }
+
+    hid_t mem_type = H5T_NATIVE_DOUBLE;
+    if (dtype == DTYPE_COMPLEX128) mem_type = create_h5_complex_type();
+
+    size_t n_sel = sparse_pattern_count(&pat, reg);
+    printf("tiles : %zu of %zu selected (density %.4f)\n",
+           n_sel, reg->total_tiles,
+           (double)n_sel / (double)reg->total_tiles);
+
+    tile_writer_opts_t opts;
+    memset(&opts, 0, sizeof(opts));
+    opts.fill        = TW_FILL_RANDOM;
+    opts.seed        = pat.seed;
+    opts.select      = sparse_pattern_select;
+    opts.select_user = &pat;
+    opts.direct      = 1;
+    opts.progress    = 1;
+    if (pat.kind == SP_SYMMETRIC) {
+        opts.fill      = TW_FILL_CALLBACK;
+        opts.tile_fn   = sparse_pattern_fill_symmetric;
+        opts.tile_user = &pat;
+    }
+
+    tile_writer_stats_t st;
+    int rc = tile_writer_run(dset, reg, mem_type, &opts, &st);
+
+    if (dtype == DTYPE_COMPLEX128) H5Tclose(mem_type);
+    registry_destroy(reg);
+    H5Dclose(dset);
+    H5Fclose(fid);
+
+    if (rc < 0) {
+        fprintf(stderr, "gen: tile_writer_run failed (%d)\n", rc);
+        return 1;
+    }
+
+    double mib = (double)st.bytes / (1024.0 * 1024.0);
+    printf("done  %zu tiles  %.1f MiB  %.2f s  %.1f MiB/s%s\n",
+           st.tiles, mib, st.seconds,
+           (st.seconds > 0.0) ? mib / st.seconds : 0.0,
+           st.direct ? "  (direct chunk writes)" : "");
+    return 0;
+}
@@ -0,0 +1,132 @@
+/*
+ * job_server.c
+ *
+ * Command-line front end for the contraction service (job_server.h): runs
+ * the server, or submits one job to a running server and waits for it.
+ *
+ * Usage:  job_server serve SOCKET [--pool-mb N] [--tile-bytes N]
+ *                          [--cache-mb N] [--keep-b N] [--queue N]
+ *         job_server SOCKET contract    EXPR A.h5 B.h5 C.h5
+ *         job_server SOCKET accumulate  EXPR A.h5 B.h5 C.h5
+ *         job_server SOCKET verify      EXPR A.h5 B.h5 C.h5
+ *         job_server SOCKET elementwise EXPR OUT.h5 IN.h5 [IN.h5 ...]
+ *         job_server SOCKET status | shutdown
+ *
+ *   --pool-mb N     buffer-pool cap per job in MiB   (default: engine auto)
+ *   --tile-bytes N  tile size for created outputs    (default: 16 MiB)
+ *   --cache-mb N    shared B tile cache per B file   (default: off)
+ *   --keep-b N      B caches kept warm between jobs  (default: 4)
+ *   --queue N       queued jobs before rejecting     (default: 64)
+ *
+ * Relative paths are sent as absolute paths, since the server resolves
+ * them in its own working directory.
+ *
+ * Exit: 0 success, 1 the job failed or was rejected, 2 usage or
+ *       connection error.
+ */
+
+#include "job_server.h"
+#include "tensor_engine.h"
+#include <hdf5.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "Usage: job_server serve SOCKET [--pool-mb N] [--tile-bytes N]\n"
+            "                          [--cache-mb N] [--keep-b N] "
+            "[--queue N]\n"
+            "       job_server SOCKET contract|accumulate|verify "
+            "EXPR A.h5 B.h5 C.h5\n"
+            "       job_server SOCKET elementwise EXPR OUT.h5 IN.h5 "
+            "[IN.h5 ...]\n"
+            "       job_server SOCKET status|shutdown\n");
+}
+
+static int serve(int argc, char **argv)
+{
+    jsrv_config_t cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    for (int i = 3; i < argc; i++) {
+        const char *a   = argv[i];
+        const char *val = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (!val) { usage(); return 2; }
+        if      (strcmp(a, "--pool-mb") == 0)    cfg.pool_mb    = strtoul(val, NULL, 10);
+        else if (strcmp(a, "--tile-bytes") == 0) cfg.tile_bytes = strtoul(val, NULL, 10);
+        else if (strcmp(a, "--cache-mb") == 0)   cfg.cache_mb   = strtoul(val, NULL, 10);
+        else if (strcmp(a, "--keep-b") == 0)     cfg.keep_b     = atoi(val);
+        else if (strcmp(a, "--queue") == 0)      cfg.max_queue  = atoi(val);
+        else { usage(); return 2; }
+        i++;
+    }
+    H5Eset_auto2(H5E_DEFAULT, NULL, NULL);
+    return jsrv_serve(argv[2], &cfg) == 0 ? 0 : 2;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc >= 3 && strcmp(argv[1], "serve") == 0)
+        return serve(argc, argv);
+    if (argc < 3) { usage(); return 2; }
+
+    static const char *ops[] = {
+        NULL, "contract", "accumulate", "elementwise", "verify", "status",
+        "shutdown"
+    };
+    int op = 0;
+    for (int k = JSRV_OP_CONTRACT; k <= JSRV_OP_SHUTDOWN; k++)
+        if (strcmp(argv[2], ops[k]) == 0) op = k;
+    if (!op) { usage(); return 2; }
+
+    /* The server resolves paths in its own working directory: send ours
+     * made absolute.  args[0] is the expression. */
+    int   n_args = argc - 3;
+    char  cwd[4096];
+    char *args[JSRV_MAX_ARGS];
+    if (n_args > JSRV_MAX_ARGS || !getcwd(cwd, sizeof(cwd))) {
+        usage();
+        return 2;
+    }
+    for (int i = 0; i < n_args; i++) {
+        const char *a = argv[3 + i];
+        size_t      n = strlen(cwd) + strlen(a) + 2;
+        args[i] = (char *)malloc(n);
+        if (!args[i]) return 2;
+        if (i == 0 || a[0] == '/') snprintf(args[i], n, "%s", a);
+        else                       snprintf(args[i], n, "%s/%s", cwd, a);
+    }
+
+    jsrv_reply_t rep;
+    int          rc = jsrv_call(argv[1], op, (const char *const *)args,
+                                n_args, &rep);
+    for (int i = 0; i < n_args; i++) free(args[i]);
+    if (rc != 0) return 2;
+
+    switch (rep.status) {
+    case JSRV_BAD_REQUEST:
+        fprintf(stderr, "job_server: bad request\n");
+        usage();
+        return 2;
+    case JSRV_BUSY:
+        fprintf(stderr, "job_server: queue full, try again later\n");
+        return 1;
+    case JSRV_CLOSING:
+        fprintf(stderr, "job_server: server is shutting down\n");
+        return 1;
+    }
+
+    if (op == JSRV_OP_STATUS || op == JSRV_OP_SHUTDOWN) {
+        printf("%llu jobs done, %u queued%s\n",
+               (unsigned long long)rep.jobs_done, rep.queued,
+               op == JSRV_OP_SHUTDOWN ? ", shutting down" : "");
+        return 0;
+    }
+    printf("%s: %s  (queued %.2f s, ran %.2f s)\n", ops[op],
+           tensor_engine_strerror(rep.rc), rep.queue_s, rep.run_s);
+    if (op == JSRV_OP_VERIFY)
+        printf("max relative error %.3e\n", rep.max_rel_err);
+    return rep.rc == TENSOR_ENGINE_OK ? 0 : 1;
+}